@@ -0,0 +1,63 @@
+// esp_timer, ROM delay, logging and restart on the host.
+#include "esp_err.h"
+#include "esp_log.h"
+#include "esp_rom_sys.h"
+#include "esp_system.h"
+#include "esp_timer.h"
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <time.h>
+
+static pthread_once_t start_once = PTHREAD_ONCE_INIT;
+static struct timespec start_time;
+
+static void record_start(void) {
+    clock_gettime(CLOCK_MONOTONIC, &start_time);
+}
+
+int64_t esp_timer_get_time(void) {
+    pthread_once(&start_once, record_start);
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (int64_t)(now.tv_sec - start_time.tv_sec) * 1000000 +
+           (now.tv_nsec - start_time.tv_nsec) / 1000;
+}
+
+uint32_t esp_log_timestamp(void) {
+    return (uint32_t)(esp_timer_get_time() / 1000);
+}
+
+void esp_rom_delay_us(uint32_t us) {
+    struct timespec delay = {
+        .tv_sec = us / 1000000u,
+        .tv_nsec = (long)(us % 1000000u) * 1000L,
+    };
+    while (nanosleep(&delay, &delay) != 0 && errno == EINTR) {
+    }
+}
+
+const char *esp_err_to_name(esp_err_t code) {
+    switch (code) {
+    case ESP_OK:
+        return "ESP_OK";
+    case ESP_FAIL:
+        return "ESP_FAIL";
+    case ESP_ERR_NO_MEM:
+        return "ESP_ERR_NO_MEM";
+    case ESP_ERR_INVALID_ARG:
+        return "ESP_ERR_INVALID_ARG";
+    case ESP_ERR_INVALID_STATE:
+        return "ESP_ERR_INVALID_STATE";
+    case ESP_ERR_TIMEOUT:
+        return "ESP_ERR_TIMEOUT";
+    default:
+        return "UNKNOWN ERROR";
+    }
+}
+
+void esp_restart(void) {
+    ESP_LOGW("host", "esp_restart requested, exiting");
+    exit(EXIT_SUCCESS);
+}
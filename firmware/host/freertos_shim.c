@@ -0,0 +1,300 @@
+// FreeRTOS tasks, semaphores, notifications and event groups on pthreads.
+#ifdef __linux__
+#define _GNU_SOURCE // pthread_setname_np
+#endif
+#include "freertos/FreeRTOS.h"
+#include "freertos/event_groups.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+
+#include "esp_timer.h"
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+struct host_task {
+    pthread_t thread;
+    TaskFunction_t function;
+    void *param;
+    BaseType_t core_id;
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    uint32_t notify_count;
+};
+
+typedef enum {
+    HOST_SEMAPHORE_BINARY,
+    HOST_SEMAPHORE_MUTEX,
+    HOST_SEMAPHORE_RECURSIVE,
+} host_semaphore_kind_t;
+
+struct host_semaphore {
+    host_semaphore_kind_t kind;
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    unsigned int count;
+};
+
+struct host_event_group {
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    EventBits_t bits;
+};
+
+static _Thread_local struct host_task *current_task;
+
+// Condition variables wait on CLOCK_MONOTONIC so ticks match esp_timer.
+static void init_monotonic_cond(pthread_cond_t *cond) {
+    pthread_condattr_t attributes;
+    pthread_condattr_init(&attributes);
+    pthread_condattr_setclock(&attributes, CLOCK_MONOTONIC);
+    pthread_cond_init(cond, &attributes);
+    pthread_condattr_destroy(&attributes);
+}
+
+static struct timespec deadline_after(TickType_t ticks) {
+    struct timespec deadline;
+    clock_gettime(CLOCK_MONOTONIC, &deadline);
+    deadline.tv_sec += ticks / configTICK_RATE_HZ;
+    deadline.tv_nsec += (long)(ticks % configTICK_RATE_HZ) * (1000000000L / configTICK_RATE_HZ);
+    if (deadline.tv_nsec >= 1000000000L) {
+        deadline.tv_sec += 1;
+        deadline.tv_nsec -= 1000000000L;
+    }
+    return deadline;
+}
+
+// Waits on `cond` until `ready` returns true or the ticks elapse. Called
+// with `mutex` held.
+static bool wait_until(pthread_cond_t *cond, pthread_mutex_t *mutex, TickType_t ticks,
+                       bool (*ready)(void *), void *context) {
+    struct timespec deadline = deadline_after(ticks);
+    while (!ready(context)) {
+        if (ticks == 0) {
+            return false;
+        }
+        if (ticks == portMAX_DELAY) {
+            pthread_cond_wait(cond, mutex);
+        } else if (pthread_cond_timedwait(cond, mutex, &deadline) == ETIMEDOUT) {
+            return ready(context);
+        }
+    }
+    return true;
+}
+
+BaseType_t xPortGetCoreID(void) {
+    return current_task != NULL ? current_task->core_id : 0;
+}
+
+static void *task_entry(void *arg) {
+    current_task = (struct host_task *)arg;
+    current_task->function(current_task->param);
+    return NULL;
+}
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t function, const char *name,
+                                   uint32_t stack_depth, void *param, UBaseType_t priority,
+                                   TaskHandle_t *handle, BaseType_t core_id) {
+    (void)stack_depth;
+    (void)priority;
+    struct host_task *task = calloc(1, sizeof(*task));
+    if (task == NULL) {
+        return pdFAIL;
+    }
+    task->function = function;
+    task->param = param;
+    task->core_id = core_id >= 0 && core_id < portNUM_PROCESSORS ? core_id : 0;
+    pthread_mutex_init(&task->mutex, NULL);
+    init_monotonic_cond(&task->cond);
+    if (handle != NULL) {
+        *handle = task;
+    }
+    if (pthread_create(&task->thread, NULL, task_entry, task) != 0) {
+        free(task);
+        return pdFAIL;
+    }
+    pthread_detach(task->thread);
+#ifdef __linux__
+    // Thread names show up in perf and top; Linux caps them at 15 chars
+    char thread_name[16];
+    snprintf(thread_name, sizeof(thread_name), "%s", name);
+    pthread_setname_np(task->thread, thread_name);
+#else
+    (void)name;
+#endif
+    return pdPASS;
+}
+
+BaseType_t xTaskCreate(TaskFunction_t function, const char *name, uint32_t stack_depth,
+                       void *param, UBaseType_t priority, TaskHandle_t *handle) {
+    return xTaskCreatePinnedToCore(function, name, stack_depth, param, priority, handle, 0);
+}
+
+void vTaskDelete(TaskHandle_t task) {
+    if (task == NULL || task == current_task) {
+        pthread_exit(NULL);
+    }
+    pthread_cancel(task->thread);
+}
+
+void vTaskDelay(TickType_t ticks) {
+    struct timespec delay = {
+        .tv_sec = ticks / configTICK_RATE_HZ,
+        .tv_nsec = (long)(ticks % configTICK_RATE_HZ) * (1000000000L / configTICK_RATE_HZ),
+    };
+    while (nanosleep(&delay, &delay) != 0 && errno == EINTR) {
+    }
+}
+
+TickType_t xTaskGetTickCount(void) {
+    return (TickType_t)(esp_timer_get_time() / (1000000 / configTICK_RATE_HZ));
+}
+
+void xTaskNotifyGive(TaskHandle_t task) {
+    pthread_mutex_lock(&task->mutex);
+    ++task->notify_count;
+    pthread_cond_signal(&task->cond);
+    pthread_mutex_unlock(&task->mutex);
+}
+
+static bool task_notified(void *context) {
+    return ((struct host_task *)context)->notify_count > 0;
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clear_on_exit, TickType_t ticks) {
+    struct host_task *task = current_task;
+    if (task == NULL) {
+        return 0;
+    }
+    pthread_mutex_lock(&task->mutex);
+    wait_until(&task->cond, &task->mutex, ticks, task_notified, task);
+    uint32_t count = task->notify_count;
+    if (count > 0) {
+        task->notify_count = clear_on_exit ? 0 : count - 1;
+    }
+    pthread_mutex_unlock(&task->mutex);
+    return count;
+}
+
+static SemaphoreHandle_t create_semaphore(host_semaphore_kind_t kind, unsigned int count) {
+    struct host_semaphore *semaphore = calloc(1, sizeof(*semaphore));
+    if (semaphore == NULL) {
+        return NULL;
+    }
+    semaphore->kind = kind;
+    semaphore->count = count;
+    pthread_mutexattr_t attributes;
+    pthread_mutexattr_init(&attributes);
+    if (kind == HOST_SEMAPHORE_RECURSIVE) {
+        pthread_mutexattr_settype(&attributes, PTHREAD_MUTEX_RECURSIVE);
+    }
+    pthread_mutex_init(&semaphore->mutex, &attributes);
+    pthread_mutexattr_destroy(&attributes);
+    init_monotonic_cond(&semaphore->cond);
+    return semaphore;
+}
+
+SemaphoreHandle_t xSemaphoreCreateBinary(void) {
+    return create_semaphore(HOST_SEMAPHORE_BINARY, 0);
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void) {
+    return create_semaphore(HOST_SEMAPHORE_MUTEX, 1);
+}
+
+SemaphoreHandle_t xSemaphoreCreateRecursiveMutex(void) {
+    return create_semaphore(HOST_SEMAPHORE_RECURSIVE, 0);
+}
+
+static bool semaphore_available(void *context) {
+    return ((struct host_semaphore *)context)->count > 0;
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t semaphore, TickType_t ticks) {
+    pthread_mutex_lock(&semaphore->mutex);
+    bool taken = wait_until(&semaphore->cond, &semaphore->mutex, ticks, semaphore_available,
+                            semaphore);
+    if (taken) {
+        --semaphore->count;
+    }
+    pthread_mutex_unlock(&semaphore->mutex);
+    return taken ? pdTRUE : pdFALSE;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t semaphore) {
+    pthread_mutex_lock(&semaphore->mutex);
+    // Binary semaphores and mutexes both hold at most one token
+    bool given = semaphore->count == 0;
+    semaphore->count = 1;
+    pthread_cond_signal(&semaphore->cond);
+    pthread_mutex_unlock(&semaphore->mutex);
+    return given ? pdTRUE : pdFALSE;
+}
+
+// Recursive mutexes map straight onto a recursive pthread mutex; the
+// timeout is always treated as portMAX_DELAY, which is all rx_task uses.
+BaseType_t xSemaphoreTakeRecursive(SemaphoreHandle_t mutex, TickType_t ticks) {
+    (void)ticks;
+    return pthread_mutex_lock(&mutex->mutex) == 0 ? pdTRUE : pdFALSE;
+}
+
+BaseType_t xSemaphoreGiveRecursive(SemaphoreHandle_t mutex) {
+    return pthread_mutex_unlock(&mutex->mutex) == 0 ? pdTRUE : pdFALSE;
+}
+
+EventGroupHandle_t xEventGroupCreate(void) {
+    struct host_event_group *group = calloc(1, sizeof(*group));
+    if (group == NULL) {
+        return NULL;
+    }
+    pthread_mutex_init(&group->mutex, NULL);
+    init_monotonic_cond(&group->cond);
+    return group;
+}
+
+EventBits_t xEventGroupSetBits(EventGroupHandle_t group, EventBits_t bits) {
+    pthread_mutex_lock(&group->mutex);
+    group->bits |= bits;
+    EventBits_t result = group->bits;
+    pthread_cond_broadcast(&group->cond);
+    pthread_mutex_unlock(&group->mutex);
+    return result;
+}
+
+EventBits_t xEventGroupClearBits(EventGroupHandle_t group, EventBits_t bits) {
+    pthread_mutex_lock(&group->mutex);
+    EventBits_t previous = group->bits;
+    group->bits &= ~bits;
+    pthread_mutex_unlock(&group->mutex);
+    return previous;
+}
+
+typedef struct {
+    struct host_event_group *group;
+    EventBits_t bits;
+    bool wait_for_all;
+} event_wait_t;
+
+static bool event_bits_ready(void *context) {
+    const event_wait_t *wait = context;
+    EventBits_t set = wait->group->bits & wait->bits;
+    return wait->wait_for_all ? set == wait->bits : set != 0;
+}
+
+EventBits_t xEventGroupWaitBits(EventGroupHandle_t group, EventBits_t bits,
+                                BaseType_t clear_on_exit, BaseType_t wait_for_all,
+                                TickType_t ticks) {
+    event_wait_t wait = {.group = group, .bits = bits, .wait_for_all = wait_for_all};
+    pthread_mutex_lock(&group->mutex);
+    bool ready = wait_until(&group->cond, &group->mutex, ticks, event_bits_ready, &wait);
+    EventBits_t result = group->bits;
+    if (ready && clear_on_exit) {
+        group->bits &= ~bits;
+    }
+    pthread_mutex_unlock(&group->mutex);
+    return result;
+}
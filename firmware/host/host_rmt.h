@@ -0,0 +1,38 @@
+#pragma once
+
+#include "driver/rmt_types.h"
+
+// Recording side of the host RMT stub. rmt_transmit runs the channel's
+// encoder exactly as the driver would, refilling mem_block_symbols at a time,
+// keeps the resulting symbol stream and holds the channel busy for the
+// stream's wire time, so rmt_tx_wait_all_done blocks as long as real strips
+// would. Encoders keep state across refills, so rmt_transmit fails with
+// ESP_ERR_INVALID_STATE when an encoder is handed to a second channel while
+// its stream on the first is still on the wire.
+
+#define HOST_RMT_MAX_CHANNELS 8
+
+// Called from rmt_transmit with the channel's full symbol stream for one
+// transmission and the esp_timer time it starts on the wire. Runs on the
+// transmitting task and must not block.
+typedef void (*host_rmt_observer_fn)(unsigned int channel, const rmt_symbol_word_t *symbols,
+                                     size_t symbol_count, int64_t start_us, void *arg);
+void host_rmt_set_observer(host_rmt_observer_fn observer, void *arg);
+
+// Channels in creation order, which is run order for driver_task.
+unsigned int host_rmt_channel_count(void);
+uint32_t host_rmt_transmit_count(unsigned int channel);
+// rmt_tx_wait_all_done calls made on the channel so far.
+uint32_t host_rmt_wait_count(unsigned int channel);
+// Makes the channel's next `count` rmt_tx_wait_all_done calls wait out their
+// timeout and return ESP_ERR_TIMEOUT, as a stalled channel would;
+// host_rmt_injected_timeouts reports how many are still to fail.
+void host_rmt_inject_timeouts(unsigned int channel, unsigned int count);
+unsigned int host_rmt_injected_timeouts(unsigned int channel);
+// Copies the most recent transmission; returns its full symbol count even
+// when `capacity` truncates the copy.
+size_t host_rmt_copy_last_symbols(unsigned int channel, rmt_symbol_word_t *symbols,
+                                  size_t capacity);
+// 0 completes transmissions immediately instead of after their wire time,
+// for load tests that only care about the receive path.
+void host_rmt_set_wire_timing(int enabled);
@@ -0,0 +1,18 @@
+#pragma once
+
+#include "driver/rmt_types.h"
+#include "esp_err.h"
+
+typedef size_t (*rmt_encode_simple_cb_t)(const void *data, size_t data_size,
+                                         size_t symbols_written, size_t symbols_free,
+                                         rmt_symbol_word_t *symbols, bool *done, void *arg);
+
+typedef struct {
+    rmt_encode_simple_cb_t callback;
+    void *arg;
+    size_t min_chunk_size;
+} rmt_simple_encoder_config_t;
+
+esp_err_t rmt_new_simple_encoder(const rmt_simple_encoder_config_t *config,
+                                 rmt_encoder_handle_t *ret_encoder);
+esp_err_t rmt_del_encoder(rmt_encoder_handle_t encoder);
@@ -0,0 +1,34 @@
+#pragma once
+
+#include "driver/rmt_encoder.h"
+#include "driver/rmt_types.h"
+#include "esp_err.h"
+
+typedef struct {
+    gpio_num_t gpio_num;
+    rmt_clock_source_t clk_src;
+    uint32_t resolution_hz;
+    size_t mem_block_symbols;
+    size_t trans_queue_depth;
+} rmt_tx_channel_config_t;
+
+typedef struct {
+    int loop_count;
+} rmt_transmit_config_t;
+
+typedef struct {
+    const rmt_channel_handle_t *tx_channel_array;
+    size_t array_size;
+} rmt_sync_manager_config_t;
+
+esp_err_t rmt_new_tx_channel(const rmt_tx_channel_config_t *config,
+                             rmt_channel_handle_t *ret_channel);
+esp_err_t rmt_enable(rmt_channel_handle_t channel);
+esp_err_t rmt_transmit(rmt_channel_handle_t channel, rmt_encoder_handle_t encoder,
+                       const void *payload, size_t payload_bytes,
+                       const rmt_transmit_config_t *config);
+// timeout_ms of -1 waits forever.
+esp_err_t rmt_tx_wait_all_done(rmt_channel_handle_t channel, int timeout_ms);
+esp_err_t rmt_new_sync_manager(const rmt_sync_manager_config_t *config,
+                               rmt_sync_manager_handle_t *ret_synchro);
+esp_err_t rmt_sync_reset(rmt_sync_manager_handle_t synchro);
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+typedef int gpio_num_t;
+
+typedef union {
+    struct {
+        uint16_t duration0 : 15;
+        uint16_t level0 : 1;
+        uint16_t duration1 : 15;
+        uint16_t level1 : 1;
+    };
+    uint32_t val;
+} rmt_symbol_word_t;
+
+typedef struct host_rmt_channel *rmt_channel_handle_t;
+typedef struct host_rmt_encoder *rmt_encoder_handle_t;
+typedef struct host_rmt_sync_manager *rmt_sync_manager_handle_t;
+
+typedef enum {
+    RMT_CLK_SRC_DEFAULT,
+} rmt_clock_source_t;
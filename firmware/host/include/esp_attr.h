@@ -0,0 +1,6 @@
+#pragma once
+
+// Host memory is uniform, so placement attributes only keep their alignment.
+#define WORD_ALIGNED_ATTR __attribute__((aligned(4)))
+#define DRAM_ATTR
+#define DMA_ATTR WORD_ALIGNED_ATTR DRAM_ATTR
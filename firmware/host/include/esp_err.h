@@ -0,0 +1,25 @@
+#pragma once
+
+#include <stdio.h>
+#include <stdlib.h>
+
+typedef int esp_err_t;
+
+#define ESP_OK 0
+#define ESP_FAIL -1
+#define ESP_ERR_NO_MEM 0x101
+#define ESP_ERR_INVALID_ARG 0x102
+#define ESP_ERR_INVALID_STATE 0x103
+#define ESP_ERR_TIMEOUT 0x107
+
+const char *esp_err_to_name(esp_err_t code);
+
+#define ESP_ERROR_CHECK(x)                                                          \
+    do {                                                                            \
+        esp_err_t esp_error_check_rc = (x);                                         \
+        if (esp_error_check_rc != ESP_OK) {                                         \
+            fprintf(stderr, "ESP_ERROR_CHECK failed: %s at %s:%d (%s)\n",           \
+                    esp_err_to_name(esp_error_check_rc), __FILE__, __LINE__, #x);   \
+            abort();                                                                \
+        }                                                                           \
+    } while (0)
@@ -0,0 +1,5 @@
+#pragma once
+
+// The host shims follow the ESP-IDF 5.3 driver APIs.
+#define ESP_IDF_VERSION_VAL(major, minor, patch) (((major) << 16) | ((minor) << 8) | (patch))
+#define ESP_IDF_VERSION ESP_IDF_VERSION_VAL(5, 3, 0)
@@ -0,0 +1,16 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+
+// Milliseconds since start, matching the ESP-IDF log prefix.
+uint32_t esp_log_timestamp(void);
+
+#define HOST_LOG(letter, tag, format, ...) \
+    fprintf(stderr, letter " (%u) %s: " format "\n", (unsigned int)esp_log_timestamp(), tag, ##__VA_ARGS__)
+
+#define ESP_LOGE(tag, format, ...) HOST_LOG("E", tag, format, ##__VA_ARGS__)
+#define ESP_LOGW(tag, format, ...) HOST_LOG("W", tag, format, ##__VA_ARGS__)
+#define ESP_LOGI(tag, format, ...) HOST_LOG("I", tag, format, ##__VA_ARGS__)
+#define ESP_LOGD(tag, format, ...) do { (void)(tag); } while (0)
+#define ESP_LOGV(tag, format, ...) do { (void)(tag); } while (0)
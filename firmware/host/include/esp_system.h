@@ -0,0 +1,4 @@
+#pragma once
+
+// Ends the process; a supervisor (or the developer) restarts it.
+void esp_restart(void) __attribute__((noreturn));
@@ -0,0 +1,27 @@
+#pragma once
+
+// Host stand-in for the ESP-IDF FreeRTOS port: tasks are pthreads and one
+// tick is one millisecond of CLOCK_MONOTONIC.
+
+#include <stdint.h>
+
+typedef uint32_t TickType_t;
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+
+#define pdFALSE 0
+#define pdTRUE 1
+#define pdPASS pdTRUE
+#define pdFAIL pdFALSE
+#define portMAX_DELAY ((TickType_t)0xFFFFFFFFu)
+#define configTICK_RATE_HZ 1000
+#define pdMS_TO_TICKS(ms) ((TickType_t)(ms))
+#define portNUM_PROCESSORS 2
+
+#define BIT0 0x00000001u
+#define BIT1 0x00000002u
+#define BIT2 0x00000004u
+#define BIT3 0x00000008u
+
+// Core the calling task was pinned to; unpinned tasks report core 0.
+BaseType_t xPortGetCoreID(void);
@@ -0,0 +1,9 @@
+#pragma once
+
+// lwIP's BSD socket API maps one to one onto the host's.
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <unistd.h>
@@ -0,0 +1,5 @@
+#pragma once
+
+// ESP32 RMT capabilities
+#define SOC_RMT_CHANNELS_PER_GROUP 8
+#define SOC_RMT_SUPPORT_TX_SYNCHRO 1
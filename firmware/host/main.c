@@ -0,0 +1,104 @@
+// Runs the firmware pipeline as a Linux process: app_main starts the same
+// tasks as on target, on top of the pthread/POSIX/RMT shims.
+#include "config_autogen.h"
+#include "host_rmt.h"
+#include "metrics.h"
+#include "rx_task.h"
+#include "virtual_strip.h"
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+void app_main(void);
+
+// One virtual strip per run checks and decodes everything driver_task sends.
+// Only the driver task transmits, so the observer needs no locking.
+static virtual_strip_t strips[RUN_COUNT];
+static bool strips_attached;
+
+static void feed_strip(unsigned int channel, const rmt_symbol_word_t *symbols,
+                       size_t symbol_count, int64_t start_us, void *arg)
+{
+    (void)arg;
+    if (channel < RUN_COUNT) {
+        virtual_strip_feed(&strips[channel], symbols, symbol_count, start_us);
+    }
+}
+
+static void usage(const char *program)
+{
+    fprintf(stderr,
+            "usage: %s [--seconds N] [--no-wire-timing]\n"
+            "  --seconds N        exit after N seconds and print counters (default: run forever)\n"
+            "  --no-wire-timing   complete RMT transmissions immediately; disables the\n"
+            "                     virtual strips, whose latch-gap check needs wire time\n",
+            program);
+}
+
+static void print_counters(void)
+{
+    metrics_snapshot_t snapshot;
+    metrics_snapshot(&snapshot);
+    for (unsigned int id = 0; id < METRIC_RUN_RX; ++id) {
+        printf("%s %u\n", metrics_name((metric_id_t)id), (unsigned int)snapshot.value[id]);
+    }
+    for (unsigned int run = 0; run < RUN_COUNT; ++run) {
+        printf("run%u transmits %u\n", run, (unsigned int)host_rmt_transmit_count(run));
+        if (strips_attached) {
+            const virtual_strip_stats_t *stats = &strips[run].stats;
+            printf("run%u strip frames %u timing_errors %u length_errors %u reset_errors %u "
+                   "wire_us %u\n",
+                   run, (unsigned int)stats->frames, (unsigned int)stats->timing_errors,
+                   (unsigned int)stats->length_errors, (unsigned int)stats->reset_errors,
+                   (unsigned int)stats->max_wire_us);
+        }
+    }
+    if (strips_attached) {
+        printf("fps_ceiling %.1f\n", virtual_strip_fps_ceiling(strips, RUN_COUNT));
+    }
+}
+
+int main(int argc, char **argv)
+{
+    unsigned int seconds = 0;
+    bool wire_timing = true;
+    for (int index = 1; index < argc; ++index) {
+        if (strcmp(argv[index], "--seconds") == 0 && index + 1 < argc) {
+            seconds = (unsigned int)strtoul(argv[++index], NULL, 10);
+        } else if (strcmp(argv[index], "--no-wire-timing") == 0) {
+            wire_timing = false;
+        } else {
+            usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    host_rmt_set_wire_timing(wire_timing);
+    if (wire_timing) {
+        for (unsigned int run = 0; run < RUN_COUNT; ++run) {
+            if (!virtual_strip_init(&strips[run], LED_COUNT[run], RMT_RESOLUTION_HZ)) {
+                return EXIT_FAILURE;
+            }
+        }
+        host_rmt_set_observer(feed_strip, NULL);
+        strips_attached = true;
+    }
+
+    printf("firmware_host: runs on UDP %u..%u, extended on %u, heartbeat to 127.0.0.1:%u\n",
+           PORT_BASE, PORT_BASE + RUN_COUNT, rx_task_socket_port(RX_EXTENDED_SOCKET_INDEX),
+           STATUS_PORT);
+    fflush(stdout);
+    app_main();
+
+    if (seconds == 0) {
+        for (;;) {
+            pause();
+        }
+    }
+    sleep(seconds);
+    print_counters();
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,19 @@
+// Host replacement for net_task.c: the host's own network stack is already
+// up, so the ready bit is raised immediately and sockets bind to every
+// local interface, loopback included.
+#include "net_task.h"
+
+#include "event_log.h"
+
+#include "esp_log.h"
+
+static const char *LOG_TAG = "net_task";
+
+EventGroupHandle_t net_task_start(void)
+{
+    EventGroupHandle_t network_event_group = xEventGroupCreate();
+    event_log_post(EVENT_LINK_UP, 0);
+    xEventGroupSetBits(network_event_group, NETWORK_READY_BIT);
+    ESP_LOGI(LOG_TAG, "Network ready (host)");
+    return network_event_group;
+}
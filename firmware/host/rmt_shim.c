@@ -0,0 +1,301 @@
+// Recording stand-in for the ESP-IDF RMT TX driver.
+#include "driver/rmt_tx.h"
+#include "host_rmt.h"
+
+#include "esp_rom_sys.h"
+#include "esp_timer.h"
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+struct host_rmt_channel {
+    unsigned int index;
+    gpio_num_t gpio;
+    uint32_t resolution_hz;
+    size_t mem_block_symbols;
+    bool enabled;
+    int64_t busy_until_us;
+    // Symbol stream of the latest transmission, guarded by `mutex`
+    pthread_mutex_t mutex;
+    rmt_symbol_word_t *symbols;
+    size_t symbol_count;
+    size_t symbol_capacity;
+    atomic_uint transmit_count;
+    atomic_uint wait_count;
+    // rmt_tx_wait_all_done calls still to fail, see host_rmt_inject_timeouts
+    atomic_uint injected_timeouts;
+};
+
+// An encoder keeps its position between refills, so it belongs to the
+// channel transmitting through it until that transmission has left the wire.
+struct host_rmt_encoder {
+    rmt_simple_encoder_config_t config;
+    const struct host_rmt_channel *channel;
+    int64_t busy_until_us;
+};
+
+struct host_rmt_sync_manager {
+    size_t channel_count;
+};
+
+static struct host_rmt_channel *channels[HOST_RMT_MAX_CHANNELS];
+static atomic_uint channel_count;
+static host_rmt_observer_fn observer;
+static void *observer_arg;
+static atomic_int wire_timing = 1;
+static pthread_mutex_t encoders_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+esp_err_t rmt_new_tx_channel(const rmt_tx_channel_config_t *config,
+                             rmt_channel_handle_t *ret_channel) {
+    if (config == NULL || ret_channel == NULL || config->resolution_hz == 0 ||
+        config->mem_block_symbols == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    unsigned int index = atomic_fetch_add(&channel_count, 1);
+    if (index >= HOST_RMT_MAX_CHANNELS) {
+        atomic_fetch_sub(&channel_count, 1);
+        return ESP_ERR_NO_MEM;
+    }
+    struct host_rmt_channel *channel = calloc(1, sizeof(*channel));
+    if (channel == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    channel->index = index;
+    channel->gpio = config->gpio_num;
+    channel->resolution_hz = config->resolution_hz;
+    channel->mem_block_symbols = config->mem_block_symbols;
+    pthread_mutex_init(&channel->mutex, NULL);
+    channels[index] = channel;
+    *ret_channel = channel;
+    return ESP_OK;
+}
+
+esp_err_t rmt_enable(rmt_channel_handle_t channel) {
+    if (channel == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    channel->enabled = true;
+    return ESP_OK;
+}
+
+esp_err_t rmt_new_simple_encoder(const rmt_simple_encoder_config_t *config,
+                                 rmt_encoder_handle_t *ret_encoder) {
+    if (config == NULL || config->callback == NULL || ret_encoder == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    struct host_rmt_encoder *encoder = calloc(1, sizeof(*encoder));
+    if (encoder == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    encoder->config = *config;
+    *ret_encoder = encoder;
+    return ESP_OK;
+}
+
+esp_err_t rmt_del_encoder(rmt_encoder_handle_t encoder) {
+    free(encoder);
+    return ESP_OK;
+}
+
+static bool reserve_symbols(struct host_rmt_channel *channel, size_t capacity) {
+    if (capacity <= channel->symbol_capacity) {
+        return true;
+    }
+    size_t grown = channel->symbol_capacity > 0 ? channel->symbol_capacity * 2 : 1024;
+    while (grown < capacity) {
+        grown *= 2;
+    }
+    rmt_symbol_word_t *symbols = realloc(channel->symbols, grown * sizeof(*symbols));
+    if (symbols == NULL) {
+        return false;
+    }
+    channel->symbols = symbols;
+    channel->symbol_capacity = grown;
+    return true;
+}
+
+static int64_t wire_time_us(const struct host_rmt_channel *channel) {
+    uint64_t ticks = 0;
+    for (size_t index = 0; index < channel->symbol_count; ++index) {
+        ticks += channel->symbols[index].duration0 + channel->symbols[index].duration1;
+    }
+    return (int64_t)(ticks * 1000000u / channel->resolution_hz);
+}
+
+// Waits for the previous transmission, as a queue depth of one would.
+static void wait_idle(const struct host_rmt_channel *channel) {
+    int64_t remaining_us = channel->busy_until_us - esp_timer_get_time();
+    if (remaining_us > 0) {
+        esp_rom_delay_us((uint32_t)remaining_us);
+    }
+}
+
+// Fails when another channel's transmission through `encoder` is still in
+// flight; the real driver would interleave both streams through its state.
+static bool claim_encoder(struct host_rmt_encoder *encoder,
+                          const struct host_rmt_channel *channel) {
+    pthread_mutex_lock(&encoders_mutex);
+    bool shared = encoder->channel != NULL && encoder->channel != channel &&
+                  encoder->busy_until_us > esp_timer_get_time();
+    if (!shared) {
+        encoder->channel = channel;
+        encoder->busy_until_us = INT64_MAX;
+    }
+    pthread_mutex_unlock(&encoders_mutex);
+    return !shared;
+}
+
+// The encoder stays claimed until the channel's stream leaves the wire.
+static void release_encoder(struct host_rmt_encoder *encoder) {
+    pthread_mutex_lock(&encoders_mutex);
+    encoder->busy_until_us = encoder->channel->busy_until_us;
+    pthread_mutex_unlock(&encoders_mutex);
+}
+
+esp_err_t rmt_transmit(rmt_channel_handle_t channel, rmt_encoder_handle_t encoder,
+                       const void *payload, size_t payload_bytes,
+                       const rmt_transmit_config_t *config) {
+    if (channel == NULL || encoder == NULL || config == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (!channel->enabled) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    wait_idle(channel);
+    if (!claim_encoder(encoder, channel)) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    pthread_mutex_lock(&channel->mutex);
+    channel->symbol_count = 0;
+    bool done = false;
+    while (!done) {
+        // The driver refills channel memory one block at a time
+        if (!reserve_symbols(channel, channel->symbol_count + channel->mem_block_symbols)) {
+            pthread_mutex_unlock(&channel->mutex);
+            release_encoder(encoder);
+            return ESP_ERR_NO_MEM;
+        }
+        size_t written = encoder->config.callback(payload, payload_bytes, channel->symbol_count,
+                                                  channel->mem_block_symbols,
+                                                  channel->symbols + channel->symbol_count,
+                                                  &done, encoder->config.arg);
+        if (written == 0 && !done) {
+            // The real driver would stall here forever
+            pthread_mutex_unlock(&channel->mutex);
+            release_encoder(encoder);
+            return ESP_FAIL;
+        }
+        channel->symbol_count += written;
+    }
+    int64_t now_us = esp_timer_get_time();
+    channel->busy_until_us = atomic_load(&wire_timing) ? now_us + wire_time_us(channel) : now_us;
+    release_encoder(encoder);
+    if (observer != NULL) {
+        observer(channel->index, channel->symbols, channel->symbol_count, now_us, observer_arg);
+    }
+    pthread_mutex_unlock(&channel->mutex);
+    atomic_fetch_add(&channel->transmit_count, 1);
+    return ESP_OK;
+}
+
+esp_err_t rmt_tx_wait_all_done(rmt_channel_handle_t channel, int timeout_ms) {
+    if (channel == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    atomic_fetch_add(&channel->wait_count, 1);
+    unsigned int injected = atomic_load(&channel->injected_timeouts);
+    while (injected > 0 &&
+           !atomic_compare_exchange_weak(&channel->injected_timeouts, &injected, injected - 1)) {
+    }
+    if (injected > 0) {
+        esp_rom_delay_us(timeout_ms >= 0 ? (uint32_t)timeout_ms * 1000u : 0);
+        return ESP_ERR_TIMEOUT;
+    }
+    int64_t remaining_us = channel->busy_until_us - esp_timer_get_time();
+    if (remaining_us <= 0) {
+        return ESP_OK;
+    }
+    if (timeout_ms >= 0 && remaining_us > (int64_t)timeout_ms * 1000) {
+        esp_rom_delay_us((uint32_t)timeout_ms * 1000u);
+        return ESP_ERR_TIMEOUT;
+    }
+    esp_rom_delay_us((uint32_t)remaining_us);
+    return ESP_OK;
+}
+
+esp_err_t rmt_new_sync_manager(const rmt_sync_manager_config_t *config,
+                               rmt_sync_manager_handle_t *ret_synchro) {
+    if (config == NULL || ret_synchro == NULL || config->array_size == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    struct host_rmt_sync_manager *synchro = calloc(1, sizeof(*synchro));
+    if (synchro == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    synchro->channel_count = config->array_size;
+    *ret_synchro = synchro;
+    return ESP_OK;
+}
+
+// Channels already start as soon as they are queued, so synchronised
+// starts need no extra bookkeeping.
+esp_err_t rmt_sync_reset(rmt_sync_manager_handle_t synchro) {
+    return synchro != NULL ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+void host_rmt_set_observer(host_rmt_observer_fn fn, void *arg) {
+    observer_arg = arg;
+    observer = fn;
+}
+
+unsigned int host_rmt_channel_count(void) {
+    return atomic_load(&channel_count);
+}
+
+uint32_t host_rmt_transmit_count(unsigned int channel) {
+    if (channel >= host_rmt_channel_count() || channels[channel] == NULL) {
+        return 0;
+    }
+    return atomic_load(&channels[channel]->transmit_count);
+}
+
+size_t host_rmt_copy_last_symbols(unsigned int channel, rmt_symbol_word_t *symbols,
+                                  size_t capacity) {
+    if (channel >= host_rmt_channel_count() || channels[channel] == NULL) {
+        return 0;
+    }
+    struct host_rmt_channel *source = channels[channel];
+    pthread_mutex_lock(&source->mutex);
+    size_t count = source->symbol_count;
+    memcpy(symbols, source->symbols, (count < capacity ? count : capacity) * sizeof(*symbols));
+    pthread_mutex_unlock(&source->mutex);
+    return count;
+}
+
+void host_rmt_set_wire_timing(int enabled) {
+    atomic_store(&wire_timing, enabled != 0);
+}
+
+uint32_t host_rmt_wait_count(unsigned int channel) {
+    if (channel >= host_rmt_channel_count() || channels[channel] == NULL) {
+        return 0;
+    }
+    return atomic_load(&channels[channel]->wait_count);
+}
+
+void host_rmt_inject_timeouts(unsigned int channel, unsigned int count) {
+    if (channel < host_rmt_channel_count() && channels[channel] != NULL) {
+        atomic_store(&channels[channel]->injected_timeouts, count);
+    }
+}
+
+unsigned int host_rmt_injected_timeouts(unsigned int channel) {
+    if (channel >= host_rmt_channel_count() || channels[channel] == NULL) {
+        return 0;
+    }
+    return atomic_load(&channels[channel]->injected_timeouts);
+}
@@ -0,0 +1,167 @@
+#include "rx_replay.h"
+
+#include "config_autogen.h"
+#include "latency_stats.h"
+#include "metrics.h"
+#include "rx_task.h"
+
+#include <string.h>
+#include <time.h>
+
+_Static_assert(RX_CAPTURE_ENTRIES > 0, "replay reads outcomes back from the capture ring");
+
+#define HEADER_BYTES 4
+// One byte past the longest valid datagram, so oversized captures still
+// fail the length check after truncation
+#define PACKET_BYTES (HEADER_BYTES + MAX_RUN_LED_COUNT * 3 + 1)
+
+static const char *const OUTCOME_NAMES[RX_CAPTURE_OUTCOME_COUNT] = {
+    "accepted", "len", "run", "stale", "window", "pool", "base",
+};
+
+static uint64_t replay_now_us;
+
+static uint64_t replay_clock(void)
+{
+    return replay_now_us;
+}
+
+static uint64_t now_ns(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000u + (uint64_t)now.tv_nsec;
+}
+
+static void sleep_until_ns(uint64_t deadline_ns)
+{
+    struct timespec deadline = {
+        .tv_sec = (time_t)(deadline_ns / 1000000000u),
+        .tv_nsec = (long)(deadline_ns % 1000000000u),
+    };
+    clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, NULL);
+}
+
+const char *rx_replay_outcome_name(rx_capture_outcome_t outcome)
+{
+    return (unsigned int)outcome < RX_CAPTURE_OUTCOME_COUNT ? OUTCOME_NAMES[outcome] : "?";
+}
+
+bool rx_replay_layout_matches(const rx_capture_header_t *header)
+{
+    if (header->run_count != RUN_COUNT) {
+        return false;
+    }
+    for (unsigned int run = 0; run < RUN_COUNT; ++run) {
+        if (header->led_count[run] != LED_COUNT[run]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Length to feed for an entry: pool drops drained unread record 0
+static size_t replay_length(const rx_capture_entry_t *entry)
+{
+    size_t length = entry->length;
+    if (length == 0 && entry->run < RUN_COUNT) {
+        length = HEADER_BYTES + LED_COUNT[entry->run] * 3;
+    }
+    return length < PACKET_BYTES ? length : PACKET_BYTES;
+}
+
+static rx_capture_outcome_t replayed_outcome(void)
+{
+    rx_capture_entry_t latest = {0};
+    size_t count = rx_capture_count();
+    if (count > 0) {
+        rx_capture_read(count - 1, &latest, 1);
+    }
+    return (rx_capture_outcome_t)latest.outcome;
+}
+
+void rx_replay_run(const rx_capture_entry_t *entries, size_t entry_count,
+                   const rx_replay_options_t *options, rx_replay_result_t *result)
+{
+    memset(result, 0, sizeof(*result));
+    if (entry_count == 0) {
+        return;
+    }
+    static uint8_t packet[PACKET_BYTES];
+    for (size_t byte = HEADER_BYTES; byte < sizeof(packet); ++byte) {
+        packet[byte] = (uint8_t)byte;
+    }
+
+    // Each pass after the first starts past every frame_id and timestamp of
+    // the previous one
+    const uint32_t first_id = entries[0].frame_id;
+    const uint64_t first_us = entries[0].arrival_us;
+    int32_t newest_offset = 0;
+    uint64_t last_us = first_us;
+    for (size_t index = 0; index < entry_count; ++index) {
+        int32_t offset = (int32_t)(entries[index].frame_id - first_id);
+        if (offset > newest_offset) {
+            newest_offset = offset;
+        }
+        if (entries[index].arrival_us > last_us) {
+            last_us = entries[index].arrival_us;
+        }
+    }
+    const uint32_t pass_ids = (uint32_t)newest_offset + 2 * RX_SLOT_COUNT;
+    const uint64_t pass_us = last_us - first_us + 1000;
+
+    rx_task_start();
+    latency_stats_set_clock(options->realtime ? NULL : replay_clock);
+    metrics_snapshot_t before;
+    metrics_snapshot(&before);
+    unsigned int passes = options->repeat > 0 ? options->repeat : 1;
+    const uint64_t start_ns = now_ns();
+
+    for (unsigned int pass = 0; pass < passes; ++pass) {
+        for (size_t index = 0; index < entry_count; ++index) {
+            const rx_capture_entry_t *entry = &entries[index];
+#if RX_EXTENDED_ENABLED
+            if (entry->run == RX_EXTENDED_SOCKET_INDEX) {
+                result->skipped++;
+                continue;
+            }
+#endif
+            uint64_t offset_us = entry->arrival_us - first_us + pass * pass_us;
+            if (options->realtime) {
+                sleep_until_ns(start_ns + offset_us * 1000u);
+            } else {
+                replay_now_us = first_us + offset_us;
+            }
+            uint32_t frame_id = entry->frame_id + pass * pass_ids;
+            packet[0] = (uint8_t)(frame_id >> 24);
+            packet[1] = (uint8_t)(frame_id >> 16);
+            packet[2] = (uint8_t)(frame_id >> 8);
+            packet[3] = (uint8_t)frame_id;
+            size_t length = replay_length(entry);
+            if (entry->run == RX_PARITY_SOCKET_INDEX) {
+                rx_task_process_parity(packet, length);
+            } else {
+                rx_task_process_packet(entry->run, packet, length);
+            }
+            // Stand-in for driver_task, which takes every frame it is handed
+            rx_task_acquire_frame();
+
+            rx_capture_outcome_t outcome = replayed_outcome();
+            if (entry->outcome < RX_CAPTURE_OUTCOME_COUNT) {
+                result->captured[entry->outcome]++;
+            }
+            result->replayed[outcome]++;
+            if (outcome != entry->outcome) {
+                result->mismatches++;
+            }
+            result->datagrams++;
+            result->bytes += length;
+        }
+    }
+
+    result->elapsed_ns = now_ns() - start_ns;
+    metrics_snapshot_t after;
+    metrics_snapshot(&after);
+    result->frames_completed = after.value[METRIC_COMPLETE] - before.value[METRIC_COMPLETE];
+    latency_stats_set_clock(NULL);
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "rx_capture.h"
+
+// Feeds a capture back through rx_task_process_packet and
+// rx_task_process_parity. Payloads are synthesised, since captures only
+// keep headers; what is reproduced is every accept/drop decision.
+// Extended datagrams cannot be rebuilt from a header (their block layout is
+// not captured), so they are skipped and counted; frames that needed them
+// then replay as incomplete.
+// Requires a UNIT_TEST build of rx_task with RX_CAPTURE_ENTRIES > 0, which
+// is how each replayed outcome is read back.
+
+typedef struct {
+    // Sleep to reproduce the captured inter-arrival times; otherwise run as
+    // fast as possible with the rx clock set to the captured timestamps.
+    bool realtime;
+    // Passes over the capture. Later passes shift frame_ids and timestamps
+    // past the previous pass, so they replay as fresh traffic.
+    unsigned int repeat;
+} rx_replay_options_t;
+
+typedef struct {
+    uint64_t datagrams;
+    uint64_t bytes;
+    uint64_t elapsed_ns;
+    uint32_t frames_completed;
+    uint64_t captured[RX_CAPTURE_OUTCOME_COUNT];
+    uint64_t replayed[RX_CAPTURE_OUTCOME_COUNT];
+    // Entries whose replayed outcome differs from the captured one
+    uint64_t mismatches;
+    // Extended-socket entries left out
+    uint64_t skipped;
+} rx_replay_result_t;
+
+// False when the capture was taken with a different layout than this build.
+bool rx_replay_layout_matches(const rx_capture_header_t *header);
+
+// Restarts rx_task and replays `entries` (oldest first).
+void rx_replay_run(const rx_capture_entry_t *entries, size_t entry_count,
+                   const rx_replay_options_t *options, rx_replay_result_t *result);
+
+const char *rx_replay_outcome_name(rx_capture_outcome_t outcome);
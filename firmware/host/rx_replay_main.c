@@ -0,0 +1,93 @@
+// Replays an rx capture (see rx_capture.h) through rx_task and reports
+// throughput and whether every accept/drop decision was reproduced.
+#include "rx_replay.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static void usage(const char *program)
+{
+    fprintf(stderr,
+            "usage: %s CAPTURE [--realtime] [--repeat N]\n"
+            "  --realtime   keep the captured inter-arrival times (default: as fast as possible)\n"
+            "  --repeat N   replay the capture N times back to back, for benchmarking\n",
+            program);
+}
+
+int main(int argc, char **argv)
+{
+    const char *path = NULL;
+    rx_replay_options_t options = {.repeat = 1};
+    for (int index = 1; index < argc; ++index) {
+        if (strcmp(argv[index], "--realtime") == 0) {
+            options.realtime = true;
+        } else if (strcmp(argv[index], "--repeat") == 0 && index + 1 < argc) {
+            options.repeat = (unsigned int)strtoul(argv[++index], NULL, 10);
+        } else if (path == NULL && argv[index][0] != '-') {
+            path = argv[index];
+        } else {
+            usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+    if (path == NULL) {
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    FILE *file = fopen(path, "rb");
+    if (file == NULL) {
+        perror(path);
+        return EXIT_FAILURE;
+    }
+    uint8_t header_bytes[RX_CAPTURE_HEADER_BYTES];
+    rx_capture_header_t header;
+    if (fread(header_bytes, 1, sizeof(header_bytes), file) != sizeof(header_bytes) ||
+        !rx_capture_decode_header(header_bytes, sizeof(header_bytes), &header)) {
+        fprintf(stderr, "%s: not an rx capture\n", path);
+        fclose(file);
+        return EXIT_FAILURE;
+    }
+    if (!rx_replay_layout_matches(&header)) {
+        fprintf(stderr, "%s: captured with a different layout; regenerate config_autogen.h\n",
+                path);
+        fclose(file);
+        return EXIT_FAILURE;
+    }
+    rx_capture_entry_t *entries = calloc(header.entry_count > 0 ? header.entry_count : 1,
+                                         sizeof(*entries));
+    size_t count = 0;
+    uint8_t entry_bytes[RX_CAPTURE_ENTRY_BYTES];
+    while (count < header.entry_count &&
+           fread(entry_bytes, 1, sizeof(entry_bytes), file) == sizeof(entry_bytes)) {
+        rx_capture_decode_entry(entry_bytes, &entries[count++]);
+    }
+    fclose(file);
+    if (count < header.entry_count) {
+        fprintf(stderr, "%s: truncated, replaying %zu of %u entries\n", path, count,
+                (unsigned int)header.entry_count);
+    }
+    printf("capture: %zu entries, %u overwritten before the oldest\n", count,
+           (unsigned int)header.overwritten);
+
+    rx_replay_result_t result;
+    rx_replay_run(entries, count, &options, &result);
+    free(entries);
+
+    double seconds = result.elapsed_ns / 1e9;
+    printf("replayed %llu datagrams in %.1f ms: %.0f datagrams/s, %.1f MB/s, %u frames completed\n",
+           (unsigned long long)result.datagrams, seconds * 1e3, result.datagrams / seconds,
+           result.bytes / seconds / 1e6, (unsigned int)result.frames_completed);
+    printf("%-10s %10s %10s\n", "outcome", "captured", "replayed");
+    for (unsigned int outcome = 0; outcome < RX_CAPTURE_OUTCOME_COUNT; ++outcome) {
+        printf("%-10s %10llu %10llu\n", rx_replay_outcome_name((rx_capture_outcome_t)outcome),
+               (unsigned long long)result.captured[outcome],
+               (unsigned long long)result.replayed[outcome]);
+    }
+    printf("mismatches %llu\n", (unsigned long long)result.mismatches);
+    if (result.skipped > 0) {
+        printf("skipped %llu extended datagrams\n", (unsigned long long)result.skipped);
+    }
+    return result.mismatches == 0 ? EXIT_SUCCESS : 2;
+}
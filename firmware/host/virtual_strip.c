@@ -0,0 +1,127 @@
+#include "virtual_strip.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+const ws2815_timing_t WS2815_DATASHEET_TIMING = {
+    .t0h_min_ns = 250, .t0h_max_ns = 550,
+    .t0l_min_ns = 700, .t0l_max_ns = 1000,
+    .t1h_min_ns = 650, .t1h_max_ns = 950,
+    .t1l_min_ns = 300, .t1l_max_ns = 600,
+    .reset_min_us = 280,
+};
+
+bool virtual_strip_init(virtual_strip_t *strip, unsigned int led_count, uint32_t resolution_hz)
+{
+    memset(strip, 0, sizeof(*strip));
+    strip->led_count = led_count;
+    strip->resolution_hz = resolution_hz;
+    strip->timing = WS2815_DATASHEET_TIMING;
+    size_t bytes = led_count > 0 ? led_count * 3 : 1;
+    strip->rgb = calloc(bytes, 1);
+    strip->pending = calloc(bytes, 1);
+    if (strip->rgb == NULL || strip->pending == NULL) {
+        virtual_strip_free(strip);
+        return false;
+    }
+    return true;
+}
+
+void virtual_strip_free(virtual_strip_t *strip)
+{
+    free(strip->rgb);
+    free(strip->pending);
+    strip->rgb = NULL;
+    strip->pending = NULL;
+}
+
+static uint32_t ticks_to_ns(const virtual_strip_t *strip, uint32_t ticks)
+{
+    return (uint32_t)((uint64_t)ticks * 1000000000u / strip->resolution_hz);
+}
+
+static bool within(uint32_t value, uint32_t min, uint32_t max)
+{
+    return value >= min && value <= max;
+}
+
+// Returns the bit a symbol carries, or -1 when no window accepts it.
+static int decode_bit(const virtual_strip_t *strip, rmt_symbol_word_t symbol)
+{
+    if (symbol.level0 != 1 || symbol.level1 != 0) {
+        return -1;
+    }
+    const ws2815_timing_t *timing = &strip->timing;
+    uint32_t high_ns = ticks_to_ns(strip, symbol.duration0);
+    uint32_t low_ns = ticks_to_ns(strip, symbol.duration1);
+    if (within(high_ns, timing->t0h_min_ns, timing->t0h_max_ns) &&
+        within(low_ns, timing->t0l_min_ns, timing->t0l_max_ns)) {
+        return 0;
+    }
+    if (within(high_ns, timing->t1h_min_ns, timing->t1h_max_ns) &&
+        within(low_ns, timing->t1l_min_ns, timing->t1l_max_ns)) {
+        return 1;
+    }
+    return -1;
+}
+
+bool virtual_strip_feed(virtual_strip_t *strip, const rmt_symbol_word_t *symbols,
+                        size_t symbol_count, int64_t start_us)
+{
+    uint64_t stream_ticks = 0;
+    for (size_t index = 0; index < symbol_count; ++index) {
+        stream_ticks += symbols[index].duration0 + symbols[index].duration1;
+    }
+    uint64_t stream_ns = stream_ticks * 1000000000u / strip->resolution_hz;
+    uint32_t data_us = (uint32_t)((stream_ns + 999) / 1000);
+    strip->stats.last_wire_us = data_us + strip->timing.reset_min_us;
+    if (strip->stats.last_wire_us > strip->stats.max_wire_us) {
+        strip->stats.max_wire_us = strip->stats.last_wire_us;
+    }
+
+    // Without a long enough low gap the strip never latched the previous
+    // frame, and this stream shifts through to the LEDs past the end
+    bool latched_gap = !strip->has_previous ||
+                       start_us - strip->previous_end_us >= (int64_t)strip->timing.reset_min_us;
+    strip->has_previous = true;
+    strip->previous_end_us = start_us + (int64_t)data_us;
+    if (!latched_gap) {
+        ++strip->stats.reset_errors;
+        return false;
+    }
+    if (symbol_count != (size_t)strip->led_count * WS2815_SYMBOLS_PER_LED) {
+        ++strip->stats.length_errors;
+        return false;
+    }
+
+    // Wire order is GRB, most significant bit first
+    static const unsigned int RGB_FROM_GRB[3] = {1, 0, 2};
+    uint8_t *decoded = strip->pending;
+    for (size_t byte = 0; byte < symbol_count / 8; ++byte) {
+        unsigned int value = 0;
+        for (unsigned int bit = 0; bit < 8; ++bit) {
+            int decoded_bit = decode_bit(strip, symbols[byte * 8 + bit]);
+            if (decoded_bit < 0) {
+                ++strip->stats.timing_errors;
+                return false;
+            }
+            value = value << 1 | (unsigned int)decoded_bit;
+        }
+        decoded[byte - byte % 3 + RGB_FROM_GRB[byte % 3]] = (uint8_t)value;
+    }
+    strip->pending = strip->rgb;
+    strip->rgb = decoded;
+    ++strip->stats.frames;
+    return true;
+}
+
+double virtual_strip_fps_ceiling(const virtual_strip_t *strips, unsigned int strip_count)
+{
+    uint32_t longest_us = 0;
+    for (unsigned int index = 0; index < strip_count; ++index) {
+        if (strips[index].stats.max_wire_us > longest_us) {
+            longest_us = strips[index].stats.max_wire_us;
+        }
+    }
+    return longest_us > 0 ? 1000000.0 / (double)longest_us : 0.0;
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "ws2815_encoder.h"
+
+// Host-side model of a WS2815 strip fed by one RMT channel. It checks every
+// symbol against the datasheet timing windows, decodes the stream back to
+// RGB, and measures on-wire time, so encoder changes can be verified without
+// real strips.
+
+// Datasheet nominal pulse widths with their +-150 ns tolerance, and the
+// minimum low time that latches a frame. Kept apart from the encoder's tick
+// constants so the encoder is checked against the spec, not against itself.
+typedef struct {
+    uint32_t t0h_min_ns, t0h_max_ns;
+    uint32_t t0l_min_ns, t0l_max_ns;
+    uint32_t t1h_min_ns, t1h_max_ns;
+    uint32_t t1l_min_ns, t1l_max_ns;
+    uint32_t reset_min_us;
+} ws2815_timing_t;
+
+extern const ws2815_timing_t WS2815_DATASHEET_TIMING;
+
+typedef struct {
+    uint32_t frames;         // streams latched as complete, valid frames
+    uint32_t timing_errors;  // streams with a symbol outside the windows or with wrong levels
+    uint32_t length_errors;  // streams that were not exactly 24 bits per LED
+    uint32_t reset_errors;   // streams started before the latch gap elapsed
+    uint32_t last_wire_us;   // data plus latch gap of the latest stream
+    uint32_t max_wire_us;
+} virtual_strip_stats_t;
+
+typedef struct {
+    unsigned int led_count;
+    uint32_t resolution_hz;
+    ws2815_timing_t timing;
+    // Pixels of the last latched frame, RGB in LED order
+    uint8_t *rgb;
+    // Decode target, swapped with rgb once a whole stream checks out
+    uint8_t *pending;
+    bool has_previous;
+    int64_t previous_end_us;
+    virtual_strip_stats_t stats;
+} virtual_strip_t;
+
+// Returns false when the pixel buffer cannot be allocated.
+bool virtual_strip_init(virtual_strip_t *strip, unsigned int led_count, uint32_t resolution_hz);
+void virtual_strip_free(virtual_strip_t *strip);
+
+// Consumes one transmission that started on the wire at start_us. Returns
+// true when it latched a valid frame; otherwise the previous pixels stay and
+// the failure is counted. Not thread-safe.
+bool virtual_strip_feed(virtual_strip_t *strip, const rmt_symbol_word_t *symbols,
+                        size_t symbol_count, int64_t start_us);
+
+// Highest frame rate the wire allows when the slowest of `strips` bounds
+// the frame, from their longest measured stream.
+double virtual_strip_fps_ceiling(const virtual_strip_t *strips, unsigned int strip_count);
@@ -2,7 +2,9 @@
 
 #define SIDE_ID 0
 #define RUN_COUNT 3
+#define EXPECTED_MASK 0x7u
 #define TOTAL_LED_COUNT 1041
+#define MAX_RUN_LED_COUNT 379
 #define PORT_BASE 49600
 #define STATUS_PORT 49700
 #define STATIC_IP_ADDR0 10
@@ -19,8 +21,42 @@
 #define STATIC_GW_ADDR3 1
 
 _Static_assert(RUN_COUNT <= 4, "RUN_COUNT exceeds 4");
-_Static_assert(362 <= 400, "LED_COUNT[0] exceeds 400");
-_Static_assert(300 <= 400, "LED_COUNT[1] exceeds 400");
-_Static_assert(379 <= 400, "LED_COUNT[2] exceeds 400");
+_Static_assert(362 <= 1024, "LED_COUNT[0] exceeds 1024");
+_Static_assert(300 <= 1024, "LED_COUNT[1] exceeds 1024");
+_Static_assert(379 <= 1024, "LED_COUNT[2] exceeds 1024");
+
+// Frame arena: every receive, frame and parity buffer of rx_task in one
+// aligned static block. Run r owns FRAME_ARENA_POOL_BUFFERS buffers of
+// RUN_BUFFER_STRIDE[r] bytes starting at RUN_POOL_OFFSET[r].
+#define FRAME_ARENA_ALIGN 4
+#define FRAME_ARENA_SLOT_COUNT 4
+#define FRAME_ARENA_POOL_BUFFERS 8
+#define FRAME_ARENA_PARITY_OFFSET 25152
+#define FRAME_ARENA_PARITY_SLOT_BYTES 1140
+#define FRAME_ARENA_PARITY_RX_OFFSET 29712
+#define FRAME_ARENA_EXTENDED_RX_OFFSET 30856
+#define FRAME_ARENA_BYTES 32332
+
+// Frame budget at TARGET_FPS, checked when this header was generated.
+// Periods are wire time only, in microseconds, a lower bound on the
+// driver loop's period; the network rate counts every run datagram
+// and any parity datagram with their UDP, IP and Ethernet overhead.
+#define TARGET_FPS 60
+#define FRAME_PERIOD_SERIAL_US 32070
+#define FRAME_PERIOD_PARALLEL_US 11650
+#define MAX_DATAGRAM_BYTES 1141
+#define NETWORK_KBPS_AT_TARGET 2180
 
 static const unsigned int LED_COUNT[RUN_COUNT] = {362, 300, 379};
+static const unsigned int RUN_POOL_OFFSET[RUN_COUNT] = {0, 8736, 16000};
+static const unsigned int RUN_BUFFER_STRIDE[RUN_COUNT] = {1092, 908, 1144};
+static const unsigned int RUN_WIRE_US[RUN_COUNT] = {11140, 9280, 11650};
+
+// Sections of each run, in LED order: run r owns RUN_SECTION_COUNT[r]
+// sections from RUN_FIRST_SECTION[r]. First LEDs count from the run's
+// first LED.
+#define SECTION_COUNT 8
+static const unsigned int RUN_FIRST_SECTION[RUN_COUNT] = {0, 3, 5};
+static const unsigned int RUN_SECTION_COUNT[RUN_COUNT] = {3, 2, 3};
+static const unsigned int SECTION_LED_COUNT[SECTION_COUNT] = {124, 128, 110, 161, 139, 173, 85, 121};
+static const unsigned int SECTION_FIRST_LED[SECTION_COUNT] = {0, 124, 252, 0, 161, 0, 173, 258};
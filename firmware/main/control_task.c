@@ -2,7 +2,10 @@
 
 #include "config_autogen.h"
 #include <stdint.h>
+#include <string.h>
 #include "net_task.h"
+#include "rx_capture.h"
+#include "rx_task.h"
 #include "freertos/task.h"
 
 #include "esp_log.h"
@@ -12,7 +15,39 @@
 static const char *LOG_TAG = "control_task";
 
 // Port for reboot command, offset from PORT_BASE to avoid run ports.
-static const uint16_t REBOOT_PORT = PORT_BASE + 100;
+#ifndef CONTROL_REBOOT_PORT
+#define CONTROL_REBOOT_PORT (PORT_BASE + 100)
+#endif
+static const uint16_t REBOOT_PORT = CONTROL_REBOOT_PORT;
+
+// Asks for the rx capture ring instead of a reboot; any other datagram
+// still reboots.
+static const char CAPTURE_COMMAND[] = "CAPTURE";
+
+// Sends the capture ring to the requester as RX_CAPTURE dump datagrams.
+// Recording pauses meanwhile so the chunks describe one consistent ring.
+static void send_capture(int socket_descriptor, const struct sockaddr_in *requester)
+{
+    rx_task_lock();
+    rx_capture_set_paused(true);
+    rx_task_unlock();
+
+    static uint8_t datagram[RX_CAPTURE_DUMP_DATAGRAM_BYTES];
+    unsigned int chunk_count = rx_capture_chunk_count();
+    for (unsigned int chunk = 0; chunk < chunk_count; ++chunk) {
+        size_t length = rx_capture_encode_chunk(chunk, datagram);
+        sendto(socket_descriptor, datagram, length, 0, (const struct sockaddr *)requester,
+               sizeof(*requester));
+        // Pace the dump so it does not exhaust lwIP buffers the run
+        // sockets need
+        vTaskDelay(1);
+    }
+    ESP_LOGI(LOG_TAG, "Sent %u capture chunks", chunk_count);
+
+    rx_task_lock();
+    rx_capture_set_paused(false);
+    rx_task_unlock();
+}
 
 static void control_task(void *param)
 {
@@ -27,10 +62,16 @@ static void control_task(void *param)
     };
     bind(socket_descriptor, (struct sockaddr *)&bind_address, sizeof(bind_address));
 
-    uint8_t data_buffer[1];
+    uint8_t data_buffer[sizeof(CAPTURE_COMMAND)];
     for (;;) {
-        ssize_t received_length = recvfrom(socket_descriptor, data_buffer, sizeof(data_buffer), 0, NULL, NULL);
-        if (received_length > 0) {
+        struct sockaddr_in sender;
+        socklen_t sender_length = sizeof(sender);
+        ssize_t received_length = recvfrom(socket_descriptor, data_buffer, sizeof(data_buffer), 0,
+                                           (struct sockaddr *)&sender, &sender_length);
+        if (received_length == (ssize_t)(sizeof(CAPTURE_COMMAND) - 1) &&
+            memcmp(data_buffer, CAPTURE_COMMAND, sizeof(CAPTURE_COMMAND) - 1) == 0) {
+            send_capture(socket_descriptor, &sender);
+        } else if (received_length > 0) {
             ESP_LOGI(LOG_TAG, "Reboot command received");
             esp_restart();
         }
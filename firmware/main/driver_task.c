@@ -1,14 +1,17 @@
 #include "driver_task.h"
 
 #include "config_autogen.h"
+#include "event_log.h"
+#include "frame_timing.h"
+#include "latency_stats.h"
+#include "metrics.h"
 #include "rx_task.h"
-#include "status_task.h"
 #include "startup_sequence.h"
+#include "ws2815_encoder.h"
 
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "driver/rmt_tx.h"
-#include "driver/rmt_encoder.h"
 #include "soc/soc_caps.h"
 #include "esp_log.h"
 #include "esp_rom_sys.h"
@@ -16,16 +19,14 @@
 #include <stdlib.h>
 #include <string.h>
 
-#define RMT_CLK_DIV 2
-#define RMT_TICKS_PER_BIT (80000000 / RMT_CLK_DIV / 800000)
-_Static_assert(RMT_TICKS_PER_BIT == 50, "Unexpected RMT bit timing");
+// 1 starts every run together so frame time is bounded by the longest run;
+// 0 transmits runs one after another.
+#ifndef DRIVER_PARALLEL_OUTPUT
+#define DRIVER_PARALLEL_OUTPUT 1
+#endif
 
-#define RMT_T0H_TICKS 16
-#define RMT_T0L_TICKS (RMT_TICKS_PER_BIT - RMT_T0H_TICKS)
-#define RMT_T1H_TICKS 32
-#define RMT_T1L_TICKS (RMT_TICKS_PER_BIT - RMT_T1H_TICKS)
-_Static_assert(RMT_T0H_TICKS + RMT_T0L_TICKS == RMT_TICKS_PER_BIT, "T0 timing");
-_Static_assert(RMT_T1H_TICKS + RMT_T1L_TICKS == RMT_TICKS_PER_BIT, "T1 timing");
+// Longest the driver sleeps without a frame-complete signal.
+#define DRIVER_IDLE_TIMEOUT_MS 100
 
 #define RUN0_GPIO 12
 #define RUN1_GPIO 13
@@ -62,18 +63,26 @@ _Static_assert(RUN3_GPIO >= 0 && RUN3_GPIO <= 39, "RUN3_GPIO out of range");
 #endif
 
 
-static rmt_symbol_word_t *rmt_items[RUN_COUNT];
-static size_t rmt_item_count[RUN_COUNT];
+// Frame currently owned by the driver, streamed to the strips by the WS2815
+// encoder. rx_task never writes to it until the next frame is acquired.
+static rx_frame_t *output_frame;
 static rmt_channel_handle_t rmt_channels[RUN_COUNT];
-static rmt_encoder_handle_t copy_encoder;
+// One encoder per channel: each keeps its stream position between refills,
+// and parallel output has every channel encoding at once.
+static rmt_encoder_handle_t strip_encoders[RUN_COUNT];
+#if DRIVER_PARALLEL_OUTPUT && SOC_RMT_SUPPORT_TX_SYNCHRO
+static rmt_sync_manager_handle_t sync_manager;
+#endif
 static const rmt_transmit_config_t TRANSMIT_CONFIG = {
     .loop_count = 0,
 };
+// When the previous transmission finished on every channel
+static uint64_t last_done_us;
 
-static esp_err_t wait_all_done_retry(rmt_channel_handle_t channel) {
+static esp_err_t wait_all_done_retry(unsigned int run_index) {
     const int MAX_ATTEMPTS = 5;
     for (int attempt = 0; attempt < MAX_ATTEMPTS; ++attempt) {
-        esp_err_t err = rmt_tx_wait_all_done(channel, pdMS_TO_TICKS(1));
+        esp_err_t err = rmt_tx_wait_all_done(rmt_channels[run_index], pdMS_TO_TICKS(1));
         if (err == ESP_OK) {
             return ESP_OK;
         }
@@ -83,90 +92,106 @@ static esp_err_t wait_all_done_retry(rmt_channel_handle_t channel) {
         vTaskDelay(pdMS_TO_TICKS(1));
     }
     ESP_LOGW("driver_task", "rmt_tx_wait_all_done timeout");
+    event_log_post(EVENT_RMT_TIMEOUT, run_index);
     return ESP_ERR_TIMEOUT;
 }
 
-static inline void encode_run(unsigned int run_index, const uint8_t *rgb_data)
+static bool frame_is_newer(uint32_t a, uint32_t b)
 {
-    rmt_symbol_word_t *items = rmt_items[run_index];
-    size_t item_index = 0;
-    for (unsigned int led_index = 0; led_index < LED_COUNT[run_index]; ++led_index) {
-        uint8_t red = rgb_data[led_index * 3];
-        uint8_t green = rgb_data[led_index * 3 + 1];
-        uint8_t blue = rgb_data[led_index * 3 + 2];
-        uint8_t grb[3] = {green, red, blue};
-        for (int color = 0; color < 3; ++color) {
-            uint8_t value = grb[color];
-            for (int bit = 7; bit >= 0; --bit) {
-                bool bit_set = value & (1 << bit);
-                items[item_index].duration0 = bit_set ? RMT_T1H_TICKS : RMT_T0H_TICKS;
-                items[item_index].level0 = 1;
-                items[item_index].duration1 = bit_set ? RMT_T1L_TICKS : RMT_T0L_TICKS;
-                items[item_index].level1 = 0;
-                ++item_index;
-            }
-        }
-    }
+    return (int32_t)(a - b) > 0;
 }
 
-static bool frame_is_newer(uint32_t a, uint32_t b)
+static void queue_run(unsigned int run_index)
 {
-    return (int32_t)(a - b) > 0;
+    ESP_ERROR_CHECK(rmt_transmit(rmt_channels[run_index], strip_encoders[run_index],
+                                 output_frame->run_buffers[run_index],
+                                 LED_COUNT[run_index] * 3,
+                                 &TRANSMIT_CONFIG));
 }
 
-static void send_frame(int slot_index)
+// Waits for the run's expected wire time before falling back to short retries.
+static esp_err_t wait_run_done(unsigned int run_index)
 {
-    // Protect buffers while we read/encode
-    rx_task_lock();
-    for (unsigned int run = 0; run < RUN_COUNT; ++run) {
-        const uint8_t *buffer = rx_task_get_run_buffer(slot_index, run);
-        encode_run(run, buffer); // fills rmt_items[run] / rmt_item_count[run]
+    uint32_t wire_ms = frame_timing_run_wire_us(LED_COUNT[run_index]) / 1000 + 1;
+    esp_err_t err = rmt_tx_wait_all_done(rmt_channels[run_index], pdMS_TO_TICKS(wire_ms) + 1);
+    if (err != ESP_ERR_TIMEOUT) {
+        return err;
     }
-    rx_task_unlock();
+    return wait_all_done_retry(run_index);
+}
 
-    // Transmit each run sequentially
-    for (unsigned int run = 0; run < RUN_COUNT; ++run) {
-        ESP_ERROR_CHECK(rmt_transmit(
-            rmt_channels[run],
-            copy_encoder,
-            rmt_items[run],
-            sizeof(rmt_symbol_word_t) * rmt_item_count[run],
-            &TRANSMIT_CONFIG));
-        wait_all_done_retry(rmt_channels[run]);
+// Strips only latch a frame after the line has been low for the reset time;
+// a frame queued sooner would shift on past the end of the run instead.
+static void wait_latch_gap(void)
+{
+    uint64_t latch_us = last_done_us + WS2815_RESET_US;
+    uint64_t now_us = latency_stats_now_us();
+    if (now_us < latch_us) {
+        esp_rom_delay_us((uint32_t)(latch_us - now_us));
     }
 }
 
+static void transmit_run(unsigned int run_index)
+{
+    wait_latch_gap();
+    queue_run(run_index);
+    wait_run_done(run_index);
+    last_done_us = latency_stats_now_us();
+}
 
-static void send_black(void)
+// Sets `encode_start_us` once the latch gap has passed, so idle time spent on
+// it is not encode time, and returns when the last run was queued, which ends
+// the encode stage. The encoder streams, so this covers the symbols encoded
+// before RMT starts.
+static uint64_t transmit_all_runs(uint64_t *encode_start_us)
 {
-    for (unsigned int run_index = 0; run_index < RUN_COUNT; ++run_index) {
-        ESP_ERROR_CHECK(rmt_transmit(rmt_channels[run_index], copy_encoder,
-                                     rmt_items[run_index],
-                                     sizeof(rmt_symbol_word_t) *
-                                         rmt_item_count[run_index],
-                                     &TRANSMIT_CONFIG));
-        wait_all_done_retry(rmt_channels[run_index]);
-        esp_rom_delay_us(60);
+    wait_latch_gap();
+    *encode_start_us = latency_stats_now_us();
+#if DRIVER_PARALLEL_OUTPUT
+    // Queue every run before waiting so all channels stream concurrently
+    for (unsigned int run = 0; run < RUN_COUNT; ++run) {
+        queue_run(run);
     }
+    uint64_t queued_us = latency_stats_now_us();
+    for (unsigned int run = 0; run < RUN_COUNT; ++run) {
+        wait_run_done(run);
+    }
+#if SOC_RMT_SUPPORT_TX_SYNCHRO
+    if (sync_manager != NULL) {
+        ESP_ERROR_CHECK(rmt_sync_reset(sync_manager));
+    }
+#endif
+#else
+    uint64_t queued_us = 0;
+    for (unsigned int run = 0; run < RUN_COUNT; ++run) {
+        queue_run(run);
+        queued_us = latency_stats_now_us();
+        wait_run_done(run);
+    }
+#endif
+    last_done_us = latency_stats_now_us();
+    return queued_us;
 }
 
-static void encode_single_led(rmt_symbol_word_t *items,
-                              uint8_t red,
-                              uint8_t green,
-                              uint8_t blue)
+static void transmit_frame(const rx_frame_t *frame)
 {
-    uint8_t grb[3] = {green, red, blue};
-    for (int color = 0; color < 3; ++color) {
-        uint8_t value = grb[color];
-        for (int bit = 7; bit >= 0; --bit) {
-            bool bit_set = value & (1 << bit);
-            items->duration0 = bit_set ? RMT_T1H_TICKS : RMT_T0H_TICKS;
-            items->level0 = 1;
-            items->duration1 = bit_set ? RMT_T1L_TICKS : RMT_T0L_TICKS;
-            items->level1 = 0;
-            ++items;
-        }
+    uint64_t encode_start_us;
+    uint64_t queued_us = transmit_all_runs(&encode_start_us);
+    uint64_t done_us = latency_stats_now_us();
+    latency_stats_record(LATENCY_STAGE_HANDOFF, frame->completed_us, encode_start_us);
+    latency_stats_record(LATENCY_STAGE_ENCODE, encode_start_us, queued_us);
+    latency_stats_record(LATENCY_STAGE_TRANSMIT, queued_us, done_us);
+    latency_stats_record(LATENCY_STAGE_TOTAL, frame->received_us, done_us);
+}
+
+static void send_black(void)
+{
+    for (unsigned int run_index = 0; run_index < RUN_COUNT; ++run_index) {
+        memset(output_frame->run_buffers[run_index], 0, LED_COUNT[run_index] * 3);
     }
+    uint64_t encode_start_us;
+    transmit_all_runs(&encode_start_us);
+    esp_rom_delay_us(60);
 }
 
 static void flash_run(unsigned int run_index,
@@ -180,19 +205,16 @@ static void flash_run(unsigned int run_index,
         pixel_count = LED_COUNT[run_index];
     }
 
-    rmt_symbol_word_t *items = rmt_items[run_index];
+    uint8_t *rgb = output_frame->run_buffers[run_index];
     for (unsigned int led = 0; led < pixel_count; ++led) {
-        encode_single_led(items + led * 24, red, green, blue);
+        rgb[led * 3] = red;
+        rgb[led * 3 + 1] = green;
+        rgb[led * 3 + 2] = blue;
     }
 
-    ESP_ERROR_CHECK(rmt_transmit(rmt_channels[run_index], copy_encoder,
-                                 rmt_items[run_index],
-                                 sizeof(rmt_symbol_word_t) *
-                                     rmt_item_count[run_index],
-                                 &TRANSMIT_CONFIG));
-    wait_all_done_retry(rmt_channels[run_index]);
+    transmit_run(run_index);
 
-    memset(items, 0, sizeof(rmt_symbol_word_t) * pixel_count * 24);
+    memset(rgb, 0, pixel_count * 3);
 }
 
 static void delay_ms(uint32_t ms)
@@ -202,58 +224,49 @@ static void delay_ms(uint32_t ms)
 
 static void driver_task(void *arg)
 {
-    rmt_copy_encoder_config_t copy_config = {};
-    ESP_ERROR_CHECK(rmt_new_copy_encoder(&copy_config, &copy_encoder));
-
+    (void)arg;
     for (unsigned int run = 0; run < RUN_COUNT; ++run) {
         rmt_tx_channel_config_t channel_config = {
             .gpio_num = RUN_GPIO[run],
             .clk_src = RMT_CLK_SRC_DEFAULT,
-            .resolution_hz = 80000000 / RMT_CLK_DIV,
+            .resolution_hz = RMT_RESOLUTION_HZ,
             .mem_block_symbols = 64,
             .trans_queue_depth = 1,
         };
         ESP_ERROR_CHECK(rmt_new_tx_channel(&channel_config, &rmt_channels[run]));
+        ESP_ERROR_CHECK(ws2815_encoder_new(&strip_encoders[run]));
         ESP_ERROR_CHECK(rmt_enable(rmt_channels[run]));
-        rmt_item_count[run] = LED_COUNT[run] * 24;
-        rmt_items[run] = (rmt_symbol_word_t *)malloc(sizeof(rmt_symbol_word_t) * rmt_item_count[run]);
-        memset(rmt_items[run], 0, sizeof(rmt_symbol_word_t) * rmt_item_count[run]);
     }
 
+    output_frame = rx_task_driver_frame();
     send_black();
     startup_sequence(RUN_COUNT, flash_run, send_black, delay_ms);
 
+#if DRIVER_PARALLEL_OUTPUT && SOC_RMT_SUPPORT_TX_SYNCHRO
+    // Installed after the startup flashes, which drive one run at a time.
+    rmt_sync_manager_config_t sync_config = {
+        .tx_channel_array = rmt_channels,
+        .array_size = RUN_COUNT,
+    };
+    ESP_ERROR_CHECK(rmt_new_sync_manager(&sync_config, &sync_manager));
+#endif
+
     uint32_t last_frame_id = 0;
 
     for (;;) {
-        int selected_slot = -1;
-        uint32_t selected_id = last_frame_id;
-        rx_task_lock();
-        for (int slot = 0; slot < 2; ++slot) {
-            uint32_t frame_id = rx_task_get_frame_id(slot);
-            if (frame_is_newer(frame_id, selected_id)) {
-                bool frame_complete = true;
-                for (unsigned int run = 0; run < RUN_COUNT; ++run) {
-                    if (!rx_task_run_received(slot, run)) {
-                        frame_complete = false;
-                        break;
-                    }
-                }
-                if (frame_complete) {
-                    selected_slot = slot;
-                    selected_id = frame_id;
-                }
+        rx_frame_t *frame = rx_task_acquire_frame();
+        if (frame != NULL) {
+            output_frame = frame;
+            if (frame_is_newer(frame->frame_id, last_frame_id)) {
+                transmit_frame(frame);
+                metrics_increment(METRIC_APPLIED);
+                last_frame_id = frame->frame_id;
             }
         }
-        rx_task_unlock();
-
-        if (selected_slot >= 0) {
-            send_frame(selected_slot);
-            status_task_increment_applied();
-            last_frame_id = selected_id;
-        }
 
-        vTaskDelay(pdMS_TO_TICKS(1));
+        // Sleep until rx_task completes a frame; the timeout only bounds how
+        // long a missed signal could stall the loop.
+        rx_task_wait_for_frame(DRIVER_IDLE_TIMEOUT_MS);
     }
 }
 
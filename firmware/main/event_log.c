@@ -0,0 +1,125 @@
+#include "event_log.h"
+
+#include "latency_stats.h"
+#include "metrics.h"
+
+#include <inttypes.h>
+#include <stdatomic.h>
+#include <stdio.h>
+
+_Static_assert((EVENT_LOG_CAPACITY & (EVENT_LOG_CAPACITY - 1)) == 0,
+               "EVENT_LOG_CAPACITY must be a power of two");
+
+typedef struct {
+    const char *format;
+    event_severity_t severity;
+} event_info_t;
+
+static const event_info_t EVENT_INFO[EVENT_CODE_COUNT] = {
+    [EVENT_RMT_TIMEOUT] = {"rmt_tx_wait_all_done timeout run %" PRIu32, EVENT_SEVERITY_ERROR},
+    [EVENT_RX_BAD_LENGTH] = {"rx length mismatch run %" PRIu32, EVENT_SEVERITY_WARNING},
+    [EVENT_RX_BAD_RUN] = {"rx bad run index %" PRIu32, EVENT_SEVERITY_WARNING},
+    [EVENT_RX_POOL_EXHAUSTED] = {"rx buffer pool exhausted run %" PRIu32, EVENT_SEVERITY_WARNING},
+    [EVENT_LINK_UP] = {"ethernet link up", EVENT_SEVERITY_INFO},
+    [EVENT_LINK_DOWN] = {"ethernet link down", EVENT_SEVERITY_ERROR},
+};
+
+// Bounded queue with a sequence number per cell: a producer claims a
+// position by compare-and-swap, writes the event, then publishes it by
+// advancing the cell's sequence. The consumer reads cells in position order.
+// Cells store sequence - cell index so the zero-initialised ring starts
+// out empty without an init call.
+typedef struct {
+    atomic_uint sequence;
+    event_t event;
+} EventCell;
+
+static EventCell cells[EVENT_LOG_CAPACITY];
+static atomic_uint enqueue_position;
+static unsigned int dequeue_position;
+static event_log_notify_fn_t notify_consumer;
+
+static unsigned int load_sequence(unsigned int index) {
+    return atomic_load_explicit(&cells[index].sequence, memory_order_acquire) + index;
+}
+
+static void store_sequence(unsigned int index, unsigned int sequence) {
+    atomic_store_explicit(&cells[index].sequence, sequence - index, memory_order_release);
+}
+
+void event_log_reset(void) {
+    for (unsigned int index = 0; index < EVENT_LOG_CAPACITY; ++index) {
+        store_sequence(index, index);
+    }
+    atomic_store(&enqueue_position, 0);
+    dequeue_position = 0;
+}
+
+void event_log_set_notify(event_log_notify_fn_t notify) {
+    notify_consumer = notify;
+}
+
+event_severity_t event_log_severity(event_code_t code) {
+    return (unsigned int)code < EVENT_CODE_COUNT ? EVENT_INFO[code].severity
+                                                 : EVENT_SEVERITY_ERROR;
+}
+
+bool event_log_post(event_code_t code, uint32_t detail) {
+    unsigned int position = atomic_load_explicit(&enqueue_position, memory_order_relaxed);
+    unsigned int index;
+    for (;;) {
+        index = position & (EVENT_LOG_CAPACITY - 1);
+        unsigned int sequence = load_sequence(index);
+        int difference = (int)(sequence - position);
+        if (difference == 0) {
+            if (atomic_compare_exchange_weak_explicit(&enqueue_position, &position, position + 1,
+                                                      memory_order_relaxed,
+                                                      memory_order_relaxed)) {
+                break;
+            }
+        } else if (difference < 0) {
+            // The consumer has not freed this cell yet: the ring is full
+            metrics_increment(METRIC_EVENTS_LOST);
+            return false;
+        } else {
+            position = atomic_load_explicit(&enqueue_position, memory_order_relaxed);
+        }
+    }
+    event_t *event = &cells[index].event;
+    event->timestamp_ms = (uint32_t)(latency_stats_now_us() / 1000);
+    event->detail = detail;
+    event->code = (uint8_t)code;
+    store_sequence(index, position + 1);
+
+    event_log_notify_fn_t notify = notify_consumer;
+    if (notify != NULL && event_log_severity(code) >= EVENT_PING_SEVERITY) {
+        notify();
+    }
+    return true;
+}
+
+size_t event_log_drain(event_t *events, size_t max_events) {
+    size_t count = 0;
+    while (count < max_events) {
+        unsigned int index = dequeue_position & (EVENT_LOG_CAPACITY - 1);
+        if (load_sequence(index) != dequeue_position + 1) {
+            // Empty, or the producer holding this position has not finished
+            break;
+        }
+        events[count++] = cells[index].event;
+        store_sequence(index, dequeue_position + EVENT_LOG_CAPACITY);
+        ++dequeue_position;
+    }
+    return count;
+}
+
+size_t event_log_format(const event_t *event, char *buffer, size_t buffer_len) {
+    int prefix = snprintf(buffer, buffer_len, "%" PRIu32 ": ", event->timestamp_ms);
+    if (prefix < 0 || (size_t)prefix >= buffer_len) {
+        return prefix < 0 ? 0 : (size_t)prefix;
+    }
+    const char *format = event->code < EVENT_CODE_COUNT ? EVENT_INFO[event->code].format
+                                                        : "unknown event %" PRIu32;
+    int message = snprintf(buffer + prefix, buffer_len - (size_t)prefix, format, event->detail);
+    return (size_t)prefix + (message < 0 ? 0 : (size_t)message);
+}
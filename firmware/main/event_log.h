@@ -0,0 +1,54 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Bounded multi-producer, single-consumer ring of error and state events.
+// Posting never blocks or allocates; when the ring is full the new event is
+// dropped and counted as METRIC_EVENTS_LOST. status_task is the consumer.
+#define EVENT_LOG_CAPACITY 32
+
+typedef enum {
+    EVENT_RMT_TIMEOUT,       // detail: run index
+    EVENT_RX_BAD_LENGTH,     // detail: run index
+    EVENT_RX_BAD_RUN,        // detail: run index received
+    EVENT_RX_POOL_EXHAUSTED, // detail: run index
+    EVENT_LINK_UP,
+    EVENT_LINK_DOWN,
+    EVENT_CODE_COUNT,
+} event_code_t;
+
+typedef enum {
+    EVENT_SEVERITY_INFO,
+    EVENT_SEVERITY_WARNING,
+    EVENT_SEVERITY_ERROR,
+} event_severity_t;
+
+// Events at or above this severity trigger an immediate heartbeat.
+#ifndef EVENT_PING_SEVERITY
+#define EVENT_PING_SEVERITY EVENT_SEVERITY_ERROR
+#endif
+
+typedef struct {
+    uint32_t timestamp_ms;
+    uint32_t detail;
+    uint8_t code;
+} event_t;
+
+// Called from the posting task after an event at or above
+// EVENT_PING_SEVERITY is queued. Must not block.
+typedef void (*event_log_notify_fn_t)(void);
+void event_log_set_notify(event_log_notify_fn_t notify);
+
+// Returns false when the ring was full and the event was dropped.
+bool event_log_post(event_code_t code, uint32_t detail);
+// Moves up to max_events events, oldest first, into `events`. Single
+// consumer only.
+size_t event_log_drain(event_t *events, size_t max_events);
+
+event_severity_t event_log_severity(event_code_t code);
+// Formats "<timestamp_ms>: <message>". Returns the snprintf length.
+size_t event_log_format(const event_t *event, char *buffer, size_t buffer_len);
+// Empties the ring. Not safe against concurrent producers.
+void event_log_reset(void);
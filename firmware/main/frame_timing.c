@@ -0,0 +1,23 @@
+#include "frame_timing.h"
+
+uint32_t frame_timing_run_wire_us(unsigned int led_count)
+{
+    uint64_t data_ns = (uint64_t)led_count * 24 * WS2815_BIT_TIME_NS;
+    return (uint32_t)((data_ns + 999) / 1000) + WS2815_RESET_US;
+}
+
+uint32_t frame_timing_transmit_us(const unsigned int *led_counts,
+                                  unsigned int run_count,
+                                  frame_output_mode_t mode)
+{
+    uint32_t total_us = 0;
+    for (unsigned int run = 0; run < run_count; ++run) {
+        uint32_t run_us = frame_timing_run_wire_us(led_counts[run]);
+        if (mode == FRAME_OUTPUT_SERIAL) {
+            total_us += run_us;
+        } else if (run_us > total_us) {
+            total_us = run_us;
+        }
+    }
+    return total_us;
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <stdint.h>
+
+// WS2815 wire timing at 800 kHz: 24 bits per LED plus a latch gap per frame.
+#define WS2815_BIT_TIME_NS 1250
+#define WS2815_RESET_US 280
+
+typedef enum {
+    FRAME_OUTPUT_SERIAL,
+    FRAME_OUTPUT_PARALLEL,
+} frame_output_mode_t;
+
+// On-wire duration of one run, including the latch gap.
+uint32_t frame_timing_run_wire_us(unsigned int led_count);
+
+// Time to push one frame to every run in the given output mode.
+uint32_t frame_timing_transmit_us(const unsigned int *led_counts,
+                                  unsigned int run_count,
+                                  frame_output_mode_t mode);
+
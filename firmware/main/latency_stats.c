@@ -0,0 +1,146 @@
+#include "latency_stats.h"
+
+#include <stdatomic.h>
+#include <stddef.h>
+
+#ifndef UNIT_TEST
+#include "esp_timer.h"
+
+static uint64_t default_clock_us(void) {
+    return (uint64_t)esp_timer_get_time();
+}
+#else
+#include <time.h>
+
+static uint64_t default_clock_us(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000u + (uint64_t)now.tv_nsec / 1000u;
+}
+#endif
+
+static const char *const STAGE_NAMES[LATENCY_STAGE_COUNT] = {
+    "assemble", "handoff", "encode", "transmit", "total",
+};
+
+static latency_clock_fn_t clock_source = default_clock_us;
+
+// Written by rx and driver tasks, read by status_task; counts are
+// independent so relaxed atomics are enough.
+static atomic_uint buckets[LATENCY_STAGE_COUNT][LATENCY_BUCKET_COUNT];
+static atomic_uint max_us[LATENCY_READER_COUNT][LATENCY_STAGE_COUNT];
+
+void latency_stats_set_clock(latency_clock_fn_t clock) {
+    clock_source = clock != NULL ? clock : default_clock_us;
+}
+
+uint64_t latency_stats_now_us(void) {
+    return clock_source();
+}
+
+static unsigned int bucket_index(uint32_t duration_us) {
+    if (duration_us == 0) {
+        return 0;
+    }
+    unsigned int index = 32 - (unsigned int)__builtin_clz(duration_us);
+    return index < LATENCY_BUCKET_COUNT ? index : LATENCY_BUCKET_COUNT - 1;
+}
+
+static uint32_t bucket_upper_us(unsigned int index) {
+    return index == 0 ? 0 : (1u << index) - 1;
+}
+
+void latency_stats_record(latency_stage_t stage, uint64_t start_us, uint64_t end_us) {
+    if ((unsigned int)stage >= LATENCY_STAGE_COUNT) {
+        return;
+    }
+    uint64_t span = end_us > start_us ? end_us - start_us : 0;
+    uint32_t duration_us = span > UINT32_MAX ? UINT32_MAX : (uint32_t)span;
+    atomic_fetch_add_explicit(&buckets[stage][bucket_index(duration_us)], 1,
+                              memory_order_relaxed);
+    for (unsigned int reader = 0; reader < LATENCY_READER_COUNT; ++reader) {
+        atomic_uint *reader_max = &max_us[reader][stage];
+        unsigned int current = atomic_load_explicit(reader_max, memory_order_relaxed);
+        while (duration_us > current &&
+               !atomic_compare_exchange_weak_explicit(reader_max, &current, duration_us,
+                                                      memory_order_relaxed,
+                                                      memory_order_relaxed)) {
+        }
+    }
+}
+
+static uint32_t percentile_us(const uint32_t *counts, uint32_t total, uint32_t percent,
+                              uint32_t max) {
+    // Smallest bucket whose cumulative count reaches the rank
+    uint32_t rank = (uint32_t)(((uint64_t)total * percent + 99) / 100);
+    uint32_t seen = 0;
+    for (unsigned int index = 0; index < LATENCY_BUCKET_COUNT; ++index) {
+        seen += counts[index];
+        if (seen >= rank) {
+            uint32_t upper = bucket_upper_us(index);
+            return upper < max ? upper : max;
+        }
+    }
+    return max;
+}
+
+void latency_stats_snapshot(latency_reader_t reader, latency_snapshot_t *snapshot) {
+    for (unsigned int stage = 0; stage < LATENCY_STAGE_COUNT; ++stage) {
+        for (unsigned int index = 0; index < LATENCY_BUCKET_COUNT; ++index) {
+            snapshot->buckets[stage][index] =
+                atomic_load_explicit(&buckets[stage][index], memory_order_relaxed);
+        }
+        snapshot->max_us[stage] =
+            (unsigned int)reader < LATENCY_READER_COUNT
+                ? atomic_exchange_explicit(&max_us[reader][stage], 0, memory_order_relaxed)
+                : 0;
+    }
+}
+
+void latency_stats_delta(const latency_snapshot_t *current,
+                         const latency_snapshot_t *previous,
+                         latency_snapshot_t *delta) {
+    for (unsigned int stage = 0; stage < LATENCY_STAGE_COUNT; ++stage) {
+        for (unsigned int index = 0; index < LATENCY_BUCKET_COUNT; ++index) {
+            delta->buckets[stage][index] =
+                current->buckets[stage][index] - previous->buckets[stage][index];
+        }
+        delta->max_us[stage] = current->max_us[stage];
+    }
+}
+
+void latency_stats_summarize(const latency_snapshot_t *snapshot, latency_stage_t stage,
+                             latency_summary_t *summary) {
+    summary->count = 0;
+    summary->p50_us = 0;
+    summary->p99_us = 0;
+    summary->max_us = 0;
+    if ((unsigned int)stage >= LATENCY_STAGE_COUNT) {
+        return;
+    }
+    const uint32_t *counts = snapshot->buckets[stage];
+    for (unsigned int index = 0; index < LATENCY_BUCKET_COUNT; ++index) {
+        summary->count += counts[index];
+    }
+    summary->max_us = snapshot->max_us[stage];
+    if (summary->count == 0) {
+        return;
+    }
+    summary->p50_us = percentile_us(counts, summary->count, 50, summary->max_us);
+    summary->p99_us = percentile_us(counts, summary->count, 99, summary->max_us);
+}
+
+const char *latency_stats_stage_name(latency_stage_t stage) {
+    return (unsigned int)stage < LATENCY_STAGE_COUNT ? STAGE_NAMES[stage] : "unknown";
+}
+
+void latency_stats_reset(void) {
+    for (unsigned int stage = 0; stage < LATENCY_STAGE_COUNT; ++stage) {
+        for (unsigned int index = 0; index < LATENCY_BUCKET_COUNT; ++index) {
+            atomic_store_explicit(&buckets[stage][index], 0, memory_order_relaxed);
+        }
+        for (unsigned int reader = 0; reader < LATENCY_READER_COUNT; ++reader) {
+            atomic_store_explicit(&max_us[reader][stage], 0, memory_order_relaxed);
+        }
+    }
+}
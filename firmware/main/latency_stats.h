@@ -0,0 +1,63 @@
+#pragma once
+
+#include <stdint.h>
+
+// Per-frame pipeline stages, each measured between two timestamps.
+typedef enum {
+    LATENCY_STAGE_ASSEMBLE, // first datagram received -> frame complete
+    LATENCY_STAGE_HANDOFF,  // frame complete -> driver starts encoding
+    LATENCY_STAGE_ENCODE,   // encoding starts -> every run queued on RMT
+    LATENCY_STAGE_TRANSMIT, // every run queued -> RMT transmit done
+    LATENCY_STAGE_TOTAL,    // first datagram received -> RMT transmit done
+    LATENCY_STAGE_COUNT,
+} latency_stage_t;
+
+// Log2 buckets: bucket 0 holds 0 us, bucket b holds [2^(b-1), 2^b) us and the
+// last bucket also takes anything longer.
+#define LATENCY_BUCKET_COUNT 24
+
+typedef struct {
+    uint32_t count;
+    uint32_t p50_us;
+    uint32_t p99_us;
+    uint32_t max_us;
+} latency_summary_t;
+
+// Each telemetry stream reads the histograms on its own schedule. Bucket
+// counts are monotonic and shared; the exact maximum is kept per reader and
+// cleared when that reader takes a snapshot.
+typedef enum {
+    LATENCY_READER_HEARTBEAT,
+    LATENCY_READER_TELEMETRY,
+    LATENCY_READER_COUNT,
+} latency_reader_t;
+
+typedef struct {
+    uint32_t buckets[LATENCY_STAGE_COUNT][LATENCY_BUCKET_COUNT];
+    uint32_t max_us[LATENCY_STAGE_COUNT];
+} latency_snapshot_t;
+
+// Microsecond clock. The default is esp_timer on target and CLOCK_MONOTONIC
+// on host; tests install their own to control time.
+typedef uint64_t (*latency_clock_fn_t)(void);
+void latency_stats_set_clock(latency_clock_fn_t clock);
+uint64_t latency_stats_now_us(void);
+
+// Records the span between two timestamps; spans that run backwards count
+// as zero. Safe to call from any task.
+void latency_stats_record(latency_stage_t stage, uint64_t start_us, uint64_t end_us);
+
+// Bucket counts since boot, and the maximum span since this reader's
+// previous snapshot.
+void latency_stats_snapshot(latency_reader_t reader, latency_snapshot_t *snapshot);
+// Bucket counts current - previous; the maximum is taken from current.
+void latency_stats_delta(const latency_snapshot_t *current,
+                         const latency_snapshot_t *previous,
+                         latency_snapshot_t *delta);
+// Percentiles are the upper bound of the bucket holding that rank, capped at
+// the exact maximum.
+void latency_stats_summarize(const latency_snapshot_t *snapshot, latency_stage_t stage,
+                             latency_summary_t *summary);
+const char *latency_stats_stage_name(latency_stage_t stage);
+// Clears every histogram and reader maximum. For tests.
+void latency_stats_reset(void);
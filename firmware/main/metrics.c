@@ -0,0 +1,94 @@
+#include "metrics.h"
+
+#include <stdatomic.h>
+#include <stddef.h>
+
+#ifndef UNIT_TEST
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#define METRICS_CORE_COUNT portNUM_PROCESSORS
+
+static unsigned int current_core(void) {
+    return (unsigned int)xPortGetCoreID();
+}
+#else
+// Two rows on host so tests exercise the per-core sum; threads are spread
+// across them round-robin.
+#define METRICS_CORE_COUNT 2
+
+static unsigned int current_core(void) {
+    static atomic_uint next_thread;
+    static _Thread_local unsigned int thread_row = ~0u;
+    if (thread_row == ~0u) {
+        thread_row = atomic_fetch_add(&next_thread, 1) % METRICS_CORE_COUNT;
+    }
+    return thread_row;
+}
+#endif
+
+static const char *const METRIC_NAMES[METRIC_COUNT] = {
+    "rx_frames", "complete", "applied", "len", "run", "stale", "window", "pool", "base",
+    "recovered",
+    "events_lost", "frames_skipped", "frame_gaps",
+    [METRIC_RUN_RX] = "run_rx",
+    [METRIC_RUN_DROPS] = "run_drops",
+    [METRIC_RUN_RECOVERED] = "run_recovered",
+};
+
+// One row per core keeps writers on different cores off each other's
+// counters. A task can migrate mid-increment, so the adds stay atomic.
+static atomic_uint counters[METRICS_CORE_COUNT][METRIC_COUNT];
+
+void metrics_add(metric_id_t id, uint32_t amount) {
+    if ((unsigned int)id >= METRIC_COUNT) {
+        return;
+    }
+    atomic_fetch_add_explicit(&counters[current_core()][id], amount, memory_order_relaxed);
+}
+
+void metrics_increment(metric_id_t id) {
+    metrics_add(id, 1);
+}
+
+void metrics_increment_run(metric_id_t block, unsigned int run) {
+    if (run < METRICS_MAX_RUNS) {
+        metrics_add((metric_id_t)(block + run), 1);
+    }
+}
+
+void metrics_snapshot(metrics_snapshot_t *snapshot) {
+    for (unsigned int id = 0; id < METRIC_COUNT; ++id) {
+        uint32_t total = 0;
+        for (unsigned int core = 0; core < METRICS_CORE_COUNT; ++core) {
+            total += atomic_load_explicit(&counters[core][id], memory_order_relaxed);
+        }
+        snapshot->value[id] = total;
+    }
+}
+
+void metrics_delta(const metrics_snapshot_t *current,
+                   const metrics_snapshot_t *previous,
+                   metrics_snapshot_t *delta) {
+    for (unsigned int id = 0; id < METRIC_COUNT; ++id) {
+        delta->value[id] = current->value[id] - previous->value[id];
+    }
+}
+
+uint32_t metrics_total_drops(const metrics_snapshot_t *snapshot) {
+    return snapshot->value[METRIC_DROPS_LEN] + snapshot->value[METRIC_DROPS_RUN] +
+           snapshot->value[METRIC_DROPS_STALE] + snapshot->value[METRIC_DROPS_WINDOW] +
+           snapshot->value[METRIC_DROPS_POOL] + snapshot->value[METRIC_DROPS_BASE];
+}
+
+const char *metrics_name(metric_id_t id) {
+    if ((unsigned int)id >= METRIC_COUNT) {
+        return "unknown";
+    }
+    // Per-run counters share their block's name
+    unsigned int base = id;
+    while (METRIC_NAMES[base] == NULL) {
+        --base;
+    }
+    return METRIC_NAMES[base];
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <stdint.h>
+
+// Per-run counters are laid out for the largest supported layout.
+#define METRICS_MAX_RUNS 4
+
+// Monotonic event counters. They are never reset: readers take snapshots
+// and report the difference between two of them.
+typedef enum {
+    METRIC_RX_FRAMES,       // run datagrams accepted into a slot
+    METRIC_COMPLETE,        // frames completed and published
+    METRIC_APPLIED,         // frames pushed to the strips
+    METRIC_DROPS_LEN,       // datagram length did not match the run
+    METRIC_DROPS_RUN,       // run index out of range
+    METRIC_DROPS_STALE,     // frame not newer than the last published one
+    METRIC_DROPS_WINDOW,    // a newer frame already holds the frame's slot
+    METRIC_DROPS_POOL,      // no free receive buffer for the run
+    METRIC_DROPS_BASE,      // delta against a frame the assembler no longer holds
+    METRIC_PARITY_RECOVERED, // runs rebuilt from a parity datagram
+    METRIC_EVENTS_LOST,     // events dropped because the event ring was full
+    METRIC_FRAMES_SKIPPED,  // frame_ids never published between two published frames
+    METRIC_FRAME_GAPS,      // publishes that skipped at least one frame_id
+    // Per-run blocks of METRICS_MAX_RUNS counters, indexed by run
+    METRIC_RUN_RX,          // run datagrams accepted into a slot
+    METRIC_RUN_DROPS = METRIC_RUN_RX + METRICS_MAX_RUNS, // run datagrams dropped
+    METRIC_RUN_RECOVERED = METRIC_RUN_DROPS + METRICS_MAX_RUNS, // rebuilt from parity
+    METRIC_COUNT = METRIC_RUN_RECOVERED + METRICS_MAX_RUNS,
+} metric_id_t;
+
+typedef struct {
+    uint32_t value[METRIC_COUNT];
+} metrics_snapshot_t;
+
+// Lock-free; callable from any task on either core.
+void metrics_increment(metric_id_t id);
+void metrics_add(metric_id_t id, uint32_t amount);
+// Increments counter `run` of a per-run block such as METRIC_RUN_RX.
+void metrics_increment_run(metric_id_t block, unsigned int run);
+
+void metrics_snapshot(metrics_snapshot_t *snapshot);
+// Per-counter current - previous, correct across 32-bit wraparound.
+void metrics_delta(const metrics_snapshot_t *current,
+                   const metrics_snapshot_t *previous,
+                   metrics_snapshot_t *delta);
+// Sum of every METRIC_DROPS_* counter in a snapshot or delta.
+uint32_t metrics_total_drops(const metrics_snapshot_t *snapshot);
+// Short key used in the heartbeat, e.g. "stale" for METRIC_DROPS_STALE.
+const char *metrics_name(metric_id_t id);
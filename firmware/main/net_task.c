@@ -10,6 +10,7 @@
 #include "driver/gpio.h"
 #include "lwip/ip4_addr.h"
 #include "config_autogen.h"
+#include "event_log.h"
 
 // Compile-time checks for static IP configuration
 #ifndef STATIC_IP_ADDR0
@@ -75,6 +76,18 @@ _Static_assert(RMII_POWER_GPIO >= 0 && RMII_POWER_GPIO <= 39, "RMII_POWER_GPIO o
 static EventGroupHandle_t network_event_group;
 static const char *LOG_TAG = "net_task";
 
+static void link_event_handler(void *arg, esp_event_base_t base, int32_t event_id, void *data)
+{
+    (void)arg;
+    (void)base;
+    (void)data;
+    if (event_id == ETHERNET_EVENT_CONNECTED) {
+        event_log_post(EVENT_LINK_UP, 0);
+    } else if (event_id == ETHERNET_EVENT_DISCONNECTED) {
+        event_log_post(EVENT_LINK_DOWN, 0);
+    }
+}
+
 static void network_task(void *param)
 {
     ESP_ERROR_CHECK(esp_netif_init());
@@ -122,6 +135,7 @@ static void network_task(void *param)
     ESP_ERROR_CHECK(esp_netif_dhcpc_stop(netif));
     ESP_ERROR_CHECK(esp_netif_set_ip_info(netif, &ip_info));
 
+    ESP_ERROR_CHECK(esp_event_handler_register(ETH_EVENT, ESP_EVENT_ANY_ID, link_event_handler, NULL));
     ESP_ERROR_CHECK(esp_eth_start(eth_handle));
     xEventGroupSetBits(network_event_group, NETWORK_READY_BIT);
     ESP_LOGI(LOG_TAG, "Network ready");
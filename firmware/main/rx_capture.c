@@ -0,0 +1,185 @@
+#include "rx_capture.h"
+
+#include "config_autogen.h"
+
+#include <stdatomic.h>
+#include <string.h>
+
+_Static_assert(RUN_COUNT <= RX_CAPTURE_MAX_RUNS, "capture header too small for RUN_COUNT");
+_Static_assert(sizeof(rx_capture_entry_t) == RX_CAPTURE_ENTRY_BYTES, "capture entry is not packed");
+_Static_assert(RX_CAPTURE_CHUNK_BYTES % RX_CAPTURE_ENTRY_BYTES == 0 &&
+                   RX_CAPTURE_HEADER_BYTES % RX_CAPTURE_ENTRY_BYTES == 0,
+               "chunks must split the stream on entry boundaries");
+_Static_assert((RX_CAPTURE_ENTRIES & (RX_CAPTURE_ENTRIES - 1)) == 0,
+               "RX_CAPTURE_ENTRIES must be a power of two");
+
+// Entries ever recorded; the ring holds the newest RX_CAPTURE_ENTRIES
+static uint32_t recorded;
+static atomic_bool paused;
+
+#if RX_CAPTURE_ENTRIES > 0
+static rx_capture_entry_t entries[RX_CAPTURE_ENTRIES];
+
+void rx_capture_record(uint64_t arrival_us, unsigned int run, uint32_t frame_id, size_t length,
+                       rx_capture_outcome_t outcome) {
+    if (atomic_load_explicit(&paused, memory_order_relaxed)) {
+        return;
+    }
+    rx_capture_entry_t *entry = &entries[recorded & (RX_CAPTURE_ENTRIES - 1)];
+    entry->arrival_us = arrival_us;
+    entry->frame_id = frame_id;
+    entry->length = length > UINT16_MAX ? UINT16_MAX : (uint16_t)length;
+    entry->run = run > UINT8_MAX ? UINT8_MAX : (uint8_t)run;
+    entry->outcome = (uint8_t)outcome;
+    ++recorded;
+}
+
+size_t rx_capture_count(void) {
+    return recorded < RX_CAPTURE_ENTRIES ? recorded : RX_CAPTURE_ENTRIES;
+}
+
+size_t rx_capture_read(size_t first, rx_capture_entry_t *out, size_t max_entries) {
+    size_t count = rx_capture_count();
+    uint32_t oldest = recorded - (uint32_t)count;
+    size_t copied = 0;
+    for (size_t index = first; index < count && copied < max_entries; ++index) {
+        out[copied++] = entries[(oldest + index) & (RX_CAPTURE_ENTRIES - 1)];
+    }
+    return copied;
+}
+#else
+// Capture compiled out: the ring is always empty
+size_t rx_capture_count(void) {
+    return 0;
+}
+
+size_t rx_capture_read(size_t first, rx_capture_entry_t *out, size_t max_entries) {
+    (void)first;
+    (void)out;
+    (void)max_entries;
+    return 0;
+}
+#endif
+
+void rx_capture_set_paused(bool value) {
+    atomic_store(&paused, value);
+}
+
+void rx_capture_reset(void) {
+    recorded = 0;
+}
+
+static void put_u16(uint8_t *out, uint16_t value) {
+    out[0] = (uint8_t)value;
+    out[1] = (uint8_t)(value >> 8);
+}
+
+static void put_u32(uint8_t *out, uint32_t value) {
+    put_u16(out, (uint16_t)value);
+    put_u16(out + 2, (uint16_t)(value >> 16));
+}
+
+static uint16_t get_u16(const uint8_t *in) {
+    return (uint16_t)(in[0] | (in[1] << 8));
+}
+
+static uint32_t get_u32(const uint8_t *in) {
+    return get_u16(in) | ((uint32_t)get_u16(in + 2) << 16);
+}
+
+void rx_capture_header(rx_capture_header_t *header) {
+    memset(header, 0, sizeof(*header));
+    header->version = RX_CAPTURE_VERSION;
+    header->side = SIDE_ID;
+    header->run_count = RUN_COUNT;
+    for (unsigned int run = 0; run < RUN_COUNT; ++run) {
+        header->led_count[run] = (uint16_t)LED_COUNT[run];
+    }
+    header->port_base = PORT_BASE;
+    header->entry_count = (uint32_t)rx_capture_count();
+    header->overwritten = recorded - header->entry_count;
+}
+
+void rx_capture_encode_header(const rx_capture_header_t *header, uint8_t *out) {
+    memset(out, 0, RX_CAPTURE_HEADER_BYTES);
+    memcpy(out, "BCAP", 4);
+    out[4] = header->version;
+    out[5] = header->side;
+    out[6] = header->run_count;
+    out[7] = RX_CAPTURE_ENTRY_BYTES;
+    put_u32(out + 8, header->entry_count);
+    put_u32(out + 12, header->overwritten);
+    for (unsigned int run = 0; run < RX_CAPTURE_MAX_RUNS; ++run) {
+        put_u16(out + 16 + run * 2, header->led_count[run]);
+    }
+    put_u16(out + 24, header->port_base);
+}
+
+bool rx_capture_decode_header(const uint8_t *in, size_t length, rx_capture_header_t *header) {
+    if (length < RX_CAPTURE_HEADER_BYTES || memcmp(in, "BCAP", 4) != 0 ||
+        in[4] != RX_CAPTURE_VERSION || in[7] != RX_CAPTURE_ENTRY_BYTES ||
+        in[6] > RX_CAPTURE_MAX_RUNS) {
+        return false;
+    }
+    header->version = in[4];
+    header->side = in[5];
+    header->run_count = in[6];
+    header->entry_count = get_u32(in + 8);
+    header->overwritten = get_u32(in + 12);
+    for (unsigned int run = 0; run < RX_CAPTURE_MAX_RUNS; ++run) {
+        header->led_count[run] = get_u16(in + 16 + run * 2);
+    }
+    header->port_base = get_u16(in + 24);
+    return true;
+}
+
+void rx_capture_encode_entry(const rx_capture_entry_t *entry, uint8_t *out) {
+    put_u32(out, (uint32_t)entry->arrival_us);
+    put_u32(out + 4, (uint32_t)(entry->arrival_us >> 32));
+    put_u32(out + 8, entry->frame_id);
+    put_u16(out + 12, entry->length);
+    out[14] = entry->run;
+    out[15] = entry->outcome;
+}
+
+void rx_capture_decode_entry(const uint8_t *in, rx_capture_entry_t *entry) {
+    entry->arrival_us = get_u32(in) | ((uint64_t)get_u32(in + 4) << 32);
+    entry->frame_id = get_u32(in + 8);
+    entry->length = get_u16(in + 12);
+    entry->run = in[14];
+    entry->outcome = in[15];
+}
+
+unsigned int rx_capture_chunk_count(void) {
+    size_t stream_bytes = RX_CAPTURE_HEADER_BYTES + rx_capture_count() * RX_CAPTURE_ENTRY_BYTES;
+    return (unsigned int)((stream_bytes + RX_CAPTURE_CHUNK_BYTES - 1) / RX_CAPTURE_CHUNK_BYTES);
+}
+
+size_t rx_capture_encode_chunk(unsigned int chunk_index, uint8_t *out) {
+    unsigned int chunk_count = rx_capture_chunk_count();
+    out[0] = 'B';
+    out[1] = 'D';
+    out[2] = RX_CAPTURE_VERSION;
+    out[3] = 0;
+    put_u16(out + 4, (uint16_t)chunk_index);
+    put_u16(out + 6, (uint16_t)chunk_count);
+    uint8_t *payload = out + RX_CAPTURE_CHUNK_HEADER_BYTES;
+    size_t written = 0;
+    // Chunk boundaries fall on entry boundaries, see the asserts above
+    size_t stream_offset = (size_t)chunk_index * RX_CAPTURE_CHUNK_BYTES;
+    if (stream_offset == 0) {
+        rx_capture_header_t header;
+        rx_capture_header(&header);
+        rx_capture_encode_header(&header, payload);
+        written = RX_CAPTURE_HEADER_BYTES;
+        stream_offset = RX_CAPTURE_HEADER_BYTES;
+    }
+    size_t first = (stream_offset - RX_CAPTURE_HEADER_BYTES) / RX_CAPTURE_ENTRY_BYTES;
+    rx_capture_entry_t entry;
+    while (written < RX_CAPTURE_CHUNK_BYTES && rx_capture_read(first, &entry, 1) == 1) {
+        rx_capture_encode_entry(&entry, payload + written);
+        written += RX_CAPTURE_ENTRY_BYTES;
+        ++first;
+    }
+    return RX_CAPTURE_CHUNK_HEADER_BYTES + written;
+}
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Entries in the rx capture ring, 16 bytes each; 0 compiles capture out.
+// 1024 keeps the last few seconds of a four-run wall in 16 KB.
+#ifndef RX_CAPTURE_ENTRIES
+#define RX_CAPTURE_ENTRIES 0
+#endif
+
+// What rx_task did with a datagram. Values are part of the capture format.
+typedef enum {
+    RX_CAPTURE_ACCEPTED,
+    RX_CAPTURE_DROP_LEN,
+    RX_CAPTURE_DROP_RUN,
+    RX_CAPTURE_DROP_STALE,
+    RX_CAPTURE_DROP_WINDOW,
+    RX_CAPTURE_DROP_POOL,
+    RX_CAPTURE_DROP_BASE,
+    RX_CAPTURE_OUTCOME_COUNT,
+} rx_capture_outcome_t;
+
+typedef struct {
+    uint64_t arrival_us;  // latency_stats clock when rx_task took the datagram
+    uint32_t frame_id;
+    uint16_t length;      // datagram bytes; 0 when a pool drop drained it unread
+    uint8_t run;          // socket index: run, then RUN_COUNT for parity
+    uint8_t outcome;      // rx_capture_outcome_t
+} rx_capture_entry_t;
+
+// Capture stream, used both for files and, sliced into chunks, for dumps
+// over UDP. Little-endian:
+//   0  "BCAP", u8 version, u8 side, u8 run_count, u8 entry_bytes
+//   8  u32 entry_count, u32 overwritten (entries lost to the ring before the oldest)
+//   16 u16 led_count[4], u16 port_base, u16 reserved, u32 reserved
+//   32 entries, oldest first: u64 arrival_us, u32 frame_id, u16 length, u8 run, u8 outcome
+#define RX_CAPTURE_VERSION 1
+#define RX_CAPTURE_HEADER_BYTES 32
+#define RX_CAPTURE_ENTRY_BYTES 16
+#define RX_CAPTURE_MAX_RUNS 4
+
+// Dump datagrams: "BD", u8 version, u8 reserved, u16 chunk_index,
+// u16 chunk_count, then bytes [chunk_index * RX_CAPTURE_CHUNK_BYTES, ...)
+// of the capture stream.
+#define RX_CAPTURE_CHUNK_HEADER_BYTES 8
+#define RX_CAPTURE_CHUNK_BYTES 1024
+#define RX_CAPTURE_DUMP_DATAGRAM_BYTES (RX_CAPTURE_CHUNK_HEADER_BYTES + RX_CAPTURE_CHUNK_BYTES)
+
+typedef struct {
+    uint8_t version;
+    uint8_t side;
+    uint8_t run_count;
+    uint16_t led_count[RX_CAPTURE_MAX_RUNS];
+    uint16_t port_base;
+    uint32_t entry_count;
+    uint32_t overwritten;
+} rx_capture_header_t;
+
+// Appends one entry, overwriting the oldest when full. Callers hold the
+// rx_task lock, which serialises every writer.
+#if RX_CAPTURE_ENTRIES > 0
+void rx_capture_record(uint64_t arrival_us, unsigned int run, uint32_t frame_id, size_t length,
+                       rx_capture_outcome_t outcome);
+#else
+static inline void rx_capture_record(uint64_t arrival_us, unsigned int run, uint32_t frame_id,
+                                     size_t length, rx_capture_outcome_t outcome)
+{
+    (void)arrival_us;
+    (void)run;
+    (void)frame_id;
+    (void)length;
+    (void)outcome;
+}
+#endif
+
+// While paused, records are discarded so a reader sees a fixed ring. Set it
+// under the rx_task lock; reads need no lock once it is set.
+void rx_capture_set_paused(bool paused);
+// Empties the ring and clears the overwritten count.
+void rx_capture_reset(void);
+// Entries held, at most RX_CAPTURE_ENTRIES.
+size_t rx_capture_count(void);
+// Copies up to max_entries entries, starting `first` entries after the
+// oldest. Returns the number copied.
+size_t rx_capture_read(size_t first, rx_capture_entry_t *entries, size_t max_entries);
+
+// Header describing the current ring and the build's layout.
+void rx_capture_header(rx_capture_header_t *header);
+void rx_capture_encode_header(const rx_capture_header_t *header, uint8_t *out);
+void rx_capture_encode_entry(const rx_capture_entry_t *entry, uint8_t *out);
+// False on bad magic, version or entry size.
+bool rx_capture_decode_header(const uint8_t *in, size_t length, rx_capture_header_t *header);
+void rx_capture_decode_entry(const uint8_t *in, rx_capture_entry_t *entry);
+
+// Chunks needed to dump the current ring, at least one for the header.
+unsigned int rx_capture_chunk_count(void);
+// Builds dump datagram `chunk_index` from the paused ring into `out`, which
+// holds RX_CAPTURE_DUMP_DATAGRAM_BYTES. Returns its length.
+size_t rx_capture_encode_chunk(unsigned int chunk_index, uint8_t *out);
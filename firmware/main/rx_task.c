@@ -1,43 +1,196 @@
 #include "rx_task.h"
 
 #include "config_autogen.h"
-#include "status_task.h"
+#include "event_log.h"
+#include "latency_stats.h"
+#include "metrics.h"
+#include "rx_capture.h"
 
+#include <stdatomic.h>
 #include <stdbool.h>
-#include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
 
 _Static_assert(RUN_COUNT <= 4, "RUN_COUNT exceeds supported maximum (4)");
 
+// 1 services every run socket from one task via select(); 0 runs one
+// listener task per run.
+#ifndef RX_MULTIPLEXED_LISTENER
+#define RX_MULTIPLEXED_LISTENER 0
+#endif
+#ifndef RX_MUX_TASK_PRIORITY
+#define RX_MUX_TASK_PRIORITY 5
+#endif
+#ifndef RX_MUX_TASK_CORE
+#define RX_MUX_TASK_CORE 0
+#endif
+// Per-socket receive buffer; 0 keeps the lwIP default.
+#ifndef RX_SOCKET_RCVBUF_BYTES
+#define RX_SOCKET_RCVBUF_BYTES 8192
+#endif
+
 #ifndef UNIT_TEST
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "freertos/semphr.h"
 #include "lwip/sockets.h"
+#include "esp_attr.h"
 #include "esp_log.h"
 #else
-// Minimal FreeRTOS semaphore stubs for host-side unit tests
-typedef int SemaphoreHandle_t;
-static inline SemaphoreHandle_t xSemaphoreCreateRecursiveMutex(void) { return 0; }
+#include <arpa/inet.h>
+#include <errno.h>
+#include <netinet/in.h>
+#include <pthread.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <time.h>
+// FreeRTOS recursive mutex stand-ins for host-side unit tests
+typedef pthread_mutex_t *SemaphoreHandle_t;
+static pthread_mutex_t host_recursive_mutex;
+static inline SemaphoreHandle_t xSemaphoreCreateRecursiveMutex(void) {
+    static bool initialised = false;
+    if (!initialised) {
+        pthread_mutexattr_t attributes;
+        pthread_mutexattr_init(&attributes);
+        pthread_mutexattr_settype(&attributes, PTHREAD_MUTEX_RECURSIVE);
+        pthread_mutex_init(&host_recursive_mutex, &attributes);
+        pthread_mutexattr_destroy(&attributes);
+        initialised = true;
+    }
+    return &host_recursive_mutex;
+}
 static inline void xSemaphoreTakeRecursive(SemaphoreHandle_t mutex, int ticks) {
-    (void)mutex;
     (void)ticks;
+    pthread_mutex_lock(mutex);
 }
-static inline void xSemaphoreGiveRecursive(SemaphoreHandle_t mutex) { (void)mutex; }
+static inline void xSemaphoreGiveRecursive(SemaphoreHandle_t mutex) { pthread_mutex_unlock(mutex); }
 #define portMAX_DELAY 0
+#define DMA_ATTR
 #endif
 
 
+_Static_assert(RX_SLOT_COUNT >= 2 && (RX_SLOT_COUNT & (RX_SLOT_COUNT - 1)) == 0,
+               "RX_SLOT_COUNT must be a power of two so slots survive frame_id wraparound");
+_Static_assert(EXPECTED_MASK == (1u << RUN_COUNT) - 1, "EXPECTED_MASK does not match RUN_COUNT");
+
+// Each assembly slot writes into its own bank. On completion the bank is
+// swapped with the published one; driver_task swaps its bank with the
+// published one when it picks up a frame. Banks: slots + published + driver.
+#define FRAME_BANK_COUNT (RX_SLOT_COUNT + 2)
+#define BANK_INDEX_MASK 0xFFu
+#define BANK_FRESH 0x100u
+_Static_assert(FRAME_BANK_COUNT <= BANK_INDEX_MASK + 1, "Too many frame banks");
+
+// Reassembly ring keyed by frame_id: frame N lives in slot N % RX_SLOT_COUNT.
+// A slot whose frame is older than the newest published frame is free, so
+// publishing evicts every older frame without touching their slots.
 typedef struct {
     uint32_t frame_id;
-    bool run_received[RUN_COUNT];
+    uint32_t received_mask;
+    uint64_t first_rx_us;
+    bool in_use;
+    bool published;
+    unsigned int bank;
+    // Bank received from the handoff, written once the slot is reused
+    unsigned int returned_bank;
+    bool has_parity;
+    uint8_t *parity;
+    // Fragment progress per run: fragment indices seen, the LED range each
+    // one last wrote, and the announced count, 0 until the run's first
+    // fragment
+    uint32_t fragment_mask[RUN_COUNT];
+    uint16_t fragment_first[RUN_COUNT][RX_MAX_FRAGMENTS];
+    uint16_t fragment_end[RUN_COUNT][RX_MAX_FRAGMENTS];
+    uint8_t fragment_total[RUN_COUNT];
 } FrameSlot;
 
-static FrameSlot frame_slots[2];
-static uint8_t **frame_buffers[2];
-static int current_slot_index = 0;
+// Receive buffers hold whole datagrams and are passed by pointer: a received
+// buffer replaces the bank's run buffer, whose old buffer returns to the
+// pool. Every bank always owns one buffer per run; the spares cover buffers
+// held by listeners while they wait in recvfrom.
+#define RX_HEADER_LENGTH 4
+#define RX_SPARE_BUFFERS_PER_RUN 2
+#define RX_POOL_BUFFERS_PER_RUN (FRAME_BANK_COUNT + RX_SPARE_BUFFERS_PER_RUN)
+
+#define RX_PARITY_PAYLOAD_LENGTH (MAX_RUN_LED_COUNT * 3)
+
+_Static_assert(RX_SLOT_COUNT == FRAME_ARENA_SLOT_COUNT &&
+                   RX_POOL_BUFFERS_PER_RUN == FRAME_ARENA_POOL_BUFFERS,
+               "Frame arena layout does not match the reassembly ring; rerun gen_config.py");
+_Static_assert(FRAME_ARENA_PARITY_SLOT_BYTES >= RX_PARITY_PAYLOAD_LENGTH,
+               "Frame arena parity slots are too small");
+_Static_assert(FRAME_ARENA_EXTENDED_RX_OFFSET - FRAME_ARENA_PARITY_RX_OFFSET >=
+                   RX_HEADER_LENGTH + RX_PARITY_PAYLOAD_LENGTH + 1,
+               "Frame arena parity receive buffer is too small");
+_Static_assert(FRAME_ARENA_BYTES - FRAME_ARENA_EXTENDED_RX_OFFSET >= RX_EXTENDED_MAX_BYTES + 1,
+               "Frame arena extended receive buffer is too small");
+_Static_assert(RX_MAX_FRAGMENTS <= 32, "fragment_mask holds one bit per fragment");
+
+// Every pool, bank and parity buffer, laid out by gen_config.py. Static
+// placement keeps it in internal DMA-capable RAM and leaves nothing to fail
+// at startup.
+static DMA_ATTR uint8_t frame_arena[FRAME_ARENA_BYTES]
+    __attribute__((aligned(FRAME_ARENA_ALIGN)));
+// Only one task receives parity, and one extended datagrams, so a single
+// receive buffer each suffices
+static uint8_t *const parity_receive_buffer = frame_arena + FRAME_ARENA_PARITY_RX_OFFSET;
+static uint8_t *const extended_receive_buffer = frame_arena + FRAME_ARENA_EXTENDED_RX_OFFSET;
+static uint8_t *free_buffers[RUN_COUNT][RX_POOL_BUFFERS_PER_RUN];
+static size_t free_buffer_count[RUN_COUNT];
+
+static FrameSlot frame_slots[RX_SLOT_COUNT];
+static rx_frame_t frame_banks[FRAME_BANK_COUNT];
+static atomic_uint published_bank;
+static unsigned int driver_bank;
+static bool have_published;
+static uint32_t last_published_id;
 static SemaphoreHandle_t frame_mutex;
 
+#ifndef UNIT_TEST
+static SemaphoreHandle_t frame_ready;
+
+static void signal_frame_ready(void) {
+    xSemaphoreGive(frame_ready);
+}
+
+bool rx_task_wait_for_frame(uint32_t timeout_ms) {
+    return xSemaphoreTake(frame_ready, pdMS_TO_TICKS(timeout_ms)) == pdTRUE;
+}
+#else
+// Condition variable stand-in for the binary semaphore used on target
+static pthread_mutex_t frame_ready_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t frame_ready_cond = PTHREAD_COND_INITIALIZER;
+static bool frame_ready;
+
+static void signal_frame_ready(void) {
+    pthread_mutex_lock(&frame_ready_mutex);
+    frame_ready = true;
+    pthread_cond_signal(&frame_ready_cond);
+    pthread_mutex_unlock(&frame_ready_mutex);
+}
+
+bool rx_task_wait_for_frame(uint32_t timeout_ms) {
+    struct timespec deadline;
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_sec += timeout_ms / 1000;
+    deadline.tv_nsec += (long)(timeout_ms % 1000) * 1000000L;
+    if (deadline.tv_nsec >= 1000000000L) {
+        deadline.tv_sec += 1;
+        deadline.tv_nsec -= 1000000000L;
+    }
+    pthread_mutex_lock(&frame_ready_mutex);
+    while (!frame_ready) {
+        if (pthread_cond_timedwait(&frame_ready_cond, &frame_ready_mutex, &deadline) != 0) {
+            break;
+        }
+    }
+    bool signalled = frame_ready;
+    frame_ready = false;
+    pthread_mutex_unlock(&frame_ready_mutex);
+    return signalled;
+}
+#endif
+
 void rx_task_lock(void) {
     xSemaphoreTakeRecursive(frame_mutex, portMAX_DELAY);
 }
@@ -50,151 +203,1050 @@ static bool frame_is_newer(uint32_t a, uint32_t b) {
     return (int32_t)(a - b) > 0;
 }
 
-static void allocate_buffers(void) {
-    for (int slot = 0; slot < 2; ++slot) {
-        frame_buffers[slot] = (uint8_t **)malloc(sizeof(uint8_t *) * RUN_COUNT);
-        for (int run = 0; run < RUN_COUNT; ++run) {
-            frame_buffers[slot][run] = (uint8_t *)malloc(LED_COUNT[run] * 3);
+size_t rx_task_rx_buffer_capacity(unsigned int run_index) {
+    // One byte beyond the valid length so oversized datagrams are not
+    // silently truncated to a valid size by recvfrom.
+    return RX_HEADER_LENGTH + LED_COUNT[run_index] * 3 + 1;
+}
+
+uint8_t *rx_task_acquire_rx_buffer(unsigned int run_index) {
+    if (run_index >= RUN_COUNT) {
+        return NULL;
+    }
+    uint8_t *buffer = NULL;
+    rx_task_lock();
+    if (free_buffer_count[run_index] > 0) {
+        buffer = free_buffers[run_index][--free_buffer_count[run_index]];
+    }
+    rx_task_unlock();
+    return buffer;
+}
+
+void rx_task_release_rx_buffer(unsigned int run_index, uint8_t *buffer) {
+    rx_task_lock();
+    free_buffers[run_index][free_buffer_count[run_index]++] = buffer;
+    rx_task_unlock();
+}
+
+size_t rx_task_free_rx_buffers(unsigned int run_index) {
+    if (run_index >= RUN_COUNT) {
+        return 0;
+    }
+    rx_task_lock();
+    size_t count = free_buffer_count[run_index];
+    rx_task_unlock();
+    return count;
+}
+
+static void place_buffers(void) {
+    memset(frame_arena, 0, sizeof(frame_arena));
+    for (int run = 0; run < RUN_COUNT; ++run) {
+        uint8_t *pool = frame_arena + RUN_POOL_OFFSET[run];
+        for (int bank = 0; bank < FRAME_BANK_COUNT; ++bank) {
+            frame_banks[bank].run_buffers[run] =
+                pool + RUN_BUFFER_STRIDE[run] * bank + RX_HEADER_LENGTH;
         }
+        free_buffer_count[run] = 0;
+        for (int spare = FRAME_BANK_COUNT; spare < RX_POOL_BUFFERS_PER_RUN; ++spare) {
+            free_buffers[run][free_buffer_count[run]++] = pool + RUN_BUFFER_STRIDE[run] * spare;
+        }
+    }
+    for (int bank = 0; bank < FRAME_BANK_COUNT; ++bank) {
+        frame_banks[bank].frame_id = 0;
+        frame_banks[bank].received_us = 0;
+        frame_banks[bank].completed_us = 0;
     }
+    for (unsigned int slot = 0; slot < RX_SLOT_COUNT; ++slot) {
+        frame_slots[slot].bank = slot;
+        frame_slots[slot].parity =
+            frame_arena + FRAME_ARENA_PARITY_OFFSET + FRAME_ARENA_PARITY_SLOT_BYTES * slot;
+    }
+    atomic_store(&published_bank, RX_SLOT_COUNT);
+    driver_bank = RX_SLOT_COUNT + 1;
 }
 
 static void clear_slot(FrameSlot *slot) {
     slot->frame_id = 0;
-    for (int run = 0; run < RUN_COUNT; ++run) {
-        slot->run_received[run] = false;
+    slot->received_mask = 0;
+    slot->in_use = false;
+    slot->has_parity = false;
+    memset(slot->fragment_mask, 0, sizeof(slot->fragment_mask));
+    memset(slot->fragment_total, 0, sizeof(slot->fragment_total));
+    if (slot->published) {
+        slot->bank = slot->returned_bank;
+        slot->published = false;
+    }
+}
+
+// True while the slot holds a frame that is still pending or is the newest
+// published one; anything older has been evicted.
+static bool slot_is_live(const FrameSlot *slot) {
+    if (!slot->in_use) {
+        return false;
+    }
+    return !have_published || slot->frame_id == last_published_id ||
+           frame_is_newer(slot->frame_id, last_published_id);
+}
+
+static void publish_slot(FrameSlot *slot) {
+    rx_frame_t *bank = &frame_banks[slot->bank];
+    bank->frame_id = slot->frame_id;
+    bank->received_us = slot->first_rx_us;
+    bank->completed_us = latency_stats_now_us();
+    latency_stats_record(LATENCY_STAGE_ASSEMBLE, bank->received_us, bank->completed_us);
+    unsigned int previous = atomic_exchange(&published_bank, slot->bank | BANK_FRESH);
+    slot->returned_bank = previous & BANK_INDEX_MASK;
+    slot->published = true;
+    if (have_published) {
+        uint32_t skipped = slot->frame_id - last_published_id - 1;
+        if (skipped > 0) {
+            metrics_add(METRIC_FRAMES_SKIPPED, skipped);
+            metrics_increment(METRIC_FRAME_GAPS);
+        }
+    }
+    last_published_id = slot->frame_id;
+    have_published = true;
+}
+
+int rx_task_slot_index(uint32_t frame_id) {
+    return (int)(frame_id % RX_SLOT_COUNT);
+}
+
+rx_frame_t *rx_task_acquire_frame(void) {
+    if ((atomic_load(&published_bank) & BANK_FRESH) == 0) {
+        return NULL;
+    }
+    unsigned int previous = atomic_exchange(&published_bank, driver_bank);
+    driver_bank = previous & BANK_INDEX_MASK;
+    return &frame_banks[driver_bank];
+}
+
+rx_frame_t *rx_task_driver_frame(void) {
+    return &frame_banks[driver_bank];
+}
+
+static uint32_t read_frame_id(const uint8_t *data) {
+    return ((uint32_t)data[0] << 24) |
+           ((uint32_t)data[1] << 16) |
+           ((uint32_t)data[2] << 8) |
+           (uint32_t)data[3];
+}
+
+static rx_capture_outcome_t capture_outcome(metric_id_t reason) {
+    switch (reason) {
+    case METRIC_DROPS_LEN:
+        return RX_CAPTURE_DROP_LEN;
+    case METRIC_DROPS_RUN:
+        return RX_CAPTURE_DROP_RUN;
+    case METRIC_DROPS_STALE:
+        return RX_CAPTURE_DROP_STALE;
+    case METRIC_DROPS_WINDOW:
+        return RX_CAPTURE_DROP_WINDOW;
+    case METRIC_DROPS_BASE:
+        return RX_CAPTURE_DROP_BASE;
+    default:
+        return RX_CAPTURE_DROP_POOL;
     }
 }
 
+static uint16_t read_u16(const uint8_t *data) {
+    return (uint16_t)(((uint16_t)data[0] << 8) | data[1]);
+}
+
+// frame_id of a datagram that may be too short to carry one
+static uint32_t header_frame_id(const uint8_t *data, size_t length) {
+    return length >= RX_HEADER_LENGTH ? read_frame_id(data) : 0;
+}
+
+// Records a datagram rejected before reaching the slots, where the lock is
+// not already held.
+static void capture_early_drop(uint64_t received_us, unsigned int socket_index,
+                               uint32_t frame_id, size_t length, metric_id_t reason) {
+#if RX_CAPTURE_ENTRIES > 0
+    rx_task_lock();
+    rx_capture_record(received_us, socket_index, frame_id, length, capture_outcome(reason));
+    rx_task_unlock();
+#else
+    (void)received_us;
+    (void)socket_index;
+    (void)frame_id;
+    (void)length;
+    (void)reason;
+#endif
+}
+
+static void count_run_drop(unsigned int run_index, metric_id_t reason) {
+    metrics_increment(reason);
+    metrics_increment_run(METRIC_RUN_DROPS, run_index);
+}
+
 void rx_task_process_packet(unsigned int run_index, const uint8_t *data, size_t length) {
     if (run_index >= RUN_COUNT) {
-        status_task_increment_drops();
+        metrics_increment(METRIC_DROPS_RUN);
+        capture_early_drop(latency_stats_now_us(), run_index, header_frame_id(data, length), length,
+                           METRIC_DROPS_RUN);
+        event_log_post(EVENT_RX_BAD_RUN, run_index);
         return;
     }
-    size_t expected_length = LED_COUNT[run_index] * 3 + 4;
+    size_t expected_length = LED_COUNT[run_index] * 3 + RX_HEADER_LENGTH;
     if (length != expected_length) {
-        status_task_increment_drops();
+        count_run_drop(run_index, METRIC_DROPS_LEN);
+        capture_early_drop(latency_stats_now_us(), run_index, header_frame_id(data, length), length,
+                           METRIC_DROPS_LEN);
+        event_log_post(EVENT_RX_BAD_LENGTH, run_index);
         return;
     }
-    uint32_t frame_id = ((uint32_t)data[0] << 24) |
-                        ((uint32_t)data[1] << 16) |
-                        ((uint32_t)data[2] << 8) |
-                        (uint32_t)data[3];
+    uint8_t *buffer = rx_task_acquire_rx_buffer(run_index);
+    if (buffer == NULL) {
+        count_run_drop(run_index, METRIC_DROPS_POOL);
+        capture_early_drop(latency_stats_now_us(), run_index, read_frame_id(data), length,
+                           METRIC_DROPS_POOL);
+        event_log_post(EVENT_RX_POOL_EXHAUSTED, run_index);
+        return;
+    }
+    memcpy(buffer, data, length);
+    rx_task_process_rx_buffer(run_index, buffer, length);
+}
+
+static void drop_rx_buffer(unsigned int run_index, uint8_t *buffer, metric_id_t reason) {
+    count_run_drop(run_index, reason);
+    rx_task_release_rx_buffer(run_index, buffer);
+}
+
+// Returns the slot assembling frame_id, claiming it if needed, or NULL when
+// the frame is stale or a newer frame holds its slot, with `drop_reason` set
+// to the matching drop metric. Caller holds the lock.
+static FrameSlot *claim_slot(uint32_t frame_id, uint64_t received_us, metric_id_t *drop_reason) {
+    if (have_published && !frame_is_newer(frame_id, last_published_id)) {
+        // Stale, or a late duplicate of a frame already handed to the driver
+        *drop_reason = METRIC_DROPS_STALE;
+        return NULL;
+    }
+    FrameSlot *slot = &frame_slots[rx_task_slot_index(frame_id)];
+    if (!slot_is_live(slot) ||
+        (slot->frame_id != frame_id && frame_is_newer(frame_id, slot->frame_id))) {
+        // Free, evicted, or holding an incomplete frame a full window older
+        clear_slot(slot);
+        slot->frame_id = frame_id;
+        slot->first_rx_us = received_us;
+        slot->in_use = true;
+    } else if (slot->frame_id != frame_id) {
+        // A newer frame already owns this slot; the window cannot reach back
+        *drop_reason = METRIC_DROPS_WINDOW;
+        return NULL;
+    }
+    return slot;
+}
+
+// Rebuilds the single missing run as parity XOR every received run. Runs
+// shorter than the missing one contribute zeros past their end.
+static void recover_missing_run(FrameSlot *slot, unsigned int missing_run) {
+    rx_frame_t *bank = &frame_banks[slot->bank];
+    size_t length = LED_COUNT[missing_run] * 3;
+    uint8_t *output = bank->run_buffers[missing_run];
+    memcpy(output, slot->parity, length);
+    for (unsigned int run = 0; run < RUN_COUNT; ++run) {
+        if (run == missing_run) {
+            continue;
+        }
+        const uint8_t *input = bank->run_buffers[run];
+        size_t run_length = LED_COUNT[run] * 3;
+        size_t overlap = run_length < length ? run_length : length;
+        for (size_t index = 0; index < overlap; ++index) {
+            output[index] ^= input[index];
+        }
+    }
+    slot->received_mask |= 1u << missing_run;
+    metrics_increment(METRIC_PARITY_RECOVERED);
+    metrics_increment_run(METRIC_RUN_RECOVERED, missing_run);
+}
+
+// Publishes the slot once every run is present, recovering one missing run
+// from parity first. Returns true when the frame was published.
+static bool try_complete_slot(FrameSlot *slot) {
+    uint32_t missing = EXPECTED_MASK & ~slot->received_mask;
+    if (missing != 0 && slot->has_parity && (missing & (missing - 1)) == 0) {
+        recover_missing_run(slot, (unsigned int)__builtin_ctz(missing));
+    }
+    if (slot->received_mask != EXPECTED_MASK) {
+        return false;
+    }
+    metrics_increment(METRIC_COMPLETE);
+    publish_slot(slot);
+    return true;
+}
+
+void rx_task_process_rx_buffer(unsigned int run_index, uint8_t *buffer, size_t length) {
+    uint64_t received_us = latency_stats_now_us();
+    size_t expected_length = LED_COUNT[run_index] * 3 + RX_HEADER_LENGTH;
+    if (length != expected_length) {
+        capture_early_drop(received_us, run_index, header_frame_id(buffer, length), length,
+                           METRIC_DROPS_LEN);
+        drop_rx_buffer(run_index, buffer, METRIC_DROPS_LEN);
+        event_log_post(EVENT_RX_BAD_LENGTH, run_index);
+        return;
+    }
+    uint32_t frame_id = read_frame_id(buffer);
     rx_task_lock();
 
-    FrameSlot *current_slot = &frame_slots[current_slot_index];
-    FrameSlot *next_slot = &frame_slots[1 - current_slot_index];
-    FrameSlot *target_slot = NULL;
-
-    if (frame_id == current_slot->frame_id || current_slot->frame_id == 0) {
-        current_slot->frame_id = frame_id;
-        target_slot = current_slot;
-    } else if (frame_id == next_slot->frame_id) {
-        target_slot = next_slot;
-    } else if (frame_is_newer(frame_id, current_slot->frame_id)) {
-        if (next_slot->frame_id == 0 || frame_is_newer(next_slot->frame_id, frame_id)) {
-            clear_slot(next_slot);
-            next_slot->frame_id = frame_id;
-            target_slot = next_slot;
+    metric_id_t drop_reason;
+    FrameSlot *target_slot = claim_slot(frame_id, received_us, &drop_reason);
+    if (target_slot == NULL) {
+        rx_capture_record(received_us, run_index, frame_id, length, capture_outcome(drop_reason));
+        drop_rx_buffer(run_index, buffer, drop_reason);
+        rx_task_unlock();
+        return;
+    }
+    rx_capture_record(received_us, run_index, frame_id, length, RX_CAPTURE_ACCEPTED);
+
+    metrics_increment(METRIC_RX_FRAMES);
+    metrics_increment_run(METRIC_RUN_RX, run_index);
+
+    // Swap the datagram in as the run buffer; the payload is kept as-is and
+    // driver_task handles RGB to GRB reordering.
+    uint8_t **run_buffer = &frame_banks[target_slot->bank].run_buffers[run_index];
+    uint8_t *previous_buffer = *run_buffer - RX_HEADER_LENGTH;
+    *run_buffer = buffer + RX_HEADER_LENGTH;
+    rx_task_release_rx_buffer(run_index, previous_buffer);
+
+    target_slot->received_mask |= 1u << run_index;
+    bool complete = try_complete_slot(target_slot);
+
+    rx_task_unlock();
+
+    if (complete) {
+        signal_frame_ready();
+    }
+}
+
+size_t rx_task_parity_length(void) {
+    return RX_HEADER_LENGTH + RX_PARITY_PAYLOAD_LENGTH;
+}
+
+void rx_task_process_parity(const uint8_t *data, size_t length) {
+    uint64_t received_us = latency_stats_now_us();
+    if (length != rx_task_parity_length()) {
+        metrics_increment(METRIC_DROPS_LEN);
+        capture_early_drop(received_us, RX_PARITY_SOCKET_INDEX, header_frame_id(data, length),
+                           length, METRIC_DROPS_LEN);
+        event_log_post(EVENT_RX_BAD_LENGTH, RX_PARITY_SOCKET_INDEX);
+        return;
+    }
+    uint32_t frame_id = read_frame_id(data);
+    rx_task_lock();
+    // Parity for a frame that already completed is simply not needed, so
+    // it is not counted as a drop; the capture still records why
+    metric_id_t unused_reason;
+    FrameSlot *slot = claim_slot(frame_id, received_us, &unused_reason);
+    rx_capture_record(received_us, RX_PARITY_SOCKET_INDEX, frame_id, length,
+                      slot != NULL ? RX_CAPTURE_ACCEPTED : capture_outcome(unused_reason));
+    bool complete = false;
+    if (slot != NULL && !slot->has_parity) {
+        memcpy(slot->parity, data + RX_HEADER_LENGTH, RX_PARITY_PAYLOAD_LENGTH);
+        slot->has_parity = true;
+        complete = try_complete_slot(slot);
+    }
+    rx_task_unlock();
+    if (complete) {
+        signal_frame_ready();
+    }
+}
+
+// True when a delta's tokens expand to exactly `output_bytes` and end on
+// the payload's last byte.
+static bool delta_tokens_are_valid(const uint8_t *tokens, size_t token_bytes,
+                                   size_t output_bytes) {
+    size_t input = 0;
+    size_t output = 0;
+    while (input < token_bytes) {
+        unsigned int token = tokens[input++];
+        if (token < RX_DELTA_LITERAL) {
+            output += token + 1;
         } else {
-            status_task_increment_drops();
-            rx_task_unlock();
-            return;
+            size_t literals = token - RX_DELTA_LITERAL + 1;
+            input += literals;
+            output += literals;
         }
-    } else {
-        status_task_increment_drops();
-        rx_task_unlock();
+    }
+    return input == token_bytes && output == output_bytes;
+}
+
+// Index bytes a palette block needs for `leds` LEDs.
+static size_t palette_index_bytes(unsigned int encoding, size_t leds) {
+    return encoding == RX_ENCODING_PALETTE8 ? leds : (leds + 1) / 2;
+}
+
+// True when a palette payload holds exactly its palette and indices, and
+// every index names a palette colour.
+static bool palette_is_valid(unsigned int encoding, const uint8_t *payload, size_t payload_bytes) {
+    if (payload_bytes < RX_PALETTE_HEADER_BYTES) {
+        return false;
+    }
+    size_t leds = read_u16(payload);
+    size_t colours = payload[2] + 1u;
+    if (leds == 0 || (encoding == RX_ENCODING_PALETTE4 && colours > 16) ||
+        payload_bytes !=
+            RX_PALETTE_HEADER_BYTES + colours * 3 + palette_index_bytes(encoding, leds)) {
+        return false;
+    }
+    // The highest index is found without branching, which vectorises
+    const uint8_t *indices = payload + RX_PALETTE_HEADER_BYTES + colours * 3;
+    unsigned int highest = 0;
+    if (encoding == RX_ENCODING_PALETTE8) {
+        for (size_t led = 0; led < leds; ++led) {
+            highest = indices[led] > highest ? indices[led] : highest;
+        }
+        return highest < colours;
+    }
+    for (size_t byte = 0; byte < leds / 2; ++byte) {
+        unsigned int high = indices[byte] >> 4;
+        unsigned int low = indices[byte] & 0x0fu;
+        highest = high > highest ? high : highest;
+        highest = low > highest ? low : highest;
+    }
+    // The odd last LED's partner nibble is padding
+    return highest < colours &&
+           (leds % 2 == 0 || ((indices[leds / 2] >> 4) < colours && (indices[leds / 2] & 0x0f) == 0));
+}
+
+// Samples a sampled block carries for a section of `leds` LEDs: LED 0, every
+// stride-th LED after it, and the last LED.
+static size_t section_samples(size_t leds, unsigned int stride) {
+    return (leds + stride - 2) / stride + 1;
+}
+
+// True when a sampled payload covers whole sections of the run from
+// first_led on and holds exactly their samples.
+static bool sampled_is_valid(unsigned int run_index, size_t first_led, const uint8_t *payload,
+                             size_t payload_bytes) {
+    if (payload_bytes < RX_SAMPLED_HEADER_BYTES) {
+        return false;
+    }
+    size_t leds = read_u16(payload);
+    unsigned int stride = payload[2];
+    if (leds == 0 || stride == 0 || stride > RX_SAMPLED_MAX_STRIDE) {
+        return false;
+    }
+    size_t covered = 0;
+    size_t samples = 0;
+    unsigned int end = RUN_FIRST_SECTION[run_index] + RUN_SECTION_COUNT[run_index];
+    for (unsigned int section = RUN_FIRST_SECTION[run_index]; section < end && covered < leds;
+         ++section) {
+        if (SECTION_FIRST_LED[section] < first_led) {
+            continue;
+        }
+        if (covered == 0 && SECTION_FIRST_LED[section] != first_led) {
+            return false;
+        }
+        covered += SECTION_LED_COUNT[section];
+        samples += section_samples(SECTION_LED_COUNT[section], stride);
+    }
+    return covered == leds && payload_bytes == RX_SAMPLED_HEADER_BYTES + samples * 3;
+}
+
+// LEDs covered by a well-formed block.
+static size_t block_leds(const uint8_t *block) {
+    switch (block[1]) {
+    case RX_ENCODING_XOR_RLE:
+        return read_u16(block + RX_BLOCK_HEADER_BYTES + 4);
+    case RX_ENCODING_PALETTE8:
+    case RX_ENCODING_PALETTE4:
+    case RX_ENCODING_SAMPLED:
+        return read_u16(block + RX_BLOCK_HEADER_BYTES);
+    default:
+        return read_u16(block + 6) / 3;
+    }
+}
+
+// Checks one block at `block` with `remaining` datagram bytes left, and
+// returns its size or 0 when malformed. `run_index` is set once the block
+// header is readable.
+static size_t extended_block_size(const uint8_t *block, size_t remaining, unsigned int *run_index,
+                                  metric_id_t *drop_reason) {
+    if (remaining < RX_BLOCK_HEADER_BYTES) {
+        return 0;
+    }
+    *run_index = block[0];
+    if (*run_index >= RUN_COUNT) {
+        *drop_reason = METRIC_DROPS_RUN;
+        return 0;
+    }
+    unsigned int fragment_index = block[2];
+    unsigned int fragment_total = block[3];
+    size_t first_led = read_u16(block + 4);
+    size_t payload_bytes = read_u16(block + 6);
+    const uint8_t *payload = block + RX_BLOCK_HEADER_BYTES;
+    if (RX_BLOCK_HEADER_BYTES + payload_bytes > remaining || payload_bytes == 0 ||
+        fragment_total == 0 || fragment_total > RX_MAX_FRAGMENTS ||
+        fragment_index >= fragment_total) {
+        return 0;
+    }
+    bool valid;
+    switch (block[1]) {
+    case RX_ENCODING_RGB:
+        valid = payload_bytes % 3 == 0;
+        break;
+    case RX_ENCODING_XOR_RLE:
+        valid = payload_bytes > RX_DELTA_HEADER_BYTES && read_u16(payload + 4) > 0 &&
+                delta_tokens_are_valid(payload + RX_DELTA_HEADER_BYTES,
+                                       payload_bytes - RX_DELTA_HEADER_BYTES,
+                                       read_u16(payload + 4) * 3u);
+        break;
+    case RX_ENCODING_PALETTE8:
+    case RX_ENCODING_PALETTE4:
+        valid = palette_is_valid(block[1], payload, payload_bytes);
+        break;
+    case RX_ENCODING_SAMPLED:
+        valid = sampled_is_valid(*run_index, first_led, payload, payload_bytes);
+        break;
+    default:
+        valid = false;
+        break;
+    }
+    valid = valid && first_led + block_leds(block) <= LED_COUNT[*run_index];
+    return valid ? RX_BLOCK_HEADER_BYTES + payload_bytes : 0;
+}
+
+// Checks everything about an extended datagram that does not depend on
+// assembly state: the header, then every block, which must fill the
+// datagram exactly. `run_index` names the run of the offending block, or
+// RUN_COUNT when the header is at fault.
+static bool extended_is_valid(const uint8_t *data, size_t length, unsigned int *run_index,
+                              metric_id_t *drop_reason) {
+    *drop_reason = METRIC_DROPS_LEN;
+    if (length < RX_EXTENDED_HEADER_BYTES || length > RX_EXTENDED_MAX_BYTES ||
+        data[4] != RX_EXTENDED_MAGIC0 || data[5] != RX_EXTENDED_MAGIC1 ||
+        data[6] != RX_EXTENDED_VERSION || data[7] == 0) {
+        return false;
+    }
+    size_t offset = RX_EXTENDED_HEADER_BYTES;
+    for (unsigned int block = 0; block < data[7]; ++block) {
+        size_t size = extended_block_size(data + offset, length - offset, run_index, drop_reason);
+        if (size == 0) {
+            return false;
+        }
+        offset += size;
+    }
+    return offset == length;
+}
+
+static size_t block_size(const uint8_t *block) {
+    return RX_BLOCK_HEADER_BYTES + read_u16(block + 6);
+}
+
+// The slot holding base_id with run_index complete, or NULL when the
+// assembler no longer (or does not yet) hold it. Caller holds the lock.
+static const FrameSlot *delta_base_slot(uint32_t frame_id, uint32_t base_id,
+                                        unsigned int run_index) {
+    const FrameSlot *slot = &frame_slots[rx_task_slot_index(base_id)];
+    if (!frame_is_newer(frame_id, base_id) || !slot_is_live(slot) || slot->frame_id != base_id ||
+        (slot->received_mask & (1u << run_index)) == 0) {
+        return NULL;
+    }
+    return slot;
+}
+
+// True when some delta block's base frame is not available.
+static bool delta_base_missing(uint32_t frame_id, const uint8_t *data, size_t length) {
+    for (size_t offset = RX_EXTENDED_HEADER_BYTES; offset < length;
+         offset += block_size(data + offset)) {
+        const uint8_t *block = data + offset;
+        if (block[1] == RX_ENCODING_XOR_RLE &&
+            delta_base_slot(frame_id, read_frame_id(block + RX_BLOCK_HEADER_BYTES), block[0]) ==
+                NULL) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Expands validated delta tokens against `base` into `output` in one pass.
+static void decode_delta(uint8_t *output, const uint8_t *base, const uint8_t *tokens,
+                         size_t token_bytes) {
+    const uint8_t *end = tokens + token_bytes;
+    while (tokens < end) {
+        unsigned int token = *tokens++;
+        if (token < RX_DELTA_LITERAL) {
+            size_t count = token + 1;
+            memcpy(output, base, count);
+            output += count;
+            base += count;
+        } else {
+            size_t count = token - RX_DELTA_LITERAL + 1;
+            for (size_t index = 0; index < count; ++index) {
+                output[index] = base[index] ^ tokens[index];
+            }
+            tokens += count;
+            output += count;
+            base += count;
+        }
+    }
+}
+
+// Looks every index of a validated palette payload up into `output` in one
+// pass. Every LED but the last is written as one 4-byte store whose spare
+// byte the next LED overwrites; the last palette entry's spare byte is the
+// first index, so reads stay inside the payload.
+static void expand_palette(uint8_t *output, unsigned int encoding, const uint8_t *payload) {
+    size_t leds = read_u16(payload);
+    const uint8_t *palette = payload + RX_PALETTE_HEADER_BYTES;
+    const uint8_t *indices = palette + (payload[2] + 1u) * 3;
+    size_t last = leds - 1;
+    if (encoding == RX_ENCODING_PALETTE8) {
+        for (size_t led = 0; led < last; ++led, output += 3) {
+            memcpy(output, palette + indices[led] * 3u, 4);
+        }
+        memcpy(output, palette + indices[last] * 3u, 3);
         return;
     }
+    // Whole bytes, high nibble first, while both LEDs precede the last
+    size_t pairs = last / 2;
+    for (size_t byte = 0; byte < pairs; ++byte, output += 6) {
+        memcpy(output, palette + (indices[byte] >> 4) * 3u, 4);
+        memcpy(output + 3, palette + (indices[byte] & 0x0fu) * 3u, 4);
+    }
+    for (size_t led = pairs * 2; led <= last; ++led, output += 3) {
+        unsigned int index = led % 2 == 0 ? indices[led / 2] >> 4 : indices[led / 2] & 0x0fu;
+        memcpy(output, palette + index * 3, led == last ? 3 : 4);
+    }
+}
 
-    status_task_increment_rx_frames();
+// Interpolates one section of `leds` LEDs from its samples into `output`.
+// Between samples `span` LEDs apart, LED `step` is
+//   (from * (span - step) + to * step + span / 2) / span
+// The numerator steps by to - from per LED, and the division is a
+// multiplication by a 22-bit reciprocal, which is exact while
+// span <= RX_SAMPLED_MAX_STRIDE. Only the last span can be shorter than the
+// stride, so at most two reciprocals are computed.
+static void interpolate_section(uint8_t *output, const uint8_t *samples, size_t leds,
+                                unsigned int stride) {
+    size_t last = leds - 1;
+    const uint32_t stride_reciprocal = ((1u << 22) + stride - 1) / stride;
+    for (size_t start = 0; start < last; start += stride, samples += 3) {
+        uint32_t span = stride;
+        uint32_t reciprocal = stride_reciprocal;
+        if (last - start < stride) {
+            span = (uint32_t)(last - start);
+            reciprocal = ((1u << 22) + span - 1) / span;
+        }
+        uint32_t numerator[3];
+        uint32_t increment[3];
+        for (unsigned int channel = 0; channel < 3; ++channel) {
+            numerator[channel] = samples[channel] * span + span / 2;
+            // Wraps when decreasing; the sum stays in range
+            increment[channel] = (uint32_t)samples[channel + 3] - samples[channel];
+        }
+        for (uint32_t step = 0; step < span; ++step, output += 3) {
+            output[0] = (uint8_t)((numerator[0] * reciprocal) >> 22);
+            output[1] = (uint8_t)((numerator[1] * reciprocal) >> 22);
+            output[2] = (uint8_t)((numerator[2] * reciprocal) >> 22);
+            numerator[0] += increment[0];
+            numerator[1] += increment[1];
+            numerator[2] += increment[2];
+        }
+    }
+    memcpy(output, samples, 3);
+}
 
-    size_t payload_length = LED_COUNT[run_index] * 3;
-    uint8_t *destination_buffer =
-        frame_buffers[target_slot == current_slot ? current_slot_index : 1 - current_slot_index][run_index];
-    // Copy payload as-is; driver_task handles any RGB to GRB reordering.
-    memcpy(destination_buffer, data + 4, payload_length);
+// Expands a validated sampled payload, section by section from first_led.
+static void interpolate_sections(uint8_t *output, unsigned int run_index, size_t first_led,
+                                 const uint8_t *payload) {
+    size_t leds = read_u16(payload);
+    unsigned int stride = payload[2];
+    const uint8_t *samples = payload + RX_SAMPLED_HEADER_BYTES;
+    unsigned int section = RUN_FIRST_SECTION[run_index];
+    while (SECTION_FIRST_LED[section] != first_led) {
+        ++section;
+    }
+    for (size_t covered = 0; covered < leds; ++section) {
+        size_t section_leds = SECTION_LED_COUNT[section];
+        interpolate_section(output, samples, section_leds, stride);
+        output += section_leds * 3;
+        samples += section_samples(section_leds, stride) * 3;
+        covered += section_leds;
+    }
+}
+
+// True when the run's fragments, in index order, cover its LEDs back to
+// back from LED 0, so no LED keeps a byte from an older frame.
+static bool fragments_tile_run(const FrameSlot *slot, unsigned int run_index,
+                               unsigned int fragment_total) {
+    unsigned int next_led = 0;
+    for (unsigned int index = 0; index < fragment_total; ++index) {
+        if (slot->fragment_first[run_index][index] != next_led) {
+            return false;
+        }
+        next_led = slot->fragment_end[run_index][index];
+    }
+    return next_led == LED_COUNT[run_index];
+}
 
-    target_slot->run_received[run_index] = true;
+// Writes a fragment into the slot's frame and returns true once the run is
+// complete. A repeated fragment is written again and its LED range replaces
+// the one recorded for its index. Delta bases were checked by
+// delta_base_missing.
+static bool apply_fragment(FrameSlot *slot, uint32_t frame_id, unsigned int run_index,
+                           const uint8_t *block) {
+    unsigned int fragment_index = block[2];
+    unsigned int fragment_total = block[3];
+    size_t first_led = read_u16(block + 4);
+    size_t payload_bytes = read_u16(block + 6);
+    const uint8_t *payload = block + RX_BLOCK_HEADER_BYTES;
+    uint8_t *output = frame_banks[slot->bank].run_buffers[run_index] + first_led * 3;
+    switch (block[1]) {
+    case RX_ENCODING_XOR_RLE: {
+        const FrameSlot *base_slot = delta_base_slot(frame_id, read_frame_id(payload), run_index);
+        const uint8_t *base = frame_banks[base_slot->bank].run_buffers[run_index] + first_led * 3;
+        decode_delta(output, base, payload + RX_DELTA_HEADER_BYTES,
+                     payload_bytes - RX_DELTA_HEADER_BYTES);
+        break;
+    }
+    case RX_ENCODING_PALETTE8:
+    case RX_ENCODING_PALETTE4:
+        expand_palette(output, block[1], payload);
+        break;
+    case RX_ENCODING_SAMPLED:
+        interpolate_sections(output, run_index, first_led, payload);
+        break;
+    default:
+        memcpy(output, payload, payload_bytes);
+        break;
+    }
+    slot->fragment_mask[run_index] |= 1u << fragment_index;
+    slot->fragment_first[run_index][fragment_index] = (uint16_t)first_led;
+    slot->fragment_end[run_index][fragment_index] = (uint16_t)(first_led + block_leds(block));
+    slot->fragment_total[run_index] = (uint8_t)fragment_total;
+    uint32_t all = fragment_total == 32 ? UINT32_MAX : (1u << fragment_total) - 1;
+    return slot->fragment_mask[run_index] == all &&
+           fragments_tile_run(slot, run_index, fragment_total);
+}
 
-    bool complete = true;
-    for (int run = 0; run < RUN_COUNT; ++run) {
-        if (!target_slot->run_received[run]) {
-            complete = false;
-            break;
+// True when a block announces a different fragment count than earlier
+// fragments of its run in the same frame, whether those arrived in earlier
+// datagrams or earlier in this one.
+static bool fragment_count_disagrees(const FrameSlot *slot, const uint8_t *data, size_t length) {
+    uint8_t known[RUN_COUNT];
+    memcpy(known, slot->fragment_total, sizeof(known));
+    for (size_t offset = RX_EXTENDED_HEADER_BYTES; offset < length;
+         offset += block_size(data + offset)) {
+        const uint8_t *block = data + offset;
+        if (known[block[0]] != 0 && known[block[0]] != block[3]) {
+            return true;
         }
+        known[block[0]] = block[3];
     }
-    if (complete) {
-        status_task_increment_complete();
+    return false;
+}
+
+// A dropped extended datagram counts once towards the drop reason and once
+// for each run it carried.
+static void count_extended_drop(const uint8_t *data, size_t length, metric_id_t reason) {
+    metrics_increment(reason);
+    for (size_t offset = RX_EXTENDED_HEADER_BYTES; offset < length;
+         offset += block_size(data + offset)) {
+        metrics_increment_run(METRIC_RUN_DROPS, data[offset]);
     }
-    if (target_slot == next_slot && complete) {
-        current_slot_index = 1 - current_slot_index;
-        clear_slot(&frame_slots[1 - current_slot_index]);
+}
+
+void rx_task_process_extended(const uint8_t *data, size_t length) {
+    uint64_t received_us = latency_stats_now_us();
+    unsigned int run_index = RUN_COUNT;
+    metric_id_t drop_reason;
+    if (!extended_is_valid(data, length, &run_index, &drop_reason)) {
+        if (drop_reason == METRIC_DROPS_RUN) {
+            metrics_increment(METRIC_DROPS_RUN);
+            event_log_post(EVENT_RX_BAD_RUN, run_index);
+        } else if (run_index < RUN_COUNT) {
+            count_run_drop(run_index, METRIC_DROPS_LEN);
+            event_log_post(EVENT_RX_BAD_LENGTH, run_index);
+        } else {
+            metrics_increment(METRIC_DROPS_LEN);
+            event_log_post(EVENT_RX_BAD_LENGTH, RX_EXTENDED_SOCKET_INDEX);
+        }
+        capture_early_drop(received_us, RX_EXTENDED_SOCKET_INDEX, header_frame_id(data, length),
+                           length, drop_reason);
+        return;
     }
+    uint32_t frame_id = read_frame_id(data);
+    rx_task_lock();
+    FrameSlot *slot = claim_slot(frame_id, received_us, &drop_reason);
+    if (slot != NULL && fragment_count_disagrees(slot, data, length)) {
+        // Fragments of one run disagree on how many there are
+        slot = NULL;
+        drop_reason = METRIC_DROPS_LEN;
+    } else if (slot != NULL && delta_base_missing(frame_id, data, length)) {
+        // Evicted or never received: the run waits for a keyframe
+        slot = NULL;
+        drop_reason = METRIC_DROPS_BASE;
+    }
+    if (slot == NULL) {
+        rx_capture_record(received_us, RX_EXTENDED_SOCKET_INDEX, frame_id, length,
+                          capture_outcome(drop_reason));
+        count_extended_drop(data, length, drop_reason);
+        rx_task_unlock();
+        return;
+    }
+    rx_capture_record(received_us, RX_EXTENDED_SOCKET_INDEX, frame_id, length,
+                      RX_CAPTURE_ACCEPTED);
 
+    // Every block lands in the frame before the slot is checked, so a
+    // batched datagram completes a frame at most once
+    bool run_completed = false;
+    for (size_t offset = RX_EXTENDED_HEADER_BYTES; offset < length;
+         offset += block_size(data + offset)) {
+        const uint8_t *block = data + offset;
+        run_index = block[0];
+        metrics_increment(METRIC_RX_FRAMES);
+        metrics_increment_run(METRIC_RUN_RX, run_index);
+        uint32_t run_bit = 1u << run_index;
+        if (apply_fragment(slot, frame_id, run_index, block) && (slot->received_mask & run_bit) == 0) {
+            slot->received_mask |= run_bit;
+            run_completed = true;
+        }
+    }
+    bool complete = run_completed && try_complete_slot(slot);
     rx_task_unlock();
+    if (complete) {
+        signal_frame_ready();
+    }
 }
 
-#ifndef UNIT_TEST
-static void udp_listener_task(void *param) {
-    unsigned int run_index = (unsigned int)(uintptr_t)param;
+uint16_t rx_task_socket_port(unsigned int socket_index) {
+#if RX_EXTENDED_ENABLED
+    if (socket_index == RX_EXTENDED_SOCKET_INDEX) {
+        return PORT_BASE + RX_EXTENDED_PORT_OFFSET;
+    }
+#endif
+    return (uint16_t)(PORT_BASE + socket_index);
+}
+
+int rx_task_open_run_socket(uint16_t port) {
     int sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if (sock < 0) {
+        return -1;
+    }
+#if RX_SOCKET_RCVBUF_BYTES > 0
+    int receive_buffer = RX_SOCKET_RCVBUF_BYTES;
+    setsockopt(sock, SOL_SOCKET, SO_RCVBUF, &receive_buffer, sizeof(receive_buffer));
+#endif
     struct sockaddr_in addr = {
         .sin_family = AF_INET,
         .sin_addr.s_addr = htonl(INADDR_ANY),
-        .sin_port = htons(PORT_BASE + run_index),
+        .sin_port = htons(port),
     };
-    bind(sock, (struct sockaddr *)&addr, sizeof(addr));
-    size_t buffer_length = LED_COUNT[run_index] * 3 + 4;
-    uint8_t *buffer = (uint8_t *)malloc(buffer_length);
-    for (;;) {
-        ssize_t received = recvfrom(sock, buffer, buffer_length, 0, NULL, NULL);
-        if (received > 0) {
-            rx_task_process_packet(run_index, buffer, (size_t)received);
+    if (bind(sock, (struct sockaddr *)&addr, sizeof(addr)) != 0) {
+        close(sock);
+        return -1;
+    }
+    return sock;
+}
+
+// Receives one datagram for the run into a pool buffer. Returns false when
+// nothing was waiting (non-blocking) or the socket failed.
+static bool receive_run_datagram(int sock, unsigned int run_index, int flags) {
+    uint8_t *buffer = rx_task_acquire_rx_buffer(run_index);
+    if (buffer == NULL) {
+        // Pool exhausted: drain the datagram so the socket keeps flowing
+        uint8_t discard[RX_HEADER_LENGTH];
+        ssize_t received = recvfrom(sock, discard, sizeof(discard), flags, NULL, NULL);
+        if (received < 0) {
+            return false;
+        }
+        count_run_drop(run_index, METRIC_DROPS_POOL);
+        // Only the header was read, so the datagram's length is unknown
+        capture_early_drop(latency_stats_now_us(), run_index,
+                           header_frame_id(discard, (size_t)received),
+                           (size_t)received < RX_HEADER_LENGTH ? (size_t)received : 0,
+                           METRIC_DROPS_POOL);
+        event_log_post(EVENT_RX_POOL_EXHAUSTED, run_index);
+        return true;
+    }
+    ssize_t received = recvfrom(sock, buffer, rx_task_rx_buffer_capacity(run_index), flags, NULL, NULL);
+    if (received <= 0) {
+        rx_task_release_rx_buffer(run_index, buffer);
+        return false;
+    }
+    rx_task_process_rx_buffer(run_index, buffer, (size_t)received);
+    return true;
+}
+
+static bool receive_parity_datagram(int sock, int flags) {
+    ssize_t received = recvfrom(sock, parity_receive_buffer, rx_task_parity_length() + 1,
+                                flags, NULL, NULL);
+    if (received <= 0) {
+        return false;
+    }
+    rx_task_process_parity(parity_receive_buffer, (size_t)received);
+    return true;
+}
+
+static bool receive_extended_datagram(int sock, int flags) {
+    ssize_t received = recvfrom(sock, extended_receive_buffer, RX_EXTENDED_MAX_BYTES + 1, flags,
+                                NULL, NULL);
+    if (received <= 0) {
+        return false;
+    }
+    rx_task_process_extended(extended_receive_buffer, (size_t)received);
+    return true;
+}
+
+static bool receive_datagram(const int *sockets, unsigned int socket_index, int flags) {
+#if RX_PARITY_ENABLED
+    if (socket_index == RX_PARITY_SOCKET_INDEX) {
+        return receive_parity_datagram(sockets[socket_index], flags);
+    }
+#endif
+#if RX_EXTENDED_ENABLED
+    if (socket_index == RX_EXTENDED_SOCKET_INDEX) {
+        return receive_extended_datagram(sockets[socket_index], flags);
+    }
+#endif
+    return receive_run_datagram(sockets[socket_index], socket_index, flags);
+}
+
+size_t rx_task_service_sockets(const int *sockets, uint32_t timeout_ms) {
+    fd_set ready;
+    FD_ZERO(&ready);
+    int max_socket = -1;
+    for (unsigned int index = 0; index < RX_SOCKET_COUNT; ++index) {
+        FD_SET(sockets[index], &ready);
+        if (sockets[index] > max_socket) {
+            max_socket = sockets[index];
         }
     }
+    struct timeval timeout = {
+        .tv_sec = timeout_ms / 1000,
+        .tv_usec = (timeout_ms % 1000) * 1000,
+    };
+    if (select(max_socket + 1, &ready, NULL, NULL, &timeout) <= 0) {
+        return 0;
+    }
+    // Drain everything queued so back-to-back runs cost one wakeup. Taking
+    // one datagram per socket per pass keeps runs of the same frame together.
+    size_t processed = 0;
+    bool progressed = true;
+    while (progressed) {
+        progressed = false;
+        for (unsigned int index = 0; index < RX_SOCKET_COUNT; ++index) {
+            if (FD_ISSET(sockets[index], &ready) &&
+                receive_datagram(sockets, index, MSG_DONTWAIT)) {
+                ++processed;
+                progressed = true;
+            } else {
+                FD_CLR(sockets[index], &ready);
+            }
+        }
+    }
+    return processed;
+}
+
+#ifndef UNIT_TEST
+#if RX_MULTIPLEXED_LISTENER
+static void udp_multiplex_task(void *param) {
+    (void)param;
+    int sockets[RX_SOCKET_COUNT];
+    for (unsigned int index = 0; index < RX_SOCKET_COUNT; ++index) {
+        sockets[index] = rx_task_open_run_socket(rx_task_socket_port(index));
+    }
+    for (;;) {
+        rx_task_service_sockets(sockets, 1000);
+    }
+}
+#else
+static void udp_listener_task(void *param) {
+    unsigned int run_index = (unsigned int)(uintptr_t)param;
+    int sock = rx_task_open_run_socket(PORT_BASE + run_index);
+    for (;;) {
+        receive_run_datagram(sock, run_index, 0);
+    }
+}
+
+#if RX_PARITY_ENABLED
+static void udp_parity_task(void *param) {
+    (void)param;
+    int sock = rx_task_open_run_socket(PORT_BASE + RX_PARITY_SOCKET_INDEX);
+    for (;;) {
+        receive_parity_datagram(sock, 0);
+    }
+}
+#endif
+
+#if RX_EXTENDED_ENABLED
+static void udp_extended_task(void *param) {
+    (void)param;
+    int sock = rx_task_open_run_socket(rx_task_socket_port(RX_EXTENDED_SOCKET_INDEX));
+    for (;;) {
+        receive_extended_datagram(sock, 0);
+    }
 }
 #endif
+#endif
+#endif
 
 void rx_task_start(void) {
     frame_mutex = xSemaphoreCreateRecursiveMutex();
-    allocate_buffers();
-    clear_slot(&frame_slots[0]);
-    clear_slot(&frame_slots[1]);
 #ifndef UNIT_TEST
+    frame_ready = xSemaphoreCreateBinary();
+#else
+    frame_ready = false;
+#endif
+    for (unsigned int slot = 0; slot < RX_SLOT_COUNT; ++slot) {
+        frame_slots[slot].published = false;
+    }
+    place_buffers();
+    for (unsigned int slot = 0; slot < RX_SLOT_COUNT; ++slot) {
+        clear_slot(&frame_slots[slot]);
+    }
+    have_published = false;
+    last_published_id = 0;
+    rx_capture_reset();
+    rx_capture_set_paused(false);
+#ifndef UNIT_TEST
+#if RX_MULTIPLEXED_LISTENER
+    xTaskCreatePinnedToCore(udp_multiplex_task, "rx_mux", 4096, NULL,
+                            RX_MUX_TASK_PRIORITY, NULL, RX_MUX_TASK_CORE);
+#else
     for (unsigned int run = 0; run < RUN_COUNT; ++run) {
         xTaskCreate(udp_listener_task, "rx_run", 4096, (void *)(uintptr_t)run, 5, NULL);
     }
+#if RX_PARITY_ENABLED
+    xTaskCreate(udp_parity_task, "rx_parity", 4096, NULL, 5, NULL);
+#endif
+#if RX_EXTENDED_ENABLED
+    xTaskCreate(udp_extended_task, "rx_ext", 4096, NULL, 5, NULL);
+#endif
+#endif
 #endif
 }
 
 uint32_t rx_task_get_frame_id(int slot_index) {
-    if (slot_index < 0 || slot_index > 1) {
+    if (slot_index < 0 || slot_index >= RX_SLOT_COUNT) {
         return 0;
     }
     rx_task_lock();
-    uint32_t id = frame_slots[slot_index].frame_id;
+    const FrameSlot *slot = &frame_slots[slot_index];
+    uint32_t id = slot_is_live(slot) ? slot->frame_id : 0;
     rx_task_unlock();
     return id;
 }
 
 const uint8_t *rx_task_get_run_buffer(int slot_index, unsigned int run_index) {
-    if (slot_index < 0 || slot_index > 1 || run_index >= RUN_COUNT) {
+    if (slot_index < 0 || slot_index >= RX_SLOT_COUNT || run_index >= RUN_COUNT) {
         return NULL;
     }
     rx_task_lock();
-    const uint8_t *buffer = frame_buffers[slot_index][run_index];
+    const uint8_t *buffer = frame_banks[frame_slots[slot_index].bank].run_buffers[run_index];
     rx_task_unlock();
     return buffer;
 }
 
 bool rx_task_run_received(int slot_index, unsigned int run_index) {
-    if (slot_index < 0 || slot_index > 1 || run_index >= RUN_COUNT) {
+    if (slot_index < 0 || slot_index >= RX_SLOT_COUNT || run_index >= RUN_COUNT) {
         return false;
     }
     rx_task_lock();
-    bool received = frame_slots[slot_index].run_received[run_index];
+    const FrameSlot *slot = &frame_slots[slot_index];
+    bool received = slot_is_live(slot) && (slot->received_mask & (1u << run_index)) != 0;
     rx_task_unlock();
     return received;
 }
-
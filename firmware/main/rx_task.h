@@ -1,14 +1,168 @@
 #pragma once
 
+#include "config_autogen.h"
+
 #include <stddef.h>
 #include <stdint.h>
 #include <stdbool.h>
 
+// Depth of the frame reassembly ring: frames in flight at once. Must be a
+// power of two. The frame arena in config_autogen.h is sized for it.
+#ifndef RX_SLOT_COUNT
+#define RX_SLOT_COUNT FRAME_ARENA_SLOT_COUNT
+#endif
+
+// 1 accepts an optional XOR parity datagram per frame on
+// PORT_BASE + RUN_COUNT, which lets the assembler rebuild one lost run.
+#ifndef RX_PARITY_ENABLED
+#define RX_PARITY_ENABLED 1
+#endif
+// 1 accepts extended datagrams on PORT_BASE + RUN_COUNT + 1, whose blocks
+// carry a run (or a fragment of one) with an explicit run index and LED
+// offset, so runs can exceed what one datagram holds and several short runs
+// can share one.
+#ifndef RX_EXTENDED_ENABLED
+#define RX_EXTENDED_ENABLED 1
+#endif
+// Sockets served by rx_task: one per run, then the parity socket, then the
+// extended socket.
+#define RX_PARITY_SOCKET_INDEX RUN_COUNT
+#define RX_EXTENDED_SOCKET_INDEX (RUN_COUNT + RX_PARITY_ENABLED)
+#define RX_SOCKET_COUNT (RUN_COUNT + RX_PARITY_ENABLED + RX_EXTENDED_ENABLED)
+#define RX_EXTENDED_PORT_OFFSET (RUN_COUNT + 1)
+
+// Extended datagram, big-endian like the run datagram's frame_id:
+//   0 u32 frame_id, 'W' 'X' magic, u8 version, u8 block count
+//   8 blocks, back to back, filling the datagram exactly:
+//     u8 run, u8 encoding, u8 fragment index, u8 fragment count,
+//     u16 first LED, u16 payload bytes, payload
+// A whole run is a block with fragment index 0 of 1. A run sent in
+// fragments completes once every fragment index below the count has arrived
+// and, in index order, they cover the run back to back: fragment 0 starts
+// at LED 0 and each later one where the one before it ended. A datagram is
+// taken or dropped whole: one malformed block, or one disagreeing on a run's
+// fragment count, drops every block in it.
+//
+// An RX_ENCODING_XOR_RLE block's payload is a delta against the same LEDs of
+// an earlier frame of the run:
+//   0 u32 base frame_id, u16 LEDs covered, then tokens until the payload ends:
+//     0x00..0x7f  copy token + 1 bytes unchanged from the base
+//     0x80..0xff  token - 0x7f literal bytes follow, each XORed with the base
+// The tokens must expand to exactly 3 bytes per LED. The base must be the
+// newest published frame, or a frame still assembling whose run is already
+// complete; otherwise the datagram is dropped as "base" and the run waits
+// for a keyframe, an RGB block or plain run datagram.
+//
+// RX_ENCODING_PALETTE8 and RX_ENCODING_PALETTE4 blocks carry a palette and
+// one index per LED:
+//   0 u16 LEDs covered, u8 colours - 1, colours x RGB, then the indices:
+//     PALETTE8  one byte per LED
+//     PALETTE4  two LEDs per byte, high nibble first; at most 16 colours, and
+//               an odd count leaves the last low nibble 0
+// The payload must end with the last index, and every index must name a
+// colour of the palette.
+//
+// An RX_ENCODING_SAMPLED block carries whole sections of its run (the
+// SECTION_* tables of config_autogen.h) at one sample per `stride` LEDs:
+//   0 u16 LEDs covered, u8 stride, then each section's samples as RGB
+// A section of n LEDs is sampled at LED 0, every stride-th LED after it and
+// LED n - 1, which is (n + stride - 2) / stride + 1 samples. The LEDs between
+// two samples are interpolated linearly, rounding halves up, and never
+// across a section boundary. The block must start and end on section
+// boundaries, and the payload must end with the last sample.
+#define RX_EXTENDED_MAGIC0 'W'
+#define RX_EXTENDED_MAGIC1 'X'
+#define RX_EXTENDED_VERSION 1
+#define RX_EXTENDED_HEADER_BYTES 8
+#define RX_BLOCK_HEADER_BYTES 8
+// Largest UDP payload that crosses a 1500-byte MTU unfragmented
+#define RX_EXTENDED_MAX_BYTES 1472
+#define RX_MAX_FRAGMENTS 32
+#define RX_DELTA_HEADER_BYTES 6
+// First literal token; tokens below it copy from the base
+#define RX_DELTA_LITERAL 0x80
+#define RX_PALETTE_HEADER_BYTES 3
+#define RX_SAMPLED_HEADER_BYTES 3
+// Interpolation divides by a 22-bit reciprocal, which is exact up to here
+#define RX_SAMPLED_MAX_STRIDE 128
+// LEDs of RGB a single-block datagram can carry; every further block in a
+// datagram costs RX_BLOCK_HEADER_BYTES
+#define RX_FRAGMENT_MAX_LEDS \
+    ((RX_EXTENDED_MAX_BYTES - RX_EXTENDED_HEADER_BYTES - RX_BLOCK_HEADER_BYTES) / 3)
+
+typedef enum {
+    RX_ENCODING_RGB,     // LED-order RGB bytes, 3 per LED
+    RX_ENCODING_XOR_RLE, // run-length coded XOR delta against a base frame
+    RX_ENCODING_PALETTE8, // palette and one index byte per LED
+    RX_ENCODING_PALETTE4, // palette of up to 16 colours, two indices per byte
+    RX_ENCODING_SAMPLED,  // sections sampled every few LEDs, interpolated between
+} rx_encoding_t;
+
+// A complete frame handed from rx_task to driver_task. Run buffers hold RGB
+// bytes in LED order.
+typedef struct {
+    uint32_t frame_id;
+    uint8_t *run_buffers[RUN_COUNT];
+    // latency_stats clock readings for the frame's first datagram and for
+    // its completion
+    uint64_t received_us;
+    uint64_t completed_us;
+} rx_frame_t;
+
 void rx_task_start(void);
+// Copies a datagram into a receive buffer and processes it.
 void rx_task_process_packet(unsigned int run_index, const uint8_t *data, size_t length);
+
+// Zero-copy reception. Buffers hold a whole run datagram (frame_id header and
+// payload) of up to rx_task_rx_buffer_capacity() bytes. Acquire returns NULL
+// when the run's pool is exhausted. rx_task_process_rx_buffer takes ownership
+// of the buffer: it becomes the slot's run buffer or returns to the pool.
+size_t rx_task_rx_buffer_capacity(unsigned int run_index);
+uint8_t *rx_task_acquire_rx_buffer(unsigned int run_index);
+void rx_task_release_rx_buffer(unsigned int run_index, uint8_t *buffer);
+void rx_task_process_rx_buffer(unsigned int run_index, uint8_t *buffer, size_t length);
+size_t rx_task_free_rx_buffers(unsigned int run_index);
+
+// Parity datagrams carry the frame_id header followed by the XOR of every
+// run payload, zero-padded to the longest run. The payload is copied, so
+// the caller keeps the buffer.
+size_t rx_task_parity_length(void);
+void rx_task_process_parity(const uint8_t *data, size_t length);
+
+// Extended datagrams; each block's payload is copied straight from `data`
+// into the frame, so the caller keeps the buffer. Every block counts as a
+// run datagram in METRIC_RX_FRAMES. Malformed datagrams are dropped whole,
+// as METRIC_DROPS_RUN for an unknown run and METRIC_DROPS_LEN otherwise.
+void rx_task_process_extended(const uint8_t *data, size_t length);
+
+// UDP port of socket `socket_index`: runs, parity, then extended.
+uint16_t rx_task_socket_port(unsigned int socket_index);
+
+// Opens and binds a UDP socket for one run with the configured receive
+// buffer size. Returns -1 on failure.
+int rx_task_open_run_socket(uint16_t port);
+// Waits up to timeout_ms for any of the RX_SOCKET_COUNT sockets (indexed by
+// run, then parity, then extended) to become readable, then drains every ready socket.
+// Returns datagrams processed.
+size_t rx_task_service_sockets(const int *sockets, uint32_t timeout_ms);
 void rx_task_lock(void);
 void rx_task_unlock(void);
 
+// Blocks until a frame completes or timeout_ms elapses. Returns true when a
+// frame completed since the previous call.
+bool rx_task_wait_for_frame(uint32_t timeout_ms);
+
+// Lock-free handoff to the single consumer (driver_task). Returns the most
+// recently completed frame if one was published since the previous call, or
+// NULL. The returned frame stays owned by the caller until the next call.
+rx_frame_t *rx_task_acquire_frame(void);
+// The frame currently owned by the consumer. It may be written, e.g. to show
+// startup patterns, since rx_task never touches it.
+rx_frame_t *rx_task_driver_frame(void);
+
+// Assembly slot inspection for tests and diagnostics. Frame N is assembled
+// in slot rx_task_slot_index(N); evicted or free slots report frame_id 0.
+int rx_task_slot_index(uint32_t frame_id);
 uint32_t rx_task_get_frame_id(int slot_index);
 const uint8_t *rx_task_get_run_buffer(int slot_index, unsigned int run_index);
 bool rx_task_run_received(int slot_index, unsigned int run_index);
@@ -1,5 +1,8 @@
 #include "status_task.h"
 #include "config_autogen.h"
+#include "event_log.h"
+#include "latency_stats.h"
+#include "telemetry.h"
 
 #include <inttypes.h>
 #include <stdio.h>
@@ -19,38 +22,58 @@
 #define SIDE_ID_STR "RIGHT"
 #endif
 
-static uint32_t rx_frames_count;
-static uint32_t complete_count;
-static uint32_t applied_count;
-static uint32_t dropped_count;
-
-void status_task_increment_rx_frames(void) { rx_frames_count++; }
-void status_task_increment_complete(void) { complete_count++; }
-void status_task_increment_applied(void) { applied_count++; }
-void status_task_increment_drops(void) { dropped_count++; }
-void status_task_reset_counters(void) {
-    rx_frames_count = 0;
-    complete_count = 0;
-    applied_count = 0;
-    dropped_count = 0;
-}
-
-size_t status_task_format_json(char *buffer, size_t buffer_len, uint32_t uptime_ms, bool link) {
+size_t status_task_format_json(char *buffer, size_t buffer_len, uint32_t uptime_ms,
+                               uint32_t interval_ms, bool link,
+                               const telemetry_interval_t *interval,
+                               const event_t *events, size_t event_count) {
+    const metrics_snapshot_t *delta = &interval->metrics;
     char ip_str[16];
     snprintf(ip_str, sizeof(ip_str), "%u.%u.%u.%u", STATIC_IP_ADDR0, STATIC_IP_ADDR1, STATIC_IP_ADDR2, STATIC_IP_ADDR3);
     size_t offset = 0;
     offset += snprintf(buffer + offset, buffer_len - offset,
-                       "{\"id\":\"%s\",\"ip\":\"%s\",\"uptime_ms\":%" PRIu32 ",\"link\":%s,\"runs\":%u,\"leds\":[",
-                       SIDE_ID_STR, ip_str, uptime_ms, link ? "true" : "false", RUN_COUNT);
+                       "{\"id\":\"%s\",\"ip\":\"%s\",\"uptime_ms\":%" PRIu32 ",\"interval_ms\":%" PRIu32
+                       ",\"link\":%s,\"runs\":%u,\"leds\":[",
+                       SIDE_ID_STR, ip_str, uptime_ms, interval_ms, link ? "true" : "false", RUN_COUNT);
     for (unsigned int i = 0; i < RUN_COUNT; ++i) {
         offset += snprintf(buffer + offset, buffer_len - offset, "%u", LED_COUNT[i]);
         if (i + 1 < RUN_COUNT) {
             offset += snprintf(buffer + offset, buffer_len - offset, ",");
         }
     }
+    // Build-time frame budget, so the monitor can compare it with "applied"
+    offset += snprintf(buffer + offset, buffer_len - offset,
+                       "],\"budget\":{\"fps\":%u,\"parallel_us\":%u,\"serial_us\":%u,\"kbps\":%u}",
+                       TARGET_FPS, FRAME_PERIOD_PARALLEL_US, FRAME_PERIOD_SERIAL_US,
+                       NETWORK_KBPS_AT_TARGET);
+    offset += snprintf(buffer + offset, buffer_len - offset,
+                       ",\"rx_frames\":%" PRIu32 ",\"complete\":%" PRIu32 ",\"applied\":%" PRIu32 ",\"dropped_frames\":%" PRIu32 ",\"drops\":{",
+                       delta->value[METRIC_RX_FRAMES], delta->value[METRIC_COMPLETE],
+                       delta->value[METRIC_APPLIED], metrics_total_drops(delta));
+    for (unsigned int id = METRIC_DROPS_LEN; id <= METRIC_DROPS_BASE; ++id) {
+        offset += snprintf(buffer + offset, buffer_len - offset, "%s\"%s\":%" PRIu32,
+                           id > METRIC_DROPS_LEN ? "," : "", metrics_name((metric_id_t)id),
+                           delta->value[id]);
+    }
     offset += snprintf(buffer + offset, buffer_len - offset,
-                       "],\"rx_frames\":%" PRIu32 ",\"complete\":%" PRIu32 ",\"applied\":%" PRIu32 ",\"dropped_frames\":%" PRIu32 ",\"errors\":[]}",
-                       rx_frames_count, complete_count, applied_count, dropped_count);
+                       "},\"recovered\":%" PRIu32 ",\"events_lost\":%" PRIu32 ",\"latency_us\":{",
+                       delta->value[METRIC_PARITY_RECOVERED], delta->value[METRIC_EVENTS_LOST]);
+    // [p50, p99, max] per stage since the previous heartbeat
+    for (unsigned int stage = 0; stage < LATENCY_STAGE_COUNT; ++stage) {
+        latency_summary_t summary;
+        latency_stats_summarize(&interval->latency, (latency_stage_t)stage, &summary);
+        offset += snprintf(buffer + offset, buffer_len - offset,
+                           "%s\"%s\":[%" PRIu32 ",%" PRIu32 ",%" PRIu32 "]",
+                           stage > 0 ? "," : "", latency_stats_stage_name((latency_stage_t)stage),
+                           summary.p50_us, summary.p99_us, summary.max_us);
+    }
+    offset += snprintf(buffer + offset, buffer_len - offset, "},\"errors\":[");
+    for (size_t index = 0; index < event_count; ++index) {
+        char message[STATUS_EVENT_MESSAGE_BYTES];
+        event_log_format(&events[index], message, sizeof(message));
+        offset += snprintf(buffer + offset, buffer_len - offset, "%s\"%s\"",
+                           index > 0 ? "," : "", message);
+    }
+    offset += snprintf(buffer + offset, buffer_len - offset, "]}");
     return offset;
 }
 
@@ -61,7 +84,48 @@ size_t status_task_format_json(char *buffer, size_t buffer_len, uint32_t uptime_
 #include "lwip/sockets.h"
 #include "esp_timer.h"
 
+// Reader state lives here rather than on the task stack: each reader holds a
+// full latency snapshot.
+static telemetry_reader_t heartbeat_reader;
+static telemetry_interval_t heartbeat_interval;
+static uint32_t heartbeat_uptime_ms;
+#if TELEMETRY_INTERVAL_MS > 0
+static telemetry_reader_t telemetry_reader;
+static telemetry_interval_t telemetry_interval;
+static uint32_t telemetry_sequence;
+#endif
+
+static bool deadline_passed(TickType_t deadline, TickType_t now) {
+    return (int32_t)(now - deadline) >= 0;
+}
+
+static void send_heartbeat(int sock, const struct sockaddr_in *dest) {
+    char json[STATUS_HEARTBEAT_MAX_BYTES];
+    uint32_t uptime_ms = (uint32_t)(esp_timer_get_time() / 1000);
+    telemetry_reader_next(&heartbeat_reader, &heartbeat_interval);
+    // Pings share the reader, so a heartbeat may cover less than a second
+    uint32_t interval_ms = uptime_ms - heartbeat_uptime_ms;
+    heartbeat_uptime_ms = uptime_ms;
+    event_t events[STATUS_MAX_EVENTS];
+    size_t event_count = event_log_drain(events, STATUS_MAX_EVENTS);
+    size_t length = status_task_format_json(json, sizeof(json), uptime_ms, interval_ms, true,
+                                            &heartbeat_interval, events, event_count);
+    sendto(sock, json, length, 0, (const struct sockaddr *)dest, sizeof(*dest));
+}
+
+#if TELEMETRY_INTERVAL_MS > 0
+static void send_telemetry(int sock, const struct sockaddr_in *dest) {
+    uint8_t datagram[TELEMETRY_DATAGRAM_BYTES];
+    uint32_t uptime_ms = (uint32_t)(esp_timer_get_time() / 1000);
+    telemetry_reader_next(&telemetry_reader, &telemetry_interval);
+    size_t length = telemetry_encode(&telemetry_interval, telemetry_sequence++, uptime_ms, true,
+                                     datagram, sizeof(datagram));
+    sendto(sock, datagram, length, 0, (const struct sockaddr *)dest, sizeof(*dest));
+}
+#endif
+
 static void status_task(void *param) {
+    (void)param;
     int sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
     struct sockaddr_in dest = {
         .sin_family = AF_INET,
@@ -71,18 +135,66 @@ static void status_task(void *param) {
                                  ((uint32_t)SENDER_IP_ADDR2 << 8) |
                                  (uint32_t)SENDER_IP_ADDR3),
     };
-    char json[256];
+    telemetry_reader_init(&heartbeat_reader, LATENCY_READER_HEARTBEAT);
+    heartbeat_uptime_ms = (uint32_t)(esp_timer_get_time() / 1000);
+    TickType_t last_heartbeat = xTaskGetTickCount();
+    TickType_t next_heartbeat = last_heartbeat + pdMS_TO_TICKS(1000);
+    bool ping_pending = false;
+#if TELEMETRY_INTERVAL_MS > 0
+    telemetry_reader_init(&telemetry_reader, LATENCY_READER_TELEMETRY);
+    TickType_t next_telemetry = xTaskGetTickCount() + pdMS_TO_TICKS(TELEMETRY_INTERVAL_MS);
+#endif
     for (;;) {
-        uint32_t uptime_ms = (uint32_t)(esp_timer_get_time() / 1000);
-        status_task_format_json(json, sizeof(json), uptime_ms, true);
-        sendto(sock, json, strlen(json), 0, (struct sockaddr *)&dest, sizeof(dest));
-        status_task_reset_counters();
-        vTaskDelay(pdMS_TO_TICKS(1000));
+        // Severe events notify the task to send an event ping, at most one
+        // per STATUS_PING_MIN_INTERVAL_MS; otherwise it wakes for whichever
+        // periodic datagram is due first.
+        TickType_t ping_at = last_heartbeat + pdMS_TO_TICKS(STATUS_PING_MIN_INTERVAL_MS);
+        TickType_t deadline = next_heartbeat;
+        if (ping_pending && (int32_t)(ping_at - deadline) < 0) {
+            deadline = ping_at;
+        }
+#if TELEMETRY_INTERVAL_MS > 0
+        if ((int32_t)(next_telemetry - deadline) < 0) {
+            deadline = next_telemetry;
+        }
+#endif
+        TickType_t now = xTaskGetTickCount();
+        TickType_t wait = (int32_t)(deadline - now) > 0 ? deadline - now : 0;
+        if (ulTaskNotifyTake(pdTRUE, wait) != 0) {
+            ping_pending = true;
+        }
+        now = xTaskGetTickCount();
+        bool heartbeat_due = deadline_passed(next_heartbeat, now);
+        if (heartbeat_due || (ping_pending && deadline_passed(ping_at, now))) {
+            send_heartbeat(sock, &dest);
+            last_heartbeat = now;
+            ping_pending = false;
+        }
+        // Pings leave the 1 Hz cadence alone; after a stall it restarts from now
+        if (heartbeat_due) {
+            next_heartbeat += pdMS_TO_TICKS(1000);
+            if (deadline_passed(next_heartbeat, now)) {
+                next_heartbeat = now + pdMS_TO_TICKS(1000);
+            }
+        }
+#if TELEMETRY_INTERVAL_MS > 0
+        if (deadline_passed(next_telemetry, now)) {
+            send_telemetry(sock, &dest);
+            next_telemetry += pdMS_TO_TICKS(TELEMETRY_INTERVAL_MS);
+        }
+#endif
     }
 }
 
+static TaskHandle_t status_task_handle;
+
+static void notify_status_task(void) {
+    xTaskNotifyGive(status_task_handle);
+}
+
 void status_task_start(void) {
-    xTaskCreate(status_task, "status_task", 4096, NULL, 5, NULL);
+    xTaskCreate(status_task, "status_task", 4096, NULL, 5, &status_task_handle);
+    event_log_set_notify(notify_status_task);
 }
 #else
 void status_task_start(void) {}
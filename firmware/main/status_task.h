@@ -4,12 +4,28 @@
 #include <stddef.h>
 #include <stdint.h>
 
-void status_task_start(void);
+#include "event_log.h"
+#include "telemetry.h"
+
+// Events carried per heartbeat; the rest stay queued for the next one.
+#define STATUS_MAX_EVENTS 4
+// Longest formatted event message, including the timestamp prefix.
+#define STATUS_EVENT_MESSAGE_BYTES 64
+// Largest heartbeat status_task_format_json can produce, with every counter
+// and latency at its maximum width and STATUS_MAX_EVENTS events.
+#define STATUS_HEARTBEAT_MAX_BYTES 1024
+// Shortest gap between an event ping and the heartbeat before it; events
+// arriving sooner are held and sent together once the gap has passed.
+#ifndef STATUS_PING_MIN_INTERVAL_MS
+#define STATUS_PING_MIN_INTERVAL_MS 250
+#endif
 
-void status_task_increment_rx_frames(void);
-void status_task_increment_complete(void);
-void status_task_increment_applied(void);
-void status_task_increment_drops(void);
-void status_task_reset_counters(void);
+void status_task_start(void);
 
-size_t status_task_format_json(char *buffer, size_t buffer_len, uint32_t uptime_ms, bool link);
+// Formats a heartbeat reporting `interval`, the counters and latencies over
+// the `interval_ms` since the previous one, and the drained events as its
+// "errors" array.
+size_t status_task_format_json(char *buffer, size_t buffer_len, uint32_t uptime_ms,
+                               uint32_t interval_ms, bool link,
+                               const telemetry_interval_t *interval,
+                               const event_t *events, size_t event_count);
@@ -0,0 +1,127 @@
+#include "telemetry.h"
+#include "config_autogen.h"
+
+#include <string.h>
+
+_Static_assert(RUN_COUNT <= METRICS_MAX_RUNS, "telemetry run slots too small for RUN_COUNT");
+_Static_assert(LATENCY_BUCKET_COUNT <= UINT8_MAX, "bucket_count must fit in a byte");
+// Moving a field is a wire format change: bump TELEMETRY_VERSION and the
+// decoder in tools/heartbeat_monitor.py along with these.
+_Static_assert(TELEMETRY_RUNS_OFFSET == 68, "telemetry counter block moved");
+_Static_assert(TELEMETRY_STAGES_OFFSET == 116, "telemetry run block moved");
+_Static_assert(TELEMETRY_DATAGRAM_BYTES == 376, "telemetry datagram size changed");
+
+static void put_u16(uint8_t *out, uint16_t value) {
+    out[0] = (uint8_t)value;
+    out[1] = (uint8_t)(value >> 8);
+}
+
+static void put_u32(uint8_t *out, uint32_t value) {
+    out[0] = (uint8_t)value;
+    out[1] = (uint8_t)(value >> 8);
+    out[2] = (uint8_t)(value >> 16);
+    out[3] = (uint8_t)(value >> 24);
+}
+
+static uint16_t get_u16(const uint8_t *in) {
+    return (uint16_t)(in[0] | (in[1] << 8));
+}
+
+static uint32_t get_u32(const uint8_t *in) {
+    return (uint32_t)in[0] | ((uint32_t)in[1] << 8) | ((uint32_t)in[2] << 16) |
+           ((uint32_t)in[3] << 24);
+}
+
+static const metric_id_t RUN_BLOCKS[TELEMETRY_RUN_COUNTERS] = {
+    METRIC_RUN_RX, METRIC_RUN_DROPS, METRIC_RUN_RECOVERED,
+};
+
+void telemetry_reader_init(telemetry_reader_t *reader, latency_reader_t latency_reader) {
+    reader->latency_reader = latency_reader;
+    metrics_snapshot(&reader->metrics);
+    latency_stats_snapshot(latency_reader, &reader->latency);
+}
+
+void telemetry_reader_next(telemetry_reader_t *reader, telemetry_interval_t *interval) {
+    // Counters only grow, so increments racing the snapshot land in the next
+    // interval instead of being lost to a reset.
+    metrics_snapshot_t metrics;
+    metrics_snapshot(&metrics);
+    metrics_delta(&metrics, &reader->metrics, &interval->metrics);
+    reader->metrics = metrics;
+
+    latency_snapshot_t latency;
+    latency_stats_snapshot(reader->latency_reader, &latency);
+    latency_stats_delta(&latency, &reader->latency, &interval->latency);
+    reader->latency = latency;
+}
+
+size_t telemetry_encode(const telemetry_interval_t *interval, uint32_t sequence,
+                        uint32_t uptime_ms, bool link, uint8_t *buffer, size_t buffer_len) {
+    if (buffer_len < TELEMETRY_DATAGRAM_BYTES) {
+        return 0;
+    }
+    buffer[0] = TELEMETRY_MAGIC0;
+    buffer[1] = TELEMETRY_MAGIC1;
+    buffer[2] = TELEMETRY_VERSION;
+    buffer[3] = SIDE_ID;
+    put_u32(buffer + 4, sequence);
+    put_u32(buffer + 8, uptime_ms);
+    buffer[12] = RUN_COUNT;
+    buffer[13] = LATENCY_STAGE_COUNT;
+    buffer[14] = LATENCY_BUCKET_COUNT;
+    buffer[15] = link ? TELEMETRY_FLAG_LINK : 0;
+
+    uint8_t *out = buffer + TELEMETRY_HEADER_BYTES;
+    for (unsigned int id = 0; id < TELEMETRY_GLOBAL_COUNTERS; ++id, out += 4) {
+        put_u32(out, interval->metrics.value[id]);
+    }
+    for (unsigned int run = 0; run < METRICS_MAX_RUNS; ++run) {
+        for (unsigned int counter = 0; counter < TELEMETRY_RUN_COUNTERS; ++counter, out += 4) {
+            put_u32(out, interval->metrics.value[RUN_BLOCKS[counter] + run]);
+        }
+    }
+    for (unsigned int stage = 0; stage < LATENCY_STAGE_COUNT; ++stage) {
+        put_u32(out, interval->latency.max_us[stage]);
+        out += 4;
+        for (unsigned int index = 0; index < LATENCY_BUCKET_COUNT; ++index, out += 2) {
+            uint32_t count = interval->latency.buckets[stage][index];
+            put_u16(out, count > UINT16_MAX ? UINT16_MAX : (uint16_t)count);
+        }
+    }
+    return TELEMETRY_DATAGRAM_BYTES;
+}
+
+bool telemetry_decode(const uint8_t *buffer, size_t length, telemetry_header_t *header,
+                      telemetry_interval_t *interval) {
+    if (length < TELEMETRY_DATAGRAM_BYTES || buffer[0] != TELEMETRY_MAGIC0 ||
+        buffer[1] != TELEMETRY_MAGIC1 || buffer[2] != TELEMETRY_VERSION ||
+        buffer[13] != LATENCY_STAGE_COUNT || buffer[14] != LATENCY_BUCKET_COUNT) {
+        return false;
+    }
+    header->version = buffer[2];
+    header->side = buffer[3];
+    header->sequence = get_u32(buffer + 4);
+    header->uptime_ms = get_u32(buffer + 8);
+    header->run_count = buffer[12];
+    header->link = (buffer[15] & TELEMETRY_FLAG_LINK) != 0;
+
+    memset(interval, 0, sizeof(*interval));
+    const uint8_t *in = buffer + TELEMETRY_HEADER_BYTES;
+    for (unsigned int id = 0; id < TELEMETRY_GLOBAL_COUNTERS; ++id, in += 4) {
+        interval->metrics.value[id] = get_u32(in);
+    }
+    for (unsigned int run = 0; run < METRICS_MAX_RUNS; ++run) {
+        for (unsigned int counter = 0; counter < TELEMETRY_RUN_COUNTERS; ++counter, in += 4) {
+            interval->metrics.value[RUN_BLOCKS[counter] + run] = get_u32(in);
+        }
+    }
+    for (unsigned int stage = 0; stage < LATENCY_STAGE_COUNT; ++stage) {
+        interval->latency.max_us[stage] = get_u32(in);
+        in += 4;
+        for (unsigned int index = 0; index < LATENCY_BUCKET_COUNT; ++index, in += 2) {
+            interval->latency.buckets[stage][index] = get_u16(in);
+        }
+    }
+    return true;
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "latency_stats.h"
+#include "metrics.h"
+
+// Binary telemetry period; 100 gives 10 Hz for diagnosis, 0 disables it.
+// The JSON heartbeat keeps its own 1 Hz cadence either way.
+#ifndef TELEMETRY_INTERVAL_MS
+#define TELEMETRY_INTERVAL_MS 1000
+#endif
+
+// Fixed little-endian layout, bumped whenever a field moves:
+//   0  'B' 'L' magic, u8 version, u8 side
+//   4  u32 sequence, u32 uptime_ms
+//   12 u8 run_count, u8 stage_count, u8 bucket_count, u8 flags
+//   16 u32 counters[TELEMETRY_GLOBAL_COUNTERS], in metric_id_t order
+//   68 per run slot: u32 rx, u32 drops, u32 recovered
+//   116 per stage: u32 max_us, u16 buckets[LATENCY_BUCKET_COUNT], saturating
+#define TELEMETRY_MAGIC0 'B'
+#define TELEMETRY_MAGIC1 'L'
+#define TELEMETRY_VERSION 2
+#define TELEMETRY_FLAG_LINK 0x01u
+#define TELEMETRY_GLOBAL_COUNTERS METRIC_RUN_RX
+#define TELEMETRY_RUN_COUNTERS 3
+#define TELEMETRY_HEADER_BYTES 16
+#define TELEMETRY_RUNS_OFFSET (TELEMETRY_HEADER_BYTES + TELEMETRY_GLOBAL_COUNTERS * 4)
+#define TELEMETRY_STAGES_OFFSET (TELEMETRY_RUNS_OFFSET + METRICS_MAX_RUNS * TELEMETRY_RUN_COUNTERS * 4)
+#define TELEMETRY_STAGE_BYTES (4 + LATENCY_BUCKET_COUNT * 2)
+#define TELEMETRY_DATAGRAM_BYTES (TELEMETRY_STAGES_OFFSET + LATENCY_STAGE_COUNT * TELEMETRY_STAGE_BYTES)
+
+// Counters and latency histograms accumulated over one reporting interval.
+typedef struct {
+    metrics_snapshot_t metrics;
+    latency_snapshot_t latency;
+} telemetry_interval_t;
+
+// Snapshots taken at the end of a reader's previous interval. The JSON
+// heartbeat and the binary telemetry each own one, so neither disturbs the
+// other's deltas.
+typedef struct {
+    latency_reader_t latency_reader;
+    metrics_snapshot_t metrics;
+    latency_snapshot_t latency;
+} telemetry_reader_t;
+
+typedef struct {
+    uint8_t version;
+    uint8_t side;
+    uint8_t run_count;
+    bool link;
+    uint32_t sequence;
+    uint32_t uptime_ms;
+} telemetry_header_t;
+
+void telemetry_reader_init(telemetry_reader_t *reader, latency_reader_t latency_reader);
+// Fills `interval` with everything recorded since the previous call.
+void telemetry_reader_next(telemetry_reader_t *reader, telemetry_interval_t *interval);
+
+// Returns TELEMETRY_DATAGRAM_BYTES, or 0 when the buffer is too small.
+size_t telemetry_encode(const telemetry_interval_t *interval, uint32_t sequence,
+                        uint32_t uptime_ms, bool link, uint8_t *buffer, size_t buffer_len);
+// Inverse of telemetry_encode; false on a short buffer, bad magic or
+// unknown version. Buckets come back saturated at UINT16_MAX.
+bool telemetry_decode(const uint8_t *buffer, size_t length, telemetry_header_t *header,
+                      telemetry_interval_t *interval);
@@ -0,0 +1,113 @@
+#include "ws2815_encoder.h"
+
+#include <stdbool.h>
+#include <string.h>
+
+_Static_assert(RMT_TICKS_PER_BIT == 50, "Unexpected RMT bit timing");
+_Static_assert(RMT_T0H_TICKS + RMT_T0L_TICKS == RMT_TICKS_PER_BIT, "T0 timing");
+_Static_assert(RMT_T1H_TICKS + RMT_T1L_TICKS == RMT_TICKS_PER_BIT, "T1 timing");
+_Static_assert(sizeof(rmt_symbol_word_t) == sizeof(uint32_t), "RMT symbol size");
+
+#define BIT_WORD(bit_set) ((bit_set) ? WS2815_SYMBOL_ONE : WS2815_SYMBOL_ZERO)
+#define BYTE_WORDS(value)                                              \
+    {BIT_WORD((value) & 0x80), BIT_WORD((value) & 0x40),                \
+     BIT_WORD((value) & 0x20), BIT_WORD((value) & 0x10),                \
+     BIT_WORD((value) & 0x08), BIT_WORD((value) & 0x04),                \
+     BIT_WORD((value) & 0x02), BIT_WORD((value) & 0x01)}
+#define BYTE_ROWS_4(value) BYTE_WORDS(value), BYTE_WORDS((value) + 1), \
+    BYTE_WORDS((value) + 2), BYTE_WORDS((value) + 3)
+#define BYTE_ROWS_16(value) BYTE_ROWS_4(value), BYTE_ROWS_4((value) + 4), \
+    BYTE_ROWS_4((value) + 8), BYTE_ROWS_4((value) + 12)
+#define BYTE_ROWS_64(value) BYTE_ROWS_16(value), BYTE_ROWS_16((value) + 16), \
+    BYTE_ROWS_16((value) + 32), BYTE_ROWS_16((value) + 48)
+
+const uint32_t WS2815_BYTE_SYMBOLS[256][8] = {
+    BYTE_ROWS_64(0), BYTE_ROWS_64(64), BYTE_ROWS_64(128), BYTE_ROWS_64(192),
+};
+
+// Wire order is GRB while run buffers hold RGB.
+static const uint8_t GRB_SOURCE_OFFSET[3] = {1, 0, 2};
+
+size_t ws2815_encode_symbols(const uint8_t *rgb_data,
+                             size_t rgb_length,
+                             size_t symbol_offset,
+                             rmt_symbol_word_t *symbols,
+                             size_t symbol_capacity)
+{
+    size_t total_symbols = rgb_length * 8;
+    size_t written = 0;
+    while (written < symbol_capacity && symbol_offset < total_symbols) {
+        size_t byte_index = symbol_offset / 8;
+        size_t bit_index = symbol_offset % 8;
+        if (bit_index == 0 && byte_index % 3 == 0) {
+            // Whole LEDs: three table rows per pixel
+            size_t led_count = (symbol_capacity - written) / WS2815_SYMBOLS_PER_LED;
+            size_t leds_left = (rgb_length - byte_index) / 3;
+            if (led_count > leds_left) {
+                led_count = leds_left;
+            }
+            const uint8_t *rgb = rgb_data + byte_index;
+            rmt_symbol_word_t *out = symbols + written;
+            for (size_t led = 0; led < led_count; ++led) {
+                memcpy(out, WS2815_BYTE_SYMBOLS[rgb[1]], sizeof(WS2815_BYTE_SYMBOLS[0]));
+                memcpy(out + 8, WS2815_BYTE_SYMBOLS[rgb[0]], sizeof(WS2815_BYTE_SYMBOLS[0]));
+                memcpy(out + 16, WS2815_BYTE_SYMBOLS[rgb[2]], sizeof(WS2815_BYTE_SYMBOLS[0]));
+                rgb += 3;
+                out += WS2815_SYMBOLS_PER_LED;
+            }
+            written += led_count * WS2815_SYMBOLS_PER_LED;
+            symbol_offset += led_count * WS2815_SYMBOLS_PER_LED;
+            if (led_count > 0) {
+                continue;
+            }
+        }
+        // Chunk edges that split an LED copy a slice of one table row
+        size_t led_base = byte_index - byte_index % 3;
+        uint8_t value = rgb_data[led_base + GRB_SOURCE_OFFSET[byte_index % 3]];
+        size_t count = 8 - bit_index;
+        if (count > symbol_capacity - written) {
+            count = symbol_capacity - written;
+        }
+        memcpy(symbols + written, &WS2815_BYTE_SYMBOLS[value][bit_index],
+               count * sizeof(uint32_t));
+        written += count;
+        symbol_offset += count;
+    }
+    return written;
+}
+
+#ifndef UNIT_TEST
+#include "esp_idf_version.h"
+
+#if ESP_IDF_VERSION < ESP_IDF_VERSION_VAL(5, 3, 0)
+#error "ws2815_encoder requires ESP-IDF 5.3+ (rmt_new_simple_encoder)"
+#endif
+
+static size_t ws2815_encode_callback(const void *data,
+                                     size_t data_size,
+                                     size_t symbols_written,
+                                     size_t symbols_free,
+                                     rmt_symbol_word_t *symbols,
+                                     bool *done,
+                                     void *arg)
+{
+    (void)arg;
+    size_t written = ws2815_encode_symbols((const uint8_t *)data, data_size,
+                                           symbols_written, symbols, symbols_free);
+    if (symbols_written + written >= data_size * 8) {
+        *done = true;
+    }
+    return written;
+}
+
+esp_err_t ws2815_encoder_new(rmt_encoder_handle_t *ret_encoder)
+{
+    const rmt_simple_encoder_config_t config = {
+        .callback = ws2815_encode_callback,
+        .arg = NULL,
+        // The callback can make progress with a single free symbol.
+        .min_chunk_size = 1,
+    };
+    return rmt_new_simple_encoder(&config, ret_encoder);
+}
+#endif
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifndef UNIT_TEST
+#include "driver/rmt_encoder.h"
+#else
+// Host-side mirror of the ESP-IDF RMT symbol layout
+typedef union {
+    struct {
+        uint16_t duration0 : 15;
+        uint16_t level0 : 1;
+        uint16_t duration1 : 15;
+        uint16_t level1 : 1;
+    };
+    uint32_t val;
+} rmt_symbol_word_t;
+#endif
+
+#define RMT_CLK_DIV 2
+#define RMT_RESOLUTION_HZ (80000000 / RMT_CLK_DIV)
+#define RMT_TICKS_PER_BIT (RMT_RESOLUTION_HZ / 800000)
+
+#define RMT_T0H_TICKS 16
+#define RMT_T0L_TICKS (RMT_TICKS_PER_BIT - RMT_T0H_TICKS)
+#define RMT_T1H_TICKS 32
+#define RMT_T1L_TICKS (RMT_TICKS_PER_BIT - RMT_T1H_TICKS)
+
+#define WS2815_SYMBOLS_PER_LED 24
+
+// Raw 32-bit symbol words: duration0 in bits 0-14, level0 in bit 15,
+// duration1 in bits 16-30, level1 in bit 31.
+#define WS2815_SYMBOL_WORD(high_ticks, low_ticks) \
+    ((uint32_t)(high_ticks) | (1u << 15) | ((uint32_t)(low_ticks) << 16))
+#define WS2815_SYMBOL_ZERO WS2815_SYMBOL_WORD(RMT_T0H_TICKS, RMT_T0L_TICKS)
+#define WS2815_SYMBOL_ONE WS2815_SYMBOL_WORD(RMT_T1H_TICKS, RMT_T1L_TICKS)
+
+// Eight symbol words per byte value, most significant bit first.
+extern const uint32_t WS2815_BYTE_SYMBOLS[256][8];
+
+// Encodes RGB bytes as GRB WS2815 symbols, one symbol per bit. Encoding
+// starts at `symbol_offset` into the run's symbol stream and stops when
+// `symbol_capacity` symbols have been written or the stream ends. Returns the
+// number of symbols written.
+size_t ws2815_encode_symbols(const uint8_t *rgb_data,
+                             size_t rgb_length,
+                             size_t symbol_offset,
+                             rmt_symbol_word_t *symbols,
+                             size_t symbol_capacity);
+
+#ifndef UNIT_TEST
+// Creates an RMT encoder that streams RGB run buffers straight into the
+// channel's RMT memory, so no per-run symbol buffer is needed.
+esp_err_t ws2815_encoder_new(rmt_encoder_handle_t *ret_encoder);
+#endif
@@ -0,0 +1,193 @@
+#include "bench.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#ifndef BENCH_BUILD_TYPE
+#define BENCH_BUILD_TYPE "unknown"
+#endif
+
+#define BENCH_MAX_RESULTS 64
+
+volatile uint32_t bench_sink;
+
+static const char *bench_name;
+static bool json_output;
+static uint64_t iterations_override;
+static bench_result_t results[BENCH_MAX_RESULTS];
+static size_t result_count;
+static uint64_t allocations;
+
+#ifdef BENCH_WRAP_ALLOCATIONS
+// Linked with -Wl,--wrap for each allocator entry point, so every call from
+// the code under test lands here first.
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t count, size_t size);
+void *__real_realloc(void *pointer, size_t size);
+
+void *__wrap_malloc(size_t size)
+{
+    ++allocations;
+    return __real_malloc(size);
+}
+
+void *__wrap_calloc(size_t count, size_t size)
+{
+    ++allocations;
+    return __real_calloc(count, size);
+}
+
+void *__wrap_realloc(void *pointer, size_t size)
+{
+    ++allocations;
+    return __real_realloc(pointer, size);
+}
+#endif
+
+bool bench_counts_allocations(void)
+{
+#ifdef BENCH_WRAP_ALLOCATIONS
+    return true;
+#else
+    return false;
+#endif
+}
+
+uint64_t bench_allocations(void)
+{
+    return allocations;
+}
+
+bool bench_init(int argc, char **argv, const char *name)
+{
+    bench_name = name;
+    for (int index = 1; index < argc; ++index) {
+        if (strcmp(argv[index], "--json") == 0) {
+            json_output = true;
+        } else if (strcmp(argv[index], "--iterations") == 0 && index + 1 < argc) {
+            iterations_override = strtoull(argv[++index], NULL, 10);
+        } else {
+            fprintf(stderr, "usage: %s [--json] [--iterations N]\n", argv[0]);
+            return false;
+        }
+    }
+    return true;
+}
+
+uint64_t bench_iterations(uint64_t default_iterations)
+{
+    return iterations_override > 0 ? iterations_override : default_iterations;
+}
+
+uint64_t bench_now_ns(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000ull + (uint64_t)now.tv_nsec;
+}
+
+void bench_record(const bench_result_t *result)
+{
+    if (result_count < BENCH_MAX_RESULTS) {
+        results[result_count++] = *result;
+    }
+}
+
+void bench_run(const char *name, uint64_t iterations, uint64_t leds_per_op,
+               void (*body)(uint64_t iteration, void *context), void *context)
+{
+    uint64_t allocations_before = allocations;
+    uint64_t start_ns = bench_now_ns();
+    for (uint64_t iteration = 0; iteration < iterations; ++iteration) {
+        body(iteration, context);
+    }
+    bench_result_t result = {
+        .name = name,
+        .iterations = iterations,
+        .elapsed_ns = bench_now_ns() - start_ns,
+        .leds_per_op = leds_per_op,
+        .allocations = allocations - allocations_before,
+    };
+    bench_record(&result);
+}
+
+const bench_result_t *bench_last(void)
+{
+    return result_count > 0 ? &results[result_count - 1] : NULL;
+}
+
+void bench_annotate(const char *key, double value)
+{
+    if (result_count == 0) {
+        return;
+    }
+    bench_result_t *result = &results[result_count - 1];
+    if (result->extra_count < BENCH_MAX_EXTRAS) {
+        result->extras[result->extra_count++] = (bench_extra_t){key, value};
+    }
+}
+
+static double ns_per_op(const bench_result_t *result)
+{
+    return result->iterations ? (double)result->elapsed_ns / result->iterations : 0.0;
+}
+
+int bench_finish(void)
+{
+    if (!json_output) {
+        printf("%-36s %12s %12s %10s %8s\n", "benchmark", "iterations", "ns/op", "ns/LED",
+               "allocs");
+        for (size_t index = 0; index < result_count; ++index) {
+            const bench_result_t *result = &results[index];
+            char per_led[32] = "-";
+            if (result->leds_per_op > 0) {
+                snprintf(per_led, sizeof(per_led), "%.2f",
+                         ns_per_op(result) / result->leds_per_op);
+            }
+            char allocs[32] = "-";
+            if (bench_counts_allocations()) {
+                snprintf(allocs, sizeof(allocs), "%llu",
+                         (unsigned long long)result->allocations);
+            }
+            printf("%-36s %12llu %12.1f %10s %8s\n", result->name,
+                   (unsigned long long)result->iterations, ns_per_op(result), per_led, allocs);
+            for (size_t extra = 0; extra < result->extra_count; ++extra) {
+                printf("  %-34s %12.1f\n", result->extras[extra].key,
+                       result->extras[extra].value);
+            }
+        }
+        return 0;
+    }
+
+    const char *build = BENCH_BUILD_TYPE[0] ? BENCH_BUILD_TYPE : "unknown";
+    printf("{\"bench\":\"%s\",\"build\":\"%s\",\"results\":[", bench_name, build);
+    for (size_t index = 0; index < result_count; ++index) {
+        const bench_result_t *result = &results[index];
+        printf("%s{\"name\":\"%s\",\"iterations\":%llu,\"elapsed_ns\":%llu,\"ns_per_op\":%.3f,",
+               index ? "," : "", result->name, (unsigned long long)result->iterations,
+               (unsigned long long)result->elapsed_ns, ns_per_op(result));
+        if (result->leds_per_op > 0) {
+            printf("\"ns_per_led\":%.4f,", ns_per_op(result) / result->leds_per_op);
+        } else {
+            printf("\"ns_per_led\":null,");
+        }
+        if (bench_counts_allocations()) {
+            printf("\"allocations\":%llu", (unsigned long long)result->allocations);
+        } else {
+            printf("\"allocations\":null");
+        }
+        if (result->extra_count > 0) {
+            printf(",\"extra\":{");
+            for (size_t extra = 0; extra < result->extra_count; ++extra) {
+                printf("%s\"%s\":%.3f", extra ? "," : "", result->extras[extra].key,
+                       result->extras[extra].value);
+            }
+            printf("}");
+        }
+        printf("}");
+    }
+    printf("]}\n");
+    return 0;
+}
@@ -0,0 +1,52 @@
+// Shared harness for the bench_* executables: timing, allocation counting
+// and a report printed as a table or, with --json, as one JSON document so
+// runs can be diffed across commits.
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define BENCH_MAX_EXTRAS 12
+
+// A derived figure reported with a result, e.g. datagrams per second
+typedef struct {
+    const char *key;
+    double value;
+} bench_extra_t;
+
+typedef struct {
+    const char *name;
+    uint64_t iterations;
+    uint64_t elapsed_ns;
+    // LEDs handled per iteration, 0 when per-LED cost means nothing
+    uint64_t leds_per_op;
+    // Heap allocations made inside the timed loop
+    uint64_t allocations;
+    bench_extra_t extras[BENCH_MAX_EXTRAS];
+    size_t extra_count;
+} bench_result_t;
+
+// Parses --json and --iterations N. Returns false on unknown arguments.
+bool bench_init(int argc, char **argv, const char *bench_name);
+// default_iterations, or the --iterations override.
+uint64_t bench_iterations(uint64_t default_iterations);
+uint64_t bench_now_ns(void);
+// Calls to malloc, calloc and realloc so far. Only counted where the
+// linker can wrap them; see bench_counts_allocations.
+uint64_t bench_allocations(void);
+bool bench_counts_allocations(void);
+
+// Times `iterations` calls of `body` and records the result.
+void bench_run(const char *name, uint64_t iterations, uint64_t leds_per_op,
+               void (*body)(uint64_t iteration, void *context), void *context);
+void bench_record(const bench_result_t *result);
+// The most recently recorded result, or NULL before the first one.
+const bench_result_t *bench_last(void);
+// Attaches a derived figure to the most recently recorded result.
+void bench_annotate(const char *key, double value);
+// Prints every recorded result. Returns the process exit status.
+int bench_finish(void);
+
+// Keeps results alive so the compiler cannot drop the measured work.
+extern volatile uint32_t bench_sink;
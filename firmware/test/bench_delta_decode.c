@@ -0,0 +1,162 @@
+// Host micro-benchmark: whole frames of the generated layout sent as XOR+RLE
+// deltas against the previous frame, for slow-moving and noisy content,
+// against the same frames sent as RGB blocks. Each result carries the bytes
+// on the wire per frame and the compression ratio against RGB.
+#include "bench.h"
+#include "config_autogen.h"
+#include "loadgen_packet.h"
+#include "rx_task.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define DEFAULT_FRAMES 200000
+// Frames of content encoded ahead; the sequence repeats after this many
+#define CYCLE_FRAMES 64
+#define CHASE_LEDS 8
+#define MAX_FRAME_DATAGRAMS (RUN_COUNT * 3)
+
+typedef enum {
+    CONTENT_GRADIENT, // every fourth LED steps by one per frame
+    CONTENT_CHASE,    // a short lit block moves one LED per frame
+    CONTENT_NOISE,    // every byte changes every frame
+} content_t;
+
+typedef struct {
+    uint8_t datagrams[CYCLE_FRAMES][MAX_FRAME_DATAGRAMS][LOADGEN_UDP_MAX_PAYLOAD];
+    size_t lengths[CYCLE_FRAMES][MAX_FRAME_DATAGRAMS];
+    unsigned int datagram_count[CYCLE_FRAMES];
+    uint64_t wire_bytes;
+} cycle_t;
+
+static void fill_content(content_t content, unsigned int frame, uint8_t *rgb[RUN_COUNT])
+{
+    uint32_t seed = frame * 2654435761u + 1;
+    for (unsigned int run = 0; run < RUN_COUNT; ++run) {
+        for (size_t led = 0; led < LED_COUNT[run]; ++led) {
+            uint8_t *pixel = rgb[run] + led * 3;
+            switch (content) {
+            case CONTENT_GRADIENT: {
+                uint8_t level = (uint8_t)((led * 4 + frame) >> 2);
+                pixel[0] = level;
+                pixel[1] = (uint8_t)(255 - level);
+                pixel[2] = (uint8_t)(run * 64);
+                break;
+            }
+            case CONTENT_CHASE: {
+                bool lit = (led + LED_COUNT[run] - frame % LED_COUNT[run]) % LED_COUNT[run] <
+                           CHASE_LEDS;
+                pixel[0] = lit ? 255 : 8;
+                pixel[1] = lit ? 160 : 0;
+                pixel[2] = lit ? 40 : 16;
+                break;
+            }
+            case CONTENT_NOISE:
+                for (unsigned int channel = 0; channel < 3; ++channel) {
+                    seed = seed * 1103515245u + 12345u;
+                    pixel[channel] = (uint8_t)(seed >> 16);
+                }
+                break;
+            }
+        }
+    }
+}
+
+// Encodes each frame of the cycle against the one before it, wrapping, or
+// as RGB blocks when `delta` is false. A fragment whose delta does not fit
+// one datagram goes as RGB, as the sender would send it.
+static void encode_cycle(content_t content, bool delta, cycle_t *cycle)
+{
+    uint8_t *current[RUN_COUNT];
+    uint8_t *previous[RUN_COUNT];
+    for (unsigned int run = 0; run < RUN_COUNT; ++run) {
+        current[run] = malloc(LED_COUNT[run] * 3);
+        previous[run] = malloc(LED_COUNT[run] * 3);
+    }
+    cycle->wire_bytes = 0;
+    for (unsigned int frame = 0; frame < CYCLE_FRAMES; ++frame) {
+        fill_content(content, frame, current);
+        fill_content(content, (frame + CYCLE_FRAMES - 1) % CYCLE_FRAMES, previous);
+        unsigned int count = 0;
+        for (unsigned int run = 0; run < RUN_COUNT; ++run) {
+            unsigned int fragments = loadgen_fragment_count(LED_COUNT[run], LOADGEN_FRAGMENT_MAX_LEDS);
+            for (unsigned int index = 0; index < fragments; ++index, ++count) {
+                uint8_t *out = cycle->datagrams[frame][count];
+                size_t length = delta ? loadgen_encode_delta_fragment(0, 0, run, current[run],
+                                                                      previous[run], LED_COUNT[run],
+                                                                      0, index, out)
+                                      : 0;
+                if (length == 0) {
+                    length = loadgen_encode_fragment(0, run, current[run], LED_COUNT[run], 0,
+                                                     index, out);
+                }
+                cycle->lengths[frame][count] = length;
+                cycle->wire_bytes += length;
+            }
+        }
+        cycle->datagram_count[frame] = count;
+    }
+    for (unsigned int run = 0; run < RUN_COUNT; ++run) {
+        free(current[run]);
+        free(previous[run]);
+    }
+}
+
+static void send_frame(uint64_t iteration, void *context)
+{
+    cycle_t *cycle = context;
+    uint32_t frame_id = (uint32_t)iteration + 1;
+    unsigned int frame = frame_id % CYCLE_FRAMES;
+    for (unsigned int index = 0; index < cycle->datagram_count[frame]; ++index) {
+        uint8_t *datagram = cycle->datagrams[frame][index];
+        loadgen_write_frame_id(datagram, frame_id);
+        if (datagram[LOADGEN_EXTENDED_HEADER_BYTES + 1] == RX_ENCODING_XOR_RLE) {
+            loadgen_write_frame_id(
+                datagram + LOADGEN_EXTENDED_HEADER_BYTES + LOADGEN_BLOCK_HEADER_BYTES,
+                frame_id - 1);
+        }
+        rx_task_process_extended(datagram, cycle->lengths[frame][index]);
+    }
+    // Stand-in for driver_task picking up each completed frame
+    if (rx_task_acquire_frame() != NULL) {
+        ++bench_sink;
+    }
+}
+
+static void run_case(const char *name, content_t content, bool delta, uint64_t frames,
+                     cycle_t *cycle, uint64_t rgb_bytes)
+{
+    encode_cycle(content, delta, cycle);
+    // Frame 0 goes as RGB, so the first delta has a published base
+    static cycle_t keyframe;
+    encode_cycle(content, false, &keyframe);
+    rx_task_start();
+    for (unsigned int index = 0; index < keyframe.datagram_count[0]; ++index) {
+        rx_task_process_extended(keyframe.datagrams[0][index], keyframe.lengths[0][index]);
+    }
+    rx_task_acquire_frame();
+
+    bench_run(name, frames, TOTAL_LED_COUNT, send_frame, cycle);
+    double wire_bytes = (double)cycle->wire_bytes / CYCLE_FRAMES;
+    bench_annotate("wire_bytes_per_frame", wire_bytes);
+    bench_annotate("compression_ratio", (double)rgb_bytes / CYCLE_FRAMES / wire_bytes);
+}
+
+int main(int argc, char **argv)
+{
+    if (!bench_init(argc, argv, "bench_delta_decode")) {
+        return 1;
+    }
+    uint64_t frames = bench_iterations(DEFAULT_FRAMES);
+    cycle_t *cycle = malloc(sizeof(*cycle));
+    encode_cycle(CONTENT_CHASE, false, cycle);
+    uint64_t rgb_bytes = cycle->wire_bytes;
+
+    run_case("rgb", CONTENT_CHASE, false, frames, cycle, rgb_bytes);
+    run_case("delta_gradient", CONTENT_GRADIENT, true, frames, cycle, rgb_bytes);
+    run_case("delta_chase", CONTENT_CHASE, true, frames, cycle, rgb_bytes);
+    run_case("delta_noise", CONTENT_NOISE, true, frames, cycle, rgb_bytes);
+
+    free(cycle);
+    return bench_finish();
+}
@@ -0,0 +1,117 @@
+// Host micro-benchmark: ns/LED of the WS2815 encoders for every run of the
+// checked-in layouts.
+#include "bench.h"
+#include "loadgen_layout.h"
+#include "ws2815_encoder.h"
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define DEFAULT_ITERATIONS 2000
+
+static const char *const LAYOUTS[] = {"left", "right", "four_run"};
+
+// Per-bit branch loop the driver used before the lookup table.
+static void loop_encode_run(unsigned int led_count, const uint8_t *rgb_data,
+                            rmt_symbol_word_t *items)
+{
+    size_t item_index = 0;
+    for (unsigned int led_index = 0; led_index < led_count; ++led_index) {
+        uint8_t red = rgb_data[led_index * 3];
+        uint8_t green = rgb_data[led_index * 3 + 1];
+        uint8_t blue = rgb_data[led_index * 3 + 2];
+        uint8_t grb[3] = {green, red, blue};
+        for (int color = 0; color < 3; ++color) {
+            uint8_t value = grb[color];
+            for (int bit = 7; bit >= 0; --bit) {
+                bool bit_set = value & (1 << bit);
+                items[item_index].duration0 = bit_set ? RMT_T1H_TICKS : RMT_T0H_TICKS;
+                items[item_index].level0 = 1;
+                items[item_index].duration1 = bit_set ? RMT_T1L_TICKS : RMT_T0L_TICKS;
+                items[item_index].level1 = 0;
+                ++item_index;
+            }
+        }
+    }
+}
+
+typedef struct {
+    unsigned int led_count;
+    uint8_t *rgb;
+    rmt_symbol_word_t *symbols;
+} run_context_t;
+
+static void encode_loop(uint64_t iteration, void *context)
+{
+    run_context_t *run = context;
+    run->rgb[0] = (uint8_t)iteration;
+    loop_encode_run(run->led_count, run->rgb, run->symbols);
+    bench_sink += run->symbols[run->led_count * WS2815_SYMBOLS_PER_LED - 1].val;
+}
+
+static void encode_table(uint64_t iteration, void *context)
+{
+    run_context_t *run = context;
+    size_t symbol_count = run->led_count * WS2815_SYMBOLS_PER_LED;
+    run->rgb[0] = (uint8_t)iteration;
+    ws2815_encode_symbols(run->rgb, run->led_count * 3, 0, run->symbols, symbol_count);
+    bench_sink += run->symbols[symbol_count - 1].val;
+}
+
+// 64-symbol chunks mirror RMT ping-pong refills
+static void encode_chunked(uint64_t iteration, void *context)
+{
+    run_context_t *run = context;
+    size_t symbol_count = run->led_count * WS2815_SYMBOLS_PER_LED;
+    run->rgb[0] = (uint8_t)iteration;
+    for (size_t written = 0; written < symbol_count;) {
+        written += ws2815_encode_symbols(run->rgb, run->led_count * 3, written,
+                                         run->symbols + written, 64);
+    }
+    bench_sink += run->symbols[symbol_count - 1].val;
+}
+
+int main(int argc, char **argv)
+{
+    if (!bench_init(argc, argv, "bench_encode_run")) {
+        return 1;
+    }
+    uint64_t iterations = bench_iterations(DEFAULT_ITERATIONS);
+    // Result names must outlive bench_finish
+    static char names[sizeof(LAYOUTS) / sizeof(LAYOUTS[0])][LOADGEN_MAX_RUNS][3][48];
+
+    for (size_t layout_index = 0; layout_index < sizeof(LAYOUTS) / sizeof(LAYOUTS[0]);
+         ++layout_index) {
+        char path[512];
+        snprintf(path, sizeof(path), "%s/%s.json", BENCH_CONFIG_DIR, LAYOUTS[layout_index]);
+        loadgen_layout_t layout;
+        char error[128];
+        if (!loadgen_layout_load(path, &layout, error, sizeof(error))) {
+            fprintf(stderr, "%s: %s\n", path, error);
+            return 1;
+        }
+        for (unsigned int run = 0; run < layout.run_count; ++run) {
+            run_context_t context = {.led_count = layout.led_count[run]};
+            size_t byte_count = context.led_count * 3;
+            context.rgb = malloc(byte_count);
+            context.symbols = malloc(sizeof(rmt_symbol_word_t) * context.led_count *
+                                     WS2815_SYMBOLS_PER_LED);
+            for (size_t index = 0; index < byte_count; ++index) {
+                context.rgb[index] = (uint8_t)(index * 37u);
+            }
+            static const char *const VARIANTS[] = {"loop", "table", "table_64"};
+            void (*const BODIES[])(uint64_t, void *) = {encode_loop, encode_table,
+                                                         encode_chunked};
+            for (size_t variant = 0; variant < 3; ++variant) {
+                char *name = names[layout_index][run][variant];
+                snprintf(name, sizeof(names[0][0][0]), "%s/run%u_%uled/%s", LAYOUTS[layout_index],
+                         run, context.led_count, VARIANTS[variant]);
+                bench_run(name, iterations, context.led_count, BODIES[variant], &context);
+            }
+            free(context.symbols);
+            free(context.rgb);
+        }
+    }
+    return bench_finish();
+}
@@ -0,0 +1,105 @@
+// Host micro-benchmark: whole frames of the generated layout sent as RGB
+// blocks and as palette blocks with 8-bit and 4-bit indices. ns/LED is the
+// expansion cost on top of validation; each result carries the bytes on
+// the wire per frame and the ratio against RGB.
+#include "bench.h"
+#include "config_autogen.h"
+#include "loadgen_packet.h"
+#include "rx_task.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define DEFAULT_FRAMES 200000
+#define MAX_FRAME_DATAGRAMS (RUN_COUNT * 3)
+
+typedef struct {
+    uint8_t datagrams[MAX_FRAME_DATAGRAMS][LOADGEN_UDP_MAX_PAYLOAD];
+    size_t lengths[MAX_FRAME_DATAGRAMS];
+    unsigned int datagram_count;
+    uint64_t wire_bytes;
+} frame_t;
+
+// Runs painted from `colours` colours in bands of four LEDs
+static void fill_content(unsigned int colours, uint8_t *rgb[RUN_COUNT])
+{
+    for (unsigned int run = 0; run < RUN_COUNT; ++run) {
+        for (size_t led = 0; led < LED_COUNT[run]; ++led) {
+            unsigned int colour = (unsigned int)((led / 4 + run) % colours);
+            rgb[run][led * 3] = (uint8_t)(colour * 37);
+            rgb[run][led * 3 + 1] = (uint8_t)(255 - colour);
+            rgb[run][led * 3 + 2] = (uint8_t)(colour * 11);
+        }
+    }
+}
+
+// Encodes one frame with `bits` per index, or as RGB when bits is 0
+static void encode_frame(unsigned int colours, unsigned int bits, frame_t *frame)
+{
+    uint8_t *rgb[RUN_COUNT];
+    for (unsigned int run = 0; run < RUN_COUNT; ++run) {
+        rgb[run] = malloc(LED_COUNT[run] * 3);
+    }
+    fill_content(colours, rgb);
+    frame->datagram_count = 0;
+    frame->wire_bytes = 0;
+    for (unsigned int run = 0; run < RUN_COUNT; ++run) {
+        unsigned int fragments = loadgen_fragment_count(LED_COUNT[run], LOADGEN_FRAGMENT_MAX_LEDS);
+        for (unsigned int index = 0; index < fragments; ++index) {
+            uint8_t *out = frame->datagrams[frame->datagram_count];
+            size_t length = bits > 0 ? loadgen_encode_palette_fragment(0, run, rgb[run],
+                                                                        LED_COUNT[run], 0, index,
+                                                                        bits, out)
+                                     : loadgen_encode_fragment(0, run, rgb[run], LED_COUNT[run],
+                                                               0, index, out);
+            frame->lengths[frame->datagram_count++] = length;
+            frame->wire_bytes += length;
+        }
+    }
+    for (unsigned int run = 0; run < RUN_COUNT; ++run) {
+        free(rgb[run]);
+    }
+}
+
+static void send_frame(uint64_t iteration, void *context)
+{
+    frame_t *frame = context;
+    uint32_t frame_id = (uint32_t)iteration + 1;
+    for (unsigned int index = 0; index < frame->datagram_count; ++index) {
+        loadgen_write_frame_id(frame->datagrams[index], frame_id);
+        rx_task_process_extended(frame->datagrams[index], frame->lengths[index]);
+    }
+    // Stand-in for driver_task picking up each completed frame
+    if (rx_task_acquire_frame() != NULL) {
+        ++bench_sink;
+    }
+}
+
+static void run_case(const char *name, unsigned int colours, unsigned int bits, uint64_t frames,
+                     frame_t *frame, uint64_t rgb_bytes)
+{
+    encode_frame(colours, bits, frame);
+    rx_task_start();
+    bench_run(name, frames, TOTAL_LED_COUNT, send_frame, frame);
+    bench_annotate("wire_bytes_per_frame", (double)frame->wire_bytes);
+    bench_annotate("compression_ratio", (double)rgb_bytes / frame->wire_bytes);
+}
+
+int main(int argc, char **argv)
+{
+    if (!bench_init(argc, argv, "bench_palette_expand")) {
+        return 1;
+    }
+    uint64_t frames = bench_iterations(DEFAULT_FRAMES);
+    frame_t *frame = malloc(sizeof(*frame));
+    encode_frame(16, 0, frame);
+    uint64_t rgb_bytes = frame->wire_bytes;
+
+    run_case("rgb", 16, 0, frames, frame, rgb_bytes);
+    run_case("palette8_48_colours", 48, 8, frames, frame, rgb_bytes);
+    run_case("palette8_16_colours", 16, 8, frames, frame, rgb_bytes);
+    run_case("palette4_16_colours", 16, 4, frames, frame, rgb_bytes);
+
+    free(frame);
+    return bench_finish();
+}
@@ -0,0 +1,107 @@
+// Host micro-benchmark: rx_task_process_packet per datagram for in-order,
+// reordered and lossy traffic on the generated layout.
+#include "bench.h"
+#include "config_autogen.h"
+#include "loadgen_plan.h"
+#include "rx_task.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define DEFAULT_DATAGRAMS 2000000
+
+typedef struct {
+    uint32_t frame_id;
+    uint8_t run;
+} scheduled_t;
+
+typedef struct {
+    const scheduled_t *schedule;
+    uint8_t *packets[RX_SOCKET_COUNT];
+    size_t lengths[RX_SOCKET_COUNT];
+} replay_context_t;
+
+// Datagram order from the load generator's impairment plan, computed ahead
+// so planning stays out of the timed loop.
+static scheduled_t *plan_schedule(const loadgen_impairments_t *impairments, uint64_t datagrams)
+{
+    scheduled_t *schedule = malloc(sizeof(*schedule) * datagrams);
+    loadgen_plan_t plan;
+    loadgen_plan_init(&plan, RUN_COUNT, impairments, 1);
+    loadgen_datagram_t frame[LOADGEN_MAX_FRAME_DATAGRAMS];
+    uint64_t planned = 0;
+    for (uint32_t frame_id = 1; planned < datagrams; ++frame_id) {
+        size_t count = loadgen_plan_frame(&plan, frame_id, frame);
+        for (size_t index = 0; index < count && planned < datagrams; ++index) {
+            schedule[planned].frame_id = frame[index].frame_id;
+            schedule[planned].run = frame[index].run;
+            ++planned;
+        }
+    }
+    return schedule;
+}
+
+static void process_datagram(uint64_t iteration, void *context)
+{
+    replay_context_t *replay = context;
+    const scheduled_t *datagram = &replay->schedule[iteration];
+    uint8_t *packet = replay->packets[datagram->run];
+    packet[0] = (uint8_t)(datagram->frame_id >> 24);
+    packet[1] = (uint8_t)(datagram->frame_id >> 16);
+    packet[2] = (uint8_t)(datagram->frame_id >> 8);
+    packet[3] = (uint8_t)datagram->frame_id;
+    if (datagram->run == RX_PARITY_SOCKET_INDEX) {
+        rx_task_process_parity(packet, replay->lengths[datagram->run]);
+    } else {
+        rx_task_process_packet(datagram->run, packet, replay->lengths[datagram->run]);
+    }
+    // Stand-in for driver_task picking up each completed frame
+    if (rx_task_acquire_frame() != NULL) {
+        ++bench_sink;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    if (!bench_init(argc, argv, "bench_rx_assembly")) {
+        return 1;
+    }
+    uint64_t datagrams = bench_iterations(DEFAULT_DATAGRAMS);
+    replay_context_t context = {0};
+    unsigned int total_leds = 0;
+    for (unsigned int run = 0; run < RUN_COUNT; ++run) {
+        context.lengths[run] = 4 + LED_COUNT[run] * 3;
+        total_leds += LED_COUNT[run];
+    }
+#if RX_PARITY_ENABLED
+    context.lengths[RX_PARITY_SOCKET_INDEX] = rx_task_parity_length();
+#endif
+    for (unsigned int socket = 0; socket < RX_SOCKET_COUNT; ++socket) {
+        context.packets[socket] = calloc(1, context.lengths[socket]);
+    }
+
+    static const struct {
+        const char *name;
+        loadgen_impairments_t impairments;
+    } PATTERNS[] = {
+        {"in_order", {.loss = 0}},
+        // Runs arrive spread over the frame and a fifth trail the next frame
+        {"reordered", {.reorder = 0.2, .skew_us = 1000}},
+        {"lossy", {.loss = 0.05, .duplicate = 0.01, .parity = RX_PARITY_ENABLED}},
+    };
+    // Per-datagram cost; ns/LED spreads it over an average run
+    uint64_t leds_per_datagram = (total_leds + RUN_COUNT / 2) / RUN_COUNT;
+    for (size_t pattern = 0; pattern < sizeof(PATTERNS) / sizeof(PATTERNS[0]); ++pattern) {
+        context.schedule = plan_schedule(&PATTERNS[pattern].impairments, datagrams);
+        rx_task_start();
+        bench_run(PATTERNS[pattern].name, datagrams, leds_per_datagram, process_datagram,
+                  &context);
+        free((void *)context.schedule);
+    }
+
+    for (unsigned int socket = 0; socket < RX_SOCKET_COUNT; ++socket) {
+        free(context.packets[socket]);
+    }
+    return bench_finish();
+}
@@ -0,0 +1,114 @@
+// Host micro-benchmark: one frame of short runs sent as a datagram per run
+// against the same runs batched into extended datagrams. Built against
+// config/four_short.json rather than the generated layout.
+#include "bench.h"
+#include "config_autogen.h"
+#include "loadgen_packet.h"
+#include "rx_task.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define DEFAULT_FRAMES 500000
+#define MAX_BATCHES RUN_COUNT
+
+static const unsigned int FRAME_RATES[] = {60, 120};
+
+typedef struct {
+    uint8_t *packets[RUN_COUNT];
+    uint8_t batches[MAX_BATCHES][LOADGEN_UDP_MAX_PAYLOAD];
+    size_t batch_lengths[MAX_BATCHES];
+    unsigned int batch_count;
+} frame_context_t;
+
+static void take_frame(void)
+{
+    // Stand-in for driver_task picking up each completed frame
+    if (rx_task_acquire_frame() != NULL) {
+        ++bench_sink;
+    }
+}
+
+static void send_per_run(uint64_t iteration, void *context)
+{
+    frame_context_t *frame = context;
+    uint32_t frame_id = (uint32_t)iteration + 1;
+    for (unsigned int run = 0; run < RUN_COUNT; ++run) {
+        loadgen_write_frame_id(frame->packets[run], frame_id);
+        rx_task_process_packet(run, frame->packets[run], 4 + LED_COUNT[run] * 3);
+    }
+    take_frame();
+}
+
+static void send_batched(uint64_t iteration, void *context)
+{
+    frame_context_t *frame = context;
+    uint32_t frame_id = (uint32_t)iteration + 1;
+    for (unsigned int batch = 0; batch < frame->batch_count; ++batch) {
+        loadgen_write_frame_id(frame->batches[batch], frame_id);
+        rx_task_process_extended(frame->batches[batch], frame->batch_lengths[batch]);
+    }
+    take_frame();
+}
+
+// Datagrams per second and rx_task CPU time per second of the last result
+// at each frame rate. Per-datagram interrupt and lwIP cost on the target
+// comes on top and scales with the datagram rate.
+static void annotate_rates(unsigned int datagrams_per_frame, double *cpu_us_per_frame)
+{
+    const bench_result_t *result = bench_last();
+    *cpu_us_per_frame = (double)result->elapsed_ns / result->iterations / 1000.0;
+    bench_annotate("datagrams_per_frame", datagrams_per_frame);
+    for (size_t rate = 0; rate < sizeof(FRAME_RATES) / sizeof(FRAME_RATES[0]); ++rate) {
+        bench_annotate(rate == 0 ? "datagrams_per_s_60fps" : "datagrams_per_s_120fps",
+                       (double)datagrams_per_frame * FRAME_RATES[rate]);
+        bench_annotate(rate == 0 ? "cpu_us_per_s_60fps" : "cpu_us_per_s_120fps",
+                       *cpu_us_per_frame * FRAME_RATES[rate]);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    if (!bench_init(argc, argv, "bench_rx_batching")) {
+        return 1;
+    }
+    uint64_t frames = bench_iterations(DEFAULT_FRAMES);
+    static frame_context_t context;
+    const uint8_t *rgb[RUN_COUNT];
+    unsigned int total_leds = 0;
+    for (unsigned int run = 0; run < RUN_COUNT; ++run) {
+        context.packets[run] = calloc(1, 4 + LED_COUNT[run] * 3);
+        for (size_t byte = 0; byte < LED_COUNT[run] * 3; ++byte) {
+            context.packets[run][4 + byte] = (uint8_t)(byte + run);
+        }
+        rgb[run] = context.packets[run] + 4;
+        total_leds += LED_COUNT[run];
+    }
+    for (unsigned int run = 0; run < RUN_COUNT;) {
+        unsigned int count = loadgen_batch_runs(LED_COUNT, RUN_COUNT, run);
+        context.batch_lengths[context.batch_count] = loadgen_encode_batch(
+            0, LED_COUNT, rgb, run, count, context.batches[context.batch_count]);
+        ++context.batch_count;
+        run += count;
+    }
+
+    double per_run_us;
+    double batched_us;
+    rx_task_start();
+    bench_run("per_run", frames, total_leds, send_per_run, &context);
+    annotate_rates(RUN_COUNT, &per_run_us);
+    rx_task_start();
+    bench_run("batched", frames, total_leds, send_batched, &context);
+    annotate_rates(context.batch_count, &batched_us);
+    for (size_t rate = 0; rate < sizeof(FRAME_RATES) / sizeof(FRAME_RATES[0]); ++rate) {
+        bench_annotate(rate == 0 ? "datagrams_saved_per_s_60fps" : "datagrams_saved_per_s_120fps",
+                       (double)(RUN_COUNT - context.batch_count) * FRAME_RATES[rate]);
+        bench_annotate(rate == 0 ? "cpu_us_saved_per_s_60fps" : "cpu_us_saved_per_s_120fps",
+                       (per_run_us - batched_us) * FRAME_RATES[rate]);
+    }
+
+    for (unsigned int run = 0; run < RUN_COUNT; ++run) {
+        free(context.packets[run]);
+    }
+    return bench_finish();
+}
@@ -0,0 +1,108 @@
+// Host micro-benchmark: whole frames of the generated layout sent as RGB
+// blocks and as sampled blocks at one sample per 2, 4 and 8 LEDs of each
+// section. ns/LED is the interpolation cost on top of validation; each
+// result carries the bytes on the wire per frame and the ratio against RGB.
+#include "bench.h"
+#include "config_autogen.h"
+#include "loadgen_packet.h"
+#include "rx_task.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define DEFAULT_FRAMES 200000
+#define MAX_FRAME_DATAGRAMS (RUN_COUNT * 3)
+
+typedef struct {
+    uint8_t datagrams[MAX_FRAME_DATAGRAMS][LOADGEN_UDP_MAX_PAYLOAD];
+    size_t lengths[MAX_FRAME_DATAGRAMS];
+    unsigned int datagram_count;
+    uint64_t wire_bytes;
+} frame_t;
+
+// Smooth content: a triangle wave per channel along each run
+static void fill_content(uint8_t *rgb[RUN_COUNT])
+{
+    for (unsigned int run = 0; run < RUN_COUNT; ++run) {
+        for (size_t byte = 0; byte < LED_COUNT[run] * 3; ++byte) {
+            unsigned int phase = (unsigned int)(byte / 3 * 2 + run * 64 + byte % 3 * 170) & 0x1ff;
+            rgb[run][byte] = (uint8_t)(phase > 0xff ? 0x1ff - phase : phase);
+        }
+    }
+}
+
+// Encodes one frame sampled every `stride` LEDs, or as RGB when stride is 0
+static void encode_frame(unsigned int stride, frame_t *frame)
+{
+    uint8_t *rgb[RUN_COUNT];
+    for (unsigned int run = 0; run < RUN_COUNT; ++run) {
+        rgb[run] = malloc(LED_COUNT[run] * 3);
+    }
+    fill_content(rgb);
+    frame->datagram_count = 0;
+    frame->wire_bytes = 0;
+    for (unsigned int run = 0; run < RUN_COUNT; ++run) {
+        const unsigned int *sections = &SECTION_LED_COUNT[RUN_FIRST_SECTION[run]];
+        unsigned int fragments =
+            stride > 0
+                ? loadgen_sampled_fragment_count(sections, RUN_SECTION_COUNT[run], stride)
+                : loadgen_fragment_count(LED_COUNT[run], LOADGEN_FRAGMENT_MAX_LEDS);
+        for (unsigned int index = 0; index < fragments; ++index) {
+            uint8_t *out = frame->datagrams[frame->datagram_count];
+            size_t length = stride > 0
+                                ? loadgen_encode_sampled_fragment(0, run, rgb[run], sections,
+                                                                  RUN_SECTION_COUNT[run], stride,
+                                                                  index, out)
+                                : loadgen_encode_fragment(0, run, rgb[run], LED_COUNT[run], 0,
+                                                          index, out);
+            frame->lengths[frame->datagram_count++] = length;
+            frame->wire_bytes += length;
+        }
+    }
+    for (unsigned int run = 0; run < RUN_COUNT; ++run) {
+        free(rgb[run]);
+    }
+}
+
+static void send_frame(uint64_t iteration, void *context)
+{
+    frame_t *frame = context;
+    uint32_t frame_id = (uint32_t)iteration + 1;
+    for (unsigned int index = 0; index < frame->datagram_count; ++index) {
+        loadgen_write_frame_id(frame->datagrams[index], frame_id);
+        rx_task_process_extended(frame->datagrams[index], frame->lengths[index]);
+    }
+    // Stand-in for driver_task picking up each completed frame
+    if (rx_task_acquire_frame() != NULL) {
+        ++bench_sink;
+    }
+}
+
+static void run_case(const char *name, unsigned int stride, uint64_t frames, frame_t *frame,
+                     uint64_t rgb_bytes)
+{
+    encode_frame(stride, frame);
+    rx_task_start();
+    bench_run(name, frames, TOTAL_LED_COUNT, send_frame, frame);
+    bench_annotate("wire_bytes_per_frame", (double)frame->wire_bytes);
+    bench_annotate("compression_ratio", (double)rgb_bytes / frame->wire_bytes);
+}
+
+int main(int argc, char **argv)
+{
+    if (!bench_init(argc, argv, "bench_sampled_interpolate")) {
+        return 1;
+    }
+    uint64_t frames = bench_iterations(DEFAULT_FRAMES);
+    frame_t *frame = malloc(sizeof(*frame));
+    encode_frame(0, frame);
+    uint64_t rgb_bytes = frame->wire_bytes;
+
+    run_case("rgb", 0, frames, frame, rgb_bytes);
+    run_case("sampled_stride_2", 2, frames, frame, rgb_bytes);
+    run_case("sampled_stride_4", 4, frames, frame, rgb_bytes);
+    run_case("sampled_stride_8", 8, frames, frame, rgb_bytes);
+
+    free(frame);
+    return bench_finish();
+}
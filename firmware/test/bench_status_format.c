@@ -0,0 +1,84 @@
+// Host micro-benchmark: cost of formatting one JSON heartbeat, next to the
+// binary telemetry datagram carrying the same interval.
+#include "bench.h"
+#include "config_autogen.h"
+#include "latency_stats.h"
+#include "status_task.h"
+#include "telemetry.h"
+
+#include <stdint.h>
+
+#define DEFAULT_ITERATIONS 500000
+
+typedef struct {
+    telemetry_interval_t interval;
+    const event_t *events;
+    size_t event_count;
+    char json[STATUS_HEARTBEAT_MAX_BYTES];
+    uint8_t datagram[TELEMETRY_DATAGRAM_BYTES];
+} heartbeat_context_t;
+
+// Counters and latencies of one second at 85 fps with a little loss
+static void fill_busy_interval(telemetry_interval_t *interval)
+{
+    latency_stats_reset();
+    telemetry_reader_t reader;
+    telemetry_reader_init(&reader, LATENCY_READER_HEARTBEAT);
+    for (uint32_t frame = 0; frame < 85; ++frame) {
+        uint64_t start_us = 1000000ull + frame * 11765ull;
+        latency_stats_record(LATENCY_STAGE_ASSEMBLE, start_us, start_us + 300 + frame * 7);
+        latency_stats_record(LATENCY_STAGE_HANDOFF, start_us, start_us + 40 + frame % 9);
+        latency_stats_record(LATENCY_STAGE_ENCODE, start_us, start_us + 900 + frame * 3);
+        latency_stats_record(LATENCY_STAGE_TRANSMIT, start_us, start_us + 11000 + frame);
+        latency_stats_record(LATENCY_STAGE_TOTAL, start_us, start_us + 12500 + frame * 11);
+    }
+    telemetry_reader_next(&reader, interval);
+    interval->metrics.value[METRIC_RX_FRAMES] = 85 * RUN_COUNT - 3;
+    interval->metrics.value[METRIC_COMPLETE] = 84;
+    interval->metrics.value[METRIC_APPLIED] = 84;
+    interval->metrics.value[METRIC_DROPS_STALE] = 2;
+    interval->metrics.value[METRIC_DROPS_WINDOW] = 1;
+    interval->metrics.value[METRIC_PARITY_RECOVERED] = 1;
+    for (unsigned int run = 0; run < RUN_COUNT; ++run) {
+        interval->metrics.value[METRIC_RUN_RX + run] = 85 - (run == 0 ? 3 : 0);
+    }
+}
+
+static void format_heartbeat(uint64_t iteration, void *context)
+{
+    heartbeat_context_t *heartbeat = context;
+    bench_sink += status_task_format_json(heartbeat->json, sizeof(heartbeat->json),
+                                          (uint32_t)iteration, 1000, true, &heartbeat->interval,
+                                          heartbeat->events, heartbeat->event_count);
+}
+
+static void encode_telemetry(uint64_t iteration, void *context)
+{
+    heartbeat_context_t *heartbeat = context;
+    bench_sink += telemetry_encode(&heartbeat->interval, (uint32_t)iteration, (uint32_t)iteration,
+                                   true, heartbeat->datagram, sizeof(heartbeat->datagram));
+}
+
+int main(int argc, char **argv)
+{
+    if (!bench_init(argc, argv, "bench_status_format")) {
+        return 1;
+    }
+    uint64_t iterations = bench_iterations(DEFAULT_ITERATIONS);
+    static const event_t EVENTS[STATUS_MAX_EVENTS] = {
+        {.timestamp_ms = 812345, .detail = 1, .code = EVENT_RX_BAD_LENGTH},
+        {.timestamp_ms = 812350, .detail = 0, .code = EVENT_RX_POOL_EXHAUSTED},
+        {.timestamp_ms = 812400, .detail = 2, .code = EVENT_RMT_TIMEOUT},
+        {.timestamp_ms = 813000, .detail = 0, .code = EVENT_LINK_UP},
+    };
+    static heartbeat_context_t context;
+
+    bench_run("json/idle", iterations, 0, format_heartbeat, &context);
+    fill_busy_interval(&context.interval);
+    bench_run("json/busy", iterations, 0, format_heartbeat, &context);
+    context.events = EVENTS;
+    context.event_count = STATUS_MAX_EVENTS;
+    bench_run("json/busy_4_events", iterations, 0, format_heartbeat, &context);
+    bench_run("telemetry/busy", iterations, 0, encode_telemetry, &context);
+    return bench_finish();
+}
@@ -0,0 +1,174 @@
+// Bounded MPSC event ring: overflow, ordering and concurrent producers.
+#include "unity.h"
+#include "event_log.h"
+#include "latency_stats.h"
+#include "metrics.h"
+#include <pthread.h>
+#include <sched.h>
+#include <string.h>
+
+#define PRODUCER_COUNT 4
+#define EVENTS_PER_PRODUCER 50000
+
+static uint64_t fake_now_us;
+static int notify_calls;
+
+static uint64_t fake_clock(void)
+{
+    return fake_now_us;
+}
+
+static void count_notify(void)
+{
+    ++notify_calls;
+}
+
+static uint32_t events_lost(const metrics_snapshot_t *before)
+{
+    metrics_snapshot_t after;
+    metrics_snapshot_t delta;
+    metrics_snapshot(&after);
+    metrics_delta(&after, before, &delta);
+    return delta.value[METRIC_EVENTS_LOST];
+}
+
+void setUp(void)
+{
+    event_log_reset();
+    event_log_set_notify(NULL);
+    fake_now_us = 0;
+    notify_calls = 0;
+    latency_stats_set_clock(fake_clock);
+}
+
+void tearDown(void)
+{
+    latency_stats_set_clock(NULL);
+}
+
+void test_drain_returns_events_oldest_first(void)
+{
+    fake_now_us = 12000;
+    TEST_ASSERT_TRUE(event_log_post(EVENT_RMT_TIMEOUT, 2));
+    fake_now_us = 13000;
+    TEST_ASSERT_TRUE(event_log_post(EVENT_LINK_DOWN, 0));
+    event_t events[4];
+    TEST_ASSERT_EQUAL(2, event_log_drain(events, 4));
+    TEST_ASSERT_EQUAL(EVENT_RMT_TIMEOUT, events[0].code);
+    TEST_ASSERT_EQUAL_UINT32(2, events[0].detail);
+    TEST_ASSERT_EQUAL_UINT32(12, events[0].timestamp_ms);
+    TEST_ASSERT_EQUAL(EVENT_LINK_DOWN, events[1].code);
+    TEST_ASSERT_EQUAL(0, event_log_drain(events, 4));
+}
+
+void test_full_ring_drops_newest_and_counts_loss(void)
+{
+    metrics_snapshot_t before;
+    metrics_snapshot(&before);
+    for (uint32_t index = 0; index < EVENT_LOG_CAPACITY; ++index) {
+        TEST_ASSERT_TRUE(event_log_post(EVENT_RX_BAD_LENGTH, index));
+    }
+    for (uint32_t index = 0; index < 5; ++index) {
+        TEST_ASSERT_FALSE(event_log_post(EVENT_RX_BAD_LENGTH, 1000 + index));
+    }
+    TEST_ASSERT_EQUAL_UINT32(5, events_lost(&before));
+
+    // The oldest events survive; draining frees room for new ones
+    event_t events[EVENT_LOG_CAPACITY];
+    TEST_ASSERT_EQUAL(2, event_log_drain(events, 2));
+    TEST_ASSERT_EQUAL_UINT32(0, events[0].detail);
+    TEST_ASSERT_EQUAL_UINT32(1, events[1].detail);
+    TEST_ASSERT_TRUE(event_log_post(EVENT_RX_BAD_LENGTH, 2000));
+    TEST_ASSERT_EQUAL(EVENT_LOG_CAPACITY - 1, event_log_drain(events, EVENT_LOG_CAPACITY));
+    TEST_ASSERT_EQUAL_UINT32(EVENT_LOG_CAPACITY - 1, events[EVENT_LOG_CAPACITY - 3].detail);
+    TEST_ASSERT_EQUAL_UINT32(2000, events[EVENT_LOG_CAPACITY - 2].detail);
+}
+
+void test_only_severe_events_notify(void)
+{
+    event_log_set_notify(count_notify);
+    event_log_post(EVENT_LINK_UP, 0);
+    event_log_post(EVENT_RX_POOL_EXHAUSTED, 1);
+    TEST_ASSERT_EQUAL(0, notify_calls);
+    event_log_post(EVENT_RMT_TIMEOUT, 1);
+    event_log_post(EVENT_LINK_DOWN, 0);
+    TEST_ASSERT_EQUAL(2, notify_calls);
+}
+
+void test_format_prefixes_timestamp(void)
+{
+    event_t event = {.timestamp_ms = 4321, .detail = 3, .code = EVENT_RMT_TIMEOUT};
+    char message[64];
+    size_t length = event_log_format(&event, message, sizeof(message));
+    TEST_ASSERT_EQUAL_STRING("4321: rmt_tx_wait_all_done timeout run 3", message);
+    TEST_ASSERT_EQUAL(strlen(message), length);
+}
+
+static void *produce(void *arg)
+{
+    uint32_t producer = (uint32_t)(uintptr_t)arg;
+    for (uint32_t sequence = 0; sequence < EVENTS_PER_PRODUCER; ++sequence) {
+        event_log_post(EVENT_RX_BAD_LENGTH, (producer << 24) | sequence);
+        if (sequence % 64 == 0) {
+            sched_yield();
+        }
+    }
+    return NULL;
+}
+
+void test_concurrent_producers_lose_nothing_silently(void)
+{
+    latency_stats_set_clock(NULL);
+    metrics_snapshot_t before;
+    metrics_snapshot(&before);
+    pthread_t producers[PRODUCER_COUNT];
+    for (uintptr_t producer = 0; producer < PRODUCER_COUNT; ++producer) {
+        pthread_create(&producers[producer], NULL, produce, (void *)producer);
+    }
+
+    // Each producer's events must arrive in order, without duplicates
+    int64_t last_sequence[PRODUCER_COUNT];
+    for (int producer = 0; producer < PRODUCER_COUNT; ++producer) {
+        last_sequence[producer] = -1;
+    }
+    uint32_t received = 0;
+    int joined = 0;
+    for (;;) {
+        event_t events[8];
+        size_t count = event_log_drain(events, 8);
+        for (size_t index = 0; index < count; ++index) {
+            uint32_t producer = events[index].detail >> 24;
+            int64_t sequence = events[index].detail & 0xFFFFFF;
+            TEST_ASSERT_TRUE(producer < PRODUCER_COUNT);
+            TEST_ASSERT_TRUE(sequence > last_sequence[producer]);
+            last_sequence[producer] = sequence;
+        }
+        received += (uint32_t)count;
+        if (count == 0) {
+            if (joined) {
+                break;
+            }
+            if (received + events_lost(&before) == PRODUCER_COUNT * EVENTS_PER_PRODUCER) {
+                for (int producer = 0; producer < PRODUCER_COUNT; ++producer) {
+                    pthread_join(producers[producer], NULL);
+                }
+                joined = 1;
+            }
+            sched_yield();
+        }
+    }
+    // Every post was either delivered or counted as lost
+    TEST_ASSERT_EQUAL_UINT32(PRODUCER_COUNT * EVENTS_PER_PRODUCER, received + events_lost(&before));
+    TEST_ASSERT_TRUE(received > 0);
+}
+
+int main(void)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_drain_returns_events_oldest_first);
+    RUN_TEST(test_full_ring_drops_newest_and_counts_loss);
+    RUN_TEST(test_only_severe_events_notify);
+    RUN_TEST(test_format_prefixes_timestamp);
+    RUN_TEST(test_concurrent_producers_lose_nothing_silently);
+    return UNITY_END();
+}
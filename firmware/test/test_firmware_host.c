@@ -0,0 +1,264 @@
+// End-to-end run of the real firmware tasks on the host shims: UDP frames in
+// on loopback, decoded by virtual strips on the recording RMT stub.
+#include "unity.h"
+#include "config_autogen.h"
+#include "host_rmt.h"
+#include "virtual_strip.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <time.h>
+#include <unistd.h>
+
+void app_main(void);
+
+// Startup holds black for a second and flashes each run for a second
+#define STARTUP_SECONDS (1 + RUN_COUNT)
+#define FRAME_INTERVAL_MS 20
+
+static int sender;
+static uint32_t next_frame_id = 1;
+static int heartbeat_listener;
+static uint8_t *run_packets[RUN_COUNT];
+
+static void sleep_ms(unsigned int ms)
+{
+    struct timespec delay = {.tv_sec = ms / 1000, .tv_nsec = (long)(ms % 1000) * 1000000L};
+    nanosleep(&delay, NULL);
+}
+
+static void send_to_port(uint16_t port, const uint8_t *data, size_t length)
+{
+    struct sockaddr_in destination = {
+        .sin_family = AF_INET,
+        .sin_port = htons(port),
+        .sin_addr.s_addr = htonl(INADDR_LOOPBACK),
+    };
+    sendto(sender, data, length, 0, (struct sockaddr *)&destination, sizeof(destination));
+}
+
+static void send_frame(uint32_t frame_id)
+{
+    for (unsigned int run = 0; run < RUN_COUNT; ++run) {
+        uint8_t *packet = run_packets[run];
+        packet[0] = (uint8_t)(frame_id >> 24);
+        packet[1] = (uint8_t)(frame_id >> 16);
+        packet[2] = (uint8_t)(frame_id >> 8);
+        packet[3] = (uint8_t)frame_id;
+        send_to_port(PORT_BASE + run, packet, 4 + LED_COUNT[run] * 3);
+    }
+}
+
+// The observer runs on driver_task; the test thread reads under the lock
+static pthread_mutex_t strips_mutex = PTHREAD_MUTEX_INITIALIZER;
+static virtual_strip_t strips[RUN_COUNT];
+// Whether each run has latched a frame yet, and whether the first was black
+static bool first_frame_seen[RUN_COUNT];
+static bool first_frame_black[RUN_COUNT];
+
+static bool is_black(const uint8_t *rgb, size_t length)
+{
+    for (size_t index = 0; index < length; ++index) {
+        if (rgb[index] != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void feed_strip(unsigned int channel, const rmt_symbol_word_t *stream,
+                       size_t symbol_count, int64_t start_us, void *arg)
+{
+    (void)arg;
+    pthread_mutex_lock(&strips_mutex);
+    if (channel < RUN_COUNT &&
+        virtual_strip_feed(&strips[channel], stream, symbol_count, start_us) &&
+        !first_frame_seen[channel]) {
+        first_frame_seen[channel] = true;
+        first_frame_black[channel] = is_black(strips[channel].rgb, LED_COUNT[channel] * 3);
+    }
+    pthread_mutex_unlock(&strips_mutex);
+}
+
+static bool strips_show_frame(void)
+{
+    bool shown = true;
+    pthread_mutex_lock(&strips_mutex);
+    for (unsigned int run = 0; run < RUN_COUNT; ++run) {
+        shown = shown && memcmp(strips[run].rgb, run_packets[run] + 4, LED_COUNT[run] * 3) == 0;
+    }
+    pthread_mutex_unlock(&strips_mutex);
+    return shown;
+}
+
+static uint32_t frames_latched(unsigned int run)
+{
+    pthread_mutex_lock(&strips_mutex);
+    uint32_t frames = strips[run].stats.frames;
+    pthread_mutex_unlock(&strips_mutex);
+    return frames;
+}
+
+static void assert_strips_error_free(void)
+{
+    pthread_mutex_lock(&strips_mutex);
+    for (unsigned int run = 0; run < RUN_COUNT; ++run) {
+        TEST_ASSERT_EQUAL_UINT32(0, strips[run].stats.timing_errors);
+        TEST_ASSERT_EQUAL_UINT32(0, strips[run].stats.length_errors);
+        TEST_ASSERT_EQUAL_UINT32(0, strips[run].stats.reset_errors);
+    }
+    pthread_mutex_unlock(&strips_mutex);
+}
+
+void setUp(void) {}
+void tearDown(void) {}
+
+void test_startup_latches_black_first(void)
+{
+    // send_black runs before the startup flashes
+    bool seen = false;
+    bool black = false;
+    for (unsigned int attempt = 0; !seen && attempt < 2000 / FRAME_INTERVAL_MS; ++attempt) {
+        sleep_ms(FRAME_INTERVAL_MS);
+        seen = true;
+        black = true;
+        pthread_mutex_lock(&strips_mutex);
+        for (unsigned int run = 0; run < RUN_COUNT; ++run) {
+            seen = seen && first_frame_seen[run];
+            black = black && first_frame_black[run];
+        }
+        pthread_mutex_unlock(&strips_mutex);
+    }
+    TEST_ASSERT_TRUE_MESSAGE(seen, "startup never latched a frame");
+    TEST_ASSERT_TRUE_MESSAGE(black, "first latched frame was not black");
+}
+
+void test_frames_reach_every_strip(void)
+{
+    bool shown = false;
+    for (unsigned int attempt = 0;
+         !shown && attempt < (STARTUP_SECONDS + 5) * 1000 / FRAME_INTERVAL_MS; ++attempt) {
+        send_frame(next_frame_id++);
+        sleep_ms(FRAME_INTERVAL_MS);
+        shown = strips_show_frame();
+    }
+    TEST_ASSERT_TRUE_MESSAGE(shown, "received frame never reached the strips");
+    TEST_ASSERT_EQUAL_UINT(RUN_COUNT, host_rmt_channel_count());
+    assert_strips_error_free();
+}
+
+void test_back_to_back_frames_keep_latch_gap(void)
+{
+    // Frames arriving faster than the wire drains them keep the driver
+    // transmitting continuously
+    uint32_t frames_before = frames_latched(0);
+    for (unsigned int frame = 0; frame < 100; ++frame) {
+        send_frame(next_frame_id++);
+        sleep_ms(1);
+    }
+    sleep_ms(100);
+    TEST_ASSERT_TRUE(frames_latched(0) > frames_before + 1);
+    assert_strips_error_free();
+}
+
+// Sends one frame and returns the channel-0 rmt_tx_wait_all_done calls it
+// took once the injected timeouts are used up and the driver has settled
+static uint32_t waits_for_one_frame(unsigned int injected_timeouts)
+{
+    // Let frames from earlier tests drain first
+    sleep_ms(100);
+    uint32_t waits_before = host_rmt_wait_count(0);
+    host_rmt_inject_timeouts(0, injected_timeouts);
+    send_frame(next_frame_id++);
+    for (unsigned int attempt = 0; host_rmt_injected_timeouts(0) > 0 && attempt < 200; ++attempt) {
+        sleep_ms(5);
+    }
+    TEST_ASSERT_EQUAL_UINT(0, host_rmt_injected_timeouts(0));
+    sleep_ms(50);
+    return host_rmt_wait_count(0) - waits_before;
+}
+
+void test_wait_retry_recovers_from_timeouts(void)
+{
+    // The wire-time wait and two retries time out, the third retry succeeds
+    TEST_ASSERT_EQUAL_UINT32(4, waits_for_one_frame(3));
+    TEST_ASSERT_TRUE(strips_show_frame());
+}
+
+void test_wait_retry_posts_event_when_exhausted(void)
+{
+    // The wire-time wait and all five retries time out
+    TEST_ASSERT_EQUAL_UINT32(6, waits_for_one_frame(6));
+    char heartbeat[2048];
+    bool reported = false;
+    for (unsigned int attempt = 0; !reported && attempt < 2000 / FRAME_INTERVAL_MS; ++attempt) {
+        ssize_t length = recv(heartbeat_listener, heartbeat, sizeof(heartbeat) - 1, 0);
+        if (length <= 0 || heartbeat[0] != '{') {
+            continue;
+        }
+        heartbeat[length] = '\0';
+        reported = strstr(heartbeat, ": rmt_tx_wait_all_done timeout run 0\"") != NULL;
+    }
+    TEST_ASSERT_TRUE_MESSAGE(reported, "no heartbeat carried the RMT timeout event");
+}
+
+void test_heartbeat_reports_applied_frames(void)
+{
+    char heartbeat[2048];
+    bool reported = false;
+    // Keep frames flowing so the next heartbeat interval applies some
+    for (unsigned int attempt = 0; !reported && attempt < 3000 / FRAME_INTERVAL_MS; ++attempt) {
+        send_frame(next_frame_id++);
+        ssize_t length = recv(heartbeat_listener, heartbeat, sizeof(heartbeat) - 1, 0);
+        if (length <= 0 || heartbeat[0] != '{') {
+            continue;
+        }
+        heartbeat[length] = '\0';
+        reported = strstr(heartbeat, "\"applied\":0,") == NULL &&
+                   strstr(heartbeat, "\"applied\":") != NULL;
+    }
+    TEST_ASSERT_TRUE_MESSAGE(reported, "no heartbeat with applied frames");
+}
+
+int main(void)
+{
+    sender = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    heartbeat_listener = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    struct sockaddr_in status_address = {
+        .sin_family = AF_INET,
+        .sin_port = htons(STATUS_PORT),
+        .sin_addr.s_addr = htonl(INADDR_LOOPBACK),
+    };
+    bind(heartbeat_listener, (struct sockaddr *)&status_address, sizeof(status_address));
+    struct timeval receive_timeout = {.tv_usec = FRAME_INTERVAL_MS * 1000};
+    setsockopt(heartbeat_listener, SOL_SOCKET, SO_RCVTIMEO, &receive_timeout,
+               sizeof(receive_timeout));
+
+    srand(1234);
+    for (unsigned int run = 0; run < RUN_COUNT; ++run) {
+        run_packets[run] = malloc(4 + LED_COUNT[run] * 3);
+        for (unsigned int byte = 0; byte < LED_COUNT[run] * 3; ++byte) {
+            run_packets[run][4 + byte] = (uint8_t)rand();
+        }
+    }
+    for (unsigned int run = 0; run < RUN_COUNT; ++run) {
+        virtual_strip_init(&strips[run], LED_COUNT[run], RMT_RESOLUTION_HZ);
+    }
+    host_rmt_set_observer(feed_strip, NULL);
+
+    app_main();
+
+    UNITY_BEGIN();
+    RUN_TEST(test_startup_latches_black_first);
+    RUN_TEST(test_frames_reach_every_strip);
+    RUN_TEST(test_back_to_back_frames_keep_latch_gap);
+    RUN_TEST(test_wait_retry_recovers_from_timeouts);
+    RUN_TEST(test_wait_retry_posts_event_when_exhausted);
+    RUN_TEST(test_heartbeat_reports_applied_frames);
+    return UNITY_END();
+}
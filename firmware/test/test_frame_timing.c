@@ -0,0 +1,92 @@
+#include "unity.h"
+#include "config_autogen.h"
+#include "frame_timing.h"
+#include <stdio.h>
+
+typedef struct {
+    const char *name;
+    unsigned int run_count;
+    unsigned int led_counts[4];
+} Layout;
+
+// LED counts of the checked-in layouts under config/.
+static const Layout LAYOUTS[] = {
+    {"left.json", 3, {362, 300, 379}},
+    {"right.json", 1, {20}},
+    {"four_run.json", 4, {400, 400, 400, 400}},
+};
+
+static double fps_for_period(uint32_t period_us)
+{
+    return 1000000.0 / (double)period_us;
+}
+
+void setUp(void) {}
+void tearDown(void) {}
+
+void test_run_wire_time_matches_spec(void)
+{
+    // Spec §5: a 400-LED run takes ~12.3 ms, a 500-LED run ~15.3 ms.
+    TEST_ASSERT_EQUAL_UINT32(12280, frame_timing_run_wire_us(400));
+    TEST_ASSERT_EQUAL_UINT32(15280, frame_timing_run_wire_us(500));
+    TEST_ASSERT_EQUAL_UINT32(WS2815_RESET_US, frame_timing_run_wire_us(0));
+}
+
+void test_parallel_is_bounded_by_longest_run(void)
+{
+    const unsigned int led_counts[] = {100, 379, 20};
+    TEST_ASSERT_EQUAL_UINT32(frame_timing_run_wire_us(379),
+                             frame_timing_transmit_us(led_counts, 3, FRAME_OUTPUT_PARALLEL));
+    TEST_ASSERT_EQUAL_UINT32(frame_timing_run_wire_us(100) + frame_timing_run_wire_us(379) +
+                                 frame_timing_run_wire_us(20),
+                             frame_timing_transmit_us(led_counts, 3, FRAME_OUTPUT_SERIAL));
+}
+
+void test_report_layout_frame_periods(void)
+{
+    for (size_t index = 0; index < sizeof(LAYOUTS) / sizeof(LAYOUTS[0]); ++index) {
+        const Layout *layout = &LAYOUTS[index];
+        uint32_t serial_us = frame_timing_transmit_us(layout->led_counts, layout->run_count,
+                                                      FRAME_OUTPUT_SERIAL);
+        uint32_t parallel_us = frame_timing_transmit_us(layout->led_counts, layout->run_count,
+                                                        FRAME_OUTPUT_PARALLEL);
+        printf("%-14s serial %6.2f ms (%5.1f FPS)  parallel %6.2f ms (%5.1f FPS)\n",
+               layout->name, serial_us / 1000.0, fps_for_period(serial_us),
+               parallel_us / 1000.0, fps_for_period(parallel_us));
+        TEST_ASSERT_TRUE(parallel_us <= serial_us);
+        // Spec §5: parallel output must sustain at least 30 FPS.
+        TEST_ASSERT_TRUE(fps_for_period(parallel_us) >= 30.0);
+    }
+}
+
+void test_four_run_serial_misses_target(void)
+{
+    const Layout *four_run = &LAYOUTS[2];
+    uint32_t serial_us = frame_timing_transmit_us(four_run->led_counts, four_run->run_count,
+                                                  FRAME_OUTPUT_SERIAL);
+    TEST_ASSERT_TRUE(fps_for_period(serial_us) < 30.0);
+}
+
+// gen_config.py mirrors this model; the generated budget must agree with it
+void test_generated_budget_matches_model(void)
+{
+    for (unsigned int run = 0; run < RUN_COUNT; ++run) {
+        TEST_ASSERT_EQUAL_UINT32(frame_timing_run_wire_us(LED_COUNT[run]), RUN_WIRE_US[run]);
+    }
+    TEST_ASSERT_EQUAL_UINT32(frame_timing_transmit_us(LED_COUNT, RUN_COUNT, FRAME_OUTPUT_SERIAL),
+                             FRAME_PERIOD_SERIAL_US);
+    TEST_ASSERT_EQUAL_UINT32(frame_timing_transmit_us(LED_COUNT, RUN_COUNT, FRAME_OUTPUT_PARALLEL),
+                             FRAME_PERIOD_PARALLEL_US);
+    TEST_ASSERT_TRUE(FRAME_PERIOD_PARALLEL_US <= 1000000 / TARGET_FPS);
+}
+
+int main(void)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_run_wire_time_matches_spec);
+    RUN_TEST(test_parallel_is_bounded_by_longest_run);
+    RUN_TEST(test_report_layout_frame_periods);
+    RUN_TEST(test_four_run_serial_misses_target);
+    RUN_TEST(test_generated_budget_matches_model);
+    return UNITY_END();
+}
@@ -0,0 +1,155 @@
+// Latency histograms driven by an injected clock.
+#include "unity.h"
+#include "latency_stats.h"
+#include "rx_task.h"
+#include "config_autogen.h"
+#include <stdlib.h>
+#include <string.h>
+
+static uint64_t fake_now_us;
+
+static uint64_t fake_clock(void)
+{
+    return fake_now_us;
+}
+
+static void send_run(unsigned int run, uint32_t frame_id)
+{
+    size_t length = 4 + LED_COUNT[run] * 3;
+    uint8_t *packet = (uint8_t *)calloc(length, 1);
+    packet[2] = (uint8_t)(frame_id >> 8);
+    packet[3] = (uint8_t)frame_id;
+    rx_task_process_packet(run, packet, length);
+    free(packet);
+}
+
+// setUp clears the histograms, so a snapshot covers just this test
+static void summarize(latency_stage_t stage, latency_summary_t *summary)
+{
+    latency_snapshot_t snapshot;
+    latency_stats_snapshot(LATENCY_READER_HEARTBEAT, &snapshot);
+    latency_stats_summarize(&snapshot, stage, summary);
+}
+
+void setUp(void)
+{
+    fake_now_us = 1000000;
+    latency_stats_set_clock(fake_clock);
+    latency_stats_reset();
+    rx_task_start();
+}
+
+void tearDown(void)
+{
+    latency_stats_set_clock(NULL);
+}
+
+void test_empty_stage_reports_zero(void)
+{
+    latency_summary_t summary;
+    summarize(LATENCY_STAGE_ENCODE, &summary);
+    TEST_ASSERT_EQUAL_UINT32(0, summary.count);
+    TEST_ASSERT_EQUAL_UINT32(0, summary.p50_us);
+    TEST_ASSERT_EQUAL_UINT32(0, summary.p99_us);
+    TEST_ASSERT_EQUAL_UINT32(0, summary.max_us);
+}
+
+void test_percentiles_use_bucket_upper_bounds(void)
+{
+    // 98 spans of 100 us land in [64, 127]; two outliers of 3000 us
+    for (int sample = 0; sample < 98; ++sample) {
+        latency_stats_record(LATENCY_STAGE_TRANSMIT, 0, 100);
+    }
+    latency_stats_record(LATENCY_STAGE_TRANSMIT, 0, 3000);
+    latency_stats_record(LATENCY_STAGE_TRANSMIT, 0, 3000);
+    latency_summary_t summary;
+    summarize(LATENCY_STAGE_TRANSMIT, &summary);
+    TEST_ASSERT_EQUAL_UINT32(100, summary.count);
+    TEST_ASSERT_EQUAL_UINT32(127, summary.p50_us);
+    TEST_ASSERT_EQUAL_UINT32(3000, summary.p99_us);
+    TEST_ASSERT_EQUAL_UINT32(3000, summary.max_us);
+}
+
+void test_backwards_and_huge_spans_are_clamped(void)
+{
+    latency_stats_record(LATENCY_STAGE_HANDOFF, 500, 100);
+    latency_stats_record(LATENCY_STAGE_HANDOFF, 0, 1ull << 40);
+    latency_summary_t summary;
+    summarize(LATENCY_STAGE_HANDOFF, &summary);
+    TEST_ASSERT_EQUAL_UINT32(2, summary.count);
+    TEST_ASSERT_EQUAL_UINT32(0, summary.p50_us);
+    TEST_ASSERT_EQUAL_UINT32(UINT32_MAX, summary.max_us);
+}
+
+void test_assembly_spans_first_datagram_to_completion(void)
+{
+    for (unsigned int run = 0; run < RUN_COUNT; ++run) {
+        send_run(run, 1);
+        fake_now_us += 250;
+    }
+    // Completion is stamped when the last run arrives
+    uint64_t last_arrival_us = fake_now_us - 250;
+    rx_frame_t *frame = rx_task_acquire_frame();
+    TEST_ASSERT_NOT_NULL(frame);
+    TEST_ASSERT_EQUAL_UINT64(1000000, frame->received_us);
+    TEST_ASSERT_EQUAL_UINT64(last_arrival_us, frame->completed_us);
+
+    latency_summary_t summary;
+    summarize(LATENCY_STAGE_ASSEMBLE, &summary);
+    TEST_ASSERT_EQUAL_UINT32(1, summary.count);
+    TEST_ASSERT_EQUAL_UINT32((RUN_COUNT - 1) * 250, summary.max_us);
+}
+
+void test_delta_covers_only_the_interval(void)
+{
+    latency_stats_record(LATENCY_STAGE_ENCODE, 0, 40);
+    latency_snapshot_t previous;
+    latency_stats_snapshot(LATENCY_READER_HEARTBEAT, &previous);
+    latency_stats_record(LATENCY_STAGE_ENCODE, 0, 20);
+    latency_snapshot_t current;
+    latency_snapshot_t delta;
+    latency_stats_snapshot(LATENCY_READER_HEARTBEAT, &current);
+    latency_stats_delta(&current, &previous, &delta);
+    latency_summary_t summary;
+    latency_stats_summarize(&delta, LATENCY_STAGE_ENCODE, &summary);
+    TEST_ASSERT_EQUAL_UINT32(1, summary.count);
+    TEST_ASSERT_EQUAL_UINT32(20, summary.max_us);
+}
+
+void test_readers_keep_independent_maxima(void)
+{
+    latency_stats_record(LATENCY_STAGE_TOTAL, 0, 9000);
+    latency_snapshot_t heartbeat;
+    latency_stats_snapshot(LATENCY_READER_HEARTBEAT, &heartbeat);
+    TEST_ASSERT_EQUAL_UINT32(9000, heartbeat.max_us[LATENCY_STAGE_TOTAL]);
+    latency_stats_snapshot(LATENCY_READER_HEARTBEAT, &heartbeat);
+    TEST_ASSERT_EQUAL_UINT32(0, heartbeat.max_us[LATENCY_STAGE_TOTAL]);
+
+    // The heartbeat reading its maximum leaves the telemetry one untouched
+    latency_snapshot_t telemetry;
+    latency_stats_snapshot(LATENCY_READER_TELEMETRY, &telemetry);
+    TEST_ASSERT_EQUAL_UINT32(9000, telemetry.max_us[LATENCY_STAGE_TOTAL]);
+    TEST_ASSERT_EQUAL_UINT32(1, telemetry.buckets[LATENCY_STAGE_TOTAL][14]);
+}
+
+void test_stage_names_match_heartbeat_keys(void)
+{
+    TEST_ASSERT_EQUAL_STRING("assemble", latency_stats_stage_name(LATENCY_STAGE_ASSEMBLE));
+    TEST_ASSERT_EQUAL_STRING("handoff", latency_stats_stage_name(LATENCY_STAGE_HANDOFF));
+    TEST_ASSERT_EQUAL_STRING("encode", latency_stats_stage_name(LATENCY_STAGE_ENCODE));
+    TEST_ASSERT_EQUAL_STRING("transmit", latency_stats_stage_name(LATENCY_STAGE_TRANSMIT));
+    TEST_ASSERT_EQUAL_STRING("total", latency_stats_stage_name(LATENCY_STAGE_TOTAL));
+}
+
+int main(void)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_empty_stage_reports_zero);
+    RUN_TEST(test_percentiles_use_bucket_upper_bounds);
+    RUN_TEST(test_backwards_and_huge_spans_are_clamped);
+    RUN_TEST(test_assembly_spans_first_datagram_to_completion);
+    RUN_TEST(test_delta_covers_only_the_interval);
+    RUN_TEST(test_readers_keep_independent_maxima);
+    RUN_TEST(test_stage_names_match_heartbeat_keys);
+    return UNITY_END();
+}
@@ -0,0 +1,238 @@
+// Layout parsing, impairment planning and packet encoding of tools/loadgen.
+#include "unity.h"
+#include "loadgen_layout.h"
+#include "loadgen_packet.h"
+#include "loadgen_plan.h"
+
+#include <stdio.h>
+#include <string.h>
+
+static loadgen_layout_t layout;
+static char error[128];
+
+void setUp(void) {}
+void tearDown(void) {}
+
+static void load(const char *name)
+{
+    char path[512];
+    snprintf(path, sizeof(path), "%s/%s", LOADGEN_CONFIG_DIR, name);
+    TEST_ASSERT_TRUE_MESSAGE(loadgen_layout_load(path, &layout, error, sizeof(error)), error);
+}
+
+void test_parses_sample_layouts(void)
+{
+    load("left.json");
+    TEST_ASSERT_EQUAL_UINT(49600, layout.port_base);
+    TEST_ASSERT_EQUAL_UINT(3, layout.run_count);
+    const unsigned int LEFT[] = {362, 300, 379};
+    TEST_ASSERT_EQUAL_UINT32_ARRAY(LEFT, layout.led_count, 3);
+    const unsigned int LEFT_RUN0_SECTIONS[] = {124, 128, 110};
+    TEST_ASSERT_EQUAL_UINT(3, layout.section_count[0]);
+    TEST_ASSERT_EQUAL_UINT32_ARRAY(LEFT_RUN0_SECTIONS, layout.section_leds[0], 3);
+    const uint8_t IP[] = {10, 10, 0, 2};
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(IP, layout.static_ip, 4);
+
+    load("four_run.json");
+    TEST_ASSERT_EQUAL_UINT(49620, layout.port_base);
+    TEST_ASSERT_EQUAL_UINT(4, layout.run_count);
+    const unsigned int FOUR[] = {400, 400, 400, 400};
+    TEST_ASSERT_EQUAL_UINT32_ARRAY(FOUR, layout.led_count, 4);
+
+    load("right.json");
+    TEST_ASSERT_TRUE(layout.run_count > 0);
+}
+
+void test_runs_are_placed_by_run_index(void)
+{
+    const char *json = "{\"port_base\": 5000, \"static_ip\": [127, 0, 0, 1], \"runs\": ["
+                       "{\"run_index\": 1, \"led_count\": 20,"
+                       " \"sections\": [{\"led_count\": 9, \"x0\": 1.5},"
+                       " {\"id\": \"b\", \"led_count\": 11}]},"
+                       "{\"sections\": [], \"led_count\": 10, \"run_index\": 0}],"
+                       "\"sampling\": {\"space\": \"normalized\", \"flip\": false}}";
+    TEST_ASSERT_TRUE_MESSAGE(loadgen_layout_parse(json, &layout, error, sizeof(error)), error);
+    TEST_ASSERT_EQUAL_UINT(2, layout.run_count);
+    TEST_ASSERT_EQUAL_UINT(10, layout.led_count[0]);
+    TEST_ASSERT_EQUAL_UINT(20, layout.led_count[1]);
+    // A run without sections is one
+    TEST_ASSERT_EQUAL_UINT(1, layout.section_count[0]);
+    TEST_ASSERT_EQUAL_UINT(10, layout.section_leds[0][0]);
+    TEST_ASSERT_EQUAL_UINT(2, layout.section_count[1]);
+    TEST_ASSERT_EQUAL_UINT(9, layout.section_leds[1][0]);
+    TEST_ASSERT_EQUAL_UINT(11, layout.section_leds[1][1]);
+}
+
+void test_rejects_bad_layouts(void)
+{
+    const char *BAD[] = {
+        "",
+        "{\"port_base\": 5000, \"runs\": [{\"run_index\": 1, \"led_count\": 10}]}",
+        "{\"port_base\": 5000, \"runs\": [{\"run_index\": 0, \"led_count\": 1025}]}",
+        "{\"port_base\": 5000, \"runs\": [{\"run_index\": 0}]}",
+        "{\"port_base\": 5000, \"runs\": [{\"run_index\": 0, \"led_count\": 1},"
+        " {\"run_index\": 0, \"led_count\": 1}]}",
+        "{\"runs\": [{\"run_index\": 0, \"led_count\": 10}]}",
+        "{\"port_base\": 5000, \"runs\": [{\"run_index\": 0, \"led_count\": 10}]",
+        "{\"port_base\": 5000, \"runs\": [{\"run_index\": 0, \"led_count\": 10,"
+        " \"sections\": [{\"led_count\": 9}]}]}",
+        "{\"port_base\": 5000, \"runs\": [{\"run_index\": 0, \"led_count\": 10,"
+        " \"sections\": [{\"led_count\": 10}, {\"id\": \"empty\"}]}]}",
+    };
+    for (size_t index = 0; index < sizeof(BAD) / sizeof(BAD[0]); ++index) {
+        TEST_ASSERT_FALSE_MESSAGE(loadgen_layout_parse(BAD[index], &layout, error, sizeof(error)),
+                                  BAD[index]);
+        TEST_ASSERT_TRUE(strlen(error) > 0);
+    }
+}
+
+void test_clean_plan_sends_every_run_in_order(void)
+{
+    loadgen_impairments_t impairments = {.parity = true};
+    loadgen_plan_t plan;
+    loadgen_plan_init(&plan, 3, &impairments, 1);
+    loadgen_datagram_t out[LOADGEN_MAX_FRAME_DATAGRAMS];
+    // Frame ids wrap like the sender's
+    for (uint32_t frame_id = UINT32_MAX - 2; frame_id != 3; ++frame_id) {
+        TEST_ASSERT_EQUAL_size_t(4, loadgen_plan_frame(&plan, frame_id, out));
+        for (unsigned int run = 0; run < 4; ++run) {
+            TEST_ASSERT_EQUAL_UINT8(run, out[run].run);
+            TEST_ASSERT_EQUAL_UINT32(frame_id, out[run].frame_id);
+            TEST_ASSERT_EQUAL_UINT32(0, out[run].offset_us);
+        }
+    }
+    TEST_ASSERT_EQUAL_UINT32(0, plan.stats.lost + plan.stats.duplicated + plan.stats.reordered);
+}
+
+void test_impairment_rates_follow_probabilities(void)
+{
+    loadgen_impairments_t impairments = {.loss = 0.1, .duplicate = 0.05, .skew_us = 300};
+    loadgen_plan_t plan;
+    loadgen_plan_init(&plan, 4, &impairments, 42);
+    loadgen_datagram_t out[LOADGEN_MAX_FRAME_DATAGRAMS];
+    uint32_t sent = 0;
+    for (uint32_t frame_id = 0; frame_id < 10000; ++frame_id) {
+        size_t count = loadgen_plan_frame(&plan, frame_id, out);
+        for (size_t index = 0; index < count; ++index) {
+            TEST_ASSERT_TRUE(out[index].offset_us <= 300);
+            if (index > 0) {
+                TEST_ASSERT_TRUE(out[index - 1].offset_us <= out[index].offset_us);
+            }
+        }
+        sent += (uint32_t)count;
+    }
+    TEST_ASSERT_EQUAL_UINT32(40000, plan.stats.planned);
+    TEST_ASSERT_UINT32_WITHIN(400, 4000, plan.stats.lost);
+    TEST_ASSERT_UINT32_WITHIN(300, 1800, plan.stats.duplicated);
+    TEST_ASSERT_EQUAL_UINT32(plan.stats.planned - plan.stats.lost + plan.stats.duplicated, sent);
+}
+
+void test_reordered_datagrams_trail_the_next_frame(void)
+{
+    loadgen_impairments_t impairments = {.reorder = 1.0};
+    loadgen_plan_t plan;
+    loadgen_plan_init(&plan, 2, &impairments, 7);
+    loadgen_datagram_t out[LOADGEN_MAX_FRAME_DATAGRAMS];
+    TEST_ASSERT_EQUAL_size_t(0, loadgen_plan_frame(&plan, 10, out));
+    TEST_ASSERT_EQUAL_size_t(2, loadgen_plan_frame(&plan, 11, out));
+    TEST_ASSERT_EQUAL_UINT32(10, out[0].frame_id);
+    TEST_ASSERT_EQUAL_UINT32(10, out[1].frame_id);
+
+    plan.impairments.reorder = 0.5;
+    uint32_t late = 0;
+    for (uint32_t frame_id = 12; frame_id < 2012; ++frame_id) {
+        size_t count = loadgen_plan_frame(&plan, frame_id, out);
+        bool seen_older = false;
+        for (size_t index = 0; index < count; ++index) {
+            if (out[index].frame_id == frame_id - 1) {
+                seen_older = true;
+                ++late;
+            } else {
+                TEST_ASSERT_EQUAL_UINT32(frame_id, out[index].frame_id);
+                TEST_ASSERT_FALSE(seen_older);
+            }
+        }
+    }
+    TEST_ASSERT_UINT32_WITHIN(200, 2000, late);
+}
+
+void test_runs_split_into_fragments_only_when_needed(void)
+{
+    TEST_ASSERT_EQUAL_UINT(1, loadgen_fragment_count(400, 0));
+    TEST_ASSERT_EQUAL_UINT(1, loadgen_fragment_count(489, 0));
+    TEST_ASSERT_EQUAL_UINT(2, loadgen_fragment_count(490, 0));
+    TEST_ASSERT_EQUAL_UINT(3, loadgen_fragment_count(1024, 0));
+    TEST_ASSERT_EQUAL_UINT(4, loadgen_fragment_count(400, 100));
+    TEST_ASSERT_EQUAL_UINT(1, loadgen_fragment_count(400, 400));
+}
+
+void test_fragments_cover_the_run_once(void)
+{
+    static uint8_t rgb[1024 * 3];
+    static uint8_t out[LOADGEN_UDP_MAX_PAYLOAD];
+    static uint8_t rebuilt[1024 * 3];
+    for (size_t index = 0; index < sizeof(rgb); ++index) {
+        rgb[index] = (uint8_t)(index * 7);
+    }
+    unsigned int count = loadgen_fragment_count(1024, 0);
+    unsigned int next_led = 0;
+    for (unsigned int index = 0; index < count; ++index) {
+        size_t length = loadgen_encode_fragment(0x01020304u, 2, rgb, 1024, 0, index, out);
+        TEST_ASSERT_TRUE(length <= LOADGEN_UDP_MAX_PAYLOAD);
+        const uint8_t HEADER[] = {1, 2, 3, 4, 'W', 'X', 1, 1, 2, 0, (uint8_t)index,
+                                  (uint8_t)count};
+        TEST_ASSERT_EQUAL_UINT8_ARRAY(HEADER, out, sizeof(HEADER));
+        unsigned int first_led = (unsigned int)(out[12] << 8 | out[13]);
+        size_t payload_bytes = (size_t)(out[14] << 8 | out[15]);
+        TEST_ASSERT_EQUAL_UINT(next_led, first_led);
+        TEST_ASSERT_EQUAL_size_t(length, 16 + payload_bytes);
+        memcpy(rebuilt + first_led * 3, out + 16, payload_bytes);
+        next_led += (unsigned int)(payload_bytes / 3);
+    }
+    TEST_ASSERT_EQUAL_UINT(1024, next_led);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(rgb, rebuilt, sizeof(rgb));
+}
+
+void test_short_runs_batch_into_one_datagram(void)
+{
+    const unsigned int SHORT[] = {60, 60, 60, 60};
+    const unsigned int MIXED[] = {240, 240, 240, 600};
+    TEST_ASSERT_EQUAL_UINT(4, loadgen_batch_runs(SHORT, 4, 0));
+    TEST_ASSERT_EQUAL_UINT(2, loadgen_batch_runs(SHORT, 4, 2));
+    TEST_ASSERT_EQUAL_UINT(2, loadgen_batch_runs(MIXED, 4, 0));
+    TEST_ASSERT_EQUAL_UINT(1, loadgen_batch_runs(MIXED, 4, 2));
+    TEST_ASSERT_EQUAL_UINT(0, loadgen_batch_runs(MIXED, 4, 3));
+
+    static uint8_t rgb[4][60 * 3];
+    const uint8_t *runs[4];
+    for (unsigned int run = 0; run < 4; ++run) {
+        memset(rgb[run], (int)(run + 1), sizeof(rgb[run]));
+        runs[run] = rgb[run];
+    }
+    static uint8_t out[LOADGEN_UDP_MAX_PAYLOAD];
+    size_t length = loadgen_encode_batch(7, SHORT, runs, 1, 3, out);
+    TEST_ASSERT_EQUAL_size_t(8 + 3 * (8 + 180), length);
+    const uint8_t HEADER[] = {0, 0, 0, 7, 'W', 'X', 1, 3};
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(HEADER, out, sizeof(HEADER));
+    for (unsigned int block = 0; block < 3; ++block) {
+        const uint8_t *at = out + 8 + block * (8 + 180);
+        const uint8_t BLOCK[] = {(uint8_t)(block + 1), 0, 0, 1, 0, 0, 0, 180};
+        TEST_ASSERT_EQUAL_UINT8_ARRAY(BLOCK, at, sizeof(BLOCK));
+        TEST_ASSERT_EQUAL_UINT8_ARRAY(rgb[block + 1], at + 8, 180);
+    }
+}
+
+int main(void)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_parses_sample_layouts);
+    RUN_TEST(test_runs_are_placed_by_run_index);
+    RUN_TEST(test_rejects_bad_layouts);
+    RUN_TEST(test_clean_plan_sends_every_run_in_order);
+    RUN_TEST(test_impairment_rates_follow_probabilities);
+    RUN_TEST(test_reordered_datagrams_trail_the_next_frame);
+    RUN_TEST(test_runs_split_into_fragments_only_when_needed);
+    RUN_TEST(test_fragments_cover_the_run_once);
+    RUN_TEST(test_short_runs_batch_into_one_datagram);
+    return UNITY_END();
+}
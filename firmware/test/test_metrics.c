@@ -0,0 +1,87 @@
+// Lock-free metrics registry under concurrent writers.
+#include "unity.h"
+#include "metrics.h"
+#include <pthread.h>
+#include <sched.h>
+
+#define WRITER_COUNT 4
+#define INCREMENTS_PER_WRITER 200000
+
+void setUp(void) {}
+void tearDown(void) {}
+
+static void *hammer_counters(void *arg)
+{
+    (void)arg;
+    for (int count = 0; count < INCREMENTS_PER_WRITER; ++count) {
+        metrics_increment(METRIC_RX_FRAMES);
+        metrics_increment((metric_id_t)(METRIC_DROPS_LEN + count % 5));
+        if (count % 1024 == 0) {
+            sched_yield();
+        }
+    }
+    return NULL;
+}
+
+void test_concurrent_increments_are_not_lost(void)
+{
+    metrics_snapshot_t before;
+    metrics_snapshot(&before);
+
+    pthread_t writers[WRITER_COUNT];
+    for (int writer = 0; writer < WRITER_COUNT; ++writer) {
+        pthread_create(&writers[writer], NULL, hammer_counters, NULL);
+    }
+    // Snapshots taken mid-flight never go backwards
+    metrics_snapshot_t previous = before;
+    for (int sample = 0; sample < 1000; ++sample) {
+        metrics_snapshot_t current;
+        metrics_snapshot(&current);
+        metrics_snapshot_t delta;
+        metrics_delta(&current, &previous, &delta);
+        TEST_ASSERT_TRUE(delta.value[METRIC_RX_FRAMES] <= WRITER_COUNT * INCREMENTS_PER_WRITER);
+        previous = current;
+        sched_yield();
+    }
+    for (int writer = 0; writer < WRITER_COUNT; ++writer) {
+        pthread_join(writers[writer], NULL);
+    }
+
+    metrics_snapshot_t after;
+    metrics_snapshot(&after);
+    metrics_snapshot_t delta;
+    metrics_delta(&after, &before, &delta);
+    TEST_ASSERT_EQUAL_UINT32(WRITER_COUNT * INCREMENTS_PER_WRITER, delta.value[METRIC_RX_FRAMES]);
+    TEST_ASSERT_EQUAL_UINT32(WRITER_COUNT * INCREMENTS_PER_WRITER, metrics_total_drops(&delta));
+    TEST_ASSERT_EQUAL_UINT32(WRITER_COUNT * INCREMENTS_PER_WRITER / 5, delta.value[METRIC_DROPS_STALE]);
+}
+
+void test_delta_survives_wraparound(void)
+{
+    metrics_snapshot_t previous = {{0}};
+    metrics_snapshot_t current = {{0}};
+    previous.value[METRIC_APPLIED] = UINT32_MAX - 1;
+    current.value[METRIC_APPLIED] = 3;
+    metrics_snapshot_t delta;
+    metrics_delta(&current, &previous, &delta);
+    TEST_ASSERT_EQUAL_UINT32(5, delta.value[METRIC_APPLIED]);
+}
+
+void test_drop_reasons_have_heartbeat_names(void)
+{
+    TEST_ASSERT_EQUAL_STRING("len", metrics_name(METRIC_DROPS_LEN));
+    TEST_ASSERT_EQUAL_STRING("run", metrics_name(METRIC_DROPS_RUN));
+    TEST_ASSERT_EQUAL_STRING("stale", metrics_name(METRIC_DROPS_STALE));
+    TEST_ASSERT_EQUAL_STRING("window", metrics_name(METRIC_DROPS_WINDOW));
+    TEST_ASSERT_EQUAL_STRING("pool", metrics_name(METRIC_DROPS_POOL));
+    TEST_ASSERT_EQUAL_STRING("base", metrics_name(METRIC_DROPS_BASE));
+}
+
+int main(void)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_concurrent_increments_are_not_lost);
+    RUN_TEST(test_delta_survives_wraparound);
+    RUN_TEST(test_drop_reasons_have_heartbeat_names);
+    return UNITY_END();
+}
@@ -0,0 +1,214 @@
+// rx capture ring, its dump format, and replay through rx_task.
+#include "unity.h"
+#include "config_autogen.h"
+#include "latency_stats.h"
+#include "rx_capture.h"
+#include "rx_replay.h"
+#include "rx_task.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+static uint64_t fake_now_us;
+static uint8_t packet[4 + MAX_RUN_LED_COUNT * 3 + 1];
+
+static uint64_t fake_clock(void)
+{
+    return fake_now_us;
+}
+
+void setUp(void)
+{
+    fake_now_us = 1000;
+    latency_stats_set_clock(fake_clock);
+    rx_task_start();
+}
+
+void tearDown(void)
+{
+    latency_stats_set_clock(NULL);
+}
+
+static size_t run_length(unsigned int run)
+{
+    return 4 + LED_COUNT[run] * 3;
+}
+
+static void send(unsigned int run, uint32_t frame_id, size_t length)
+{
+    packet[0] = (uint8_t)(frame_id >> 24);
+    packet[1] = (uint8_t)(frame_id >> 16);
+    packet[2] = (uint8_t)(frame_id >> 8);
+    packet[3] = (uint8_t)frame_id;
+    fake_now_us += 100;
+    if (run == RX_PARITY_SOCKET_INDEX) {
+        rx_task_process_parity(packet, length);
+    } else {
+        rx_task_process_packet(run, packet, length);
+    }
+}
+
+static void send_frame(uint32_t frame_id)
+{
+    for (unsigned int run = 0; run < RUN_COUNT; ++run) {
+        send(run, frame_id, run_length(run));
+    }
+}
+
+static rx_capture_entry_t entry_at(size_t index)
+{
+    rx_capture_entry_t entry;
+    TEST_ASSERT_EQUAL_size_t(1, rx_capture_read(index, &entry, 1));
+    return entry;
+}
+
+void test_records_every_outcome(void)
+{
+    if (RUN_COUNT < 2) {
+        TEST_IGNORE_MESSAGE("needs two runs to leave frame 11 incomplete");
+    }
+    send_frame(10);
+    send(0, 11, run_length(0) - 1);
+    send(0, 9, run_length(0));
+    send(0, 10 + RX_SLOT_COUNT + 1, run_length(0));
+    send(0, 11, run_length(0));
+    send(RX_PARITY_SOCKET_INDEX, 5, rx_task_parity_length());
+
+    TEST_ASSERT_EQUAL_size_t(RUN_COUNT + 5, rx_capture_count());
+    for (unsigned int run = 0; run < RUN_COUNT; ++run) {
+        rx_capture_entry_t entry = entry_at(run);
+        TEST_ASSERT_EQUAL_UINT8(RX_CAPTURE_ACCEPTED, entry.outcome);
+        TEST_ASSERT_EQUAL_UINT8(run, entry.run);
+        TEST_ASSERT_EQUAL_UINT32(10, entry.frame_id);
+        TEST_ASSERT_EQUAL_UINT16(run_length(run), entry.length);
+        TEST_ASSERT_EQUAL_UINT64(1100 + 100 * run, entry.arrival_us);
+    }
+    const uint8_t EXPECTED[] = {
+        RX_CAPTURE_DROP_LEN, RX_CAPTURE_DROP_STALE, RX_CAPTURE_ACCEPTED,
+        RX_CAPTURE_DROP_WINDOW, RX_CAPTURE_DROP_STALE,
+    };
+    for (size_t index = 0; index < sizeof(EXPECTED); ++index) {
+        TEST_ASSERT_EQUAL_UINT8(EXPECTED[index], entry_at(RUN_COUNT + index).outcome);
+    }
+    TEST_ASSERT_EQUAL_UINT8(RX_PARITY_SOCKET_INDEX, entry_at(RUN_COUNT + 4).run);
+}
+
+void test_ring_keeps_the_newest_entries(void)
+{
+    for (uint32_t frame_id = 1; frame_id <= RX_CAPTURE_ENTRIES + 5; ++frame_id) {
+        send(0, frame_id, run_length(0));
+    }
+    TEST_ASSERT_EQUAL_size_t(RX_CAPTURE_ENTRIES, rx_capture_count());
+    TEST_ASSERT_EQUAL_UINT32(6, entry_at(0).frame_id);
+    TEST_ASSERT_EQUAL_UINT32(RX_CAPTURE_ENTRIES + 5, entry_at(RX_CAPTURE_ENTRIES - 1).frame_id);
+    rx_capture_header_t header;
+    rx_capture_header(&header);
+    TEST_ASSERT_EQUAL_UINT32(5, header.overwritten);
+
+    rx_capture_set_paused(true);
+    send(0, 1000, run_length(0));
+    rx_capture_set_paused(false);
+    TEST_ASSERT_EQUAL_UINT32(RX_CAPTURE_ENTRIES + 5, entry_at(RX_CAPTURE_ENTRIES - 1).frame_id);
+}
+
+void test_dump_chunks_reassemble_into_the_ring(void)
+{
+    for (uint32_t frame_id = 1; frame_id <= 3; ++frame_id) {
+        send_frame(frame_id);
+    }
+    rx_capture_set_paused(true);
+    unsigned int chunk_count = rx_capture_chunk_count();
+    uint8_t *stream = malloc(chunk_count * RX_CAPTURE_CHUNK_BYTES);
+    size_t stream_length = 0;
+    uint8_t datagram[RX_CAPTURE_DUMP_DATAGRAM_BYTES];
+    for (unsigned int chunk = 0; chunk < chunk_count; ++chunk) {
+        size_t length = rx_capture_encode_chunk(chunk, datagram);
+        TEST_ASSERT_EQUAL_MEMORY("BD", datagram, 2);
+        TEST_ASSERT_EQUAL_UINT8(chunk, datagram[4]);
+        TEST_ASSERT_EQUAL_UINT8(chunk_count, datagram[6]);
+        memcpy(stream + stream_length, datagram + RX_CAPTURE_CHUNK_HEADER_BYTES,
+               length - RX_CAPTURE_CHUNK_HEADER_BYTES);
+        stream_length += length - RX_CAPTURE_CHUNK_HEADER_BYTES;
+    }
+    rx_capture_set_paused(false);
+
+    rx_capture_header_t header;
+    TEST_ASSERT_TRUE(rx_capture_decode_header(stream, stream_length, &header));
+    TEST_ASSERT_EQUAL_UINT8(RUN_COUNT, header.run_count);
+    TEST_ASSERT_EQUAL_UINT16(PORT_BASE, header.port_base);
+    TEST_ASSERT_TRUE(rx_replay_layout_matches(&header));
+    TEST_ASSERT_EQUAL_size_t(RX_CAPTURE_HEADER_BYTES + header.entry_count * RX_CAPTURE_ENTRY_BYTES,
+                             stream_length);
+    for (size_t index = 0; index < header.entry_count; ++index) {
+        rx_capture_entry_t decoded;
+        rx_capture_decode_entry(stream + RX_CAPTURE_HEADER_BYTES + index * RX_CAPTURE_ENTRY_BYTES,
+                                &decoded);
+        rx_capture_entry_t original = entry_at(index);
+        TEST_ASSERT_EQUAL_MEMORY(&original, &decoded, sizeof(original));
+    }
+    stream[0] = 'X';
+    TEST_ASSERT_FALSE(rx_capture_decode_header(stream, stream_length, &header));
+    free(stream);
+}
+
+void test_replay_reproduces_every_decision(void)
+{
+    if (RUN_COUNT < 2) {
+        TEST_IGNORE_MESSAGE("needs two runs to leave frames 20 and 22 incomplete");
+    }
+    // Out of order, duplicated, stale and malformed traffic
+    send(0, 20, run_length(0));
+    send(0, 21, run_length(0));
+    send_frame(21);
+    send(0, 20, run_length(0));
+    send(0, 21, run_length(0));
+    send(0, 22, 3);
+    send(0, 22 + RX_SLOT_COUNT, run_length(0));
+#if RX_PARITY_ENABLED
+    // Without parity its socket index is the extended one, which replay skips
+    send(RX_PARITY_SOCKET_INDEX, 23, rx_task_parity_length());
+#endif
+    size_t count = rx_capture_count();
+    rx_capture_entry_t captured[RX_CAPTURE_ENTRIES];
+    TEST_ASSERT_EQUAL_size_t(count, rx_capture_read(0, captured, count));
+
+    rx_replay_options_t options = {.repeat = 3};
+    rx_replay_result_t result;
+    rx_replay_run(captured, count, &options, &result);
+    TEST_ASSERT_EQUAL_UINT64(3 * count, result.datagrams);
+    TEST_ASSERT_EQUAL_UINT64(0, result.mismatches);
+    TEST_ASSERT_EQUAL_UINT64(3 * 2, result.captured[RX_CAPTURE_DROP_STALE]);
+    TEST_ASSERT_EQUAL_UINT32(3, result.frames_completed);
+    TEST_ASSERT_EQUAL_MEMORY(result.captured, result.replayed, sizeof(result.captured));
+}
+
+void test_replay_skips_extended_datagrams(void)
+{
+    send_frame(30);
+    // Captured on the extended socket, whatever the block layout was
+    rx_task_process_extended(packet, 5);
+    rx_capture_entry_t extended = entry_at(rx_capture_count() - 1);
+    TEST_ASSERT_EQUAL_UINT8(RX_EXTENDED_SOCKET_INDEX, extended.run);
+    TEST_ASSERT_EQUAL_UINT8(RX_CAPTURE_DROP_LEN, extended.outcome);
+
+    size_t count = rx_capture_count();
+    rx_capture_entry_t captured[RX_CAPTURE_ENTRIES];
+    rx_capture_read(0, captured, count);
+    rx_replay_options_t options = {.repeat = 1};
+    rx_replay_result_t result;
+    rx_replay_run(captured, count, &options, &result);
+    TEST_ASSERT_EQUAL_UINT64(1, result.skipped);
+    TEST_ASSERT_EQUAL_UINT64(count - 1, result.datagrams);
+    TEST_ASSERT_EQUAL_UINT64(0, result.mismatches);
+}
+
+int main(void)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_records_every_outcome);
+    RUN_TEST(test_ring_keeps_the_newest_entries);
+    RUN_TEST(test_dump_chunks_reassemble_into_the_ring);
+    RUN_TEST(test_replay_reproduces_every_decision);
+    RUN_TEST(test_replay_skips_extended_datagrams);
+    return UNITY_END();
+}
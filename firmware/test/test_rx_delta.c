@@ -0,0 +1,376 @@
+// XOR+RLE delta blocks on the extended port: the load generator's encoder,
+// decoding against published and still-assembling frames, the keyframe
+// fallback when the base is gone, and stream validation.
+#include "unity.h"
+#include "rx_task.h"
+#include "config_autogen.h"
+#include "loadgen_packet.h"
+#include "metrics.h"
+#include <stdlib.h>
+#include <string.h>
+
+static uint8_t *run_rgb[RUN_COUNT];
+static uint8_t *base_rgb[RUN_COUNT];
+static uint8_t *run_packets[RUN_COUNT];
+static uint8_t datagram[LOADGEN_UDP_MAX_PAYLOAD + 1];
+
+// Reference decoder, written from the format description in rx_task.h
+static size_t reference_decode(const uint8_t *tokens, size_t token_bytes, const uint8_t *base,
+                               uint8_t *output)
+{
+    size_t written = 0;
+    size_t at = 0;
+    while (at < token_bytes) {
+        uint8_t token = tokens[at++];
+        size_t count = token < 0x80 ? token + 1u : token - 0x7fu;
+        for (size_t index = 0; index < count; ++index, ++written) {
+            output[written] = token < 0x80 ? base[written] : base[written] ^ tokens[at++];
+        }
+    }
+    return written;
+}
+
+static void fill_random(uint32_t seed)
+{
+    for (unsigned int run = 0; run < RUN_COUNT; ++run) {
+        for (size_t index = 0; index < LED_COUNT[run] * 3; ++index) {
+            seed = seed * 1103515245u + 12345u;
+            run_rgb[run][index] = (uint8_t)(seed >> 16);
+        }
+    }
+}
+
+// Keeps the current frame as the base and moves on by changing a few LEDs
+static void next_frame(unsigned int changed_leds)
+{
+    for (unsigned int run = 0; run < RUN_COUNT; ++run) {
+        memcpy(base_rgb[run], run_rgb[run], LED_COUNT[run] * 3);
+        for (unsigned int led = 0; led < changed_leds && led < LED_COUNT[run]; ++led) {
+            size_t at = (size_t)(led * 7 % LED_COUNT[run]) * 3;
+            run_rgb[run][at] ^= 0x5a;
+            run_rgb[run][at + 2] += 1;
+        }
+    }
+}
+
+static void send_keyframe_run(uint32_t frame_id, unsigned int run)
+{
+    loadgen_write_frame_id(run_packets[run], frame_id);
+    memcpy(run_packets[run] + 4, run_rgb[run], LED_COUNT[run] * 3);
+    rx_task_process_packet(run, run_packets[run], 4 + LED_COUNT[run] * 3);
+}
+
+static void send_keyframe(uint32_t frame_id)
+{
+    for (unsigned int run = 0; run < RUN_COUNT; ++run) {
+        send_keyframe_run(frame_id, run);
+    }
+}
+
+static size_t encode_delta(uint32_t frame_id, uint32_t base_id, unsigned int run,
+                           unsigned int max_leds, unsigned int index)
+{
+    size_t length = loadgen_encode_delta_fragment(frame_id, base_id, run, run_rgb[run],
+                                                  base_rgb[run], LED_COUNT[run], max_leds, index,
+                                                  datagram);
+    TEST_ASSERT_GREATER_THAN_UINT32(0, length);
+    return length;
+}
+
+// Sends every fragment of the run's delta, and returns how many there were
+static unsigned int send_delta_run(uint32_t frame_id, uint32_t base_id, unsigned int run)
+{
+    unsigned int count = loadgen_fragment_count(LED_COUNT[run], 0);
+    for (unsigned int index = 0; index < count; ++index) {
+        rx_task_process_extended(datagram, encode_delta(frame_id, base_id, run, 0, index));
+    }
+    return count;
+}
+
+static uint32_t metric_since(const metrics_snapshot_t *before, metric_id_t id)
+{
+    metrics_snapshot_t after;
+    metrics_snapshot_t delta;
+    metrics_snapshot(&after);
+    metrics_delta(&after, before, &delta);
+    return delta.value[id];
+}
+
+static void assert_frame_matches(uint32_t frame_id)
+{
+    rx_frame_t *frame = rx_task_acquire_frame();
+    TEST_ASSERT_NOT_NULL(frame);
+    TEST_ASSERT_EQUAL_UINT32(frame_id, frame->frame_id);
+    for (unsigned int run = 0; run < RUN_COUNT; ++run) {
+        TEST_ASSERT_EQUAL_UINT8_ARRAY(run_rgb[run], frame->run_buffers[run], LED_COUNT[run] * 3);
+    }
+}
+
+void setUp(void)
+{
+    rx_task_start();
+    for (unsigned int run = 0; run < RUN_COUNT; ++run) {
+        run_rgb[run] = (uint8_t *)malloc(LED_COUNT[run] * 3);
+        base_rgb[run] = (uint8_t *)malloc(LED_COUNT[run] * 3);
+        run_packets[run] = (uint8_t *)malloc(4 + LED_COUNT[run] * 3);
+    }
+    fill_random(0xD17Au);
+}
+
+void tearDown(void)
+{
+    for (unsigned int run = 0; run < RUN_COUNT; ++run) {
+        free(run_rgb[run]);
+        free(base_rgb[run]);
+        free(run_packets[run]);
+    }
+}
+
+void test_encoder_round_trips_through_reference_decoder(void)
+{
+    static uint8_t base[1024 * 3];
+    static uint8_t rgb[1024 * 3];
+    static uint8_t tokens[1024 * 4];
+    static uint8_t decoded[1024 * 3];
+    for (size_t index = 0; index < sizeof(base); ++index) {
+        base[index] = (uint8_t)(index * 13);
+    }
+    // Unchanged, fully changed, and alternating stretches past one token each
+    memcpy(rgb, base, sizeof(rgb));
+    for (size_t index = 300; index < 700; ++index) {
+        rgb[index] ^= 0xff;
+    }
+    for (size_t index = 1000; index < 1400; index += 2) {
+        rgb[index] ^= 0x01;
+    }
+    rgb[sizeof(rgb) - 1] ^= 0x80;
+    size_t length = loadgen_xor_rle(rgb, base, sizeof(rgb), tokens, sizeof(tokens));
+    TEST_ASSERT_GREATER_THAN_UINT32(0, length);
+    TEST_ASSERT_EQUAL_size_t(sizeof(rgb), reference_decode(tokens, length, base, decoded));
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(rgb, decoded, sizeof(rgb));
+
+    // An identical run is one copy token per 128 bytes
+    TEST_ASSERT_EQUAL_size_t(24, loadgen_xor_rle(base, base, sizeof(base), tokens, 64));
+    TEST_ASSERT_EQUAL_HEX8(0x7f, tokens[0]);
+    // A lone unchanged byte between changes stays inside the literal
+    const uint8_t BASE[] = {0, 0, 0, 0, 0};
+    const uint8_t SPARSE[] = {1, 0, 1, 0, 0};
+    TEST_ASSERT_EQUAL_size_t(5, loadgen_xor_rle(SPARSE, BASE, 5, tokens, sizeof(tokens)));
+    const uint8_t EXPECTED[] = {0x82, 1, 0, 1, 0x01};
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(EXPECTED, tokens, sizeof(EXPECTED));
+    // Capacity is respected rather than overrun
+    TEST_ASSERT_EQUAL_size_t(0, loadgen_xor_rle(SPARSE, BASE, 5, tokens, 4));
+}
+
+void test_delta_against_published_frame_decodes(void)
+{
+    send_keyframe(1);
+    assert_frame_matches(1);
+    next_frame(5);
+    metrics_snapshot_t before;
+    metrics_snapshot(&before);
+    unsigned int datagrams = 0;
+    for (unsigned int run = 0; run < RUN_COUNT; ++run) {
+        TEST_ASSERT_NULL(rx_task_acquire_frame());
+        unsigned int count = loadgen_fragment_count(LED_COUNT[run], 0);
+        datagrams += count;
+        for (unsigned int index = 0; index < count; ++index) {
+            size_t length = encode_delta(2, 1, run, 0, index);
+            // Sparse changes cost far less than the RGB block would
+            TEST_ASSERT_TRUE(length < LED_COUNT[run] * 3 / 2 || LED_COUNT[run] < 64);
+            TEST_ASSERT_EQUAL_HEX8(RX_ENCODING_XOR_RLE, datagram[9]);
+            rx_task_process_extended(datagram, length);
+        }
+    }
+    assert_frame_matches(2);
+    TEST_ASSERT_EQUAL_UINT32(datagrams, metric_since(&before, METRIC_RX_FRAMES));
+
+    // A chain of deltas keeps following the newest frame
+    for (uint32_t frame_id = 3; frame_id < 10; ++frame_id) {
+        next_frame(frame_id);
+        for (unsigned int run = 0; run < RUN_COUNT; ++run) {
+            send_delta_run(frame_id, frame_id - 1, run);
+        }
+        assert_frame_matches(frame_id);
+    }
+}
+
+void test_delta_against_assembling_frame_decodes(void)
+{
+    if (RUN_COUNT < 2) {
+        TEST_IGNORE_MESSAGE("needs a second run to hold the base frame open");
+    }
+    send_keyframe(1);
+    assert_frame_matches(1);
+    // Frame 2 stays open: every run but the last arrives
+    next_frame(3);
+    for (unsigned int run = 0; run + 1 < RUN_COUNT; ++run) {
+        send_keyframe_run(2, run);
+    }
+    TEST_ASSERT_NULL(rx_task_acquire_frame());
+    next_frame(4);
+    metrics_snapshot_t before;
+    metrics_snapshot(&before);
+    send_delta_run(3, 2, 0);
+    TEST_ASSERT_EQUAL_UINT32(0, metric_since(&before, METRIC_DROPS_BASE));
+    // The open frame's last run was never received, so it cannot be a base
+    unsigned int dropped = send_delta_run(3, 2, RUN_COUNT - 1);
+    TEST_ASSERT_EQUAL_UINT32(dropped, metric_since(&before, METRIC_DROPS_BASE));
+    for (unsigned int run = 1; run < RUN_COUNT; ++run) {
+        send_keyframe_run(3, run);
+    }
+    assert_frame_matches(3);
+}
+
+void test_missing_base_waits_for_keyframe(void)
+{
+    send_keyframe(1);
+    assert_frame_matches(1);
+    // Frame 2 is lost entirely, so deltas against it have nothing to apply to
+    next_frame(2);
+    next_frame(2);
+    metrics_snapshot_t before;
+    metrics_snapshot(&before);
+    unsigned int dropped = 0;
+    for (unsigned int run = 0; run < RUN_COUNT; ++run) {
+        dropped += send_delta_run(3, 2, run);
+    }
+    TEST_ASSERT_NULL(rx_task_acquire_frame());
+    TEST_ASSERT_EQUAL_UINT32(dropped, metric_since(&before, METRIC_DROPS_BASE));
+    TEST_ASSERT_EQUAL_UINT32(0, metric_since(&before, METRIC_RX_FRAMES));
+    TEST_ASSERT_EQUAL_UINT32(loadgen_fragment_count(LED_COUNT[0], 0),
+                             metric_since(&before, (metric_id_t)(METRIC_RUN_DROPS + 0)));
+
+    // The keyframe recovers, and deltas against it decode again
+    next_frame(2);
+    send_keyframe(5);
+    assert_frame_matches(5);
+    // A delta against a frame older than the published one finds nothing
+    dropped += send_delta_run(6, 1, 0);
+    TEST_ASSERT_EQUAL_UINT32(dropped, metric_since(&before, METRIC_DROPS_BASE));
+    next_frame(6);
+    for (unsigned int run = 0; run < RUN_COUNT; ++run) {
+        send_delta_run(6, 5, run);
+    }
+    assert_frame_matches(6);
+}
+
+void test_delta_cannot_reference_its_own_or_a_newer_frame(void)
+{
+    send_keyframe(1);
+    assert_frame_matches(1);
+    next_frame(1);
+    metrics_snapshot_t before;
+    metrics_snapshot(&before);
+    unsigned int dropped = send_delta_run(2, 2, 0);
+    dropped += send_delta_run(2, 3, 0);
+    TEST_ASSERT_EQUAL_UINT32(dropped, metric_since(&before, METRIC_DROPS_BASE));
+}
+
+void test_fragmented_deltas_mix_with_rgb_fragments(void)
+{
+    send_keyframe(1);
+    assert_frame_matches(1);
+    next_frame(40);
+    for (unsigned int run = 0; run < RUN_COUNT; ++run) {
+        unsigned int max_leds = LED_COUNT[run] > 3 ? LED_COUNT[run] / 3 + 1 : 1;
+        unsigned int count = loadgen_fragment_count(LED_COUNT[run], max_leds);
+        // Last fragment first, and the middle one as plain RGB
+        for (unsigned int step = 0; step < count; ++step) {
+            unsigned int index = count - 1 - step;
+            size_t length = index == count / 2
+                                ? loadgen_encode_fragment(2, run, run_rgb[run], LED_COUNT[run],
+                                                          max_leds, index, datagram)
+                                : encode_delta(2, 1, run, max_leds, index);
+            rx_task_process_extended(datagram, length);
+        }
+    }
+    assert_frame_matches(2);
+}
+
+void test_malformed_delta_streams_are_dropped_as_len(void)
+{
+    send_keyframe(1);
+    assert_frame_matches(1);
+    next_frame(2);
+    size_t length = encode_delta(2, 1, 0, 0, 0);
+    uint8_t *payload = datagram + LOADGEN_EXTENDED_HEADER_BYTES + LOADGEN_BLOCK_HEADER_BYTES;
+    static uint8_t good[LOADGEN_UDP_MAX_PAYLOAD];
+    memcpy(good, datagram, length);
+    unsigned int leds = (unsigned int)(payload[4] << 8 | payload[5]);
+
+    metrics_snapshot_t before;
+    metrics_snapshot(&before);
+    uint32_t expected = 0;
+
+    // Tokens expanding to one LED too few or too many
+    payload[4] = (uint8_t)((leds + 1) >> 8);
+    payload[5] = (uint8_t)(leds + 1);
+    rx_task_process_extended(datagram, length);
+    ++expected;
+    memcpy(datagram, good, length);
+    payload[4] = (uint8_t)((leds - 1) >> 8);
+    payload[5] = (uint8_t)(leds - 1);
+    rx_task_process_extended(datagram, length);
+    ++expected;
+    // A zero LED count, and a span past the end of the run
+    memcpy(datagram, good, length);
+    payload[4] = 0;
+    payload[5] = 0;
+    rx_task_process_extended(datagram, length);
+    ++expected;
+    memcpy(datagram, good, length);
+    unsigned int past_end = LED_COUNT[0] - leds + 1;
+    datagram[LOADGEN_EXTENDED_HEADER_BYTES + 4] = (uint8_t)(past_end >> 8);
+    datagram[LOADGEN_EXTENDED_HEADER_BYTES + 5] = (uint8_t)past_end;
+    rx_task_process_extended(datagram, length);
+    ++expected;
+    // A trailing literal token whose bytes run past the end of the payload
+    memcpy(datagram, good, length);
+    datagram[length] = 0xff;
+    size_t payload_bytes = length - LOADGEN_EXTENDED_HEADER_BYTES - LOADGEN_BLOCK_HEADER_BYTES + 1;
+    datagram[LOADGEN_EXTENDED_HEADER_BYTES + 6] = (uint8_t)(payload_bytes >> 8);
+    datagram[LOADGEN_EXTENDED_HEADER_BYTES + 7] = (uint8_t)payload_bytes;
+    rx_task_process_extended(datagram, length + 1);
+    ++expected;
+    // A payload holding only part of the delta header
+    memcpy(datagram, good, length);
+    datagram[LOADGEN_EXTENDED_HEADER_BYTES + 6] = 0;
+    datagram[LOADGEN_EXTENDED_HEADER_BYTES + 7] = LOADGEN_DELTA_HEADER_BYTES;
+    rx_task_process_extended(datagram, LOADGEN_EXTENDED_HEADER_BYTES +
+                                           LOADGEN_BLOCK_HEADER_BYTES +
+                                           LOADGEN_DELTA_HEADER_BYTES);
+    ++expected;
+    // An encoding nobody defined
+    memcpy(datagram, good, length);
+    datagram[LOADGEN_EXTENDED_HEADER_BYTES + 1] = RX_ENCODING_XOR_RLE + 1;
+    rx_task_process_extended(datagram, length);
+    ++expected;
+
+    TEST_ASSERT_EQUAL_UINT32(expected, metric_since(&before, METRIC_DROPS_LEN));
+    TEST_ASSERT_EQUAL_UINT32(0, metric_since(&before, METRIC_RX_FRAMES));
+
+    // The untouched datagram still decodes
+    memcpy(datagram, good, length);
+    rx_task_process_extended(datagram, length);
+    for (unsigned int index = 1; index < loadgen_fragment_count(LED_COUNT[0], 0); ++index) {
+        rx_task_process_extended(datagram, encode_delta(2, 1, 0, 0, index));
+    }
+    for (unsigned int run = 1; run < RUN_COUNT; ++run) {
+        send_delta_run(2, 1, run);
+    }
+    assert_frame_matches(2);
+}
+
+int main(void)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_encoder_round_trips_through_reference_decoder);
+    RUN_TEST(test_delta_against_published_frame_decodes);
+    RUN_TEST(test_delta_against_assembling_frame_decodes);
+    RUN_TEST(test_missing_base_waits_for_keyframe);
+    RUN_TEST(test_delta_cannot_reference_its_own_or_a_newer_frame);
+    RUN_TEST(test_fragmented_deltas_mix_with_rgb_fragments);
+    RUN_TEST(test_malformed_delta_streams_are_dropped_as_len);
+    return UNITY_END();
+}
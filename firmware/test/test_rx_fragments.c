@@ -0,0 +1,495 @@
+// Extended datagrams: runs sent as fragments or batched several to a
+// datagram, alone and mixed with plain run datagrams and parity.
+#include "unity.h"
+#include "rx_task.h"
+#include "config_autogen.h"
+#include "loadgen_packet.h"
+#include "metrics.h"
+#include <stdlib.h>
+#include <string.h>
+
+static uint8_t *run_rgb[RUN_COUNT];
+static uint8_t *run_packets[RUN_COUNT];
+static uint8_t *parity_packet;
+static uint8_t datagram[LOADGEN_UDP_MAX_PAYLOAD + 1];
+
+// Splits every run into at least two fragments, and three where it can
+static unsigned int fragment_leds(unsigned int run)
+{
+    return LED_COUNT[run] > 3 ? LED_COUNT[run] / 3 + 1 : 1;
+}
+
+static unsigned int fragment_count(unsigned int run)
+{
+    return loadgen_fragment_count(LED_COUNT[run], fragment_leds(run));
+}
+
+static void build_frame(uint32_t frame_id, uint32_t seed)
+{
+    memset(parity_packet, 0, rx_task_parity_length());
+    loadgen_write_frame_id(parity_packet, frame_id);
+    for (unsigned int run = 0; run < RUN_COUNT; ++run) {
+        loadgen_write_frame_id(run_packets[run], frame_id);
+        for (size_t index = 0; index < LED_COUNT[run] * 3; ++index) {
+            seed = seed * 1103515245u + 12345u;
+            run_rgb[run][index] = (uint8_t)(seed >> 16);
+            run_packets[run][4 + index] = run_rgb[run][index];
+            parity_packet[4 + index] ^= run_rgb[run][index];
+        }
+    }
+}
+
+static size_t encode_fragment(uint32_t frame_id, unsigned int run, unsigned int index)
+{
+    return loadgen_encode_fragment(frame_id, run, run_rgb[run], LED_COUNT[run],
+                                   fragment_leds(run), index, datagram);
+}
+
+static void send_fragment(uint32_t frame_id, unsigned int run, unsigned int index)
+{
+    rx_task_process_extended(datagram, encode_fragment(frame_id, run, index));
+}
+
+// Batched datagrams are built block by block: start one, append blocks
+// carrying LEDs [first_led, first_led + leds) of a run, then send.
+static size_t start_datagram(uint32_t frame_id)
+{
+    loadgen_write_frame_id(datagram, frame_id);
+    datagram[4] = 'W';
+    datagram[5] = 'X';
+    datagram[6] = 1;
+    datagram[7] = 0;
+    return LOADGEN_EXTENDED_HEADER_BYTES;
+}
+
+static size_t append_block(size_t length, unsigned int run, unsigned int index, unsigned int count,
+                           unsigned int first_led, unsigned int leds)
+{
+    uint8_t *block = datagram + length;
+    size_t payload_bytes = (size_t)leds * 3;
+    block[0] = (uint8_t)run;
+    block[1] = 0;
+    block[2] = (uint8_t)index;
+    block[3] = (uint8_t)count;
+    block[4] = (uint8_t)(first_led >> 8);
+    block[5] = (uint8_t)first_led;
+    block[6] = (uint8_t)(payload_bytes >> 8);
+    block[7] = (uint8_t)payload_bytes;
+    memcpy(block + LOADGEN_BLOCK_HEADER_BYTES, run_rgb[run] + (size_t)first_led * 3,
+           payload_bytes);
+    datagram[7]++;
+    return length + LOADGEN_BLOCK_HEADER_BYTES + payload_bytes;
+}
+
+static uint32_t metric_since(const metrics_snapshot_t *before, metric_id_t id)
+{
+    metrics_snapshot_t after;
+    metrics_snapshot_t delta;
+    metrics_snapshot(&after);
+    metrics_delta(&after, before, &delta);
+    return delta.value[id];
+}
+
+static void send_run(unsigned int run)
+{
+    rx_task_process_packet(run, run_packets[run], 4 + LED_COUNT[run] * 3);
+}
+
+static void assert_frame_matches(uint32_t frame_id)
+{
+    rx_frame_t *frame = rx_task_acquire_frame();
+    TEST_ASSERT_NOT_NULL(frame);
+    TEST_ASSERT_EQUAL_UINT32(frame_id, frame->frame_id);
+    for (unsigned int run = 0; run < RUN_COUNT; ++run) {
+        TEST_ASSERT_EQUAL_UINT8_ARRAY(run_rgb[run], frame->run_buffers[run], LED_COUNT[run] * 3);
+    }
+}
+
+void setUp(void)
+{
+    rx_task_start();
+    for (unsigned int run = 0; run < RUN_COUNT; ++run) {
+        run_rgb[run] = (uint8_t *)malloc(LED_COUNT[run] * 3);
+        run_packets[run] = (uint8_t *)malloc(4 + LED_COUNT[run] * 3);
+    }
+    parity_packet = (uint8_t *)malloc(rx_task_parity_length());
+}
+
+void tearDown(void)
+{
+    for (unsigned int run = 0; run < RUN_COUNT; ++run) {
+        free(run_rgb[run]);
+        free(run_packets[run]);
+    }
+    free(parity_packet);
+}
+
+void test_extended_port_follows_parity_port(void)
+{
+#if RX_PARITY_ENABLED
+    TEST_ASSERT_EQUAL_UINT16(PORT_BASE + RUN_COUNT, rx_task_socket_port(RX_PARITY_SOCKET_INDEX));
+#endif
+    TEST_ASSERT_EQUAL_UINT16(PORT_BASE + RUN_COUNT + LOADGEN_EXTENDED_PORT_GAP,
+                             rx_task_socket_port(RX_EXTENDED_SOCKET_INDEX));
+}
+
+void test_in_order_fragments_complete_the_frame(void)
+{
+    build_frame(1, 0x5EEDu);
+    for (unsigned int run = 0; run < RUN_COUNT; ++run) {
+        TEST_ASSERT_GREATER_THAN_UINT32(1, fragment_count(run));
+        for (unsigned int index = 0; index < fragment_count(run); ++index) {
+            TEST_ASSERT_NULL(rx_task_acquire_frame());
+            send_fragment(1, run, index);
+        }
+    }
+    assert_frame_matches(1);
+}
+
+void test_reordered_interleaved_fragments_complete_the_frame(void)
+{
+    build_frame(7, 0xF00Du);
+    // Last fragment first, runs interleaved
+    for (unsigned int step = 0; step < RX_MAX_FRAGMENTS; ++step) {
+        for (unsigned int run = RUN_COUNT; run-- > 0;) {
+            if (step < fragment_count(run)) {
+                send_fragment(7, run, fragment_count(run) - 1 - step);
+            }
+        }
+    }
+    assert_frame_matches(7);
+}
+
+void test_missing_fragment_holds_the_run_until_it_arrives(void)
+{
+    build_frame(1, 0xABCu);
+    for (unsigned int run = 1; run < RUN_COUNT; ++run) {
+        send_run(run);
+    }
+    for (unsigned int index = 1; index < fragment_count(0); ++index) {
+        send_fragment(1, 0, index);
+    }
+    TEST_ASSERT_FALSE(rx_task_run_received(rx_task_slot_index(1), 0));
+    TEST_ASSERT_NULL(rx_task_acquire_frame());
+    send_fragment(1, 0, 0);
+    assert_frame_matches(1);
+}
+
+void test_duplicate_fragment_is_not_counted_twice(void)
+{
+    build_frame(1, 0xD0Bu);
+    for (unsigned int run = 1; run < RUN_COUNT; ++run) {
+        send_run(run);
+    }
+    // Every fragment but the last, the first one repeatedly
+    for (unsigned int repeat = 0; repeat < fragment_count(0); ++repeat) {
+        send_fragment(1, 0, 0);
+    }
+    for (unsigned int index = 1; index + 1 < fragment_count(0); ++index) {
+        send_fragment(1, 0, index);
+    }
+    TEST_ASSERT_NULL(rx_task_acquire_frame());
+    send_fragment(1, 0, fragment_count(0) - 1);
+    assert_frame_matches(1);
+}
+
+void test_overlapping_fragments_do_not_complete_the_run(void)
+{
+    build_frame(1, 0x0E1u);
+    for (unsigned int run = 1; run < RUN_COUNT; ++run) {
+        send_run(run);
+    }
+    // Two fragments whose sizes add up to the run but both start at LED 0
+    unsigned int half = LED_COUNT[0] / 2;
+    size_t length = start_datagram(1);
+    length = append_block(length, 0, 0, 2, 0, half);
+    rx_task_process_extended(datagram, length);
+    length = start_datagram(1);
+    length = append_block(length, 0, 1, 2, 0, LED_COUNT[0] - half);
+    rx_task_process_extended(datagram, length);
+    TEST_ASSERT_NULL(rx_task_acquire_frame());
+    TEST_ASSERT_FALSE(rx_task_run_received(rx_task_slot_index(1), 0));
+    // The second fragment resent where it belongs completes the run
+    length = start_datagram(1);
+    length = append_block(length, 0, 1, 2, half, LED_COUNT[0] - half);
+    rx_task_process_extended(datagram, length);
+    assert_frame_matches(1);
+}
+
+void test_disagreeing_fragment_count_is_dropped(void)
+{
+    build_frame(1, 0xC0u);
+    send_fragment(1, 0, 0);
+    metrics_snapshot_t before;
+    metrics_snapshot(&before);
+    size_t length = encode_fragment(1, 0, 1);
+    datagram[LOADGEN_EXTENDED_HEADER_BYTES + 3] += 1;
+    rx_task_process_extended(datagram, length);
+    TEST_ASSERT_EQUAL_UINT32(1, metric_since(&before, METRIC_DROPS_LEN));
+    TEST_ASSERT_EQUAL_UINT32(1, metric_since(&before, METRIC_RUN_DROPS + 0));
+}
+
+void test_whole_run_in_one_fragment_is_accepted(void)
+{
+    build_frame(3, 0x77u);
+    for (unsigned int run = 0; run < RUN_COUNT; ++run) {
+        if (LED_COUNT[run] > LOADGEN_FRAGMENT_MAX_LEDS) {
+            for (unsigned int index = 0; index < loadgen_fragment_count(LED_COUNT[run], 0);
+                 ++index) {
+                rx_task_process_extended(datagram,
+                                         loadgen_encode_fragment(3, run, run_rgb[run],
+                                                                 LED_COUNT[run], 0, index,
+                                                                 datagram));
+            }
+        } else {
+            rx_task_process_extended(datagram,
+                                     loadgen_encode_fragment(3, run, run_rgb[run], LED_COUNT[run],
+                                                             LED_COUNT[run], 0, datagram));
+        }
+    }
+    assert_frame_matches(3);
+}
+
+// Each case corrupts a valid first fragment of run 0 at one byte (offset 0:
+// none) and sends `length` bytes of it
+void test_malformed_extended_datagrams_are_dropped(void)
+{
+    build_frame(1, 0xBADu);
+    size_t length = encode_fragment(1, 0, 0);
+    uint8_t *block = datagram + LOADGEN_EXTENDED_HEADER_BYTES;
+    struct {
+        size_t offset;
+        uint8_t value;
+        size_t length;
+        metric_id_t drop;
+    } cases[] = {
+        {4, 'Q', length, METRIC_DROPS_LEN},       // magic
+        {6, 2, length, METRIC_DROPS_LEN},         // version
+        {7, 2, length, METRIC_DROPS_LEN},         // block count
+        {8, RUN_COUNT, length, METRIC_DROPS_RUN}, // run
+        {9, 7, length, METRIC_DROPS_LEN},         // encoding
+        {10, 0, length, METRIC_DROPS_LEN},        // fragment index (set to count below)
+        {11, 0, length, METRIC_DROPS_LEN},        // fragment count
+        {11, RX_MAX_FRAGMENTS + 1, length, METRIC_DROPS_LEN},
+        {0, 0, length - 1, METRIC_DROPS_LEN},     // truncated payload
+        {0, 0, LOADGEN_EXTENDED_HEADER_BYTES + 3, METRIC_DROPS_LEN},
+        {0, 0, LOADGEN_UDP_MAX_PAYLOAD + 1, METRIC_DROPS_LEN},
+    };
+    for (size_t index = 0; index < sizeof(cases) / sizeof(cases[0]); ++index) {
+        encode_fragment(1, 0, 0);
+        if (cases[index].offset == 10) {
+            block[2] = block[3];
+        } else if (cases[index].offset != 0) {
+            datagram[cases[index].offset] = cases[index].value;
+        }
+        metrics_snapshot_t before;
+        metrics_snapshot(&before);
+        rx_task_process_extended(datagram, cases[index].length);
+        TEST_ASSERT_EQUAL_UINT32_MESSAGE(1, metric_since(&before, cases[index].drop),
+                                         "case dropped for the wrong reason");
+        TEST_ASSERT_EQUAL_UINT32(0, metric_since(&before, METRIC_RX_FRAMES));
+    }
+
+    // Payload running past the end of the run
+    length = encode_fragment(1, 0, fragment_count(0) - 1);
+    size_t payload_leds = (size_t)(block[6] << 8 | block[7]) / 3;
+    uint16_t first_led = (uint16_t)(LED_COUNT[0] - payload_leds + 1);
+    block[4] = (uint8_t)(first_led >> 8);
+    block[5] = (uint8_t)first_led;
+    metrics_snapshot_t before;
+    metrics_snapshot(&before);
+    rx_task_process_extended(datagram, length);
+    TEST_ASSERT_EQUAL_UINT32(1, metric_since(&before, METRIC_DROPS_LEN));
+    TEST_ASSERT_EQUAL(0, rx_task_get_frame_id(rx_task_slot_index(1)));
+}
+
+void test_fragments_of_stale_frame_are_dropped(void)
+{
+    build_frame(2, 0x11u);
+    for (unsigned int run = 0; run < RUN_COUNT; ++run) {
+        send_run(run);
+    }
+    assert_frame_matches(2);
+    metrics_snapshot_t before;
+    metrics_snapshot(&before);
+    send_fragment(1, 0, 0);
+    TEST_ASSERT_EQUAL_UINT32(1, metric_since(&before, METRIC_DROPS_STALE));
+}
+
+void test_parity_rebuilds_a_run_with_a_lost_fragment(void)
+{
+#if RX_PARITY_ENABLED
+    build_frame(1, 0x9A9Au);
+    for (unsigned int index = 1; index < fragment_count(0); ++index) {
+        send_fragment(1, 0, index);
+    }
+    for (unsigned int run = 1; run < RUN_COUNT; ++run) {
+        send_run(run);
+    }
+    TEST_ASSERT_NULL(rx_task_acquire_frame());
+    rx_task_process_parity(parity_packet, rx_task_parity_length());
+    assert_frame_matches(1);
+#else
+    TEST_IGNORE_MESSAGE("parity disabled");
+#endif
+}
+
+void test_whole_runs_batched_together_complete_the_frame(void)
+{
+    build_frame(1, 0xBA7Cu);
+    const uint8_t *rgb[RUN_COUNT];
+    for (unsigned int run = 0; run < RUN_COUNT; ++run) {
+        rgb[run] = run_rgb[run];
+    }
+    unsigned int batched_runs = 0;
+    unsigned int batches = 0;
+    for (unsigned int run = 0; run < RUN_COUNT;) {
+        unsigned int count = loadgen_batch_runs(LED_COUNT, RUN_COUNT, run);
+        TEST_ASSERT_NULL(rx_task_acquire_frame());
+        if (count == 0) {
+            // Longer than one datagram, so it goes as fragments, as loadgen sends it
+            for (unsigned int index = 0; index < fragment_count(run); ++index) {
+                send_fragment(1, run, index);
+            }
+            ++run;
+            continue;
+        }
+        rx_task_process_extended(datagram,
+                                 loadgen_encode_batch(1, LED_COUNT, rgb, run, count, datagram));
+        run += count;
+        batched_runs += count;
+        ++batches;
+    }
+    assert_frame_matches(1);
+    TEST_ASSERT_TRUE(batches <= batched_runs);
+}
+
+// 40-LED fragments of every run, interleaved across runs and packed as many
+// to a datagram as fit, so every layout exercises multi-block datagrams
+void test_fragments_of_several_runs_share_datagrams(void)
+{
+    build_frame(4, 0x5A5Au);
+    metrics_snapshot_t before;
+    metrics_snapshot(&before);
+    unsigned int counts[RUN_COUNT];
+    unsigned int most = 0;
+    for (unsigned int run = 0; run < RUN_COUNT; ++run) {
+        counts[run] = (LED_COUNT[run] + 39) / 40;
+        most = counts[run] > most ? counts[run] : most;
+    }
+    TEST_ASSERT_TRUE(most <= RX_MAX_FRAGMENTS);
+    size_t length = start_datagram(4);
+    unsigned int blocks = 0;
+    for (unsigned int index = 0; index < most; ++index) {
+        for (unsigned int run = 0; run < RUN_COUNT; ++run) {
+            if (index >= counts[run]) {
+                continue;
+            }
+            unsigned int first_led = index * 40;
+            unsigned int leds = LED_COUNT[run] - first_led < 40 ? LED_COUNT[run] - first_led : 40;
+            if (length + LOADGEN_BLOCK_HEADER_BYTES + leds * 3 > LOADGEN_UDP_MAX_PAYLOAD) {
+                TEST_ASSERT_NULL(rx_task_acquire_frame());
+                rx_task_process_extended(datagram, length);
+                length = start_datagram(4);
+            }
+            length = append_block(length, run, index, counts[run], first_led, leds);
+            ++blocks;
+        }
+    }
+    rx_task_process_extended(datagram, length);
+    assert_frame_matches(4);
+    TEST_ASSERT_EQUAL_UINT32(blocks, metric_since(&before, METRIC_RX_FRAMES));
+    TEST_ASSERT_EQUAL_UINT32(1, metric_since(&before, METRIC_COMPLETE));
+}
+
+void test_batch_with_one_bad_block_is_dropped_whole(void)
+{
+    build_frame(1, 0xBAD2u);
+    unsigned int second_run = RUN_COUNT > 1 ? 1 : 0;
+    size_t length = start_datagram(1);
+    length = append_block(length, 0, 0, 2, 0, 1);
+    size_t second_block = length;
+    length = append_block(length, second_run, 1, 2, 1, 1);
+
+    metrics_snapshot_t before;
+    metrics_snapshot(&before);
+    datagram[second_block + 1] = 7; // unknown encoding
+    rx_task_process_extended(datagram, length);
+    datagram[second_block + 1] = 0;
+    datagram[second_block] = RUN_COUNT;
+    rx_task_process_extended(datagram, length);
+    datagram[second_block] = (uint8_t)second_run;
+    // Block count promising a third block, then trailing bytes
+    datagram[7] = 3;
+    rx_task_process_extended(datagram, length);
+    datagram[7] = 2;
+    rx_task_process_extended(datagram, length + 1);
+    datagram[7] = 0;
+    rx_task_process_extended(datagram, LOADGEN_EXTENDED_HEADER_BYTES);
+    TEST_ASSERT_EQUAL_UINT32(4, metric_since(&before, METRIC_DROPS_LEN));
+    TEST_ASSERT_EQUAL_UINT32(1, metric_since(&before, METRIC_DROPS_RUN));
+    TEST_ASSERT_EQUAL_UINT32(0, metric_since(&before, METRIC_RX_FRAMES));
+    TEST_ASSERT_EQUAL(0, rx_task_get_frame_id(rx_task_slot_index(1)));
+}
+
+void test_batch_disagreeing_on_a_fragment_count_is_dropped_whole(void)
+{
+    build_frame(1, 0xD15u);
+    send_fragment(1, 0, 0);
+    unsigned int other_run = RUN_COUNT > 1 ? 1 : 0;
+    size_t length = start_datagram(1);
+    length = append_block(length, other_run, 0, 2, 0, 1);
+    length = append_block(length, 0, 1, fragment_count(0) + 1, fragment_leds(0), 1);
+    metrics_snapshot_t before;
+    metrics_snapshot(&before);
+    rx_task_process_extended(datagram, length);
+    TEST_ASSERT_EQUAL_UINT32(1, metric_since(&before, METRIC_DROPS_LEN));
+    TEST_ASSERT_EQUAL_UINT32(0, metric_since(&before, METRIC_RX_FRAMES));
+    // Each block counts towards its run
+    TEST_ASSERT_EQUAL_UINT32(other_run == 0 ? 2 : 1, metric_since(&before, METRIC_RUN_DROPS + 0));
+    if (other_run != 0) {
+        TEST_ASSERT_EQUAL_UINT32(1, metric_since(&before, METRIC_RUN_DROPS + other_run));
+        TEST_ASSERT_FALSE(rx_task_run_received(rx_task_slot_index(1), other_run));
+    }
+}
+
+void test_blocks_of_one_run_disagreeing_within_a_datagram_are_dropped(void)
+{
+    build_frame(1, 0xD1Bu);
+    size_t length = start_datagram(1);
+    length = append_block(length, 0, 0, 2, 0, 1);
+    length = append_block(length, 0, 1, 3, 1, 1);
+    metrics_snapshot_t before;
+    metrics_snapshot(&before);
+    rx_task_process_extended(datagram, length);
+    TEST_ASSERT_EQUAL_UINT32(1, metric_since(&before, METRIC_DROPS_LEN));
+    TEST_ASSERT_EQUAL_UINT32(2, metric_since(&before, METRIC_RUN_DROPS + 0));
+    // Nothing was applied, so a consistent count is still accepted
+    length = start_datagram(1);
+    length = append_block(length, 0, 0, 3, 0, 1);
+    metrics_snapshot(&before);
+    rx_task_process_extended(datagram, length);
+    TEST_ASSERT_EQUAL_UINT32(0, metric_since(&before, METRIC_DROPS_LEN));
+}
+
+int main(void)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_extended_port_follows_parity_port);
+    RUN_TEST(test_in_order_fragments_complete_the_frame);
+    RUN_TEST(test_reordered_interleaved_fragments_complete_the_frame);
+    RUN_TEST(test_missing_fragment_holds_the_run_until_it_arrives);
+    RUN_TEST(test_duplicate_fragment_is_not_counted_twice);
+    RUN_TEST(test_overlapping_fragments_do_not_complete_the_run);
+    RUN_TEST(test_disagreeing_fragment_count_is_dropped);
+    RUN_TEST(test_whole_run_in_one_fragment_is_accepted);
+    RUN_TEST(test_malformed_extended_datagrams_are_dropped);
+    RUN_TEST(test_fragments_of_stale_frame_are_dropped);
+    RUN_TEST(test_parity_rebuilds_a_run_with_a_lost_fragment);
+    RUN_TEST(test_whole_runs_batched_together_complete_the_frame);
+    RUN_TEST(test_fragments_of_several_runs_share_datagrams);
+    RUN_TEST(test_batch_with_one_bad_block_is_dropped_whole);
+    RUN_TEST(test_batch_disagreeing_on_a_fragment_count_is_dropped_whole);
+    RUN_TEST(test_blocks_of_one_run_disagreeing_within_a_datagram_are_dropped);
+    return UNITY_END();
+}
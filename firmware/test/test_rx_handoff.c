@@ -0,0 +1,160 @@
+// Multi-threaded stress test of the lock-free rx_task -> driver_task handoff.
+#include "unity.h"
+#include "rx_task.h"
+#include "config_autogen.h"
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define STRESS_FRAME_COUNT 20000
+
+static atomic_bool producers_done;
+static pthread_barrier_t frame_barrier;
+static atomic_uint torn_frames;
+static atomic_uint observed_frames;
+static atomic_uint out_of_order_frames;
+
+static uint8_t pattern_byte(uint32_t frame_id, unsigned int run, size_t index)
+{
+    return (uint8_t)(frame_id * 7u + run * 13u + index);
+}
+
+static void fill_packet(uint8_t *packet, uint32_t frame_id, unsigned int run)
+{
+    packet[0] = (uint8_t)(frame_id >> 24);
+    packet[1] = (uint8_t)(frame_id >> 16);
+    packet[2] = (uint8_t)(frame_id >> 8);
+    packet[3] = (uint8_t)frame_id;
+    for (size_t index = 0; index < LED_COUNT[run] * 3; ++index) {
+        packet[4 + index] = pattern_byte(frame_id, run, index);
+    }
+}
+
+static bool frame_is_intact(const rx_frame_t *frame)
+{
+    for (unsigned int run = 0; run < RUN_COUNT; ++run) {
+        for (size_t index = 0; index < LED_COUNT[run] * 3; ++index) {
+            if (frame->run_buffers[run][index] != pattern_byte(frame->frame_id, run, index)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// Consumer loop in the shape of driver_task, without any lock.
+static void *driver_thread(void *arg)
+{
+    (void)arg;
+    uint32_t last_frame_id = 0;
+    for (;;) {
+        bool done = atomic_load(&producers_done);
+        rx_frame_t *frame = rx_task_acquire_frame();
+        if (frame != NULL) {
+            // Check again after yielding, as the frame stays in use while the
+            // runs stream out
+            bool intact = frame_is_intact(frame);
+            sched_yield();
+            if (!intact || !frame_is_intact(frame)) {
+                atomic_fetch_add(&torn_frames, 1);
+            }
+            if ((int32_t)(frame->frame_id - last_frame_id) <= 0) {
+                atomic_fetch_add(&out_of_order_frames, 1);
+            }
+            last_frame_id = frame->frame_id;
+            atomic_fetch_add(&observed_frames, 1);
+        } else if (done) {
+            break;
+        } else {
+            sched_yield();
+        }
+    }
+    return NULL;
+}
+
+// One listener per run, as rx_task runs on target. A barrier per frame keeps
+// the listeners in step the way a sender emitting whole frames would.
+static void *run_listener_thread(void *arg)
+{
+    unsigned int run = (unsigned int)(uintptr_t)arg;
+    size_t length = 4 + LED_COUNT[run] * 3;
+    uint8_t *packet = (uint8_t *)malloc(length);
+    for (uint32_t frame_id = 1; frame_id <= STRESS_FRAME_COUNT; ++frame_id) {
+        fill_packet(packet, frame_id, run);
+        pthread_barrier_wait(&frame_barrier);
+        rx_task_process_packet(run, packet, length);
+        // Give the consumer a chance to run mid-assembly on single-core hosts
+        sched_yield();
+    }
+    free(packet);
+    return NULL;
+}
+
+static void reset_counters(void)
+{
+    atomic_store(&producers_done, false);
+    atomic_store(&torn_frames, 0);
+    atomic_store(&observed_frames, 0);
+    atomic_store(&out_of_order_frames, 0);
+}
+
+void setUp(void)
+{
+    rx_task_start();
+    reset_counters();
+}
+
+void tearDown(void) {}
+
+void test_acquire_returns_each_published_frame_once(void)
+{
+    TEST_ASSERT_NULL(rx_task_acquire_frame());
+    for (unsigned int run = 0; run < RUN_COUNT; ++run) {
+        size_t length = 4 + LED_COUNT[run] * 3;
+        uint8_t *packet = (uint8_t *)malloc(length);
+        fill_packet(packet, 5, run);
+        rx_task_process_packet(run, packet, length);
+        free(packet);
+    }
+    rx_frame_t *frame = rx_task_acquire_frame();
+    TEST_ASSERT_NOT_NULL(frame);
+    TEST_ASSERT_EQUAL_UINT32(5, frame->frame_id);
+    TEST_ASSERT_TRUE(frame_is_intact(frame));
+    TEST_ASSERT_EQUAL_PTR(frame, rx_task_driver_frame());
+    TEST_ASSERT_NULL(rx_task_acquire_frame());
+    TEST_ASSERT_EQUAL_PTR(frame, rx_task_driver_frame());
+}
+
+void test_driver_never_observes_torn_frame(void)
+{
+    pthread_t driver;
+    pthread_t listeners[RUN_COUNT];
+    pthread_barrier_init(&frame_barrier, NULL, RUN_COUNT);
+    pthread_create(&driver, NULL, driver_thread, NULL);
+    for (unsigned int run = 0; run < RUN_COUNT; ++run) {
+        pthread_create(&listeners[run], NULL, run_listener_thread, (void *)(uintptr_t)run);
+    }
+    for (unsigned int run = 0; run < RUN_COUNT; ++run) {
+        pthread_join(listeners[run], NULL);
+    }
+    atomic_store(&producers_done, true);
+    pthread_join(driver, NULL);
+    pthread_barrier_destroy(&frame_barrier);
+
+    printf("driver observed %u frames of %u sent\n", atomic_load(&observed_frames),
+           STRESS_FRAME_COUNT);
+    TEST_ASSERT_TRUE(atomic_load(&observed_frames) > 0);
+    TEST_ASSERT_EQUAL_UINT(0, atomic_load(&torn_frames));
+    TEST_ASSERT_EQUAL_UINT(0, atomic_load(&out_of_order_frames));
+}
+
+int main(void)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_acquire_returns_each_published_frame_once);
+    RUN_TEST(test_driver_never_observes_torn_frame);
+    return UNITY_END();
+}
@@ -0,0 +1,160 @@
+// Host harness measuring packet-to-wakeup latency of the driver loop.
+#include "unity.h"
+#include "rx_task.h"
+#include "config_autogen.h"
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define FRAME_COUNT 200
+#define POLL_INTERVAL_NS 1000000L
+
+static atomic_bool driver_running;
+static atomic_uint_fast64_t driver_wake_ns;
+static atomic_uint_fast32_t driver_seen_frames;
+
+static uint64_t now_ns(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000ull + (uint64_t)now.tv_nsec;
+}
+
+static void record_wake(void)
+{
+    atomic_store(&driver_wake_ns, now_ns());
+    atomic_fetch_add(&driver_seen_frames, 1);
+}
+
+// Mirrors driver_task: block until rx_task signals a completed frame.
+static void *event_driver(void *arg)
+{
+    (void)arg;
+    while (atomic_load(&driver_running)) {
+        if (rx_task_wait_for_frame(10)) {
+            record_wake();
+        }
+    }
+    return NULL;
+}
+
+// The previous driver loop: sleep 1 ms and look for a newer frame.
+static void *polling_driver(void *arg)
+{
+    (void)arg;
+    uint32_t last_frame_id = 0;
+    const struct timespec interval = {0, POLL_INTERVAL_NS};
+    while (atomic_load(&driver_running)) {
+        for (int slot = 0; slot < RX_SLOT_COUNT; ++slot) {
+            uint32_t frame_id = rx_task_get_frame_id(slot);
+            bool complete = frame_id != 0 && (int32_t)(frame_id - last_frame_id) > 0;
+            for (unsigned int run = 0; complete && run < RUN_COUNT; ++run) {
+                complete = rx_task_run_received(slot, run);
+            }
+            if (complete) {
+                last_frame_id = frame_id;
+                record_wake();
+            }
+        }
+        nanosleep(&interval, NULL);
+    }
+    return NULL;
+}
+
+static int compare_u64(const void *a, const void *b)
+{
+    uint64_t left = *(const uint64_t *)a;
+    uint64_t right = *(const uint64_t *)b;
+    return (left > right) - (left < right);
+}
+
+// Sends FRAME_COUNT complete frames and returns the median latency in ns
+// from the frame's final packet to the driver waking for it.
+static uint64_t measure_latency(void *(*driver)(void *), const char *label)
+{
+    static uint64_t latencies[FRAME_COUNT];
+    rx_task_start();
+    atomic_store(&driver_running, true);
+    atomic_store(&driver_seen_frames, 0);
+    pthread_t thread;
+    pthread_create(&thread, NULL, driver, NULL);
+
+    uint8_t *packets[RUN_COUNT];
+    for (unsigned int run = 0; run < RUN_COUNT; ++run) {
+        packets[run] = (uint8_t *)calloc(4 + LED_COUNT[run] * 3, 1);
+    }
+    const struct timespec settle = {0, 200000L};
+    for (uint32_t frame = 0; frame < FRAME_COUNT; ++frame) {
+        uint32_t frame_id = frame + 1;
+        for (unsigned int run = 0; run < RUN_COUNT; ++run) {
+            packets[run][2] = (uint8_t)(frame_id >> 8);
+            packets[run][3] = (uint8_t)frame_id;
+        }
+        for (unsigned int run = 0; run + 1 < RUN_COUNT; ++run) {
+            rx_task_process_packet(run, packets[run], 4 + LED_COUNT[run] * 3);
+        }
+        // Randomise the phase against the polling interval
+        nanosleep(&settle, NULL);
+        uint64_t sent_ns = now_ns();
+        rx_task_process_packet(RUN_COUNT - 1, packets[RUN_COUNT - 1],
+                               4 + LED_COUNT[RUN_COUNT - 1] * 3);
+        while (atomic_load(&driver_seen_frames) < frame_id) {
+            sched_yield();
+        }
+        latencies[frame] = atomic_load(&driver_wake_ns) - sent_ns;
+    }
+
+    atomic_store(&driver_running, false);
+    pthread_join(thread, NULL);
+    for (unsigned int run = 0; run < RUN_COUNT; ++run) {
+        free(packets[run]);
+    }
+    qsort(latencies, FRAME_COUNT, sizeof(latencies[0]), compare_u64);
+    printf("%-8s packet-to-wakeup latency: p50 %.1f us, p99 %.1f us, max %.1f us\n", label,
+           latencies[FRAME_COUNT / 2] / 1000.0, latencies[FRAME_COUNT * 99 / 100] / 1000.0,
+           latencies[FRAME_COUNT - 1] / 1000.0);
+    return latencies[FRAME_COUNT / 2];
+}
+
+void setUp(void) {}
+void tearDown(void) {}
+
+void test_event_wakeup_beats_polling(void)
+{
+    uint64_t polling_ns = measure_latency(polling_driver, "polling");
+    uint64_t event_ns = measure_latency(event_driver, "event");
+    TEST_ASSERT_TRUE(event_ns < polling_ns);
+    TEST_ASSERT_TRUE(event_ns < POLL_INTERVAL_NS / 4);
+}
+
+void test_wait_times_out_without_frame(void)
+{
+    rx_task_start();
+    TEST_ASSERT_FALSE(rx_task_wait_for_frame(5));
+}
+
+void test_signal_is_latched_until_waited(void)
+{
+    rx_task_start();
+    for (unsigned int run = 0; run < RUN_COUNT; ++run) {
+        size_t length = 4 + LED_COUNT[run] * 3;
+        uint8_t *packet = (uint8_t *)calloc(length, 1);
+        packet[3] = 7;
+        rx_task_process_packet(run, packet, length);
+        free(packet);
+    }
+    TEST_ASSERT_TRUE(rx_task_wait_for_frame(0));
+    TEST_ASSERT_FALSE(rx_task_wait_for_frame(0));
+}
+
+int main(void)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_wait_times_out_without_frame);
+    RUN_TEST(test_signal_is_latched_until_waited);
+    RUN_TEST(test_event_wakeup_beats_polling);
+    return UNITY_END();
+}
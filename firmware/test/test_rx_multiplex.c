@@ -0,0 +1,149 @@
+// Multiplexed receive path against real loopback UDP sockets.
+#include "unity.h"
+#include "rx_task.h"
+#include "config_autogen.h"
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+// Run sockets, then the parity socket when enabled
+static int run_sockets[RX_SOCKET_COUNT];
+static uint16_t run_ports[RX_SOCKET_COUNT];
+static int sender_socket;
+
+static uint16_t bound_port(int sock)
+{
+    struct sockaddr_in addr;
+    socklen_t length = sizeof(addr);
+    getsockname(sock, (struct sockaddr *)&addr, &length);
+    return ntohs(addr.sin_port);
+}
+
+static void send_run(unsigned int run, uint32_t frame_id, uint8_t fill, size_t length)
+{
+    uint8_t *packet = (uint8_t *)malloc(length);
+    memset(packet, fill, length);
+    packet[0] = (uint8_t)(frame_id >> 24);
+    packet[1] = (uint8_t)(frame_id >> 16);
+    packet[2] = (uint8_t)(frame_id >> 8);
+    packet[3] = (uint8_t)frame_id;
+    struct sockaddr_in destination = {
+        .sin_family = AF_INET,
+        .sin_port = htons(run_ports[run]),
+        .sin_addr.s_addr = htonl(INADDR_LOOPBACK),
+    };
+    TEST_ASSERT_EQUAL((ssize_t)length, sendto(sender_socket, packet, length, 0,
+                                              (struct sockaddr *)&destination,
+                                              sizeof(destination)));
+    free(packet);
+}
+
+static size_t service_until(size_t expected)
+{
+    size_t processed = 0;
+    for (int attempt = 0; attempt < 50 && processed < expected; ++attempt) {
+        processed += rx_task_service_sockets(run_sockets, 20);
+    }
+    return processed;
+}
+
+void setUp(void)
+{
+    rx_task_start();
+    for (unsigned int run = 0; run < RX_SOCKET_COUNT; ++run) {
+        // Port 0 lets the OS pick free loopback ports
+        run_sockets[run] = rx_task_open_run_socket(0);
+        TEST_ASSERT_TRUE(run_sockets[run] >= 0);
+        run_ports[run] = bound_port(run_sockets[run]);
+    }
+    sender_socket = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+}
+
+void tearDown(void)
+{
+    for (unsigned int run = 0; run < RX_SOCKET_COUNT; ++run) {
+        close(run_sockets[run]);
+    }
+    close(sender_socket);
+}
+
+void test_service_times_out_when_idle(void)
+{
+    TEST_ASSERT_EQUAL(0, rx_task_service_sockets(run_sockets, 10));
+}
+
+void test_one_task_assembles_frame_from_all_run_sockets(void)
+{
+    for (unsigned int run = 0; run < RUN_COUNT; ++run) {
+        send_run(run, 1, (uint8_t)(0x10 + run), 4 + LED_COUNT[run] * 3);
+    }
+    TEST_ASSERT_EQUAL(RUN_COUNT, service_until(RUN_COUNT));
+    rx_frame_t *frame = rx_task_acquire_frame();
+    TEST_ASSERT_NOT_NULL(frame);
+    TEST_ASSERT_EQUAL_UINT32(1, frame->frame_id);
+    for (unsigned int run = 0; run < RUN_COUNT; ++run) {
+        TEST_ASSERT_EQUAL_UINT8(0x10 + run, frame->run_buffers[run][0]);
+        TEST_ASSERT_EQUAL_UINT8(0x10 + run, frame->run_buffers[run][LED_COUNT[run] * 3 - 1]);
+    }
+}
+
+void test_back_to_back_frames_drain_in_one_pass(void)
+{
+    for (uint32_t frame_id = 1; frame_id <= 3; ++frame_id) {
+        for (unsigned int run = 0; run < RUN_COUNT; ++run) {
+            send_run(run, frame_id, (uint8_t)frame_id, 4 + LED_COUNT[run] * 3);
+        }
+    }
+    TEST_ASSERT_EQUAL(3 * RUN_COUNT, service_until(3 * RUN_COUNT));
+    rx_frame_t *frame = rx_task_acquire_frame();
+    TEST_ASSERT_NOT_NULL(frame);
+    TEST_ASSERT_EQUAL_UINT32(3, frame->frame_id);
+    TEST_ASSERT_EQUAL_UINT8(3, frame->run_buffers[0][0]);
+}
+
+void test_oversized_datagram_is_rejected(void)
+{
+    size_t free_before = rx_task_free_rx_buffers(0);
+    send_run(0, 1, 0, 4 + LED_COUNT[0] * 3 + 3);
+    TEST_ASSERT_EQUAL(1, service_until(1));
+    TEST_ASSERT_FALSE(rx_task_run_received(0, 0));
+    TEST_ASSERT_EQUAL(free_before, rx_task_free_rx_buffers(0));
+}
+
+void test_parity_socket_recovers_missing_run(void)
+{
+#if RX_PARITY_ENABLED
+    // Fill bytes XOR together; run 0 is never sent
+    uint8_t parity_fill = 0;
+    for (unsigned int run = 0; run < RUN_COUNT; ++run) {
+        parity_fill ^= (uint8_t)(0x10 + run);
+    }
+    for (unsigned int run = 1; run < RUN_COUNT; ++run) {
+        send_run(run, 1, (uint8_t)(0x10 + run), 4 + LED_COUNT[run] * 3);
+    }
+    send_run(RX_PARITY_SOCKET_INDEX, 1, parity_fill, rx_task_parity_length());
+    TEST_ASSERT_EQUAL(RUN_COUNT, service_until(RUN_COUNT));
+    rx_frame_t *frame = rx_task_acquire_frame();
+    TEST_ASSERT_NOT_NULL(frame);
+    TEST_ASSERT_EQUAL_UINT32(1, frame->frame_id);
+    // Uniform fills only XOR cleanly where every run has data, so check the
+    // first LED, which all runs share
+    TEST_ASSERT_EQUAL_UINT8(0x10, frame->run_buffers[0][0]);
+#else
+    TEST_IGNORE_MESSAGE("parity disabled");
+#endif
+}
+
+int main(void)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_service_times_out_when_idle);
+    RUN_TEST(test_one_task_assembles_frame_from_all_run_sockets);
+    RUN_TEST(test_back_to_back_frames_drain_in_one_pass);
+    RUN_TEST(test_oversized_datagram_is_rejected);
+    RUN_TEST(test_parity_socket_recovers_missing_run);
+    return UNITY_END();
+}
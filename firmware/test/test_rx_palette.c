@@ -0,0 +1,243 @@
+// Palette blocks on the extended port, with 8-bit and 4-bit indices: the
+// load generator's encoder, expansion into the frame, and validation.
+#include "unity.h"
+#include "rx_task.h"
+#include "config_autogen.h"
+#include "loadgen_packet.h"
+#include "metrics.h"
+#include <stdlib.h>
+#include <string.h>
+
+static uint8_t *run_rgb[RUN_COUNT];
+static uint8_t datagram[LOADGEN_UDP_MAX_PAYLOAD + 1];
+
+// Paints every run from `colours` palette entries derived from seed
+static void build_frame(unsigned int colours, uint32_t seed)
+{
+    uint8_t palette[256][3];
+    for (unsigned int colour = 0; colour < colours; ++colour) {
+        seed = seed * 1103515245u + 12345u;
+        palette[colour][0] = (uint8_t)colour;
+        palette[colour][1] = (uint8_t)(seed >> 16);
+        palette[colour][2] = (uint8_t)(seed >> 24);
+    }
+    for (unsigned int run = 0; run < RUN_COUNT; ++run) {
+        for (size_t led = 0; led < LED_COUNT[run]; ++led) {
+            memcpy(run_rgb[run] + led * 3, palette[(led * 7 + run) % colours], 3);
+        }
+    }
+}
+
+static size_t encode_palette(uint32_t frame_id, unsigned int run, unsigned int max_leds,
+                             unsigned int index, unsigned int bits)
+{
+    size_t length = loadgen_encode_palette_fragment(frame_id, run, run_rgb[run], LED_COUNT[run],
+                                                    max_leds, index, bits, datagram);
+    TEST_ASSERT_GREATER_THAN_UINT32(0, length);
+    return length;
+}
+
+static void send_frame(uint32_t frame_id, unsigned int max_leds, unsigned int bits)
+{
+    for (unsigned int run = 0; run < RUN_COUNT; ++run) {
+        unsigned int count = loadgen_fragment_count(LED_COUNT[run], max_leds);
+        for (unsigned int index = 0; index < count; ++index) {
+            rx_task_process_extended(datagram, encode_palette(frame_id, run, max_leds, index, bits));
+        }
+    }
+}
+
+static uint32_t metric_since(const metrics_snapshot_t *before, metric_id_t id)
+{
+    metrics_snapshot_t after;
+    metrics_snapshot_t delta;
+    metrics_snapshot(&after);
+    metrics_delta(&after, before, &delta);
+    return delta.value[id];
+}
+
+static void assert_frame_matches(uint32_t frame_id)
+{
+    rx_frame_t *frame = rx_task_acquire_frame();
+    TEST_ASSERT_NOT_NULL(frame);
+    TEST_ASSERT_EQUAL_UINT32(frame_id, frame->frame_id);
+    for (unsigned int run = 0; run < RUN_COUNT; ++run) {
+        TEST_ASSERT_EQUAL_UINT8_ARRAY(run_rgb[run], frame->run_buffers[run], LED_COUNT[run] * 3);
+    }
+}
+
+void setUp(void)
+{
+    rx_task_start();
+    for (unsigned int run = 0; run < RUN_COUNT; ++run) {
+        run_rgb[run] = (uint8_t *)malloc(LED_COUNT[run] * 3);
+    }
+}
+
+void tearDown(void)
+{
+    for (unsigned int run = 0; run < RUN_COUNT; ++run) {
+        free(run_rgb[run]);
+    }
+}
+
+void test_encoder_builds_palette_in_order_of_use(void)
+{
+    const uint8_t RGB[] = {1, 2, 3, 4, 5, 6, 1, 2, 3, 7, 8, 9, 4, 5, 6};
+    uint8_t palette[4 * 3];
+    uint8_t indices[5];
+    TEST_ASSERT_EQUAL_UINT(3, loadgen_build_palette(RGB, 5, 4, palette, indices));
+    const uint8_t PALETTE[] = {1, 2, 3, 4, 5, 6, 7, 8, 9};
+    const uint8_t INDICES[] = {0, 1, 0, 2, 1};
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(PALETTE, palette, sizeof(PALETTE));
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(INDICES, indices, sizeof(INDICES));
+    TEST_ASSERT_EQUAL_UINT(0, loadgen_build_palette(RGB, 5, 2, palette, indices));
+
+    // Five LEDs of 4-bit indices fill three bytes, the last low nibble zero
+    size_t length = loadgen_encode_palette_fragment(9, 0, RGB, 5, 0, 0, 4, datagram);
+    const uint8_t BLOCK[] = {0, RX_ENCODING_PALETTE4, 0, 1, 0, 0, 0, 3 + 9 + 3,
+                             0, 5, 2, 1, 2, 3, 4, 5, 6, 7, 8, 9, 0x01, 0x02, 0x10};
+    TEST_ASSERT_EQUAL_size_t(LOADGEN_EXTENDED_HEADER_BYTES + sizeof(BLOCK), length);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(BLOCK, datagram + LOADGEN_EXTENDED_HEADER_BYTES, sizeof(BLOCK));
+    length = loadgen_encode_palette_fragment(9, 0, RGB, 5, 0, 0, 8, datagram);
+    TEST_ASSERT_EQUAL_size_t(LOADGEN_EXTENDED_HEADER_BYTES + LOADGEN_BLOCK_HEADER_BYTES + 3 + 9 + 5,
+                             length);
+    TEST_ASSERT_EQUAL_HEX8(RX_ENCODING_PALETTE8, datagram[LOADGEN_EXTENDED_HEADER_BYTES + 1]);
+}
+
+void test_eight_bit_indices_expand_into_the_frame(void)
+{
+    // The full 256 colours, then a handful
+    build_frame(256, 0xC0101u);
+    send_frame(1, LOADGEN_FRAGMENT_MAX_LEDS, 8);
+    assert_frame_matches(1);
+    build_frame(5, 0xC0102u);
+    send_frame(2, LOADGEN_FRAGMENT_MAX_LEDS, 8);
+    assert_frame_matches(2);
+}
+
+void test_four_bit_indices_expand_into_the_frame(void)
+{
+    build_frame(16, 0xC0103u);
+    send_frame(1, LOADGEN_FRAGMENT_MAX_LEDS, 4);
+    assert_frame_matches(1);
+    // A single colour, and runs split into odd-sized fragments
+    build_frame(1, 0xC0104u);
+    send_frame(2, LOADGEN_FRAGMENT_MAX_LEDS, 4);
+    assert_frame_matches(2);
+    build_frame(11, 0xC0105u);
+    send_frame(3, 101, 4);
+    assert_frame_matches(3);
+    // More colours than four bits can name do not encode
+    build_frame(17, 0xC0106u);
+    TEST_ASSERT_EQUAL_size_t(0, loadgen_encode_palette_fragment(4, 0, run_rgb[0], LED_COUNT[0], 0,
+                                                                0, 4, datagram));
+}
+
+void test_palette_mixes_with_rgb_fragments(void)
+{
+    build_frame(9, 0xC0107u);
+    for (unsigned int run = 0; run < RUN_COUNT; ++run) {
+        unsigned int max_leds = LED_COUNT[run] > 3 ? LED_COUNT[run] / 3 + 1 : 1;
+        unsigned int count = loadgen_fragment_count(LED_COUNT[run], max_leds);
+        for (unsigned int index = 0; index < count; ++index) {
+            size_t length = index % 3 == 0 ? encode_palette(1, run, max_leds, index, 4)
+                            : index % 3 == 1
+                                ? encode_palette(1, run, max_leds, index, 8)
+                                : loadgen_encode_fragment(1, run, run_rgb[run], LED_COUNT[run],
+                                                          max_leds, index, datagram);
+            rx_task_process_extended(datagram, length);
+        }
+    }
+    assert_frame_matches(1);
+}
+
+// Sends a copy of the good datagram with one byte rewritten
+static void send_with(const uint8_t *good, size_t length, size_t at, uint8_t value)
+{
+    memcpy(datagram, good, length);
+    datagram[at] = value;
+    rx_task_process_extended(datagram, length);
+}
+
+static void send_resized(const uint8_t *good, size_t length, size_t new_length)
+{
+    memcpy(datagram, good, length);
+    size_t payload_bytes = new_length - LOADGEN_EXTENDED_HEADER_BYTES - LOADGEN_BLOCK_HEADER_BYTES;
+    datagram[LOADGEN_EXTENDED_HEADER_BYTES + 6] = (uint8_t)(payload_bytes >> 8);
+    datagram[LOADGEN_EXTENDED_HEADER_BYTES + 7] = (uint8_t)payload_bytes;
+    rx_task_process_extended(datagram, new_length);
+}
+
+void test_malformed_palette_blocks_are_dropped_as_len(void)
+{
+    static uint8_t good8[LOADGEN_UDP_MAX_PAYLOAD + 1];
+    static uint8_t good4[LOADGEN_UDP_MAX_PAYLOAD + 1];
+    const uint8_t RGB[] = {1, 2, 3, 4, 5, 6, 7, 8, 9, 1, 2, 3, 4, 5, 6};
+    size_t length8 = loadgen_encode_palette_fragment(1, 0, RGB, 5, 0, 0, 8, good8);
+    size_t length4 = loadgen_encode_palette_fragment(1, 0, RGB, 5, 0, 0, 4, good4);
+    const size_t payload = LOADGEN_EXTENDED_HEADER_BYTES + LOADGEN_BLOCK_HEADER_BYTES;
+    const size_t indices = payload + LOADGEN_PALETTE_HEADER_BYTES + 3 * 3;
+
+    metrics_snapshot_t before;
+    metrics_snapshot(&before);
+    uint32_t expected = 0;
+    // Index naming a colour past the palette, in either nibble or byte
+    send_with(good8, length8, indices + 4, 3);
+    ++expected;
+    send_with(good4, length4, indices, 0x30);
+    ++expected;
+    send_with(good4, length4, indices + 1, 0x13);
+    ++expected;
+    // Padding nibble after an odd LED count must be zero
+    send_with(good4, length4, indices + 2, 0x11);
+    ++expected;
+    // LED count disagreeing with the index bytes, or zero
+    send_with(good8, length8, payload + 1, 6);
+    ++expected;
+    send_with(good8, length8, payload + 1, 4);
+    ++expected;
+    send_with(good4, length4, payload + 1, 7);
+    ++expected;
+    send_with(good8, length8, payload + 1, 0);
+    ++expected;
+    // Palette size disagreeing with the payload
+    send_with(good8, length8, payload + 2, 3);
+    ++expected;
+    send_with(good4, length4, payload + 2, 1);
+    ++expected;
+    // One byte short or long
+    send_resized(good8, length8, length8 - 1);
+    ++expected;
+    send_resized(good4, length4, length4 + 1);
+    ++expected;
+    // A payload too short for the palette header
+    send_resized(good8, length8, payload + 2);
+    ++expected;
+    // More than 16 colours with 4-bit indices, however long the payload
+    memcpy(datagram, good4, length4);
+    datagram[payload + 2] = 16;
+    memset(datagram + indices, 0, 3);
+    rx_task_process_extended(datagram, length4);
+    ++expected;
+    TEST_ASSERT_EQUAL_UINT32(expected, metric_since(&before, METRIC_DROPS_LEN));
+    TEST_ASSERT_EQUAL_UINT32(0, metric_since(&before, METRIC_RX_FRAMES));
+
+    // Both untouched blocks are accepted
+    memcpy(datagram, good8, length8);
+    rx_task_process_extended(datagram, length8);
+    memcpy(datagram, good4, length4);
+    rx_task_process_extended(datagram, length4);
+    TEST_ASSERT_EQUAL_UINT32(2, metric_since(&before, METRIC_RX_FRAMES));
+}
+
+int main(void)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_encoder_builds_palette_in_order_of_use);
+    RUN_TEST(test_eight_bit_indices_expand_into_the_frame);
+    RUN_TEST(test_four_bit_indices_expand_into_the_frame);
+    RUN_TEST(test_palette_mixes_with_rgb_fragments);
+    RUN_TEST(test_malformed_palette_blocks_are_dropped_as_len);
+    return UNITY_END();
+}
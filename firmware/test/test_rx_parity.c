@@ -0,0 +1,162 @@
+// Single-run loss recovery from the XOR parity datagram.
+#include "unity.h"
+#include "rx_task.h"
+#include "config_autogen.h"
+#include "metrics.h"
+#include <stdlib.h>
+#include <string.h>
+
+static uint8_t *run_packets[RUN_COUNT];
+static uint8_t *parity_packet;
+
+static void write_frame_id(uint8_t *packet, uint32_t frame_id)
+{
+    packet[0] = (uint8_t)(frame_id >> 24);
+    packet[1] = (uint8_t)(frame_id >> 16);
+    packet[2] = (uint8_t)(frame_id >> 8);
+    packet[3] = (uint8_t)frame_id;
+}
+
+// Builds every run with a distinct pseudo-random payload and the matching
+// parity datagram: the XOR of all payloads, zero-padded to the longest run.
+static void build_frame(uint32_t frame_id, uint32_t seed)
+{
+    memset(parity_packet, 0, rx_task_parity_length());
+    write_frame_id(parity_packet, frame_id);
+    for (unsigned int run = 0; run < RUN_COUNT; ++run) {
+        write_frame_id(run_packets[run], frame_id);
+        for (size_t index = 0; index < LED_COUNT[run] * 3; ++index) {
+            seed = seed * 1103515245u + 12345u;
+            run_packets[run][4 + index] = (uint8_t)(seed >> 16);
+            parity_packet[4 + index] ^= run_packets[run][4 + index];
+        }
+    }
+}
+
+static void send_run(unsigned int run)
+{
+    rx_task_process_packet(run, run_packets[run], 4 + LED_COUNT[run] * 3);
+}
+
+static void assert_frame_matches(uint32_t frame_id)
+{
+    rx_frame_t *frame = rx_task_acquire_frame();
+    TEST_ASSERT_NOT_NULL(frame);
+    TEST_ASSERT_EQUAL_UINT32(frame_id, frame->frame_id);
+    for (unsigned int run = 0; run < RUN_COUNT; ++run) {
+        TEST_ASSERT_EQUAL_UINT8_ARRAY(run_packets[run] + 4, frame->run_buffers[run],
+                                      LED_COUNT[run] * 3);
+    }
+}
+
+void setUp(void)
+{
+    rx_task_start();
+    for (unsigned int run = 0; run < RUN_COUNT; ++run) {
+        run_packets[run] = (uint8_t *)malloc(4 + LED_COUNT[run] * 3);
+    }
+    parity_packet = (uint8_t *)malloc(rx_task_parity_length());
+}
+
+void tearDown(void)
+{
+    for (unsigned int run = 0; run < RUN_COUNT; ++run) {
+        free(run_packets[run]);
+    }
+    free(parity_packet);
+}
+
+void test_parity_length_covers_longest_run(void)
+{
+    unsigned int longest = 0;
+    for (unsigned int run = 0; run < RUN_COUNT; ++run) {
+        if (LED_COUNT[run] > longest) {
+            longest = LED_COUNT[run];
+        }
+    }
+    TEST_ASSERT_EQUAL(4 + longest * 3, rx_task_parity_length());
+}
+
+void test_each_dropped_run_is_rebuilt_byte_identical(void)
+{
+    metrics_snapshot_t before;
+    metrics_snapshot(&before);
+    for (unsigned int dropped = 0; dropped < RUN_COUNT; ++dropped) {
+        uint32_t frame_id = dropped + 1;
+        build_frame(frame_id, 0x5EED0000u + dropped);
+        for (unsigned int run = 0; run < RUN_COUNT; ++run) {
+            if (run != dropped) {
+                send_run(run);
+            }
+        }
+        TEST_ASSERT_NULL(rx_task_acquire_frame());
+        rx_task_process_parity(parity_packet, rx_task_parity_length());
+        assert_frame_matches(frame_id);
+    }
+    metrics_snapshot_t after;
+    metrics_snapshot_t delta;
+    metrics_snapshot(&after);
+    metrics_delta(&after, &before, &delta);
+    for (unsigned int run = 0; run < RUN_COUNT; ++run) {
+        TEST_ASSERT_EQUAL_UINT32(1, delta.value[METRIC_RUN_RECOVERED + run]);
+    }
+}
+
+void test_parity_before_runs_recovers_on_last_arrival(void)
+{
+    build_frame(1, 0xC0FFEEu);
+    rx_task_process_parity(parity_packet, rx_task_parity_length());
+    for (unsigned int run = 1; run < RUN_COUNT; ++run) {
+        send_run(run);
+    }
+    assert_frame_matches(1);
+}
+
+void test_two_missing_runs_are_not_recovered(void)
+{
+    if (RUN_COUNT < 2) {
+        TEST_IGNORE_MESSAGE("needs two runs to lose two");
+    }
+    build_frame(1, 0xBADu);
+    for (unsigned int run = 2; run < RUN_COUNT; ++run) {
+        send_run(run);
+    }
+    rx_task_process_parity(parity_packet, rx_task_parity_length());
+    TEST_ASSERT_NULL(rx_task_acquire_frame());
+    // The late run completes the frame through parity
+    send_run(1);
+    assert_frame_matches(1);
+}
+
+void test_parity_for_complete_frame_is_ignored(void)
+{
+    build_frame(1, 0x1234u);
+    for (unsigned int run = 0; run < RUN_COUNT; ++run) {
+        send_run(run);
+    }
+    assert_frame_matches(1);
+    rx_task_process_parity(parity_packet, rx_task_parity_length());
+    TEST_ASSERT_NULL(rx_task_acquire_frame());
+}
+
+void test_wrong_parity_length_is_dropped(void)
+{
+    build_frame(1, 0x4321u);
+    rx_task_process_parity(parity_packet, rx_task_parity_length() - 1);
+    for (unsigned int run = 1; run < RUN_COUNT; ++run) {
+        send_run(run);
+    }
+    TEST_ASSERT_NULL(rx_task_acquire_frame());
+}
+
+int main(void)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_parity_length_covers_longest_run);
+    RUN_TEST(test_each_dropped_run_is_rebuilt_byte_identical);
+    RUN_TEST(test_parity_before_runs_recovers_on_last_arrival);
+    RUN_TEST(test_two_missing_runs_are_not_recovered);
+    RUN_TEST(test_parity_for_complete_frame_is_ignored);
+    RUN_TEST(test_wrong_parity_length_is_dropped);
+    return UNITY_END();
+}
@@ -0,0 +1,344 @@
+// Sampled blocks on the extended port: the generated section tables, the
+// load generator's encoder, and interpolation in rx_task checked against a
+// floating-point reference of the formula rx_task.h states.
+#include "unity.h"
+#include "rx_task.h"
+#include "config_autogen.h"
+#include "loadgen_packet.h"
+#include "metrics.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+static uint8_t *run_rgb[RUN_COUNT];
+static uint8_t *expected[RUN_COUNT];
+static uint8_t datagram[LOADGEN_UDP_MAX_PAYLOAD + 1];
+
+static const unsigned int *run_sections(unsigned int run)
+{
+    return &SECTION_LED_COUNT[RUN_FIRST_SECTION[run]];
+}
+
+// Random bytes, half of them drawn from the extremes, which stress rounding
+static void build_frame(uint32_t seed)
+{
+    static const uint8_t EXTREMES[] = {0, 1, 254, 255};
+    for (unsigned int run = 0; run < RUN_COUNT; ++run) {
+        for (size_t byte = 0; byte < LED_COUNT[run] * 3; ++byte) {
+            seed = seed * 1103515245u + 12345u;
+            run_rgb[run][byte] = seed % 2 == 0 ? (uint8_t)(seed >> 16) : EXTREMES[(seed >> 16) % 4];
+        }
+    }
+}
+
+// LED `led` of a section of `leds` LEDs at `rgb`, from the samples the
+// sender picks: the nearest sample positions at or below and above it
+static void reference_led(const uint8_t *rgb, size_t leds, unsigned int stride, size_t led,
+                          uint8_t *out)
+{
+    size_t last = leds - 1;
+    size_t from = led / stride * stride;
+    size_t to = from + stride < last ? from + stride : last;
+    for (unsigned int channel = 0; channel < 3; ++channel) {
+        double a = rgb[from * 3 + channel];
+        double b = rgb[to * 3 + channel];
+        double value = to == from ? a : a + (b - a) * (double)(led - from) / (double)(to - from);
+        out[channel] = (uint8_t)floor(value + 0.5);
+    }
+}
+
+static void build_expected(unsigned int stride)
+{
+    for (unsigned int run = 0; run < RUN_COUNT; ++run) {
+        for (unsigned int section = 0; section < RUN_SECTION_COUNT[run]; ++section) {
+            unsigned int index = RUN_FIRST_SECTION[run] + section;
+            const uint8_t *rgb = run_rgb[run] + SECTION_FIRST_LED[index] * 3;
+            uint8_t *out = expected[run] + SECTION_FIRST_LED[index] * 3;
+            for (size_t led = 0; led < SECTION_LED_COUNT[index]; ++led) {
+                reference_led(rgb, SECTION_LED_COUNT[index], stride, led, out + led * 3);
+            }
+        }
+    }
+}
+
+static size_t encode_sampled(uint32_t frame_id, unsigned int run, unsigned int stride,
+                             unsigned int index)
+{
+    size_t length = loadgen_encode_sampled_fragment(frame_id, run, run_rgb[run], run_sections(run),
+                                                    RUN_SECTION_COUNT[run], stride, index,
+                                                    datagram);
+    TEST_ASSERT_GREATER_THAN_UINT32(0, length);
+    return length;
+}
+
+static void send_sampled_run(uint32_t frame_id, unsigned int run, unsigned int stride)
+{
+    unsigned int count =
+        loadgen_sampled_fragment_count(run_sections(run), RUN_SECTION_COUNT[run], stride);
+    TEST_ASSERT_GREATER_THAN_UINT32(0, count);
+    for (unsigned int index = 0; index < count; ++index) {
+        rx_task_process_extended(datagram, encode_sampled(frame_id, run, stride, index));
+    }
+}
+
+// A run with a section too long for one datagram at `stride` goes as RGB
+// fragments, as the load generator sends it, and arrives exactly as sent
+static void send_rgb_run(uint32_t frame_id, unsigned int run)
+{
+    memcpy(expected[run], run_rgb[run], LED_COUNT[run] * 3);
+    unsigned int count = loadgen_fragment_count(LED_COUNT[run], 0);
+    for (unsigned int index = 0; index < count; ++index) {
+        size_t length = loadgen_encode_fragment(frame_id, run, run_rgb[run], LED_COUNT[run], 0,
+                                                index, datagram);
+        TEST_ASSERT_GREATER_THAN_UINT32(0, length);
+        rx_task_process_extended(datagram, length);
+    }
+}
+
+static uint32_t metric_since(const metrics_snapshot_t *before, metric_id_t id)
+{
+    metrics_snapshot_t after;
+    metrics_snapshot_t delta;
+    metrics_snapshot(&after);
+    metrics_delta(&after, before, &delta);
+    return delta.value[id];
+}
+
+static void assert_frame_matches(uint32_t frame_id)
+{
+    rx_frame_t *frame = rx_task_acquire_frame();
+    TEST_ASSERT_NOT_NULL(frame);
+    TEST_ASSERT_EQUAL_UINT32(frame_id, frame->frame_id);
+    for (unsigned int run = 0; run < RUN_COUNT; ++run) {
+        TEST_ASSERT_EQUAL_UINT8_ARRAY(expected[run], frame->run_buffers[run], LED_COUNT[run] * 3);
+    }
+}
+
+void setUp(void)
+{
+    rx_task_start();
+    for (unsigned int run = 0; run < RUN_COUNT; ++run) {
+        run_rgb[run] = (uint8_t *)malloc(LED_COUNT[run] * 3);
+        expected[run] = (uint8_t *)malloc(LED_COUNT[run] * 3);
+    }
+}
+
+void tearDown(void)
+{
+    for (unsigned int run = 0; run < RUN_COUNT; ++run) {
+        free(run_rgb[run]);
+        free(expected[run]);
+    }
+}
+
+void test_section_tables_cover_every_run(void)
+{
+    unsigned int next_section = 0;
+    for (unsigned int run = 0; run < RUN_COUNT; ++run) {
+        TEST_ASSERT_EQUAL_UINT(next_section, RUN_FIRST_SECTION[run]);
+        TEST_ASSERT_GREATER_THAN_UINT32(0, RUN_SECTION_COUNT[run]);
+        unsigned int first_led = 0;
+        for (unsigned int section = 0; section < RUN_SECTION_COUNT[run]; ++section) {
+            TEST_ASSERT_EQUAL_UINT(first_led, SECTION_FIRST_LED[next_section]);
+            first_led += SECTION_LED_COUNT[next_section++];
+        }
+        TEST_ASSERT_EQUAL_UINT(LED_COUNT[run], first_led);
+    }
+    TEST_ASSERT_EQUAL_UINT(SECTION_COUNT, next_section);
+}
+
+void test_encoder_samples_whole_sections(void)
+{
+    // Five LEDs at stride 2 are sampled at 0, 2 and 4; a lone LED once
+    const uint8_t RGB[] = {1, 1, 1, 2, 2, 2, 3, 3, 3, 4, 4, 4, 5, 5, 5, 6, 6, 6};
+    const unsigned int SECTIONS[] = {5, 1};
+    TEST_ASSERT_EQUAL_UINT(3, loadgen_section_samples(5, 2));
+    TEST_ASSERT_EQUAL_UINT(3, loadgen_section_samples(6, 4));
+    TEST_ASSERT_EQUAL_UINT(1, loadgen_section_samples(1, 4));
+    size_t length = loadgen_encode_sampled_fragment(9, 1, RGB, SECTIONS, 2, 2, 0, datagram);
+    const uint8_t BLOCK[] = {1, RX_ENCODING_SAMPLED, 0, 1, 0, 0, 0, 3 + 4 * 3,
+                             0, 6, 2, 1, 1, 1, 3, 3, 3, 5, 5, 5, 6, 6, 6};
+    TEST_ASSERT_EQUAL_size_t(LOADGEN_EXTENDED_HEADER_BYTES + sizeof(BLOCK), length);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(BLOCK, datagram + LOADGEN_EXTENDED_HEADER_BYTES, sizeof(BLOCK));
+
+    // Sections that do not share a datagram start the next fragment; one
+    // that fits no datagram cannot be sampled at that stride
+    const unsigned int LONG[] = {400, 400, 400};
+    TEST_ASSERT_EQUAL_UINT(3, loadgen_sampled_fragment_count(LONG, 3, 1));
+    TEST_ASSERT_EQUAL_UINT(1, loadgen_sampled_fragment_count(LONG, 3, 4));
+    const unsigned int HUGE[] = {500};
+    TEST_ASSERT_EQUAL_UINT(0, loadgen_sampled_fragment_count(HUGE, 1, 1));
+    TEST_ASSERT_EQUAL_UINT(1, loadgen_sampled_fragment_count(HUGE, 1, 2));
+    TEST_ASSERT_EQUAL_UINT(0, loadgen_sampled_fragment_count(HUGE, 1, 0));
+    TEST_ASSERT_EQUAL_UINT(0, loadgen_sampled_fragment_count(HUGE, 1, 129));
+    static uint8_t long_rgb[1200 * 3];
+    length = loadgen_encode_sampled_fragment(9, 0, long_rgb, LONG, 3, 1, 2, datagram);
+    TEST_ASSERT_EQUAL_size_t(LOADGEN_EXTENDED_HEADER_BYTES + LOADGEN_BLOCK_HEADER_BYTES +
+                                 LOADGEN_SAMPLED_HEADER_BYTES + 400 * 3,
+                             length);
+    TEST_ASSERT_EQUAL_UINT8(2, datagram[LOADGEN_EXTENDED_HEADER_BYTES + 2]);
+    TEST_ASSERT_EQUAL_UINT8(3, datagram[LOADGEN_EXTENDED_HEADER_BYTES + 3]);
+    TEST_ASSERT_EQUAL_UINT16(800, (datagram[LOADGEN_EXTENDED_HEADER_BYTES + 4] << 8) |
+                                      datagram[LOADGEN_EXTENDED_HEADER_BYTES + 5]);
+}
+
+void test_interpolation_matches_reference(void)
+{
+    static const unsigned int STRIDES[] = {1, 2, 3, 4, 5, 8, 13, 16, 33, 64, 127, 128};
+    uint32_t frame_id = 1;
+    for (size_t stride = 0; stride < sizeof(STRIDES) / sizeof(STRIDES[0]); ++stride) {
+        for (uint32_t seed = 0; seed < 4; ++seed, ++frame_id) {
+            build_frame(0x5EC7u + (uint32_t)stride * 16 + seed);
+            build_expected(STRIDES[stride]);
+            if (STRIDES[stride] == 1) {
+                // Every LED is its own sample
+                TEST_ASSERT_EQUAL_UINT8_ARRAY(run_rgb[0], expected[0], LED_COUNT[0] * 3);
+            }
+            for (unsigned int run = 0; run < RUN_COUNT; ++run) {
+                if (loadgen_sampled_fragment_count(run_sections(run), RUN_SECTION_COUNT[run],
+                                                   STRIDES[stride]) == 0) {
+                    send_rgb_run(frame_id, run);
+                } else {
+                    send_sampled_run(frame_id, run, STRIDES[stride]);
+                }
+            }
+            assert_frame_matches(frame_id);
+        }
+    }
+}
+
+void test_sampled_runs_mix_with_run_datagrams(void)
+{
+    build_frame(0x5EC8u);
+    build_expected(6);
+    send_sampled_run(1, 0, 6);
+    for (unsigned int run = 1; run < RUN_COUNT; ++run) {
+        // Plain runs arrive as sent
+        memcpy(expected[run], run_rgb[run], LED_COUNT[run] * 3);
+        uint8_t *packet = malloc(4 + LED_COUNT[run] * 3);
+        loadgen_write_frame_id(packet, 1);
+        memcpy(packet + 4, run_rgb[run], LED_COUNT[run] * 3);
+        rx_task_process_packet(run, packet, 4 + LED_COUNT[run] * 3);
+        free(packet);
+    }
+    assert_frame_matches(1);
+}
+
+// Rewrites the single block of `datagram` as fragment `index` of `count`
+// starting at first_led
+static void refragment(unsigned int index, unsigned int count, unsigned int first_led)
+{
+    uint8_t *block = datagram + LOADGEN_EXTENDED_HEADER_BYTES;
+    block[2] = (uint8_t)index;
+    block[3] = (uint8_t)count;
+    block[4] = (uint8_t)(first_led >> 8);
+    block[5] = (uint8_t)first_led;
+}
+
+void test_sections_split_across_fragments(void)
+{
+    unsigned int run = 0;
+    while (run < RUN_COUNT && RUN_SECTION_COUNT[run] < 2) {
+        ++run;
+    }
+    if (run == RUN_COUNT) {
+        TEST_IGNORE_MESSAGE("needs a run of two sections");
+    }
+    build_frame(0x5EC9u);
+    build_expected(7);
+    for (unsigned int other = 0; other < RUN_COUNT; ++other) {
+        if (other != run) {
+            send_sampled_run(1, other, 7);
+        }
+    }
+    // The first section, then the rest, each encoded as a run of its own
+    const unsigned int *sections = run_sections(run);
+    size_t length =
+        loadgen_encode_sampled_fragment(1, run, run_rgb[run], sections, 1, 7, 0, datagram);
+    refragment(0, 2, 0);
+    rx_task_process_extended(datagram, length);
+    TEST_ASSERT_NULL(rx_task_acquire_frame());
+    length = loadgen_encode_sampled_fragment(1, run, run_rgb[run] + sections[0] * 3, sections + 1,
+                                             RUN_SECTION_COUNT[run] - 1, 7, 0, datagram);
+    refragment(1, 2, sections[0]);
+    rx_task_process_extended(datagram, length);
+    assert_frame_matches(1);
+}
+
+// Sends a copy of the good datagram with one byte rewritten
+static void send_with(const uint8_t *good, size_t length, size_t at, uint8_t value)
+{
+    memcpy(datagram, good, length);
+    datagram[at] = value;
+    rx_task_process_extended(datagram, length);
+}
+
+static void send_resized(const uint8_t *good, size_t length, size_t new_length)
+{
+    memcpy(datagram, good, length);
+    size_t payload_bytes = new_length - LOADGEN_EXTENDED_HEADER_BYTES - LOADGEN_BLOCK_HEADER_BYTES;
+    datagram[LOADGEN_EXTENDED_HEADER_BYTES + 6] = (uint8_t)(payload_bytes >> 8);
+    datagram[LOADGEN_EXTENDED_HEADER_BYTES + 7] = (uint8_t)payload_bytes;
+    rx_task_process_extended(datagram, new_length);
+}
+
+void test_malformed_sampled_blocks_are_dropped_as_len(void)
+{
+    static uint8_t good[LOADGEN_UDP_MAX_PAYLOAD + 1];
+    build_frame(0x5ECAu);
+    size_t length = encode_sampled(1, 0, 4, 0);
+    memcpy(good, datagram, length);
+    const size_t block = LOADGEN_EXTENDED_HEADER_BYTES;
+    const size_t payload = block + LOADGEN_BLOCK_HEADER_BYTES;
+    unsigned int leds = LED_COUNT[0];
+
+    metrics_snapshot_t before;
+    metrics_snapshot(&before);
+    uint32_t drops = 0;
+    // Strides of 0 and past RX_SAMPLED_MAX_STRIDE
+    send_with(good, length, payload + 2, 0);
+    ++drops;
+    send_with(good, length, payload + 2, RX_SAMPLED_MAX_STRIDE + 1);
+    ++drops;
+    // A stride disagreeing with the sample count
+    send_with(good, length, payload + 2, 5);
+    ++drops;
+    // Starting inside a section, or past the run
+    send_with(good, length, block + 5, 1);
+    ++drops;
+    send_with(good, length, block + 4, (uint8_t)(leds >> 8) + 4);
+    ++drops;
+    // Ending inside a section, or covering nothing
+    send_with(good, length, payload + 1, (uint8_t)(leds - 1));
+    ++drops;
+    memcpy(datagram, good, length);
+    datagram[payload] = 0;
+    datagram[payload + 1] = 0;
+    rx_task_process_extended(datagram, length);
+    ++drops;
+    // One byte short or long, or too short for the header
+    send_resized(good, length, length - 1);
+    ++drops;
+    send_resized(good, length, length + 1);
+    ++drops;
+    send_resized(good, length, payload + 2);
+    ++drops;
+    TEST_ASSERT_EQUAL_UINT32(drops, metric_since(&before, METRIC_DROPS_LEN));
+    TEST_ASSERT_EQUAL_UINT32(0, metric_since(&before, METRIC_RX_FRAMES));
+
+    memcpy(datagram, good, length);
+    rx_task_process_extended(datagram, length);
+    TEST_ASSERT_EQUAL_UINT32(1, metric_since(&before, METRIC_RX_FRAMES));
+}
+
+int main(void)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_section_tables_cover_every_run);
+    RUN_TEST(test_encoder_samples_whole_sections);
+    RUN_TEST(test_interpolation_matches_reference);
+    RUN_TEST(test_sampled_runs_mix_with_run_datagrams);
+    RUN_TEST(test_sections_split_across_fragments);
+    RUN_TEST(test_malformed_sampled_blocks_are_dropped_as_len);
+    return UNITY_END();
+}
@@ -1,6 +1,7 @@
 #include "unity.h"
 #include "rx_task.h"
 #include "config_autogen.h"
+#include "metrics.h"
 #include <stdlib.h>
 #include <string.h>
 
@@ -17,7 +18,7 @@ void test_invalid_length_ignored(void) {
     memset(packet, 0, len);
     packet[3] = 1;
     rx_task_process_packet(0, packet, len);
-    TEST_ASSERT_FALSE(rx_task_run_received(0, 0));
+    TEST_ASSERT_FALSE(rx_task_run_received(rx_task_slot_index(1), 0));
     free(packet);
 }
 
@@ -30,56 +31,277 @@ void test_copy_payload_without_reordering(void) {
     packet[5] = 2; // G
     packet[6] = 3; // B
     rx_task_process_packet(0, packet, length);
-    const uint8_t *buffer = rx_task_get_run_buffer(0, 0);
+    const uint8_t *buffer = rx_task_get_run_buffer(rx_task_slot_index(1), 0);
     TEST_ASSERT_EQUAL_UINT8(1, buffer[0]);
     TEST_ASSERT_EQUAL_UINT8(2, buffer[1]);
     TEST_ASSERT_EQUAL_UINT8(3, buffer[2]);
     free(packet);
 }
 
-void test_frame_slots_only_keep_current_and_next(void) {
-    // complete frame 1 for all runs
+static uint8_t *acquire_packet(unsigned int run, uint32_t frame_id) {
+    uint8_t *buffer = rx_task_acquire_rx_buffer(run);
+    TEST_ASSERT_NOT_NULL(buffer);
+    memset(buffer, 0, 4 + LED_COUNT[run] * 3);
+    buffer[0] = (uint8_t)(frame_id >> 24);
+    buffer[1] = (uint8_t)(frame_id >> 16);
+    buffer[2] = (uint8_t)(frame_id >> 8);
+    buffer[3] = (uint8_t)frame_id;
+    return buffer;
+}
+
+static void receive_run(unsigned int run, uint32_t frame_id) {
+    rx_task_process_rx_buffer(run, acquire_packet(run, frame_id), 4 + LED_COUNT[run] * 3);
+}
+
+void test_ring_holds_slot_count_frames(void) {
+    if (RUN_COUNT < 2) {
+        TEST_IGNORE_MESSAGE("needs two runs to leave frames incomplete");
+    }
+    for (uint32_t frame_id = 1; frame_id <= RX_SLOT_COUNT; ++frame_id) {
+        receive_run(0, frame_id);
+    }
+    for (uint32_t frame_id = 1; frame_id <= RX_SLOT_COUNT; ++frame_id) {
+        int slot = rx_task_slot_index(frame_id);
+        TEST_ASSERT_EQUAL_UINT32(frame_id, rx_task_get_frame_id(slot));
+        TEST_ASSERT_TRUE(rx_task_run_received(slot, 0));
+        TEST_ASSERT_FALSE(rx_task_run_received(slot, 1));
+    }
+    TEST_ASSERT_NULL(rx_task_acquire_frame());
+}
+
+void test_frame_a_window_ahead_evicts_incomplete_frame(void) {
+    if (RUN_COUNT < 2) {
+        TEST_IGNORE_MESSAGE("needs two runs to leave a frame incomplete");
+    }
+    receive_run(0, 1);
+    receive_run(1, 1 + RX_SLOT_COUNT);
+    int slot = rx_task_slot_index(1);
+    TEST_ASSERT_EQUAL_UINT32(1 + RX_SLOT_COUNT, rx_task_get_frame_id(slot));
+    TEST_ASSERT_FALSE(rx_task_run_received(slot, 0));
+    TEST_ASSERT_TRUE(rx_task_run_received(slot, 1));
+
+    // The evicted frame cannot reclaim the slot
+    receive_run(1, 1);
+    TEST_ASSERT_EQUAL_UINT32(1 + RX_SLOT_COUNT, rx_task_get_frame_id(slot));
+}
+
+void test_interleaved_frames_complete_independently(void) {
+    // Runs of frames 1..3 arrive interleaved and in reverse run order
+    for (int run = RUN_COUNT - 1; run >= 0; --run) {
+        for (uint32_t frame_id = 1; frame_id <= 3; ++frame_id) {
+            receive_run((unsigned int)run, frame_id);
+        }
+    }
+    // Each frame completed in turn; the newest one is handed over
+    rx_frame_t *frame = rx_task_acquire_frame();
+    TEST_ASSERT_NOT_NULL(frame);
+    TEST_ASSERT_EQUAL_UINT32(3, frame->frame_id);
+    TEST_ASSERT_NULL(rx_task_acquire_frame());
+}
+
+void test_publish_evicts_older_incomplete_frames(void) {
+    if (RUN_COUNT < 2) {
+        TEST_IGNORE_MESSAGE("needs two runs to leave a frame incomplete");
+    }
+    receive_run(0, 1);
+    receive_run(0, 2);
     for (unsigned int run = 0; run < RUN_COUNT; ++run) {
-        size_t len = 4 + LED_COUNT[run] * 3;
-        uint8_t *packet = (uint8_t *)malloc(len);
-        memset(packet, 0, len);
-        packet[3] = 1;
-        rx_task_process_packet(run, packet, len);
-        free(packet);
-    }
-    TEST_ASSERT_EQUAL_UINT32(1, rx_task_get_frame_id(0));
-
-    size_t len0 = 4 + LED_COUNT[0] * 3;
-    uint8_t *packet = (uint8_t *)malloc(len0);
-    memset(packet, 0, len0);
-
-    // send frame 2 for run 0
-    packet[3] = 2;
-    rx_task_process_packet(0, packet, len0);
+        receive_run(run, 3);
+    }
+    TEST_ASSERT_EQUAL_UINT32(0, rx_task_get_frame_id(rx_task_slot_index(1)));
+    TEST_ASSERT_EQUAL_UINT32(0, rx_task_get_frame_id(rx_task_slot_index(2)));
+    TEST_ASSERT_EQUAL_UINT32(3, rx_task_get_frame_id(rx_task_slot_index(3)));
+
+    // Late runs of the evicted frames are stale and never complete them
+    for (unsigned int run = 1; run < RUN_COUNT; ++run) {
+        receive_run(run, 1);
+        receive_run(run, 2);
+    }
+    TEST_ASSERT_EQUAL_UINT32(3, rx_task_acquire_frame()->frame_id);
+    TEST_ASSERT_NULL(rx_task_acquire_frame());
+}
+
+void test_ring_survives_frame_id_wraparound(void) {
+    const uint32_t frame_ids[] = {0xFFFFFFFEu, 0xFFFFFFFFu, 1u};
+    for (size_t index = 0; index < 3; ++index) {
+        for (unsigned int run = 0; run < RUN_COUNT; ++run) {
+            receive_run(run, frame_ids[index]);
+        }
+        rx_frame_t *frame = rx_task_acquire_frame();
+        TEST_ASSERT_NOT_NULL(frame);
+        TEST_ASSERT_EQUAL_UINT32(frame_ids[index], frame->frame_id);
+    }
+    // Frames from before the wrap are stale
+    receive_run(0, 0xFFFFFFFFu);
+    TEST_ASSERT_FALSE(rx_task_run_received(rx_task_slot_index(0xFFFFFFFFu), 0));
+}
+
+void test_received_buffer_becomes_run_buffer(void) {
+    size_t free_before = rx_task_free_rx_buffers(0);
+    uint8_t *buffer = acquire_packet(0, 1);
+    buffer[4] = 42;
+    rx_task_process_rx_buffer(0, buffer, 4 + LED_COUNT[0] * 3);
+    int slot = rx_task_slot_index(1);
     if (RUN_COUNT > 1) {
-        TEST_ASSERT_EQUAL_UINT32(2, rx_task_get_frame_id(1));
-
-        // send frame 3 which should be ignored because slots are full
-        packet[3] = 3;
-        rx_task_process_packet(0, packet, len0);
-        TEST_ASSERT_EQUAL_UINT32(2, rx_task_get_frame_id(1));
-    } else {
-        // with a single run, frame 2 becomes the current frame
-        TEST_ASSERT_EQUAL_UINT32(2, rx_task_get_frame_id(1));
-        TEST_ASSERT_EQUAL_UINT32(0, rx_task_get_frame_id(0));
-
-        packet[3] = 3;
-        rx_task_process_packet(0, packet, len0);
-        TEST_ASSERT_EQUAL_UINT32(3, rx_task_get_frame_id(0));
-        TEST_ASSERT_EQUAL_UINT32(0, rx_task_get_frame_id(1));
+        // Payload is used in place, not copied
+        TEST_ASSERT_EQUAL_PTR(buffer + 4, rx_task_get_run_buffer(slot, 0));
     }
+    TEST_ASSERT_EQUAL_UINT8(42, rx_task_get_run_buffer(slot, 0)[0]);
+    // The slot's previous buffer went back to the pool in exchange
+    TEST_ASSERT_EQUAL(free_before, rx_task_free_rx_buffers(0));
+}
+
+void test_pool_exhaustion_returns_null(void) {
+    size_t free_before = rx_task_free_rx_buffers(0);
+    TEST_ASSERT_TRUE(free_before > 0);
+    uint8_t *held[16];
+    size_t held_count = 0;
+    uint8_t *buffer;
+    while ((buffer = rx_task_acquire_rx_buffer(0)) != NULL) {
+        TEST_ASSERT_TRUE(held_count < 16);
+        held[held_count++] = buffer;
+    }
+    TEST_ASSERT_EQUAL(free_before, held_count);
+    TEST_ASSERT_EQUAL(0, rx_task_free_rx_buffers(0));
+
+    // Copying reception drops rather than overwriting a slot buffer
+    size_t length = 4 + LED_COUNT[0] * 3;
+    uint8_t *packet = (uint8_t *)calloc(length, 1);
+    packet[3] = 1;
+    rx_task_process_packet(0, packet, length);
+    TEST_ASSERT_FALSE(rx_task_run_received(rx_task_slot_index(1), 0));
     free(packet);
+
+    for (size_t index = 0; index < held_count; ++index) {
+        rx_task_release_rx_buffer(0, held[index]);
+    }
+    TEST_ASSERT_EQUAL(free_before, rx_task_free_rx_buffers(0));
+}
+
+void test_dropped_buffers_return_to_pool(void) {
+    size_t free_before = rx_task_free_rx_buffers(0);
+    for (unsigned int run = 0; run < RUN_COUNT; ++run) {
+        rx_task_process_rx_buffer(run, acquire_packet(run, 10), 4 + LED_COUNT[run] * 3);
+    }
+    TEST_ASSERT_EQUAL(free_before, rx_task_free_rx_buffers(0));
+
+    // Stale frame_id
+    rx_task_process_rx_buffer(0, acquire_packet(0, 9), 4 + LED_COUNT[0] * 3);
+    TEST_ASSERT_EQUAL(free_before, rx_task_free_rx_buffers(0));
+    // Duplicate of the already published frame
+    rx_task_process_rx_buffer(0, acquire_packet(0, 10), 4 + LED_COUNT[0] * 3);
+    TEST_ASSERT_EQUAL(free_before, rx_task_free_rx_buffers(0));
+    // Wrong length
+    rx_task_process_rx_buffer(0, acquire_packet(0, 11), 3 + LED_COUNT[0] * 3);
+    TEST_ASSERT_EQUAL(free_before, rx_task_free_rx_buffers(0));
+    TEST_ASSERT_EQUAL_UINT32(10, rx_task_get_frame_id(rx_task_slot_index(10)));
+}
+
+void test_evicted_slot_keeps_pool_balanced(void) {
+    if (RUN_COUNT < 2) {
+        TEST_IGNORE_MESSAGE("needs two runs to leave a frame incomplete");
+    }
+    size_t free_before[RUN_COUNT];
+    for (unsigned int run = 0; run < RUN_COUNT; ++run) {
+        free_before[run] = rx_task_free_rx_buffers(run);
+    }
+    // Frame 1 stays incomplete in its slot
+    receive_run(0, 1);
+    // Frame 2 completes in the next slot and evicts frame 1
+    for (unsigned int run = 0; run < RUN_COUNT; ++run) {
+        receive_run(run, 2);
+    }
+    TEST_ASSERT_EQUAL_UINT32(0, rx_task_get_frame_id(rx_task_slot_index(1)));
+    TEST_ASSERT_FALSE(rx_task_run_received(rx_task_slot_index(1), 0));
+    // The evicted slot's bank still owns frame 1's buffer, so nothing leaked
+    // and nothing was returned twice
+    for (unsigned int run = 0; run < RUN_COUNT; ++run) {
+        TEST_ASSERT_EQUAL(free_before[run], rx_task_free_rx_buffers(run));
+    }
+    rx_frame_t *frame = rx_task_acquire_frame();
+    TEST_ASSERT_NOT_NULL(frame);
+    TEST_ASSERT_EQUAL_UINT32(2, frame->frame_id);
+    // A frame a full window later reuses the evicted slot; the driver's
+    // buffers are untouched
+    const uint8_t *driver_run0 = frame->run_buffers[0];
+    for (unsigned int run = 0; run < RUN_COUNT; ++run) {
+        receive_run(run, 1 + RX_SLOT_COUNT);
+    }
+    TEST_ASSERT_EQUAL_PTR(driver_run0, rx_task_driver_frame()->run_buffers[0]);
+    for (unsigned int run = 0; run < RUN_COUNT; ++run) {
+        TEST_ASSERT_EQUAL(free_before[run], rx_task_free_rx_buffers(run));
+    }
+}
+
+void test_drops_are_counted_by_reason(void) {
+    metrics_snapshot_t before;
+    metrics_snapshot(&before);
+
+    uint8_t short_packet[4] = {0, 0, 0, 1};
+    rx_task_process_packet(0, short_packet, sizeof(short_packet));
+    rx_task_process_packet(RUN_COUNT, short_packet, sizeof(short_packet));
+    for (unsigned int run = 0; run < RUN_COUNT; ++run) {
+        receive_run(run, 5);
+    }
+    receive_run(0, 4);
+    if (RUN_COUNT > 1) {
+        // Frame 6 + RX_SLOT_COUNT holds the slot frame 6 would need
+        receive_run(0, 6 + RX_SLOT_COUNT);
+        receive_run(1, 6);
+    }
+
+    metrics_snapshot_t after;
+    metrics_snapshot_t delta;
+    metrics_snapshot(&after);
+    metrics_delta(&after, &before, &delta);
+    TEST_ASSERT_EQUAL_UINT32(1, delta.value[METRIC_DROPS_LEN]);
+    TEST_ASSERT_EQUAL_UINT32(1, delta.value[METRIC_DROPS_RUN]);
+    TEST_ASSERT_EQUAL_UINT32(1, delta.value[METRIC_DROPS_STALE]);
+    TEST_ASSERT_EQUAL_UINT32(RUN_COUNT > 1 ? 1 : 0, delta.value[METRIC_DROPS_WINDOW]);
+    TEST_ASSERT_EQUAL_UINT32(0, delta.value[METRIC_DROPS_POOL]);
+    TEST_ASSERT_EQUAL_UINT32(1, delta.value[METRIC_COMPLETE]);
+}
+
+void test_gaps_and_per_run_counters(void) {
+    metrics_snapshot_t before;
+    metrics_snapshot(&before);
+
+    for (unsigned int run = 0; run < RUN_COUNT; ++run) {
+        receive_run(run, 20);
+    }
+    // Frames 21 and 22 never arrive
+    for (unsigned int run = 0; run < RUN_COUNT; ++run) {
+        receive_run(run, 23);
+    }
+    uint8_t short_packet[4] = {0, 0, 0, 24};
+    rx_task_process_packet(RUN_COUNT - 1, short_packet, sizeof(short_packet));
+
+    metrics_snapshot_t after;
+    metrics_snapshot_t delta;
+    metrics_snapshot(&after);
+    metrics_delta(&after, &before, &delta);
+    TEST_ASSERT_EQUAL_UINT32(2, delta.value[METRIC_FRAMES_SKIPPED]);
+    TEST_ASSERT_EQUAL_UINT32(1, delta.value[METRIC_FRAME_GAPS]);
+    for (unsigned int run = 0; run < RUN_COUNT; ++run) {
+        TEST_ASSERT_EQUAL_UINT32(2, delta.value[METRIC_RUN_RX + run]);
+    }
+    TEST_ASSERT_EQUAL_UINT32(1, delta.value[METRIC_RUN_DROPS + RUN_COUNT - 1]);
 }
 
 int main(void) {
     UNITY_BEGIN();
     RUN_TEST(test_invalid_length_ignored);
     RUN_TEST(test_copy_payload_without_reordering);
-    RUN_TEST(test_frame_slots_only_keep_current_and_next);
+    RUN_TEST(test_ring_holds_slot_count_frames);
+    RUN_TEST(test_frame_a_window_ahead_evicts_incomplete_frame);
+    RUN_TEST(test_interleaved_frames_complete_independently);
+    RUN_TEST(test_publish_evicts_older_incomplete_frames);
+    RUN_TEST(test_ring_survives_frame_id_wraparound);
+    RUN_TEST(test_received_buffer_becomes_run_buffer);
+    RUN_TEST(test_pool_exhaustion_returns_null);
+    RUN_TEST(test_dropped_buffers_return_to_pool);
+    RUN_TEST(test_evicted_slot_keeps_pool_balanced);
+    RUN_TEST(test_drops_are_counted_by_reason);
+    RUN_TEST(test_gaps_and_per_run_counters);
     return UNITY_END();
 }
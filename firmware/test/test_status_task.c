@@ -1,26 +1,28 @@
 #include "unity.h"
 #include "status_task.h"
 #include "config_autogen.h"
+#include "latency_stats.h"
 #include <stdio.h>
 #include <string.h>
 
-void setUp(void) { status_task_reset_counters(); }
+void setUp(void) { latency_stats_reset(); }
 void tearDown(void) {}
 
 void test_format_json(void) {
-    status_task_increment_rx_frames();
-    status_task_increment_complete();
-    status_task_increment_applied();
-    status_task_increment_drops();
+    telemetry_interval_t interval = {0};
+    interval.metrics.value[METRIC_RX_FRAMES] = 1;
+    interval.metrics.value[METRIC_COMPLETE] = 1;
+    interval.metrics.value[METRIC_APPLIED] = 1;
+    interval.metrics.value[METRIC_DROPS_STALE] = 1;
 
-    char json_buffer[256];
-    size_t json_length = status_task_format_json(json_buffer, sizeof(json_buffer), 123, true);
+    char json_buffer[512];
+    size_t json_length = status_task_format_json(json_buffer, sizeof(json_buffer), 123, 1000, true, &interval, NULL, 0);
 
     const char *side_str = SIDE_ID == 0 ? "LEFT" : "RIGHT";
-    char expected[256];
+    char expected[512];
     size_t offset = 0;
     offset += snprintf(expected + offset, sizeof(expected) - offset,
-                       "{\"id\":\"%s\",\"ip\":\"%u.%u.%u.%u\",\"uptime_ms\":123,\"link\":true,\"runs\":%u,\"leds\":[",
+                       "{\"id\":\"%s\",\"ip\":\"%u.%u.%u.%u\",\"uptime_ms\":123,\"interval_ms\":1000,\"link\":true,\"runs\":%u,\"leds\":[",
                        side_str, STATIC_IP_ADDR0, STATIC_IP_ADDR1, STATIC_IP_ADDR2, STATIC_IP_ADDR3, RUN_COUNT);
     for (unsigned int i = 0; i < RUN_COUNT; ++i) {
         offset += snprintf(expected + offset, sizeof(expected) - offset, "%u", LED_COUNT[i]);
@@ -29,14 +31,82 @@ void test_format_json(void) {
         }
     }
     offset += snprintf(expected + offset, sizeof(expected) - offset,
-                       "],\"rx_frames\":1,\"complete\":1,\"applied\":1,\"dropped_frames\":1,\"errors\":[]}");
+                       "],\"budget\":{\"fps\":%u,\"parallel_us\":%u,\"serial_us\":%u,\"kbps\":%u}",
+                       TARGET_FPS, FRAME_PERIOD_PARALLEL_US, FRAME_PERIOD_SERIAL_US,
+                       NETWORK_KBPS_AT_TARGET);
+    offset += snprintf(expected + offset, sizeof(expected) - offset,
+                       ",\"rx_frames\":1,\"complete\":1,\"applied\":1,\"dropped_frames\":1,"
+                       "\"drops\":{\"len\":0,\"run\":0,\"stale\":1,\"window\":0,\"pool\":0,\"base\":0},\"recovered\":0,\"events_lost\":0,"
+                       "\"latency_us\":{\"assemble\":[0,0,0],\"handoff\":[0,0,0],\"encode\":[0,0,0],"
+                       "\"transmit\":[0,0,0],\"total\":[0,0,0]},\"errors\":[]}");
 
     TEST_ASSERT_EQUAL(offset, json_length);
     TEST_ASSERT_EQUAL_STRING(expected, json_buffer);
 }
 
+void test_format_json_reports_latency(void) {
+    telemetry_reader_t reader;
+    telemetry_reader_init(&reader, LATENCY_READER_HEARTBEAT);
+    latency_stats_record(LATENCY_STAGE_TOTAL, 1000, 1000 + 5000);
+    telemetry_interval_t interval;
+    telemetry_reader_next(&reader, &interval);
+    char json_buffer[512];
+    status_task_format_json(json_buffer, sizeof(json_buffer), 0, 1000, true, &interval, NULL, 0);
+    // 5000 us falls in the [4096, 8191] bucket; both percentiles cap at max
+    TEST_ASSERT_NOT_NULL(strstr(json_buffer, "\"total\":[5000,5000,5000]"));
+}
+
+void test_worst_case_heartbeat_fits_buffer(void) {
+    telemetry_interval_t interval;
+    for (unsigned int id = 0; id < METRIC_COUNT; ++id) {
+        interval.metrics.value[id] = UINT32_MAX / 8;
+    }
+    for (unsigned int stage = 0; stage < LATENCY_STAGE_COUNT; ++stage) {
+        for (unsigned int index = 0; index < LATENCY_BUCKET_COUNT; ++index) {
+            interval.latency.buckets[stage][index] = 1;
+        }
+        interval.latency.max_us[stage] = UINT32_MAX;
+    }
+    event_t events[STATUS_MAX_EVENTS];
+    for (unsigned int index = 0; index < STATUS_MAX_EVENTS; ++index) {
+        events[index] = (event_t){.timestamp_ms = UINT32_MAX, .detail = UINT32_MAX,
+                                  .code = EVENT_RX_POOL_EXHAUSTED};
+    }
+    char json_buffer[STATUS_HEARTBEAT_MAX_BYTES];
+    size_t length = status_task_format_json(json_buffer, sizeof(json_buffer), UINT32_MAX,
+                                            UINT32_MAX, true, &interval, events,
+                                            STATUS_MAX_EVENTS);
+    TEST_ASSERT_TRUE(length < sizeof(json_buffer));
+}
+
+void test_events_fill_errors_array(void) {
+    telemetry_interval_t interval = {0};
+    event_t events[2] = {
+        {.timestamp_ms = 1500, .detail = 1, .code = EVENT_RMT_TIMEOUT},
+        {.timestamp_ms = 1700, .detail = 0, .code = EVENT_LINK_DOWN},
+    };
+    char json_buffer[STATUS_HEARTBEAT_MAX_BYTES];
+    status_task_format_json(json_buffer, sizeof(json_buffer), 0, 1000, true, &interval, events, 2);
+    TEST_ASSERT_NOT_NULL(strstr(json_buffer,
+                                "\"errors\":[\"1500: rmt_tx_wait_all_done timeout run 1\","
+                                "\"1700: ethernet link down\"]}"));
+}
+
+void test_longest_event_message_fits(void) {
+    event_t event = {.timestamp_ms = UINT32_MAX, .detail = UINT32_MAX};
+    char message[STATUS_EVENT_MESSAGE_BYTES];
+    for (unsigned int code = 0; code < EVENT_CODE_COUNT; ++code) {
+        event.code = (uint8_t)code;
+        TEST_ASSERT_TRUE(event_log_format(&event, message, sizeof(message)) < sizeof(message));
+    }
+}
+
 int main(void) {
     UNITY_BEGIN();
     RUN_TEST(test_format_json);
+    RUN_TEST(test_format_json_reports_latency);
+    RUN_TEST(test_worst_case_heartbeat_fits_buffer);
+    RUN_TEST(test_events_fill_errors_array);
+    RUN_TEST(test_longest_event_message_fits);
     return UNITY_END();
 }
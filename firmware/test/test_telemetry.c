@@ -0,0 +1,141 @@
+// Binary telemetry datagram encode/decode round trips.
+#include "unity.h"
+#include "telemetry.h"
+#include "config_autogen.h"
+#include <string.h>
+
+static telemetry_interval_t sample_interval(void)
+{
+    telemetry_interval_t interval;
+    for (unsigned int id = 0; id < METRIC_COUNT; ++id) {
+        interval.metrics.value[id] = 1000u * id + 7;
+    }
+    for (unsigned int stage = 0; stage < LATENCY_STAGE_COUNT; ++stage) {
+        for (unsigned int index = 0; index < LATENCY_BUCKET_COUNT; ++index) {
+            interval.latency.buckets[stage][index] = stage * 100 + index;
+        }
+        interval.latency.max_us[stage] = 0x01020304u * (stage + 1);
+    }
+    return interval;
+}
+
+static uint32_t read_u32_le(const uint8_t *in)
+{
+    return (uint32_t)in[0] | ((uint32_t)in[1] << 8) | ((uint32_t)in[2] << 16) |
+           ((uint32_t)in[3] << 24);
+}
+
+void setUp(void)
+{
+    latency_stats_reset();
+}
+
+void tearDown(void) {}
+
+void test_round_trip_preserves_every_field(void)
+{
+    telemetry_interval_t interval = sample_interval();
+    uint8_t datagram[TELEMETRY_DATAGRAM_BYTES];
+    TEST_ASSERT_EQUAL(TELEMETRY_DATAGRAM_BYTES,
+                      telemetry_encode(&interval, 42, 123456, true, datagram, sizeof(datagram)));
+
+    telemetry_header_t header;
+    telemetry_interval_t decoded;
+    TEST_ASSERT_TRUE(telemetry_decode(datagram, sizeof(datagram), &header, &decoded));
+    TEST_ASSERT_EQUAL_UINT8(TELEMETRY_VERSION, header.version);
+    TEST_ASSERT_EQUAL_UINT8(SIDE_ID, header.side);
+    TEST_ASSERT_EQUAL_UINT8(RUN_COUNT, header.run_count);
+    TEST_ASSERT_TRUE(header.link);
+    TEST_ASSERT_EQUAL_UINT32(42, header.sequence);
+    TEST_ASSERT_EQUAL_UINT32(123456, header.uptime_ms);
+    TEST_ASSERT_EQUAL_UINT32_ARRAY(interval.metrics.value, decoded.metrics.value, METRIC_COUNT);
+    TEST_ASSERT_EQUAL_UINT32_ARRAY(interval.latency.max_us, decoded.latency.max_us,
+                                   LATENCY_STAGE_COUNT);
+    TEST_ASSERT_EQUAL_UINT32_ARRAY(interval.latency.buckets, decoded.latency.buckets,
+                                   LATENCY_STAGE_COUNT * LATENCY_BUCKET_COUNT);
+}
+
+void test_fields_sit_at_documented_offsets(void)
+{
+    telemetry_interval_t interval = sample_interval();
+    uint8_t datagram[TELEMETRY_DATAGRAM_BYTES];
+    telemetry_encode(&interval, 0x0A0B0C0Du, 0, false, datagram, sizeof(datagram));
+    TEST_ASSERT_EQUAL_UINT8('B', datagram[0]);
+    TEST_ASSERT_EQUAL_UINT8('L', datagram[1]);
+    TEST_ASSERT_EQUAL_UINT8(0x0D, datagram[4]);
+    TEST_ASSERT_EQUAL_UINT8(0, datagram[15]);
+    TEST_ASSERT_EQUAL_UINT32(interval.metrics.value[METRIC_DROPS_STALE],
+                             read_u32_le(datagram + 16 + METRIC_DROPS_STALE * 4));
+    // Run 1's drop counter is the second field of the second run slot
+    TEST_ASSERT_EQUAL_UINT32(interval.metrics.value[METRIC_RUN_DROPS + 1],
+                             read_u32_le(datagram + 68 + (1 * 3 + 1) * 4));
+    const uint8_t *total = datagram + 116 + LATENCY_STAGE_TOTAL * TELEMETRY_STAGE_BYTES;
+    TEST_ASSERT_EQUAL_UINT32(interval.latency.max_us[LATENCY_STAGE_TOTAL], read_u32_le(total));
+    TEST_ASSERT_EQUAL_UINT8(interval.latency.buckets[LATENCY_STAGE_TOTAL][1], total[4 + 2]);
+}
+
+void test_buckets_saturate_at_sixteen_bits(void)
+{
+    telemetry_interval_t interval = {0};
+    interval.latency.buckets[LATENCY_STAGE_ENCODE][3] = 70000;
+    uint8_t datagram[TELEMETRY_DATAGRAM_BYTES];
+    telemetry_encode(&interval, 0, 0, true, datagram, sizeof(datagram));
+    telemetry_header_t header;
+    telemetry_interval_t decoded;
+    TEST_ASSERT_TRUE(telemetry_decode(datagram, sizeof(datagram), &header, &decoded));
+    TEST_ASSERT_EQUAL_UINT32(UINT16_MAX, decoded.latency.buckets[LATENCY_STAGE_ENCODE][3]);
+}
+
+void test_rejects_short_or_foreign_datagrams(void)
+{
+    telemetry_interval_t interval = {0};
+    uint8_t datagram[TELEMETRY_DATAGRAM_BYTES];
+    TEST_ASSERT_EQUAL(0, telemetry_encode(&interval, 0, 0, true, datagram, sizeof(datagram) - 1));
+    telemetry_encode(&interval, 0, 0, true, datagram, sizeof(datagram));
+
+    telemetry_header_t header;
+    telemetry_interval_t decoded;
+    TEST_ASSERT_FALSE(telemetry_decode(datagram, sizeof(datagram) - 1, &header, &decoded));
+    datagram[2] = TELEMETRY_VERSION + 1;
+    TEST_ASSERT_FALSE(telemetry_decode(datagram, sizeof(datagram), &header, &decoded));
+    datagram[0] = '{';
+    datagram[2] = TELEMETRY_VERSION;
+    TEST_ASSERT_FALSE(telemetry_decode(datagram, sizeof(datagram), &header, &decoded));
+}
+
+void test_readers_report_their_own_intervals(void)
+{
+    telemetry_reader_t heartbeat;
+    telemetry_reader_t telemetry;
+    telemetry_reader_init(&heartbeat, LATENCY_READER_HEARTBEAT);
+    telemetry_reader_init(&telemetry, LATENCY_READER_TELEMETRY);
+
+    metrics_increment_run(METRIC_RUN_RX, 0);
+    latency_stats_record(LATENCY_STAGE_TOTAL, 0, 300);
+    telemetry_interval_t interval;
+    telemetry_reader_next(&telemetry, &interval);
+    TEST_ASSERT_EQUAL_UINT32(1, interval.metrics.value[METRIC_RUN_RX]);
+    TEST_ASSERT_EQUAL_UINT32(300, interval.latency.max_us[LATENCY_STAGE_TOTAL]);
+
+    metrics_increment_run(METRIC_RUN_RX, 0);
+    telemetry_reader_next(&telemetry, &interval);
+    TEST_ASSERT_EQUAL_UINT32(1, interval.metrics.value[METRIC_RUN_RX]);
+    TEST_ASSERT_EQUAL_UINT32(0, interval.latency.max_us[LATENCY_STAGE_TOTAL]);
+
+    // The slower heartbeat still sees both increments and the span
+    telemetry_reader_next(&heartbeat, &interval);
+    TEST_ASSERT_EQUAL_UINT32(2, interval.metrics.value[METRIC_RUN_RX]);
+    TEST_ASSERT_EQUAL_UINT32(1, interval.latency.buckets[LATENCY_STAGE_TOTAL][9]);
+    TEST_ASSERT_EQUAL_UINT32(300, interval.latency.max_us[LATENCY_STAGE_TOTAL]);
+}
+
+int main(void)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_round_trip_preserves_every_field);
+    RUN_TEST(test_fields_sit_at_documented_offsets);
+    RUN_TEST(test_buckets_saturate_at_sixteen_bits);
+    RUN_TEST(test_rejects_short_or_foreign_datagrams);
+    RUN_TEST(test_readers_report_their_own_intervals);
+    return UNITY_END();
+}
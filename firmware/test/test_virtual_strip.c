@@ -0,0 +1,144 @@
+// Virtual WS2815 strip as an oracle for the streaming encoder.
+#include "unity.h"
+#include "virtual_strip.h"
+#include "frame_timing.h"
+#include "config_autogen.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static uint8_t rgb[MAX_RUN_LED_COUNT * 3];
+static rmt_symbol_word_t symbols[MAX_RUN_LED_COUNT * WS2815_SYMBOLS_PER_LED];
+static virtual_strip_t strip;
+
+// Encodes in 64-symbol chunks, as the RMT driver refills channel memory.
+static size_t encode(unsigned int led_count)
+{
+    size_t total = led_count * WS2815_SYMBOLS_PER_LED;
+    size_t written = 0;
+    while (written < total) {
+        size_t chunk = total - written < 64 ? total - written : 64;
+        written += ws2815_encode_symbols(rgb, led_count * 3, written, symbols + written, chunk);
+    }
+    return written;
+}
+
+static void fill_pattern(unsigned int led_count, unsigned int seed)
+{
+    srand(seed);
+    for (unsigned int byte = 0; byte < led_count * 3; ++byte) {
+        rgb[byte] = (uint8_t)rand();
+    }
+}
+
+void setUp(void)
+{
+    TEST_ASSERT_TRUE(virtual_strip_init(&strip, LED_COUNT[0], RMT_RESOLUTION_HZ));
+}
+
+void tearDown(void)
+{
+    virtual_strip_free(&strip);
+}
+
+void test_encoder_output_decodes_to_every_run(void)
+{
+    for (unsigned int run = 0; run < RUN_COUNT; ++run) {
+        virtual_strip_t run_strip;
+        TEST_ASSERT_TRUE(virtual_strip_init(&run_strip, LED_COUNT[run], RMT_RESOLUTION_HZ));
+        fill_pattern(LED_COUNT[run], run + 1);
+        TEST_ASSERT_TRUE(virtual_strip_feed(&run_strip, symbols, encode(LED_COUNT[run]), 0));
+        TEST_ASSERT_EQUAL_UINT8_ARRAY(rgb, run_strip.rgb, LED_COUNT[run] * 3);
+        TEST_ASSERT_EQUAL_UINT32(0, run_strip.stats.timing_errors);
+        virtual_strip_free(&run_strip);
+    }
+}
+
+void test_wire_time_matches_frame_timing_model(void)
+{
+    fill_pattern(LED_COUNT[0], 7);
+    virtual_strip_feed(&strip, symbols, encode(LED_COUNT[0]), 0);
+    TEST_ASSERT_EQUAL_UINT32(frame_timing_run_wire_us(LED_COUNT[0]), strip.stats.last_wire_us);
+}
+
+void test_pulses_outside_windows_are_rejected(void)
+{
+    memset(rgb, 0, sizeof(rgb));
+    size_t count = encode(LED_COUNT[0]);
+    TEST_ASSERT_TRUE(virtual_strip_feed(&strip, symbols, count, 0));
+
+    // 200 ns high is too short for a 0; 600 ns sits between the 0 and 1
+    // windows, where a strip may read either
+    const uint16_t BAD_HIGH_TICKS[] = {8, 24};
+    int64_t start_us = 100000;
+    for (size_t index = 0; index < sizeof(BAD_HIGH_TICKS) / sizeof(BAD_HIGH_TICKS[0]); ++index) {
+        fill_pattern(LED_COUNT[0], 3);
+        encode(LED_COUNT[0]);
+        symbols[count / 2].duration0 = BAD_HIGH_TICKS[index];
+        TEST_ASSERT_FALSE(virtual_strip_feed(&strip, symbols, count, start_us));
+        start_us += 100000;
+    }
+    TEST_ASSERT_EQUAL_UINT32(2, strip.stats.timing_errors);
+    // The strip keeps showing the last frame it latched
+    for (unsigned int byte = 0; byte < LED_COUNT[0] * 3; ++byte) {
+        TEST_ASSERT_EQUAL_UINT8(0, strip.rgb[byte]);
+    }
+
+    encode(LED_COUNT[0]);
+    symbols[0].level0 = 0;
+    TEST_ASSERT_FALSE(virtual_strip_feed(&strip, symbols, count, start_us));
+    TEST_ASSERT_EQUAL_UINT32(3, strip.stats.timing_errors);
+}
+
+void test_short_latch_gap_is_a_reset_error(void)
+{
+    fill_pattern(LED_COUNT[0], 11);
+    size_t count = encode(LED_COUNT[0]);
+    TEST_ASSERT_TRUE(virtual_strip_feed(&strip, symbols, count, 0));
+    int64_t end_us = strip.stats.last_wire_us - WS2815_DATASHEET_TIMING.reset_min_us;
+    TEST_ASSERT_FALSE(virtual_strip_feed(&strip, symbols, count, end_us + 60));
+    TEST_ASSERT_EQUAL_UINT32(1, strip.stats.reset_errors);
+    end_us += 60 + strip.stats.last_wire_us - WS2815_DATASHEET_TIMING.reset_min_us;
+    TEST_ASSERT_TRUE(virtual_strip_feed(&strip, symbols, count,
+                                        end_us + WS2815_DATASHEET_TIMING.reset_min_us));
+    TEST_ASSERT_EQUAL_UINT32(2, strip.stats.frames);
+}
+
+void test_partial_stream_is_a_length_error(void)
+{
+    fill_pattern(LED_COUNT[0], 5);
+    size_t count = encode(LED_COUNT[0]);
+    TEST_ASSERT_FALSE(virtual_strip_feed(&strip, symbols, count - 8, 0));
+    TEST_ASSERT_EQUAL_UINT32(1, strip.stats.length_errors);
+}
+
+void test_report_fps_ceiling(void)
+{
+    virtual_strip_t strips[RUN_COUNT];
+    for (unsigned int run = 0; run < RUN_COUNT; ++run) {
+        virtual_strip_init(&strips[run], LED_COUNT[run], RMT_RESOLUTION_HZ);
+        fill_pattern(LED_COUNT[run], run);
+        virtual_strip_feed(&strips[run], symbols, encode(LED_COUNT[run]), 0);
+        printf("run %u: %u LEDs, %u us on the wire\n", run, LED_COUNT[run],
+               strips[run].stats.max_wire_us);
+    }
+    double ceiling = virtual_strip_fps_ceiling(strips, RUN_COUNT);
+    printf("parallel FPS ceiling: %.1f\n", ceiling);
+    uint32_t model_us = frame_timing_transmit_us(LED_COUNT, RUN_COUNT, FRAME_OUTPUT_PARALLEL);
+    TEST_ASSERT_TRUE(ceiling * model_us > 999999.0 && ceiling * model_us < 1000001.0);
+    for (unsigned int run = 0; run < RUN_COUNT; ++run) {
+        virtual_strip_free(&strips[run]);
+    }
+}
+
+int main(void)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_encoder_output_decodes_to_every_run);
+    RUN_TEST(test_wire_time_matches_frame_timing_model);
+    RUN_TEST(test_pulses_outside_windows_are_rejected);
+    RUN_TEST(test_short_latch_gap_is_a_reset_error);
+    RUN_TEST(test_partial_stream_is_a_length_error);
+    RUN_TEST(test_report_fps_ceiling);
+    return UNITY_END();
+}
@@ -0,0 +1,142 @@
+#include "unity.h"
+#include "ws2815_encoder.h"
+#include "config_autogen.h"
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Reference copy of the pre-expanded encoder the streaming encoder replaces.
+static void reference_encode_run(unsigned int led_count, const uint8_t *rgb_data,
+                                 rmt_symbol_word_t *items)
+{
+    size_t item_index = 0;
+    for (unsigned int led_index = 0; led_index < led_count; ++led_index) {
+        uint8_t red = rgb_data[led_index * 3];
+        uint8_t green = rgb_data[led_index * 3 + 1];
+        uint8_t blue = rgb_data[led_index * 3 + 2];
+        uint8_t grb[3] = {green, red, blue};
+        for (int color = 0; color < 3; ++color) {
+            uint8_t value = grb[color];
+            for (int bit = 7; bit >= 0; --bit) {
+                bool bit_set = value & (1 << bit);
+                items[item_index].duration0 = bit_set ? RMT_T1H_TICKS : RMT_T0H_TICKS;
+                items[item_index].level0 = 1;
+                items[item_index].duration1 = bit_set ? RMT_T1L_TICKS : RMT_T0L_TICKS;
+                items[item_index].level1 = 0;
+                ++item_index;
+            }
+        }
+    }
+}
+
+static uint8_t *make_pattern(size_t byte_count)
+{
+    uint8_t *rgb = (uint8_t *)malloc(byte_count);
+    uint32_t seed = 0x12345678;
+    for (size_t index = 0; index < byte_count; ++index) {
+        seed = seed * 1103515245u + 12345u;
+        rgb[index] = (uint8_t)(seed >> 16);
+    }
+    return rgb;
+}
+
+// Feeds the encoder in fixed-size chunks, as the RMT driver does when
+// refilling its ping-pong memory, and returns the stitched symbol stream.
+static rmt_symbol_word_t *encode_in_chunks(const uint8_t *rgb, size_t byte_count,
+                                           size_t chunk_symbols)
+{
+    size_t total = byte_count * 8;
+    rmt_symbol_word_t *stream =
+        (rmt_symbol_word_t *)calloc(total + chunk_symbols, sizeof(rmt_symbol_word_t));
+    size_t written = 0;
+    while (written < total) {
+        size_t count = ws2815_encode_symbols(rgb, byte_count, written,
+                                             stream + written, chunk_symbols);
+        TEST_ASSERT_TRUE(count > 0);
+        TEST_ASSERT_TRUE(count <= chunk_symbols);
+        written += count;
+    }
+    TEST_ASSERT_EQUAL(total, written);
+    TEST_ASSERT_EQUAL(0, ws2815_encode_symbols(rgb, byte_count, written,
+                                               stream + written, chunk_symbols));
+    return stream;
+}
+
+void setUp(void) {}
+void tearDown(void) {}
+
+void test_chunked_stream_matches_reference_for_each_run(void)
+{
+    const size_t CHUNK_SIZES[] = {1, 7, 24, 32, 64, 1000};
+    for (unsigned int run = 0; run < RUN_COUNT; ++run) {
+        size_t byte_count = LED_COUNT[run] * 3;
+        uint8_t *rgb = make_pattern(byte_count);
+        rmt_symbol_word_t *expected = (rmt_symbol_word_t *)malloc(
+            sizeof(rmt_symbol_word_t) * LED_COUNT[run] * WS2815_SYMBOLS_PER_LED);
+        reference_encode_run(LED_COUNT[run], rgb, expected);
+        for (size_t index = 0; index < sizeof(CHUNK_SIZES) / sizeof(CHUNK_SIZES[0]); ++index) {
+            rmt_symbol_word_t *stream = encode_in_chunks(rgb, byte_count, CHUNK_SIZES[index]);
+            TEST_ASSERT_EQUAL_MEMORY(expected, stream,
+                                     sizeof(rmt_symbol_word_t) * byte_count * 8);
+            free(stream);
+        }
+        free(expected);
+        free(rgb);
+    }
+}
+
+void test_single_led_is_sent_grb_msb_first(void)
+{
+    const uint8_t rgb[3] = {0x80, 0x01, 0x00};
+    rmt_symbol_word_t symbols[WS2815_SYMBOLS_PER_LED];
+    TEST_ASSERT_EQUAL(WS2815_SYMBOLS_PER_LED,
+                      ws2815_encode_symbols(rgb, sizeof(rgb), 0, symbols,
+                                            WS2815_SYMBOLS_PER_LED));
+    for (int index = 0; index < WS2815_SYMBOLS_PER_LED; ++index) {
+        // Green LSB (index 7) and red MSB (index 8) are the only set bits.
+        bool expect_one = index == 7 || index == 8;
+        TEST_ASSERT_EQUAL_UINT32(expect_one ? RMT_T1H_TICKS : RMT_T0H_TICKS,
+                                 symbols[index].duration0);
+        TEST_ASSERT_EQUAL_UINT32(1, symbols[index].level0);
+        TEST_ASSERT_EQUAL_UINT32(expect_one ? RMT_T1L_TICKS : RMT_T0L_TICKS,
+                                 symbols[index].duration1);
+        TEST_ASSERT_EQUAL_UINT32(0, symbols[index].level1);
+    }
+}
+
+void test_resume_mid_byte(void)
+{
+    const uint8_t rgb[6] = {0xFF, 0x00, 0xAA, 0x55, 0x0F, 0xF0};
+    rmt_symbol_word_t expected[2 * WS2815_SYMBOLS_PER_LED];
+    reference_encode_run(2, rgb, expected);
+    rmt_symbol_word_t symbols[5];
+    TEST_ASSERT_EQUAL(5, ws2815_encode_symbols(rgb, sizeof(rgb), 13, symbols, 5));
+    TEST_ASSERT_EQUAL_MEMORY(expected + 13, symbols, sizeof(symbols));
+    TEST_ASSERT_EQUAL(3, ws2815_encode_symbols(rgb, sizeof(rgb), 45, symbols, 5));
+    TEST_ASSERT_EQUAL_MEMORY(expected + 45, symbols, 3 * sizeof(rmt_symbol_word_t));
+}
+
+void test_byte_table_matches_bit_timing(void)
+{
+    for (unsigned int value = 0; value < 256; ++value) {
+        for (int bit = 0; bit < 8; ++bit) {
+            rmt_symbol_word_t symbol;
+            symbol.val = WS2815_BYTE_SYMBOLS[value][bit];
+            bool bit_set = value & (0x80 >> bit);
+            TEST_ASSERT_EQUAL_UINT32(bit_set ? RMT_T1H_TICKS : RMT_T0H_TICKS, symbol.duration0);
+            TEST_ASSERT_EQUAL_UINT32(1, symbol.level0);
+            TEST_ASSERT_EQUAL_UINT32(bit_set ? RMT_T1L_TICKS : RMT_T0L_TICKS, symbol.duration1);
+            TEST_ASSERT_EQUAL_UINT32(0, symbol.level1);
+        }
+    }
+}
+
+int main(void)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_chunked_stream_matches_reference_for_each_run);
+    RUN_TEST(test_single_led_is_sent_grb_msb_first);
+    RUN_TEST(test_resume_mid_byte);
+    RUN_TEST(test_byte_table_matches_bit_timing);
+    return UNITY_END();
+}
@@ -7,6 +7,7 @@ repository_root="$(cd "${script_directory}/.." && pwd)"
 
 # Generate configuration
 python "${repository_root}/tools/gen_config.py" --layout "${repository_root}/config/left.json"
+python "${repository_root}/tools/memory_report.py" "${repository_root}/config/left.json"
 
 # Build firmware
 pushd "${repository_root}/firmware" >/dev/null
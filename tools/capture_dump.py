@@ -0,0 +1,135 @@
+#!/usr/bin/env python3
+"""Fetch the rx capture ring from a controller and save it for rx_replay."""
+
+import argparse
+import socket
+import struct
+import sys
+from collections import Counter
+from typing import Dict, Iterable, List, Optional, Tuple
+
+CONTROL_PORT_OFFSET = 100
+CAPTURE_COMMAND = b"CAPTURE"
+
+# Mirrors firmware/main/rx_capture.h, version 1.
+CAPTURE_MAGIC = b"BCAP"
+CAPTURE_VERSION = 1
+CAPTURE_HEADER = struct.Struct("<4sBBBBII4HHHI")
+CAPTURE_ENTRY = struct.Struct("<QIHBB")
+CHUNK_HEADER = struct.Struct("<2sBBHH")
+CHUNK_MAGIC = b"BD"
+OUTCOMES = ("accepted", "len", "run", "stale", "window", "pool", "base")
+
+
+def assemble_chunks(datagrams: Iterable[bytes]) -> Optional[bytes]:
+    """Join dump datagrams into the capture stream.
+
+    Returns None until every chunk of the dump has arrived.
+    """
+    chunks: Dict[int, bytes] = {}
+    chunk_count = None
+    for data in datagrams:
+        if len(data) < CHUNK_HEADER.size:
+            continue
+        magic, version, _, index, count = CHUNK_HEADER.unpack_from(data)
+        if magic != CHUNK_MAGIC or version != CAPTURE_VERSION:
+            continue
+        chunk_count = count
+        chunks[index] = data[CHUNK_HEADER.size:]
+    if chunk_count is None or len(chunks) != chunk_count:
+        return None
+    return b"".join(chunks[index] for index in range(chunk_count))
+
+
+def decode_capture(data: bytes) -> Tuple[dict, List[dict]]:
+    """Decode a capture stream into its header and entries."""
+    if len(data) < CAPTURE_HEADER.size:
+        raise ValueError("capture too short")
+    (magic, version, side, run_count, entry_bytes, entry_count, overwritten,
+     led0, led1, led2, led3, port_base, _, _) = CAPTURE_HEADER.unpack_from(data)
+    if magic != CAPTURE_MAGIC or version != CAPTURE_VERSION or entry_bytes != CAPTURE_ENTRY.size:
+        raise ValueError("not a version 1 rx capture")
+    header = {
+        "side": side,
+        "runs": run_count,
+        "leds": [led0, led1, led2, led3][:run_count],
+        "port_base": port_base,
+        "entries": entry_count,
+        "overwritten": overwritten,
+    }
+    entries = []
+    offset = CAPTURE_HEADER.size
+    for _ in range(entry_count):
+        if offset + CAPTURE_ENTRY.size > len(data):
+            raise ValueError("capture truncated")
+        arrival_us, frame_id, length, run, outcome = CAPTURE_ENTRY.unpack_from(data, offset)
+        entries.append({
+            "arrival_us": arrival_us,
+            "frame_id": frame_id,
+            "length": length,
+            "run": run,
+            "outcome": OUTCOMES[outcome] if outcome < len(OUTCOMES) else str(outcome),
+        })
+        offset += CAPTURE_ENTRY.size
+    return header, entries
+
+
+def summarize(header: dict, entries: List[dict]) -> str:
+    """One line per socket with its outcome counts."""
+    lines = [
+        f"{header['entries']} entries ({header['overwritten']} overwritten), "
+        f"{header['runs']} runs {header['leds']}"
+    ]
+    if entries:
+        span_ms = (entries[-1]["arrival_us"] - entries[0]["arrival_us"]) / 1000
+        lines.append(f"span {span_ms:.1f} ms, frame_id {entries[0]['frame_id']}..{entries[-1]['frame_id']}")
+    by_run: Dict[int, Counter] = {}
+    for entry in entries:
+        by_run.setdefault(entry["run"], Counter())[entry["outcome"]] += 1
+    for run in sorted(by_run):
+        name = "parity" if run == header["runs"] else f"run{run}"
+        counts = " ".join(f"{outcome}={by_run[run][outcome]}" for outcome in OUTCOMES if by_run[run][outcome])
+        lines.append(f"{name}: {counts}")
+    return "\n".join(lines)
+
+
+def fetch(host: str, port: int, timeout: float) -> bytes:
+    sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    sock.settimeout(timeout)
+    sock.sendto(CAPTURE_COMMAND, (host, port))
+    datagrams = []
+    try:
+        while True:
+            data, _ = sock.recvfrom(2048)
+            datagrams.append(data)
+            stream = assemble_chunks(datagrams)
+            if stream is not None:
+                return stream
+    except socket.timeout:
+        raise RuntimeError(f"incomplete dump: {len(datagrams)} datagrams received") from None
+    finally:
+        sock.close()
+
+
+def main() -> None:
+    parser = argparse.ArgumentParser(description=__doc__)
+    parser.add_argument("--host", required=True, help="controller IP")
+    parser.add_argument("--port", type=int, default=49600 + CONTROL_PORT_OFFSET,
+                        help="control port, PORT_BASE + 100 on target (default 49700)")
+    parser.add_argument("--output", help="write the capture here for rx_replay")
+    parser.add_argument("--timeout", type=float, default=2.0)
+    args = parser.parse_args()
+
+    try:
+        stream = fetch(args.host, args.port, args.timeout)
+        header, entries = decode_capture(stream)
+    except (RuntimeError, ValueError) as error:
+        sys.exit(str(error))
+    print(summarize(header, entries))
+    if args.output:
+        with open(args.output, "wb") as output:
+            output.write(stream)
+
+
+if __name__ == "__main__":
+    main()
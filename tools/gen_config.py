@@ -1,10 +1,38 @@
 import argparse
 import json
+import sys
 from pathlib import Path
 
 
 SIDE_MAPPING = {"left": 0, "right": 1}
 
+# Receive geometry mirrored from rx_task.c, which checks it at compile time.
+RX_SLOT_COUNT = 4
+RX_HEADER_LENGTH = 4
+RX_SPARE_BUFFERS_PER_RUN = 2
+# Slots plus the published and driver banks, plus the spares
+RX_POOL_BUFFERS_PER_RUN = RX_SLOT_COUNT + 2 + RX_SPARE_BUFFERS_PER_RUN
+# ESP32 DMA descriptors need word-aligned buffers
+FRAME_ARENA_ALIGN = 4
+
+# WS2815 wire timing mirrored from firmware/main/frame_timing.h
+WS2815_BIT_TIME_NS = 1250
+WS2815_RESET_US = 280
+# Spec minimum when a layout names no target
+DEFAULT_TARGET_FPS = 30
+# Largest UDP payload that fits a 1500-byte Ethernet MTU unfragmented
+UDP_MAX_PAYLOAD = 1472
+# UDP 8 + IPv4 20 + Ethernet header 14 + FCS 4 + preamble 8 + gap 12
+DATAGRAM_WIRE_OVERHEAD = 66
+# ESP32 Ethernet MAC over RMII
+LINK_KBPS = 100000
+# Runs whose datagram would exceed UDP_MAX_PAYLOAD arrive as fragments on the
+# extended port; rx_task.h defines the framing
+MAX_RUN_LEDS = 1024
+RX_EXTENDED_HEADER_BYTES = 8
+RX_BLOCK_HEADER_BYTES = 8
+RX_FRAGMENT_MAX_LEDS = (UDP_MAX_PAYLOAD - RX_EXTENDED_HEADER_BYTES - RX_BLOCK_HEADER_BYTES) // 3
+
 
 def extract_octets(layout_data: dict, field_name: str) -> list:
     octets = layout_data.get(field_name, [])
@@ -16,6 +44,198 @@ def extract_octets(layout_data: dict, field_name: str) -> list:
     return octets
 
 
+def align_up(value: int) -> int:
+    return (value + FRAME_ARENA_ALIGN - 1) // FRAME_ARENA_ALIGN * FRAME_ARENA_ALIGN
+
+
+def frame_arena_layout(led_counts: list) -> dict:
+    """Places every rx_task buffer in one block: each run's receive pool,
+    then a parity payload per reassembly slot, then the parity and extended
+    receive buffers. Receive buffers hold a whole datagram plus one byte so
+    oversized datagrams are caught."""
+    offset = 0
+    runs = []
+    for count in led_counts:
+        capacity = RX_HEADER_LENGTH + count * 3 + 1
+        stride = align_up(capacity)
+        runs.append({"offset": offset, "stride": stride, "capacity": capacity})
+        offset += stride * RX_POOL_BUFFERS_PER_RUN
+    parity_payload = max(led_counts, default=0) * 3
+    parity_slot_bytes = align_up(parity_payload)
+    parity_offset = offset
+    offset += parity_slot_bytes * RX_SLOT_COUNT
+    parity_rx_offset = offset
+    offset += align_up(RX_HEADER_LENGTH + parity_payload + 1)
+    extended_rx_offset = offset
+    offset += align_up(UDP_MAX_PAYLOAD + 1)
+    return {
+        "runs": runs,
+        "parity_offset": parity_offset,
+        "parity_slot_bytes": parity_slot_bytes,
+        "parity_rx_offset": parity_rx_offset,
+        "extended_rx_offset": extended_rx_offset,
+        "total": offset,
+    }
+
+
+def run_wire_us(led_count: int) -> int:
+    """On-wire duration of one run including the latch gap, as
+    frame_timing_run_wire_us computes it."""
+    data_ns = led_count * 24 * WS2815_BIT_TIME_NS
+    return (data_ns + 999) // 1000 + WS2815_RESET_US
+
+
+def run_fragments(led_count: int) -> int:
+    """Datagrams a run needs: 1 when a plain run datagram fits the payload
+    limit, else the number of fragments."""
+    if RX_HEADER_LENGTH + led_count * 3 <= UDP_MAX_PAYLOAD:
+        return 1
+    return -(-led_count // RX_FRAGMENT_MAX_LEDS)
+
+
+def run_datagrams(led_count: int) -> list:
+    fragments = run_fragments(led_count)
+    if fragments == 1:
+        return [RX_HEADER_LENGTH + led_count * 3]
+    sizes = []
+    for index in range(fragments):
+        leds = min(RX_FRAGMENT_MAX_LEDS, led_count - index * RX_FRAGMENT_MAX_LEDS)
+        sizes.append(RX_EXTENDED_HEADER_BYTES + RX_BLOCK_HEADER_BYTES + leds * 3)
+    return sizes
+
+
+def batched_datagrams(led_counts: list) -> int:
+    """Run datagrams per frame when consecutive runs that fit together share
+    one extended datagram, as loadgen --batch packs them."""
+    datagrams = 0
+    length = UDP_MAX_PAYLOAD
+    for count in led_counts:
+        block = RX_BLOCK_HEADER_BYTES + count * 3
+        if run_fragments(count) > 1:
+            datagrams += run_fragments(count)
+            length = UDP_MAX_PAYLOAD
+        elif length + block <= UDP_MAX_PAYLOAD:
+            length += block
+        else:
+            datagrams += 1
+            length = RX_EXTENDED_HEADER_BYTES + block
+    return datagrams
+
+
+def frame_budget(led_counts: list, target_fps: int) -> dict:
+    """Wire time, frame period per output mode, datagram sizes and network
+    rate of a layout at target_fps. Every run datagram or fragment and, when
+    it fits one datagram, the parity datagram count towards the rate. Parity
+    cannot be fragmented, so a longer one turns parity off."""
+    wire_us = [run_wire_us(count) for count in led_counts]
+    datagrams = [size for count in led_counts for size in run_datagrams(count)]
+    parity_bytes = RX_HEADER_LENGTH + max(led_counts, default=0) * 3
+    parity_enabled = parity_bytes <= UDP_MAX_PAYLOAD
+    sent = datagrams + ([parity_bytes] if parity_enabled else [])
+    frame_bits = sum(size + DATAGRAM_WIRE_OVERHEAD for size in sent) * 8
+    return {
+        "target_fps": target_fps,
+        "run_wire_us": wire_us,
+        "run_fragments": [run_fragments(count) for count in led_counts],
+        "run_datagrams": len(datagrams),
+        "batched_datagrams": batched_datagrams(led_counts),
+        "serial_period_us": sum(wire_us),
+        "parallel_period_us": max(wire_us, default=0),
+        "target_period_us": 1000000 // target_fps,
+        "max_datagram_bytes": max(datagrams, default=0),
+        "parity_datagram_bytes": parity_bytes,
+        "parity_enabled": parity_enabled,
+        "network_kbps": (frame_bits * target_fps + 999) // 1000,
+    }
+
+
+def check_budget(budget: dict) -> list:
+    """Raises ValueError when the layout cannot meet its target with the
+    firmware's default parallel output; returns warnings for tight margins.
+    Serial output is only reported, since DRIVER_PARALLEL_OUTPUT=0 is a
+    diagnostic build."""
+    target_fps = budget["target_fps"]
+    if budget["parallel_period_us"] > budget["target_period_us"]:
+        raise ValueError(
+            f"target_fps {target_fps} needs a {budget['target_period_us']} us frame period; "
+            f"parallel output takes {budget['parallel_period_us']} us"
+        )
+    if budget["network_kbps"] > LINK_KBPS:
+        raise ValueError(
+            f"target_fps {target_fps} needs {budget['network_kbps']} kbit/s; "
+            f"the link carries {LINK_KBPS}"
+        )
+    warnings = []
+    # Encoding and the latch wait eat into whatever the wire time leaves
+    if budget["parallel_period_us"] * 10 > budget["target_period_us"] * 9:
+        warnings.append(
+            f"target_fps {target_fps} leaves under 10% headroom over the "
+            f"{budget['parallel_period_us']} us parallel frame period"
+        )
+    if not budget["parity_enabled"]:
+        warnings.append(
+            f"parity disabled: the {budget['parity_datagram_bytes']}-byte parity datagram "
+            f"would need IP fragmentation"
+        )
+    if budget["network_kbps"] * 2 > LINK_KBPS:
+        warnings.append(
+            f"{budget['network_kbps']} kbit/s at target_fps {target_fps} uses over half the link"
+        )
+    return warnings
+
+
+def run_sections(layout_data: dict) -> list:
+    """LED count of each section of each run, in run order. A run without
+    sections is one section; otherwise its sections must cover it exactly,
+    since rx_task interpolates sampled blocks section by section."""
+    sections = []
+    for index, run in enumerate(layout_data.get("runs", [])):
+        led_count = run.get("led_count", 0)
+        counts = [section.get("led_count") for section in run.get("sections", [])]
+        if not counts:
+            counts = [led_count]
+        for count in counts:
+            if not isinstance(count, int) or isinstance(count, bool) or count <= 0:
+                raise ValueError(f"run {index} has a section without a positive led_count")
+        if sum(counts) != led_count:
+            raise ValueError(f"sections of run {index} cover {sum(counts)} LEDs, not {led_count}")
+        sections.append(counts)
+    return sections
+
+
+def read_target_fps(layout_data: dict) -> int:
+    target_fps = layout_data.get("target_fps", DEFAULT_TARGET_FPS)
+    if not isinstance(target_fps, int) or isinstance(target_fps, bool) or target_fps <= 0:
+        raise ValueError("target_fps must be a positive integer")
+    return target_fps
+
+
+def format_budget(layout_data: dict) -> str:
+    led_counts = [run.get("led_count", 0) for run in layout_data.get("runs", [])]
+    budget = frame_budget(led_counts, read_target_fps(layout_data))
+    lines = [f"target {budget['target_fps']} fps: {budget['target_period_us']} us per frame"]
+    for index, wire_us in enumerate(budget["run_wire_us"]):
+        fragments = budget["run_fragments"][index]
+        sent_as = f", {fragments} fragments" if fragments > 1 else ""
+        lines.append(f"run {index}: {led_counts[index]} LEDs, {wire_us} us on the wire{sent_as}")
+    for mode in ("serial", "parallel"):
+        period_us = budget[f"{mode}_period_us"]
+        lines.append(f"{mode}: {period_us} us per frame, {1e6 / period_us:.1f} fps max")
+    lines.append(
+        f"largest datagram {budget['max_datagram_bytes']} of {UDP_MAX_PAYLOAD} bytes, "
+        f"{budget['network_kbps']} kbit/s at target"
+    )
+    if not budget["parity_enabled"]:
+        lines.append(f"parity off: {budget['parity_datagram_bytes']} bytes would not fit")
+    if budget["batched_datagrams"] < budget["run_datagrams"]:
+        lines.append(
+            f"batched: {budget['batched_datagrams']} instead of {budget['run_datagrams']} "
+            f"run datagrams per frame"
+        )
+    lines.append(f"frame arena {frame_arena_layout(led_counts)['total']} bytes")
+    return "\n".join(lines)
+
+
 def generate_header(layout_data: dict) -> str:
     side_name = layout_data.get("side", "")
     side_identifier = SIDE_MAPPING.get(side_name.lower())
@@ -27,8 +247,8 @@ def generate_header(layout_data: dict) -> str:
     if run_count > 4:
         raise ValueError("run_count exceeds 4")
     for count in led_counts:
-        if count > 400:
-            raise ValueError("led_count exceeds 400")
+        if count > MAX_RUN_LEDS:
+            raise ValueError(f"led_count exceeds {MAX_RUN_LEDS}")
     total_leds = layout_data.get("total_leds", 0)
 
     static_ip = extract_octets(layout_data, "static_ip")
@@ -46,7 +266,9 @@ def generate_header(layout_data: dict) -> str:
         "",
         f"#define SIDE_ID {side_identifier}",
         f"#define RUN_COUNT {run_count}",
+        f"#define EXPECTED_MASK 0x{(1 << run_count) - 1:X}u",
         f"#define TOTAL_LED_COUNT {total_leds}",
+        f"#define MAX_RUN_LED_COUNT {max(led_counts, default=0)}",
         f"#define PORT_BASE {port_base}",
         f"#define STATUS_PORT {gateway_port}",
     ]
@@ -61,7 +283,50 @@ def generate_header(layout_data: dict) -> str:
     header_lines.append("_Static_assert(RUN_COUNT <= 4, \"RUN_COUNT exceeds 4\");")
     for index, count in enumerate(led_counts):
         header_lines.append(
-            f"_Static_assert({count} <= 400, \"LED_COUNT[{index}] exceeds 400\");"
+            f"_Static_assert({count} <= {MAX_RUN_LEDS}, "
+            f"\"LED_COUNT[{index}] exceeds {MAX_RUN_LEDS}\");"
+        )
+    sections = run_sections(layout_data)
+    section_counts = [count for run in sections for count in run]
+    section_first_leds = [sum(run[:index]) for run in sections for index in range(len(run))]
+    run_first_sections = [sum(len(run) for run in sections[:index]) for index in range(run_count)]
+    arena = frame_arena_layout(led_counts)
+    budget = frame_budget(led_counts, read_target_fps(layout_data))
+    for warning in check_budget(budget):
+        print(f"warning: {warning}", file=sys.stderr)
+    header_lines.extend(
+        [
+            "",
+            "// Frame arena: every receive, frame and parity buffer of rx_task in one",
+            "// aligned static block. Run r owns FRAME_ARENA_POOL_BUFFERS buffers of",
+            "// RUN_BUFFER_STRIDE[r] bytes starting at RUN_POOL_OFFSET[r].",
+            f"#define FRAME_ARENA_ALIGN {FRAME_ARENA_ALIGN}",
+            f"#define FRAME_ARENA_SLOT_COUNT {RX_SLOT_COUNT}",
+            f"#define FRAME_ARENA_POOL_BUFFERS {RX_POOL_BUFFERS_PER_RUN}",
+            f"#define FRAME_ARENA_PARITY_OFFSET {arena['parity_offset']}",
+            f"#define FRAME_ARENA_PARITY_SLOT_BYTES {arena['parity_slot_bytes']}",
+            f"#define FRAME_ARENA_PARITY_RX_OFFSET {arena['parity_rx_offset']}",
+            f"#define FRAME_ARENA_EXTENDED_RX_OFFSET {arena['extended_rx_offset']}",
+            f"#define FRAME_ARENA_BYTES {arena['total']}",
+            "",
+            "// Frame budget at TARGET_FPS, checked when this header was generated.",
+            "// Periods are wire time only, in microseconds, a lower bound on the",
+            "// driver loop's period; the network rate counts every run datagram",
+            "// and any parity datagram with their UDP, IP and Ethernet overhead.",
+            f"#define TARGET_FPS {budget['target_fps']}",
+            f"#define FRAME_PERIOD_SERIAL_US {budget['serial_period_us']}",
+            f"#define FRAME_PERIOD_PARALLEL_US {budget['parallel_period_us']}",
+            f"#define MAX_DATAGRAM_BYTES {budget['max_datagram_bytes']}",
+            f"#define NETWORK_KBPS_AT_TARGET {budget['network_kbps']}",
+        ]
+    )
+    if not budget["parity_enabled"]:
+        header_lines.extend(
+            [
+                "// Parity for the longest run would not fit one UDP datagram and",
+                "// cannot be fragmented, so rx_task opens no parity socket.",
+                "#define RX_PARITY_ENABLED 0",
+            ]
         )
     header_lines.extend(
         [
@@ -69,6 +334,32 @@ def generate_header(layout_data: dict) -> str:
             "static const unsigned int LED_COUNT[RUN_COUNT] = {"
             + ", ".join(str(count) for count in led_counts)
             + "};",
+            "static const unsigned int RUN_POOL_OFFSET[RUN_COUNT] = {"
+            + ", ".join(str(run["offset"]) for run in arena["runs"])
+            + "};",
+            "static const unsigned int RUN_BUFFER_STRIDE[RUN_COUNT] = {"
+            + ", ".join(str(run["stride"]) for run in arena["runs"])
+            + "};",
+            "static const unsigned int RUN_WIRE_US[RUN_COUNT] = {"
+            + ", ".join(str(wire_us) for wire_us in budget["run_wire_us"])
+            + "};",
+            "",
+            "// Sections of each run, in LED order: run r owns RUN_SECTION_COUNT[r]",
+            "// sections from RUN_FIRST_SECTION[r]. First LEDs count from the run's",
+            "// first LED.",
+            f"#define SECTION_COUNT {len(section_counts)}",
+            "static const unsigned int RUN_FIRST_SECTION[RUN_COUNT] = {"
+            + ", ".join(str(first) for first in run_first_sections)
+            + "};",
+            "static const unsigned int RUN_SECTION_COUNT[RUN_COUNT] = {"
+            + ", ".join(str(len(run)) for run in sections)
+            + "};",
+            "static const unsigned int SECTION_LED_COUNT[SECTION_COUNT] = {"
+            + ", ".join(str(count) for count in section_counts)
+            + "};",
+            "static const unsigned int SECTION_FIRST_LED[SECTION_COUNT] = {"
+            + ", ".join(str(first) for first in section_first_leds)
+            + "};",
             "",
         ]
     )
@@ -79,12 +370,15 @@ def main() -> None:
     parser = argparse.ArgumentParser(description="Generate firmware configuration header from layout JSON.")
     parser.add_argument("--layout", required=True, help="Path to layout JSON file")
     parser.add_argument("--output", default="firmware/include/config_autogen.h", help="Path to output header file")
+    parser.add_argument("--report", action="store_true", help="Print the layout's frame budget")
     arguments = parser.parse_args()
 
     layout_path = Path(arguments.layout)
     layout_data = json.loads(layout_path.read_text())
 
     header_text = generate_header(layout_data)
+    if arguments.report:
+        print(format_budget(layout_data))
 
     output_path = Path(arguments.output)
     output_path.parent.mkdir(parents=True, exist_ok=True)
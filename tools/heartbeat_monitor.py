@@ -4,19 +4,118 @@
 import argparse
 import json
 import socket
+import struct
 import time
-from typing import Dict, Optional
+from typing import Dict, List, Optional
 
 TELEMETRY_PORT = 49700
 BUFFER_SIZE = 1024
 DEVICE_IDS = ["LEFT", "RIGHT"]
 
+# Binary telemetry datagram, version 2; mirrors firmware/main/telemetry.h.
+TELEMETRY_MAGIC = b"BL"
+TELEMETRY_VERSION = 2
+TELEMETRY_HEADER = struct.Struct("<2sBBIIBBBB")
+GLOBAL_COUNTERS = (
+    "rx_frames", "complete", "applied", "len", "run", "stale", "window", "pool", "base",
+    "recovered", "events_lost", "frames_skipped", "frame_gaps",
+)
+DROP_REASONS = ("len", "run", "stale", "window", "pool", "base")
+MAX_RUNS = 4
+RUN_COUNTERS = ("rx", "drops", "recovered")
+STAGES = ("assemble", "handoff", "encode", "transmit", "total")
+BUCKET_COUNT = 24
+TELEMETRY_BYTES = (
+    TELEMETRY_HEADER.size
+    + 4 * len(GLOBAL_COUNTERS)
+    + 4 * MAX_RUNS * len(RUN_COUNTERS)
+    + len(STAGES) * (4 + 2 * BUCKET_COUNT)
+)
+
+
+def bucket_percentile(buckets: List[int], percent: int, max_us: int) -> int:
+    """Upper bound of the log2 bucket holding the rank, capped at max_us."""
+    total = sum(buckets)
+    if total == 0:
+        return 0
+    rank = (total * percent + 99) // 100
+    seen = 0
+    for index, count in enumerate(buckets):
+        seen += count
+        if seen >= rank:
+            upper = 0 if index == 0 else (1 << index) - 1
+            return min(upper, max_us)
+    return max_us
+
+
+def decode_binary_telemetry(data: bytes) -> Optional[dict]:
+    """Decode a binary telemetry datagram into heartbeat-style keys.
+
+    Returns None for anything that is not a version 2 datagram.
+    """
+    if len(data) < TELEMETRY_BYTES or not data.startswith(TELEMETRY_MAGIC):
+        return None
+    _, version, side, sequence, uptime_ms, run_count, stage_count, bucket_count, flags = (
+        TELEMETRY_HEADER.unpack_from(data)
+    )
+    if version != TELEMETRY_VERSION or stage_count != len(STAGES) or bucket_count != BUCKET_COUNT:
+        return None
+    offset = TELEMETRY_HEADER.size
+    counters = dict(zip(GLOBAL_COUNTERS, struct.unpack_from(f"<{len(GLOBAL_COUNTERS)}I", data, offset)))
+    offset += 4 * len(GLOBAL_COUNTERS)
+    runs = []
+    for _ in range(MAX_RUNS):
+        runs.append(dict(zip(RUN_COUNTERS, struct.unpack_from("<3I", data, offset))))
+        offset += 4 * len(RUN_COUNTERS)
+    latency_us = {}
+    latency_buckets = {}
+    for stage in STAGES:
+        (max_us,) = struct.unpack_from("<I", data, offset)
+        buckets = list(struct.unpack_from(f"<{BUCKET_COUNT}H", data, offset + 4))
+        offset += 4 + 2 * BUCKET_COUNT
+        latency_us[stage] = [
+            bucket_percentile(buckets, 50, max_us),
+            bucket_percentile(buckets, 99, max_us),
+            max_us,
+        ]
+        latency_buckets[stage] = buckets
+    drops = {reason: counters[reason] for reason in DROP_REASONS}
+    return {
+        "id": DEVICE_IDS[side] if side < len(DEVICE_IDS) else str(side),
+        "sequence": sequence,
+        "uptime_ms": uptime_ms,
+        "link": bool(flags & 0x01),
+        "runs": run_count,
+        "rx_frames": counters["rx_frames"],
+        "complete": counters["complete"],
+        "applied": counters["applied"],
+        "dropped_frames": sum(drops.values()),
+        "drops": drops,
+        "recovered": counters["recovered"],
+        "events_lost": counters["events_lost"],
+        "frames_skipped": counters["frames_skipped"],
+        "frame_gaps": counters["frame_gaps"],
+        "per_run": runs[:run_count],
+        "latency_us": latency_us,
+        "latency_buckets": latency_buckets,
+    }
+
+
+def decode_datagram(data: bytes) -> Optional[dict]:
+    """Decode either heartbeat format; None if the payload is neither."""
+    if data.startswith(TELEMETRY_MAGIC):
+        return decode_binary_telemetry(data)
+    try:
+        return json.loads(data.decode("utf-8"))
+    except (UnicodeDecodeError, json.JSONDecodeError):
+        return None
+
 
 def render_table(last_data: Dict[str, Optional[dict]], last_seen: Dict[str, Optional[float]]) -> None:
     """Print a table of the most recent heartbeat data."""
     header = (
         f"{'Device':<6} {'IP':<15} {'Uptime(ms)':<12} {'Link':<5} "
-        f"{'Rx':<10} {'Complete':<10} {'Applied':<10} {'Dropped':<10} {'Last Seen':<10}"
+        f"{'Rx':<10} {'Complete':<10} {'Applied':<10} {'Dropped':<10} {'p99(us)':<10} {'Last Seen':<10}"
     )
     print(header)
     print("-" * len(header))
@@ -26,15 +125,17 @@ def render_table(last_data: Dict[str, Optional[dict]], last_seen: Dict[str, Opti
         if heartbeat is None:
             row = (
                 f"{device_id:<6} {'--':<15} {'--':<12} {'--':<5} "
-                f"{'--':<10} {'--':<10} {'--':<10} {'--':<10} {'--':<10}"
+                f"{'--':<10} {'--':<10} {'--':<10} {'--':<10} {'--':<10} {'--':<10}"
             )
         else:
             seconds_since = current_time - (last_seen.get(device_id) or current_time)
+            total_latency = heartbeat.get("latency_us", {}).get("total", ["--"] * 3)
             row = (
                 f"{device_id:<6} {heartbeat.get('ip', '--'):<15} {heartbeat.get('uptime_ms', '--'):<12} "
                 f"{str(heartbeat.get('link', '--')):<5} {heartbeat.get('rx_frames', '--'):<10} "
                 f"{heartbeat.get('complete', '--'):<10} {heartbeat.get('applied', '--'):<10} "
-                f"{heartbeat.get('dropped_frames', '--'):<10} {seconds_since:>.1f}s"
+                f"{heartbeat.get('dropped_frames', '--'):<10} {total_latency[1]:<10} "
+                f"{seconds_since:>.1f}s"
             )
         print(row)
 
@@ -63,15 +164,17 @@ def main() -> None:
             while True:
                 try:
                     payload, address = listen_socket.recvfrom(BUFFER_SIZE)
-                    heartbeat = json.loads(payload.decode("utf-8"))
-                    device_id = heartbeat.get("id")
-                    if device_id in DEVICE_IDS:
-                        last_data[device_id] = heartbeat
-                        last_seen[device_id] = time.time()
                 except BlockingIOError:
                     break
-                except json.JSONDecodeError:
+                heartbeat = decode_datagram(payload)
+                if heartbeat is None:
                     continue
+                # Binary telemetry does not carry the IP; take it from the sender
+                heartbeat.setdefault("ip", address[0])
+                device_id = heartbeat.get("id")
+                if device_id in DEVICE_IDS:
+                    last_data[device_id] = heartbeat
+                    last_seen[device_id] = time.time()
             print("\033[2J\033[H", end="")
             render_table(last_data, last_seen)
             time.sleep(1)
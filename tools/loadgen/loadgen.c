@@ -0,0 +1,562 @@
+// Synthetic sender: streams run packets for a layout at a fixed frame rate,
+// with optional loss, duplication, reordering, inter-run skew and bursts, and
+// reports the rate it actually achieved.
+#define _GNU_SOURCE
+#include "loadgen_layout.h"
+#include "loadgen_packet.h"
+#include "loadgen_plan.h"
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <netinet/in.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+#define MAX_PAYLOAD_BYTES (LOADGEN_FRAME_ID_BYTES + LOADGEN_MAX_RUN_LEDS * 3)
+
+typedef struct {
+    const char *layout_path;
+    const char *host;
+    double fps;
+    double seconds;
+    unsigned int burst;
+    uint32_t start_frame;
+    uint32_t seed;
+    unsigned int fragment_leds;
+    bool batch;
+    unsigned int delta;
+    bool palette;
+    unsigned int downsample;
+    loadgen_impairments_t impairments;
+} options_t;
+
+typedef struct {
+    uint64_t frames;
+    uint64_t datagrams;
+    uint64_t bytes;
+    uint64_t send_errors;
+    uint64_t late_frames;
+} counters_t;
+
+static void usage(const char *program)
+{
+    fprintf(stderr,
+            "usage: %s --layout FILE [options]\n"
+            "  --layout FILE      layout JSON, e.g. config/left.json\n"
+            "  --host IP          destination (default: the layout's static_ip)\n"
+            "  --fps N            target frame rate (default 60)\n"
+            "  --seconds N        stop after N seconds, 0 runs until killed (default 10)\n"
+            "  --burst N          send frames in back-to-back groups of N at the same\n"
+            "                     average rate (default 1)\n"
+            "  --loss P           drop each datagram with probability P\n"
+            "  --duplicate P      send each datagram twice with probability P\n"
+            "  --reorder P        hold each datagram back until after the next frame\n"
+            "                     with probability P\n"
+            "  --skew-us N        delay each datagram by up to N us into its frame\n"
+            "  --parity           also send the XOR parity datagram\n"
+            "  --batch            pack runs that fit together into one datagram on\n"
+            "                     the extended port; impairments follow its first run\n"
+            "  --fragment-leds N  send runs longer than N LEDs as fragments on the\n"
+            "                     extended port (runs over one datagram always are)\n"
+            "  --delta N          send a slow-moving pattern as XOR+RLE deltas against\n"
+            "                     the previous frame, with an RGB keyframe every N\n"
+            "                     frames; not with --batch\n"
+            "  --palette          send a pattern of a dozen colours as palette blocks\n"
+            "                     on the extended port; not with --batch\n"
+            "  --downsample N     send a smooth gradient as one sample per N LEDs of\n"
+            "                     each section, for the firmware to interpolate; not\n"
+            "                     with --batch, --delta, --palette or --parity\n"
+            "  --start-frame N    first frame_id; 0xfffffff0 exercises wraparound\n"
+            "  --seed N           impairment RNG seed (default 1)\n",
+            program);
+}
+
+static bool parse_probability(const char *text, double *value)
+{
+    char *end;
+    *value = strtod(text, &end);
+    return *end == '\0' && *value >= 0.0 && *value <= 1.0;
+}
+
+static bool parse_options(int argc, char **argv, options_t *options)
+{
+    *options = (options_t){
+        .fps = 60.0,
+        .seconds = 10.0,
+        .burst = 1,
+        .seed = 1,
+    };
+    for (int index = 1; index < argc; ++index) {
+        const char *flag = argv[index];
+        if (strcmp(flag, "--parity") == 0) {
+            options->impairments.parity = true;
+            continue;
+        }
+        if (strcmp(flag, "--batch") == 0) {
+            options->batch = true;
+            continue;
+        }
+        if (strcmp(flag, "--palette") == 0) {
+            options->palette = true;
+            continue;
+        }
+        if (index + 1 >= argc) {
+            return false;
+        }
+        const char *value = argv[++index];
+        char *end = NULL;
+        bool ok = true;
+        if (strcmp(flag, "--layout") == 0) {
+            options->layout_path = value;
+        } else if (strcmp(flag, "--host") == 0) {
+            options->host = value;
+        } else if (strcmp(flag, "--fps") == 0) {
+            options->fps = strtod(value, &end);
+            ok = *end == '\0' && options->fps > 0.0;
+        } else if (strcmp(flag, "--seconds") == 0) {
+            options->seconds = strtod(value, &end);
+            ok = *end == '\0' && options->seconds >= 0.0;
+        } else if (strcmp(flag, "--burst") == 0) {
+            options->burst = (unsigned int)strtoul(value, &end, 0);
+            ok = *end == '\0' && options->burst > 0;
+        } else if (strcmp(flag, "--loss") == 0) {
+            ok = parse_probability(value, &options->impairments.loss);
+        } else if (strcmp(flag, "--duplicate") == 0) {
+            ok = parse_probability(value, &options->impairments.duplicate);
+        } else if (strcmp(flag, "--reorder") == 0) {
+            ok = parse_probability(value, &options->impairments.reorder);
+        } else if (strcmp(flag, "--skew-us") == 0) {
+            options->impairments.skew_us = (uint32_t)strtoul(value, &end, 0);
+            ok = *end == '\0';
+        } else if (strcmp(flag, "--start-frame") == 0) {
+            options->start_frame = (uint32_t)strtoul(value, &end, 0);
+            ok = *end == '\0';
+        } else if (strcmp(flag, "--fragment-leds") == 0) {
+            options->fragment_leds = (unsigned int)strtoul(value, &end, 0);
+            ok = *end == '\0';
+        } else if (strcmp(flag, "--delta") == 0) {
+            options->delta = (unsigned int)strtoul(value, &end, 0);
+            ok = *end == '\0' && options->delta > 0;
+        } else if (strcmp(flag, "--downsample") == 0) {
+            options->downsample = (unsigned int)strtoul(value, &end, 0);
+            ok = *end == '\0' && options->downsample > 0 &&
+                 options->downsample <= LOADGEN_SAMPLED_MAX_STRIDE;
+        } else if (strcmp(flag, "--seed") == 0) {
+            options->seed = (uint32_t)strtoul(value, &end, 0);
+            ok = *end == '\0';
+        } else {
+            ok = false;
+        }
+        if (!ok) {
+            fprintf(stderr, "invalid %s %s\n", flag, value);
+            return false;
+        }
+    }
+    if ((options->delta > 0 || options->palette) && options->batch) {
+        fprintf(stderr, "--delta and --palette cannot be combined with --batch\n");
+        return false;
+    }
+    // Interpolated runs differ from the payload parity would be computed over
+    if (options->downsample > 0 && (options->batch || options->delta > 0 || options->palette ||
+                                    options->impairments.parity)) {
+        fprintf(stderr,
+                "--downsample cannot be combined with --batch, --delta, --palette or --parity\n");
+        return false;
+    }
+    return options->layout_path != NULL;
+}
+
+static uint64_t now_ns(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000u + (uint64_t)now.tv_nsec;
+}
+
+static void sleep_until_ns(uint64_t deadline_ns)
+{
+    struct timespec deadline = {
+        .tv_sec = (time_t)(deadline_ns / 1000000000u),
+        .tv_nsec = (long)(deadline_ns % 1000000000u),
+    };
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, NULL) == EINTR) {
+    }
+}
+
+// Cheap patterns that change every frame, so a stale frame on a strip is
+// visible and the payload bytes are not all equal.
+typedef enum {
+    PATTERN_RAMP,  // every byte steps each frame
+    PATTERN_CHASE, // a fixed gradient with a short lit block moving one LED a frame
+    PATTERN_BANDS, // bands of a dozen colours moving one LED a frame
+    PATTERN_GRADIENT, // triangle waves per channel drifting one step a frame
+} pattern_t;
+
+#define CHASE_LEDS 8
+#define BAND_LEDS 8
+
+static const uint8_t BAND_COLOURS[][3] = {
+    {255, 0, 0},   {255, 128, 0}, {255, 255, 0}, {128, 255, 0}, {0, 255, 0},   {0, 255, 128},
+    {0, 255, 255}, {0, 128, 255}, {0, 0, 255},   {128, 0, 255}, {255, 0, 255}, {255, 0, 128},
+};
+
+static uint8_t pattern_byte(pattern_t pattern, uint32_t frame_id, unsigned int run,
+                            unsigned int led_count, size_t byte)
+{
+    size_t led = byte / 3;
+    switch (pattern) {
+    case PATTERN_CHASE: {
+        size_t chase = frame_id % led_count;
+        return led >= chase && led < chase + CHASE_LEDS ? 0xff : (uint8_t)(run * 64 + led);
+    }
+    case PATTERN_BANDS: {
+        size_t band = (led + frame_id) / BAND_LEDS % (sizeof(BAND_COLOURS) / sizeof(BAND_COLOURS[0]));
+        return BAND_COLOURS[band][byte % 3];
+    }
+    case PATTERN_GRADIENT: {
+        unsigned int phase = (unsigned int)(led * 2 + frame_id + run * 64 + byte % 3 * 170) & 0x1ff;
+        return (uint8_t)(phase > 0xff ? 0x1ff - phase : phase);
+    }
+    default:
+        return (uint8_t)(frame_id + run * 64 + byte);
+    }
+}
+
+static void fill_payloads(const loadgen_layout_t *layout, bool parity, pattern_t pattern,
+                          uint32_t frame_id, uint8_t payloads[][MAX_PAYLOAD_BYTES],
+                          size_t *lengths)
+{
+    size_t parity_bytes = 0;
+    for (unsigned int run = 0; run < layout->run_count; ++run) {
+        size_t pixel_bytes = layout->led_count[run] * 3;
+        uint8_t *payload = payloads[run];
+        loadgen_write_frame_id(payload, frame_id);
+        for (size_t byte = 0; byte < pixel_bytes; ++byte) {
+            payload[LOADGEN_FRAME_ID_BYTES + byte] =
+                pattern_byte(pattern, frame_id, run, layout->led_count[run], byte);
+        }
+        lengths[run] = LOADGEN_FRAME_ID_BYTES + pixel_bytes;
+        if (pixel_bytes > parity_bytes) {
+            parity_bytes = pixel_bytes;
+        }
+    }
+    if (!parity) {
+        return;
+    }
+    uint8_t *payload = payloads[layout->run_count];
+    memcpy(payload, payloads[0], LOADGEN_FRAME_ID_BYTES);
+    memset(payload + LOADGEN_FRAME_ID_BYTES, 0, parity_bytes);
+    for (unsigned int run = 0; run < layout->run_count; ++run) {
+        for (size_t byte = LOADGEN_FRAME_ID_BYTES; byte < lengths[run]; ++byte) {
+            payload[byte] ^= payloads[run][byte];
+        }
+    }
+    lengths[layout->run_count] = LOADGEN_FRAME_ID_BYTES + parity_bytes;
+}
+
+// Sends one planned run datagram, split into fragments when the run needs
+// them. With a base payload, of the previous frame, each fragment goes as a
+// delta against it, and with `palette` as a palette block, whichever is
+// smallest, RGB included. Impairments act on the run as a whole. Returns
+// false on a send error.
+static bool send_run(int sock, struct sockaddr_in *destination, const loadgen_layout_t *layout,
+                     unsigned int fragment_leds, const loadgen_datagram_t *planned,
+                     const uint8_t *payload, size_t length, const uint8_t *base_payload,
+                     bool palette, counters_t *counters)
+{
+    unsigned int run = planned->run;
+    bool compact = run < layout->run_count && (base_payload != NULL || palette);
+    if (compact && fragment_leds == 0) {
+        // Blocks hold a few LEDs less than a run datagram
+        fragment_leds = LOADGEN_FRAGMENT_MAX_LEDS;
+    }
+    unsigned int fragments = run < layout->run_count
+                                 ? loadgen_fragment_count(layout->led_count[run], fragment_leds)
+                                 : 1;
+    if (fragments == 1 && !compact) {
+        destination->sin_port = htons((uint16_t)(layout->port_base + run));
+        ssize_t sent = sendto(sock, payload, length, 0, (const struct sockaddr *)destination,
+                              sizeof(*destination));
+        if (sent < 0) {
+            return false;
+        }
+        counters->datagrams++;
+        counters->bytes += (uint64_t)sent;
+        return true;
+    }
+    uint8_t datagram[LOADGEN_UDP_MAX_PAYLOAD];
+    destination->sin_port =
+        htons((uint16_t)(layout->port_base + layout->run_count + LOADGEN_EXTENDED_PORT_GAP));
+    for (unsigned int index = 0; index < fragments; ++index) {
+        size_t fragment_length =
+            loadgen_encode_fragment(planned->frame_id, run, payload + LOADGEN_FRAME_ID_BYTES,
+                                    layout->led_count[run], fragment_leds, index, datagram);
+        uint8_t candidate[LOADGEN_UDP_MAX_PAYLOAD];
+        if (base_payload != NULL) {
+            size_t delta_length = loadgen_encode_delta_fragment(
+                planned->frame_id, planned->frame_id - 1, run, payload + LOADGEN_FRAME_ID_BYTES,
+                base_payload + LOADGEN_FRAME_ID_BYTES, layout->led_count[run], fragment_leds,
+                index, candidate);
+            if (delta_length > 0 && delta_length < fragment_length) {
+                memcpy(datagram, candidate, delta_length);
+                fragment_length = delta_length;
+            }
+        }
+        for (unsigned int bits = 4; palette && bits <= 8; bits += 4) {
+            size_t palette_length = loadgen_encode_palette_fragment(
+                planned->frame_id, run, payload + LOADGEN_FRAME_ID_BYTES, layout->led_count[run],
+                fragment_leds, index, bits, candidate);
+            if (palette_length > 0 && palette_length < fragment_length) {
+                memcpy(datagram, candidate, palette_length);
+                fragment_length = palette_length;
+            }
+        }
+        ssize_t sent = sendto(sock, datagram, fragment_length, 0,
+                              (const struct sockaddr *)destination, sizeof(*destination));
+        if (sent < 0) {
+            return false;
+        }
+        counters->datagrams++;
+        counters->bytes += (uint64_t)sent;
+    }
+    return true;
+}
+
+// Sends a run's sections sampled every `stride` LEDs, as many whole
+// sections per datagram as fit. Returns false on a send error; a run whose
+// section does not fit one datagram at this stride goes through send_run.
+static bool send_sampled_run(int sock, struct sockaddr_in *destination,
+                             const loadgen_layout_t *layout, unsigned int stride,
+                             const loadgen_datagram_t *planned, const uint8_t *payload,
+                             size_t length, counters_t *counters)
+{
+    unsigned int run = planned->run;
+    unsigned int fragments = loadgen_sampled_fragment_count(layout->section_leds[run],
+                                                            layout->section_count[run], stride);
+    if (fragments == 0) {
+        return send_run(sock, destination, layout, 0, planned, payload, length, NULL, false,
+                        counters);
+    }
+    uint8_t datagram[LOADGEN_UDP_MAX_PAYLOAD];
+    destination->sin_port =
+        htons((uint16_t)(layout->port_base + layout->run_count + LOADGEN_EXTENDED_PORT_GAP));
+    for (unsigned int index = 0; index < fragments; ++index) {
+        size_t fragment_length = loadgen_encode_sampled_fragment(
+            planned->frame_id, run, payload + LOADGEN_FRAME_ID_BYTES, layout->section_leds[run],
+            layout->section_count[run], stride, index, datagram);
+        ssize_t sent = sendto(sock, datagram, fragment_length, 0,
+                              (const struct sockaddr *)destination, sizeof(*destination));
+        if (sent < 0) {
+            return false;
+        }
+        counters->datagrams++;
+        counters->bytes += (uint64_t)sent;
+    }
+    return true;
+}
+
+// Groups consecutive runs into batched datagrams. A batch's first run holds
+// its run count and the others 0; runs sent on their own hold 1.
+static void plan_batches(const loadgen_layout_t *layout, unsigned int *batch_runs)
+{
+    unsigned int run = 0;
+    while (run < layout->run_count) {
+        unsigned int count = loadgen_batch_runs(layout->led_count, layout->run_count, run);
+        if (count < 2) {
+            batch_runs[run++] = 1;
+            continue;
+        }
+        batch_runs[run] = count;
+        for (unsigned int member = 1; member < count; ++member) {
+            batch_runs[run + member] = 0;
+        }
+        run += count;
+    }
+}
+
+static bool send_batch(int sock, struct sockaddr_in *destination, const loadgen_layout_t *layout,
+                       uint32_t frame_id, uint8_t payloads[][MAX_PAYLOAD_BYTES],
+                       unsigned int first_run, unsigned int count, counters_t *counters)
+{
+    const uint8_t *rgb[LOADGEN_MAX_RUNS];
+    for (unsigned int run = 0; run < layout->run_count; ++run) {
+        rgb[run] = payloads[run] + LOADGEN_FRAME_ID_BYTES;
+    }
+    uint8_t datagram[LOADGEN_UDP_MAX_PAYLOAD];
+    size_t length =
+        loadgen_encode_batch(frame_id, layout->led_count, rgb, first_run, count, datagram);
+    destination->sin_port =
+        htons((uint16_t)(layout->port_base + layout->run_count + LOADGEN_EXTENDED_PORT_GAP));
+    ssize_t sent = sendto(sock, datagram, length, 0, (const struct sockaddr *)destination,
+                          sizeof(*destination));
+    if (sent < 0) {
+        return false;
+    }
+    counters->datagrams++;
+    counters->bytes += (uint64_t)sent;
+    return true;
+}
+
+static void print_rate(const char *label, const counters_t *counters, double elapsed_s,
+                       const loadgen_plan_stats_t *stats)
+{
+    printf("%s %.1fs frames %llu (%.1f fps) datagrams %llu (%.1f/s, %.1f Mbit/s) "
+           "lost %u duplicated %u reordered %u late %llu send_errors %llu\n",
+           label, elapsed_s, (unsigned long long)counters->frames,
+           counters->frames / elapsed_s, (unsigned long long)counters->datagrams,
+           counters->datagrams / elapsed_s, counters->bytes * 8.0 / elapsed_s / 1e6,
+           (unsigned int)stats->lost, (unsigned int)stats->duplicated,
+           (unsigned int)stats->reordered, (unsigned long long)counters->late_frames,
+           (unsigned long long)counters->send_errors);
+    fflush(stdout);
+}
+
+int main(int argc, char **argv)
+{
+    options_t options;
+    if (!parse_options(argc, argv, &options)) {
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    loadgen_layout_t layout;
+    char error[128];
+    if (!loadgen_layout_load(options.layout_path, &layout, error, sizeof(error))) {
+        fprintf(stderr, "%s: %s\n", options.layout_path, error);
+        return EXIT_FAILURE;
+    }
+    // gen_config.py turns parity off when it would need IP fragmentation
+    unsigned int longest_run = 0;
+    for (unsigned int run = 0; run < layout.run_count; ++run) {
+        if (layout.led_count[run] > longest_run) {
+            longest_run = layout.led_count[run];
+        }
+    }
+    if (options.impairments.parity &&
+        LOADGEN_FRAME_ID_BYTES + longest_run * 3 > LOADGEN_UDP_MAX_PAYLOAD) {
+        fprintf(stderr, "--parity: a %u-LED run does not fit one parity datagram\n", longest_run);
+        return EXIT_FAILURE;
+    }
+
+    struct sockaddr_in destination = {.sin_family = AF_INET};
+    if (options.host != NULL) {
+        if (inet_pton(AF_INET, options.host, &destination.sin_addr) != 1) {
+            fprintf(stderr, "invalid --host %s\n", options.host);
+            return EXIT_FAILURE;
+        }
+    } else {
+        memcpy(&destination.sin_addr, layout.static_ip, 4);
+    }
+
+    int sock = socket(AF_INET, SOCK_DGRAM, 0);
+    if (sock < 0) {
+        perror("socket");
+        return EXIT_FAILURE;
+    }
+    // A deep send buffer absorbs bursts instead of failing with ENOBUFS
+    int send_buffer = 4 * 1024 * 1024;
+    setsockopt(sock, SOL_SOCKET, SO_SNDBUF, &send_buffer, sizeof(send_buffer));
+
+    loadgen_plan_t plan;
+    loadgen_plan_init(&plan, layout.run_count, &options.impairments, options.seed);
+
+    // Payloads for this frame and the previous one, which reordered
+    // datagrams still need
+    static uint8_t payloads[2][LOADGEN_MAX_RUNS + 1][MAX_PAYLOAD_BYTES];
+    size_t lengths[2][LOADGEN_MAX_RUNS + 1];
+    loadgen_datagram_t datagrams[LOADGEN_MAX_FRAME_DATAGRAMS];
+    unsigned int batch_runs[LOADGEN_MAX_RUNS];
+    plan_batches(&layout, batch_runs);
+    pattern_t pattern = options.palette          ? PATTERN_BANDS
+                        : options.delta > 0      ? PATTERN_CHASE
+                        : options.downsample > 0 ? PATTERN_GRADIENT
+                                                 : PATTERN_RAMP;
+
+    char destination_text[INET_ADDRSTRLEN];
+    inet_ntop(AF_INET, &destination.sin_addr, destination_text, sizeof(destination_text));
+    printf("sending %u runs to %s:%u.. at %.1f fps\n", layout.run_count, destination_text,
+           (unsigned int)layout.port_base, options.fps);
+
+    const uint64_t period_ns = (uint64_t)(1e9 / options.fps);
+    const uint64_t start_ns = now_ns();
+    const uint64_t end_ns = options.seconds > 0 ? start_ns + (uint64_t)(options.seconds * 1e9) : 0;
+    uint64_t schedule_base_ns = start_ns;
+    uint64_t schedule_frame = 0;
+    uint64_t next_report_ns = start_ns + 1000000000u;
+    counters_t counters = {0};
+    uint32_t frame_id = options.start_frame;
+
+    for (uint64_t frame = 0;; ++frame, ++frame_id) {
+        // Frames in a burst share one start time; the group as a whole keeps
+        // the average rate
+        uint64_t relative = frame - schedule_frame;
+        uint64_t frame_start_ns =
+            schedule_base_ns + relative / options.burst * options.burst * period_ns;
+        uint64_t now = now_ns();
+        if (end_ns != 0 && frame_start_ns >= end_ns) {
+            break;
+        }
+        if (now > frame_start_ns + period_ns) {
+            // Fell a whole period behind: count it and restart the schedule
+            // here rather than firing a catch-up burst nobody asked for
+            counters.late_frames++;
+            schedule_base_ns = now;
+            schedule_frame = frame;
+            frame_start_ns = now;
+        }
+
+        unsigned int current = frame & 1;
+        fill_payloads(&layout, options.impairments.parity, pattern, frame_id, payloads[current],
+                      lengths[current]);
+        size_t count = loadgen_plan_frame(&plan, frame_id, datagrams);
+        sleep_until_ns(frame_start_ns);
+        for (size_t index = 0; index < count; ++index) {
+            const loadgen_datagram_t *datagram = &datagrams[index];
+            unsigned int buffer = datagram->frame_id == frame_id ? current : current ^ 1;
+            sleep_until_ns(frame_start_ns + (uint64_t)datagram->offset_us * 1000u);
+            unsigned int run = datagram->run;
+            if (options.batch && run < layout.run_count && batch_runs[run] != 1) {
+                // Members after the first travel in the first run's datagram
+                if (batch_runs[run] > 1 &&
+                    !send_batch(sock, &destination, &layout, datagram->frame_id,
+                                payloads[buffer], run, batch_runs[run], &counters)) {
+                    counters.send_errors++;
+                }
+                continue;
+            }
+            if (options.downsample > 0 && run < layout.run_count) {
+                if (!send_sampled_run(sock, &destination, &layout, options.downsample, datagram,
+                                      payloads[buffer][run], lengths[buffer][run], &counters)) {
+                    counters.send_errors++;
+                }
+                continue;
+            }
+            // Only the current frame has its predecessor at hand; reordered
+            // datagrams of the previous frame go as keyframes
+            bool keyframe = options.delta == 0 || frame % options.delta == 0 ||
+                            buffer != current || run >= layout.run_count;
+            const uint8_t *base = keyframe ? NULL : payloads[current ^ 1][run];
+            if (!send_run(sock, &destination, &layout, options.fragment_leds, datagram,
+                          payloads[buffer][datagram->run], lengths[buffer][datagram->run], base,
+                          options.palette, &counters)) {
+                counters.send_errors++;
+            }
+        }
+        counters.frames++;
+
+        now = now_ns();
+        if (now >= next_report_ns) {
+            print_rate("progress", &counters, (now - start_ns) / 1e9, &plan.stats);
+            next_report_ns += 1000000000u;
+        }
+    }
+
+    print_rate("total", &counters, (now_ns() - start_ns) / 1e9, &plan.stats);
+    close(sock);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,360 @@
+#include "loadgen_layout.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Just enough JSON to walk a layout file: keys the sender needs are read,
+// everything else (section geometry, sampling, ...) is skipped structurally.
+typedef struct {
+    const char *at;
+    char *error;
+    size_t error_len;
+} cursor_t;
+
+static bool fail(cursor_t *cursor, const char *reason)
+{
+    if (cursor->error_len > 0) {
+        snprintf(cursor->error, cursor->error_len, "%s", reason);
+    }
+    return false;
+}
+
+static void skip_space(cursor_t *cursor)
+{
+    while (*cursor->at == ' ' || *cursor->at == '\t' || *cursor->at == '\n' ||
+           *cursor->at == '\r') {
+        ++cursor->at;
+    }
+}
+
+static bool expect(cursor_t *cursor, char token)
+{
+    skip_space(cursor);
+    if (*cursor->at != token) {
+        return fail(cursor, "malformed JSON");
+    }
+    ++cursor->at;
+    return true;
+}
+
+// Reads a string into `out`, truncating it; escapes are kept verbatim since
+// no key or value the sender reads contains one.
+static bool parse_string(cursor_t *cursor, char *out, size_t out_len)
+{
+    if (!expect(cursor, '"')) {
+        return false;
+    }
+    size_t length = 0;
+    while (*cursor->at != '"') {
+        if (*cursor->at == '\0') {
+            return fail(cursor, "unterminated string");
+        }
+        if (*cursor->at == '\\' && cursor->at[1] != '\0') {
+            ++cursor->at;
+        }
+        if (length + 1 < out_len) {
+            out[length++] = *cursor->at;
+        }
+        ++cursor->at;
+    }
+    ++cursor->at;
+    if (out_len > 0) {
+        out[length] = '\0';
+    }
+    return true;
+}
+
+static bool parse_number(cursor_t *cursor, double *value)
+{
+    skip_space(cursor);
+    char *end;
+    *value = strtod(cursor->at, &end);
+    if (end == cursor->at) {
+        return fail(cursor, "expected a number");
+    }
+    cursor->at = end;
+    return true;
+}
+
+static bool parse_uint(cursor_t *cursor, unsigned long max, unsigned long *value)
+{
+    double number;
+    if (!parse_number(cursor, &number)) {
+        return false;
+    }
+    if (number < 0 || number > (double)max || number != (double)(unsigned long)number) {
+        return fail(cursor, "integer out of range");
+    }
+    *value = (unsigned long)number;
+    return true;
+}
+
+static bool skip_value(cursor_t *cursor, unsigned int depth);
+
+// Calls `member` for each key of an object; `member` must consume the value.
+static bool parse_object(cursor_t *cursor,
+                         bool (*member)(cursor_t *cursor, const char *key, void *context),
+                         void *context)
+{
+    if (!expect(cursor, '{')) {
+        return false;
+    }
+    skip_space(cursor);
+    if (*cursor->at == '}') {
+        ++cursor->at;
+        return true;
+    }
+    for (;;) {
+        char key[32];
+        if (!parse_string(cursor, key, sizeof(key)) || !expect(cursor, ':') ||
+            !member(cursor, key, context)) {
+            return false;
+        }
+        skip_space(cursor);
+        if (*cursor->at == ',') {
+            ++cursor->at;
+            continue;
+        }
+        return expect(cursor, '}');
+    }
+}
+
+// Calls `element` for each array element; `element` must consume it.
+static bool parse_array(cursor_t *cursor,
+                        bool (*element)(cursor_t *cursor, unsigned int index, void *context),
+                        void *context)
+{
+    if (!expect(cursor, '[')) {
+        return false;
+    }
+    skip_space(cursor);
+    if (*cursor->at == ']') {
+        ++cursor->at;
+        return true;
+    }
+    for (unsigned int index = 0;; ++index) {
+        if (!element(cursor, index, context)) {
+            return false;
+        }
+        skip_space(cursor);
+        if (*cursor->at == ',') {
+            ++cursor->at;
+            continue;
+        }
+        return expect(cursor, ']');
+    }
+}
+
+typedef struct {
+    unsigned int depth;
+} skip_context_t;
+
+static bool skip_member(cursor_t *cursor, const char *key, void *context)
+{
+    (void)key;
+    return skip_value(cursor, ((skip_context_t *)context)->depth);
+}
+
+static bool skip_element(cursor_t *cursor, unsigned int index, void *context)
+{
+    (void)index;
+    return skip_value(cursor, ((skip_context_t *)context)->depth);
+}
+
+static bool skip_value(cursor_t *cursor, unsigned int depth)
+{
+    if (depth > 16) {
+        return fail(cursor, "JSON nested too deeply");
+    }
+    skip_context_t inner = {depth + 1};
+    skip_space(cursor);
+    switch (*cursor->at) {
+    case '{':
+        return parse_object(cursor, skip_member, &inner);
+    case '[':
+        return parse_array(cursor, skip_element, &inner);
+    case '"': {
+        char ignored[1];
+        return parse_string(cursor, ignored, sizeof(ignored));
+    }
+    default:
+        break;
+    }
+    static const char *const LITERALS[] = {"true", "false", "null"};
+    for (size_t index = 0; index < sizeof(LITERALS) / sizeof(LITERALS[0]); ++index) {
+        size_t length = strlen(LITERALS[index]);
+        if (strncmp(cursor->at, LITERALS[index], length) == 0) {
+            cursor->at += length;
+            return true;
+        }
+    }
+    double ignored;
+    return parse_number(cursor, &ignored);
+}
+
+typedef struct {
+    loadgen_layout_t *layout;
+    unsigned int seen_mask;
+} layout_context_t;
+
+typedef struct {
+    bool has_index;
+    bool has_count;
+    unsigned long run_index;
+    unsigned long led_count;
+    unsigned int section_count;
+    unsigned int section_leds[LOADGEN_MAX_SECTIONS];
+} run_fields_t;
+
+static bool section_member(cursor_t *cursor, const char *key, void *context)
+{
+    if (strcmp(key, "led_count") == 0) {
+        return parse_uint(cursor, LOADGEN_MAX_RUN_LEDS, context);
+    }
+    return skip_value(cursor, 2);
+}
+
+static bool section_element(cursor_t *cursor, unsigned int index, void *context)
+{
+    run_fields_t *fields = context;
+    if (index >= LOADGEN_MAX_SECTIONS) {
+        return fail(cursor, "too many sections");
+    }
+    unsigned long led_count = 0;
+    if (!parse_object(cursor, section_member, &led_count)) {
+        return false;
+    }
+    if (led_count == 0) {
+        return fail(cursor, "section needs a positive led_count");
+    }
+    fields->section_leds[fields->section_count++] = (unsigned int)led_count;
+    return true;
+}
+
+static bool run_member(cursor_t *cursor, const char *key, void *context)
+{
+    run_fields_t *fields = context;
+    if (strcmp(key, "sections") == 0) {
+        return parse_array(cursor, section_element, fields);
+    }
+    if (strcmp(key, "run_index") == 0) {
+        fields->has_index = true;
+        return parse_uint(cursor, LOADGEN_MAX_RUNS - 1, &fields->run_index);
+    }
+    if (strcmp(key, "led_count") == 0) {
+        fields->has_count = true;
+        return parse_uint(cursor, LOADGEN_MAX_RUN_LEDS, &fields->led_count);
+    }
+    return skip_value(cursor, 1);
+}
+
+static bool run_element(cursor_t *cursor, unsigned int index, void *context)
+{
+    layout_context_t *layout_context = context;
+    if (index >= LOADGEN_MAX_RUNS) {
+        return fail(cursor, "too many runs");
+    }
+    run_fields_t fields = {0};
+    if (!parse_object(cursor, run_member, &fields)) {
+        return false;
+    }
+    if (!fields.has_index || !fields.has_count) {
+        return fail(cursor, "run needs run_index and led_count");
+    }
+    unsigned int bit = 1u << fields.run_index;
+    if (layout_context->seen_mask & bit) {
+        return fail(cursor, "duplicate run_index");
+    }
+    layout_context->seen_mask |= bit;
+    loadgen_layout_t *layout = layout_context->layout;
+    layout->led_count[fields.run_index] = (unsigned int)fields.led_count;
+    if (fields.section_count == 0) {
+        fields.section_leds[fields.section_count++] = (unsigned int)fields.led_count;
+    }
+    unsigned long covered = 0;
+    for (unsigned int section = 0; section < fields.section_count; ++section) {
+        covered += fields.section_leds[section];
+    }
+    if (covered != fields.led_count) {
+        return fail(cursor, "sections must add up to the run's led_count");
+    }
+    layout->section_count[fields.run_index] = fields.section_count;
+    memcpy(layout->section_leds[fields.run_index], fields.section_leds,
+           sizeof(fields.section_leds));
+    layout->run_count++;
+    return true;
+}
+
+static bool ip_element(cursor_t *cursor, unsigned int index, void *context)
+{
+    loadgen_layout_t *layout = context;
+    if (index >= 4) {
+        return fail(cursor, "static_ip needs four octets");
+    }
+    unsigned long octet;
+    if (!parse_uint(cursor, 255, &octet)) {
+        return false;
+    }
+    layout->static_ip[index] = (uint8_t)octet;
+    return true;
+}
+
+static bool layout_member(cursor_t *cursor, const char *key, void *context)
+{
+    layout_context_t *layout_context = context;
+    if (strcmp(key, "port_base") == 0) {
+        unsigned long port;
+        if (!parse_uint(cursor, UINT16_MAX, &port)) {
+            return false;
+        }
+        layout_context->layout->port_base = (uint16_t)port;
+        return true;
+    }
+    if (strcmp(key, "static_ip") == 0) {
+        return parse_array(cursor, ip_element, layout_context->layout);
+    }
+    if (strcmp(key, "runs") == 0) {
+        return parse_array(cursor, run_element, layout_context);
+    }
+    return skip_value(cursor, 1);
+}
+
+bool loadgen_layout_parse(const char *json, loadgen_layout_t *layout, char *error,
+                          size_t error_len)
+{
+    cursor_t cursor = {json, error, error_len};
+    memset(layout, 0, sizeof(*layout));
+    layout_context_t context = {layout, 0};
+    if (!parse_object(&cursor, layout_member, &context)) {
+        return false;
+    }
+    if (layout->port_base == 0) {
+        return fail(&cursor, "missing port_base");
+    }
+    if (layout->run_count == 0 || context.seen_mask != (1u << layout->run_count) - 1) {
+        return fail(&cursor, "run_index values must be 0..N-1");
+    }
+    return true;
+}
+
+bool loadgen_layout_load(const char *path, loadgen_layout_t *layout, char *error,
+                         size_t error_len)
+{
+    FILE *file = fopen(path, "rb");
+    if (file == NULL) {
+        snprintf(error, error_len, "cannot open %s", path);
+        return false;
+    }
+    // Layout files are a few KB; anything much larger is not a layout
+    char json[64 * 1024];
+    size_t length = fread(json, 1, sizeof(json) - 1, file);
+    bool truncated = !feof(file);
+    fclose(file);
+    if (truncated) {
+        snprintf(error, error_len, "%s is too large for a layout", path);
+        return false;
+    }
+    json[length] = '\0';
+    return loadgen_layout_parse(json, layout, error, error_len);
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Same limits gen_config.py enforces on layout files
+#define LOADGEN_MAX_RUNS 4
+#define LOADGEN_MAX_RUN_LEDS 1024
+#define LOADGEN_MAX_SECTIONS 16
+
+// The parts of a layout JSON (config/*.json) a sender needs.
+typedef struct {
+    uint8_t static_ip[4];
+    uint16_t port_base;
+    unsigned int run_count;
+    unsigned int led_count[LOADGEN_MAX_RUNS];
+    // LED count of each section of a run, in LED order
+    unsigned int section_count[LOADGEN_MAX_RUNS];
+    unsigned int section_leds[LOADGEN_MAX_RUNS][LOADGEN_MAX_SECTIONS];
+} loadgen_layout_t;
+
+// Parses a layout document. Runs are stored by run_index, which must cover
+// 0..run_count-1 exactly once. A run without sections is one section;
+// otherwise its sections must add up to its led_count, as gen_config.py
+// requires. On failure returns false and writes a short reason to `error`.
+bool loadgen_layout_parse(const char *json, loadgen_layout_t *layout, char *error,
+                          size_t error_len);
+
+// Reads and parses a layout file.
+bool loadgen_layout_load(const char *path, loadgen_layout_t *layout, char *error,
+                         size_t error_len);
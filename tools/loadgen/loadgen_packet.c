@@ -0,0 +1,323 @@
+#include "loadgen_packet.h"
+
+#include <stdbool.h>
+#include <string.h>
+
+static unsigned int fragment_leds(unsigned int max_leds)
+{
+    return max_leds > 0 && max_leds < LOADGEN_FRAGMENT_MAX_LEDS ? max_leds
+                                                               : LOADGEN_FRAGMENT_MAX_LEDS;
+}
+
+void loadgen_write_frame_id(uint8_t *out, uint32_t frame_id)
+{
+    out[0] = (uint8_t)(frame_id >> 24);
+    out[1] = (uint8_t)(frame_id >> 16);
+    out[2] = (uint8_t)(frame_id >> 8);
+    out[3] = (uint8_t)frame_id;
+}
+
+unsigned int loadgen_fragment_count(unsigned int led_count, unsigned int max_leds)
+{
+    bool fits = LOADGEN_FRAME_ID_BYTES + led_count * 3 <= LOADGEN_UDP_MAX_PAYLOAD;
+    if (fits && (max_leds == 0 || led_count <= max_leds)) {
+        return 1;
+    }
+    unsigned int per_fragment = fragment_leds(max_leds);
+    return (led_count + per_fragment - 1) / per_fragment;
+}
+
+static void write_extended_header(uint8_t *out, uint32_t frame_id, unsigned int block_count)
+{
+    loadgen_write_frame_id(out, frame_id);
+    out[4] = 'W';
+    out[5] = 'X';
+    out[6] = 1;
+    out[7] = (uint8_t)block_count;
+}
+
+static void write_block_header(uint8_t *block, unsigned int run, unsigned int encoding,
+                               unsigned int index, unsigned int count, unsigned int first_led,
+                               size_t payload_bytes)
+{
+    block[0] = (uint8_t)run;
+    block[1] = (uint8_t)encoding;
+    block[2] = (uint8_t)index;
+    block[3] = (uint8_t)count;
+    block[4] = (uint8_t)(first_led >> 8);
+    block[5] = (uint8_t)first_led;
+    block[6] = (uint8_t)(payload_bytes >> 8);
+    block[7] = (uint8_t)payload_bytes;
+}
+
+// Writes one RGB block and returns its size
+static size_t write_block(uint8_t *block, unsigned int run, unsigned int index,
+                          unsigned int count, unsigned int first_led, const uint8_t *rgb,
+                          size_t payload_bytes)
+{
+    write_block_header(block, run, 0, index, count, first_led, payload_bytes);
+    memcpy(block + LOADGEN_BLOCK_HEADER_BYTES, rgb, payload_bytes);
+    return LOADGEN_BLOCK_HEADER_BYTES + payload_bytes;
+}
+
+// The LEDs fragment `index` covers, and how many fragments there are
+static unsigned int fragment_span(unsigned int led_count, unsigned int max_leds,
+                                  unsigned int index, unsigned int *first, unsigned int *count)
+{
+    unsigned int per_fragment = fragment_leds(max_leds);
+    *first = index * per_fragment;
+    *count = (led_count + per_fragment - 1) / per_fragment;
+    return led_count - *first < per_fragment ? led_count - *first : per_fragment;
+}
+
+size_t loadgen_encode_fragment(uint32_t frame_id, unsigned int run, const uint8_t *rgb,
+                               unsigned int led_count, unsigned int max_leds, unsigned int index,
+                               uint8_t *out)
+{
+    unsigned int first;
+    unsigned int count;
+    unsigned int leds = fragment_span(led_count, max_leds, index, &first, &count);
+    size_t payload_bytes = (size_t)leds * 3;
+
+    write_extended_header(out, frame_id, 1);
+    return LOADGEN_EXTENDED_HEADER_BYTES +
+           write_block(out + LOADGEN_EXTENDED_HEADER_BYTES, run, index, count, first,
+                       rgb + (size_t)first * 3, payload_bytes);
+}
+
+// Unchanged bytes cost one token per 128, literals one per 128 plus
+// themselves, so a lone unchanged byte between changes stays a literal.
+size_t loadgen_xor_rle(const uint8_t *rgb, const uint8_t *base, size_t bytes, uint8_t *out,
+                       size_t capacity)
+{
+    size_t length = 0;
+    size_t at = 0;
+    while (at < bytes) {
+        size_t same = 0;
+        while (at + same < bytes && same < 128 && rgb[at + same] == base[at + same]) {
+            ++same;
+        }
+        if (same >= 2 || at + same == bytes) {
+            if (length + 1 > capacity) {
+                return 0;
+            }
+            out[length++] = (uint8_t)(same - 1);
+            at += same;
+            continue;
+        }
+        size_t literals = 0;
+        while (at + literals < bytes && literals < 128) {
+            size_t next = at + literals;
+            bool unchanged_pair = next + 1 < bytes && rgb[next] == base[next] &&
+                                  rgb[next + 1] == base[next + 1];
+            if (literals > 0 && unchanged_pair) {
+                break;
+            }
+            ++literals;
+        }
+        if (length + 1 + literals > capacity) {
+            return 0;
+        }
+        out[length++] = (uint8_t)(0x7f + literals);
+        for (size_t index = 0; index < literals; ++index) {
+            out[length++] = rgb[at + index] ^ base[at + index];
+        }
+        at += literals;
+    }
+    return length;
+}
+
+size_t loadgen_encode_delta_fragment(uint32_t frame_id, uint32_t base_frame_id, unsigned int run,
+                                     const uint8_t *rgb, const uint8_t *base_rgb,
+                                     unsigned int led_count, unsigned int max_leds,
+                                     unsigned int index, uint8_t *out)
+{
+    unsigned int first;
+    unsigned int count;
+    unsigned int leds = fragment_span(led_count, max_leds, index, &first, &count);
+    uint8_t *block = out + LOADGEN_EXTENDED_HEADER_BYTES;
+    uint8_t *payload = block + LOADGEN_BLOCK_HEADER_BYTES;
+    size_t capacity = LOADGEN_UDP_MAX_PAYLOAD - (size_t)(payload - out) -
+                      LOADGEN_DELTA_HEADER_BYTES;
+    size_t tokens = loadgen_xor_rle(rgb + (size_t)first * 3, base_rgb + (size_t)first * 3,
+                                    (size_t)leds * 3, payload + LOADGEN_DELTA_HEADER_BYTES,
+                                    capacity);
+    if (tokens == 0) {
+        return 0;
+    }
+    size_t payload_bytes = LOADGEN_DELTA_HEADER_BYTES + tokens;
+    write_extended_header(out, frame_id, 1);
+    write_block_header(block, run, 1, index, count, first, payload_bytes);
+    loadgen_write_frame_id(payload, base_frame_id);
+    payload[4] = (uint8_t)(leds >> 8);
+    payload[5] = (uint8_t)leds;
+    return LOADGEN_EXTENDED_HEADER_BYTES + LOADGEN_BLOCK_HEADER_BYTES + payload_bytes;
+}
+
+unsigned int loadgen_build_palette(const uint8_t *rgb, unsigned int leds, unsigned int max_colours,
+                                   uint8_t *palette, uint8_t *indices)
+{
+    unsigned int colours = 0;
+    for (unsigned int led = 0; led < leds; ++led) {
+        const uint8_t *pixel = rgb + (size_t)led * 3;
+        unsigned int colour = 0;
+        while (colour < colours && memcmp(palette + colour * 3, pixel, 3) != 0) {
+            ++colour;
+        }
+        if (colour == colours) {
+            if (colours == max_colours) {
+                return 0;
+            }
+            memcpy(palette + colours * 3, pixel, 3);
+            ++colours;
+        }
+        indices[led] = (uint8_t)colour;
+    }
+    return colours;
+}
+
+size_t loadgen_encode_palette_fragment(uint32_t frame_id, unsigned int run, const uint8_t *rgb,
+                                       unsigned int led_count, unsigned int max_leds,
+                                       unsigned int index, unsigned int bits, uint8_t *out)
+{
+    unsigned int first;
+    unsigned int count;
+    unsigned int leds = fragment_span(led_count, max_leds, index, &first, &count);
+    uint8_t palette[256 * 3];
+    uint8_t indices[LOADGEN_FRAGMENT_MAX_LEDS];
+    unsigned int colours =
+        loadgen_build_palette(rgb + (size_t)first * 3, leds, 1u << bits, palette, indices);
+    if (colours == 0) {
+        return 0;
+    }
+    uint8_t *block = out + LOADGEN_EXTENDED_HEADER_BYTES;
+    uint8_t *payload = block + LOADGEN_BLOCK_HEADER_BYTES;
+    payload[0] = (uint8_t)(leds >> 8);
+    payload[1] = (uint8_t)leds;
+    payload[2] = (uint8_t)(colours - 1);
+    memcpy(payload + LOADGEN_PALETTE_HEADER_BYTES, palette, (size_t)colours * 3);
+    uint8_t *packed = payload + LOADGEN_PALETTE_HEADER_BYTES + (size_t)colours * 3;
+    size_t index_bytes = bits == 8 ? leds : (leds + 1) / 2;
+    if (bits == 8) {
+        memcpy(packed, indices, leds);
+    } else {
+        memset(packed, 0, index_bytes);
+        for (unsigned int led = 0; led < leds; ++led) {
+            packed[led / 2] |= (uint8_t)(led % 2 == 0 ? indices[led] << 4 : indices[led]);
+        }
+    }
+    size_t payload_bytes = (size_t)(packed + index_bytes - payload);
+    write_extended_header(out, frame_id, 1);
+    write_block_header(block, run, bits == 8 ? 2 : 3, index, count, first, payload_bytes);
+    return LOADGEN_EXTENDED_HEADER_BYTES + LOADGEN_BLOCK_HEADER_BYTES + payload_bytes;
+}
+
+unsigned int loadgen_section_samples(unsigned int leds, unsigned int stride)
+{
+    return (leds + stride - 2) / stride + 1;
+}
+
+// Sections, from `first` on, whose samples fit one block
+static unsigned int sampled_fragment_sections(const unsigned int *section_leds,
+                                              unsigned int section_count, unsigned int stride,
+                                              unsigned int first)
+{
+    size_t length = LOADGEN_EXTENDED_HEADER_BYTES + LOADGEN_BLOCK_HEADER_BYTES +
+                    LOADGEN_SAMPLED_HEADER_BYTES;
+    unsigned int count = 0;
+    for (unsigned int section = first; section < section_count; ++section) {
+        length += (size_t)loadgen_section_samples(section_leds[section], stride) * 3;
+        if (length > LOADGEN_UDP_MAX_PAYLOAD) {
+            break;
+        }
+        ++count;
+    }
+    return count;
+}
+
+unsigned int loadgen_sampled_fragment_count(const unsigned int *section_leds,
+                                            unsigned int section_count, unsigned int stride)
+{
+    if (stride == 0 || stride > LOADGEN_SAMPLED_MAX_STRIDE) {
+        return 0;
+    }
+    unsigned int fragments = 0;
+    for (unsigned int section = 0; section < section_count; ++fragments) {
+        unsigned int count =
+            sampled_fragment_sections(section_leds, section_count, stride, section);
+        if (count == 0) {
+            return 0;
+        }
+        section += count;
+    }
+    return fragments;
+}
+
+size_t loadgen_encode_sampled_fragment(uint32_t frame_id, unsigned int run, const uint8_t *rgb,
+                                       const unsigned int *section_leds,
+                                       unsigned int section_count, unsigned int stride,
+                                       unsigned int index, uint8_t *out)
+{
+    unsigned int fragments = loadgen_sampled_fragment_count(section_leds, section_count, stride);
+    if (index >= fragments) {
+        return 0;
+    }
+    // Walk to the fragment's first section
+    unsigned int section = 0;
+    unsigned int first_led = 0;
+    unsigned int count = sampled_fragment_sections(section_leds, section_count, stride, section);
+    for (unsigned int fragment = 0; fragment < index; ++fragment) {
+        for (unsigned int skipped = 0; skipped < count; ++skipped) {
+            first_led += section_leds[section++];
+        }
+        count = sampled_fragment_sections(section_leds, section_count, stride, section);
+    }
+    uint8_t *block = out + LOADGEN_EXTENDED_HEADER_BYTES;
+    uint8_t *payload = block + LOADGEN_BLOCK_HEADER_BYTES;
+    uint8_t *samples = payload + LOADGEN_SAMPLED_HEADER_BYTES;
+    unsigned int leds = 0;
+    for (unsigned int end = section + count; section < end; ++section) {
+        const uint8_t *section_rgb = rgb + (size_t)(first_led + leds) * 3;
+        unsigned int last = section_leds[section] - 1;
+        for (unsigned int led = 0; led < last; led += stride, samples += 3) {
+            memcpy(samples, section_rgb + (size_t)led * 3, 3);
+        }
+        memcpy(samples, section_rgb + (size_t)last * 3, 3);
+        samples += 3;
+        leds += section_leds[section];
+    }
+    payload[0] = (uint8_t)(leds >> 8);
+    payload[1] = (uint8_t)leds;
+    payload[2] = (uint8_t)stride;
+    size_t payload_bytes = (size_t)(samples - payload);
+    write_extended_header(out, frame_id, 1);
+    write_block_header(block, run, 4, index, fragments, first_led, payload_bytes);
+    return LOADGEN_EXTENDED_HEADER_BYTES + LOADGEN_BLOCK_HEADER_BYTES + payload_bytes;
+}
+
+unsigned int loadgen_batch_runs(const unsigned int *led_counts, unsigned int run_count,
+                                unsigned int first_run)
+{
+    size_t length = LOADGEN_EXTENDED_HEADER_BYTES;
+    unsigned int count = 0;
+    for (unsigned int run = first_run; run < run_count; ++run) {
+        length += LOADGEN_BLOCK_HEADER_BYTES + (size_t)led_counts[run] * 3;
+        if (length > LOADGEN_UDP_MAX_PAYLOAD) {
+            break;
+        }
+        ++count;
+    }
+    return count;
+}
+
+size_t loadgen_encode_batch(uint32_t frame_id, const unsigned int *led_counts,
+                            const uint8_t *const *rgb, unsigned int first_run,
+                            unsigned int count, uint8_t *out)
+{
+    write_extended_header(out, frame_id, count);
+    size_t length = LOADGEN_EXTENDED_HEADER_BYTES;
+    for (unsigned int run = first_run; run < first_run + count; ++run) {
+        length += write_block(out + length, run, 0, 1, 0, rgb[run], (size_t)led_counts[run] * 3);
+    }
+    return length;
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Datagram formats a sender writes, as firmware/main/rx_task.h defines them.
+#define LOADGEN_FRAME_ID_BYTES 4
+#define LOADGEN_UDP_MAX_PAYLOAD 1472
+#define LOADGEN_EXTENDED_HEADER_BYTES 8
+#define LOADGEN_BLOCK_HEADER_BYTES 8
+#define LOADGEN_MAX_FRAGMENTS 32
+#define LOADGEN_DELTA_HEADER_BYTES 6
+#define LOADGEN_PALETTE_HEADER_BYTES 3
+#define LOADGEN_SAMPLED_HEADER_BYTES 3
+#define LOADGEN_SAMPLED_MAX_STRIDE 128
+#define LOADGEN_FRAGMENT_MAX_LEDS \
+    ((LOADGEN_UDP_MAX_PAYLOAD - LOADGEN_EXTENDED_HEADER_BYTES - LOADGEN_BLOCK_HEADER_BYTES) / 3)
+// Extended datagrams go to port_base + run_count + LOADGEN_EXTENDED_PORT_GAP
+#define LOADGEN_EXTENDED_PORT_GAP 1
+
+void loadgen_write_frame_id(uint8_t *out, uint32_t frame_id);
+
+// Fragments needed for a run of led_count LEDs, at most max_leds each
+// (LOADGEN_FRAGMENT_MAX_LEDS when 0). Returns 1 when a plain run datagram
+// fits and max_leds does not force a split.
+unsigned int loadgen_fragment_count(unsigned int led_count, unsigned int max_leds);
+
+// Writes fragment `index` of the run's LED-order RGB bytes as an extended
+// datagram into `out`, which holds LOADGEN_UDP_MAX_PAYLOAD bytes. Fragments
+// split the run into equal max_leds pieces, the last one shorter. Returns
+// the datagram length.
+size_t loadgen_encode_fragment(uint32_t frame_id, unsigned int run, const uint8_t *rgb,
+                               unsigned int led_count, unsigned int max_leds, unsigned int index,
+                               uint8_t *out);
+
+// Writes `bytes` bytes of rgb as XOR+RLE delta tokens against base into
+// `out`. Returns the token stream length, or 0 when it would exceed
+// `capacity`.
+size_t loadgen_xor_rle(const uint8_t *rgb, const uint8_t *base, size_t bytes, uint8_t *out,
+                       size_t capacity);
+
+// Like loadgen_encode_fragment, but the block is a delta against the same
+// LEDs of frame base_frame_id, whose RGB bytes base_rgb holds. Returns 0
+// when the delta does not fit one datagram; noisy content can encode larger
+// than RGB, so callers compare the length before choosing it.
+size_t loadgen_encode_delta_fragment(uint32_t frame_id, uint32_t base_frame_id, unsigned int run,
+                                     const uint8_t *rgb, const uint8_t *base_rgb,
+                                     unsigned int led_count, unsigned int max_leds,
+                                     unsigned int index, uint8_t *out);
+
+// Collects the distinct colours of `leds` LEDs of RGB bytes into `palette`,
+// in order of first use, and writes each LED's colour index to `indices`.
+// Returns the colour count, or 0 when there are more than max_colours.
+unsigned int loadgen_build_palette(const uint8_t *rgb, unsigned int leds, unsigned int max_colours,
+                                   uint8_t *palette, uint8_t *indices);
+
+// Like loadgen_encode_fragment, but the block is a palette with `bits` (8 or
+// 4) per LED index. Returns 0 when the fragment has more colours than that
+// index width can name.
+size_t loadgen_encode_palette_fragment(uint32_t frame_id, unsigned int run, const uint8_t *rgb,
+                                       unsigned int led_count, unsigned int max_leds,
+                                       unsigned int index, unsigned int bits, uint8_t *out);
+
+// Samples a section of `leds` LEDs needs at one per `stride` LEDs: LED 0,
+// every stride-th LED after it, and the last LED.
+unsigned int loadgen_section_samples(unsigned int leds, unsigned int stride);
+
+// Fragments a run of section_count sections needs as sampled blocks, each
+// holding as many whole sections as fit one datagram; 0 when one section's
+// samples alone do not fit, or stride is out of range.
+unsigned int loadgen_sampled_fragment_count(const unsigned int *section_leds,
+                                            unsigned int section_count, unsigned int stride);
+
+// Writes fragment `index` of a run's LED-order RGB bytes as a sampled block:
+// each section is sampled every `stride` LEDs for the firmware to
+// interpolate. Returns the datagram length, or 0 when
+// loadgen_sampled_fragment_count is 0.
+size_t loadgen_encode_sampled_fragment(uint32_t frame_id, unsigned int run, const uint8_t *rgb,
+                                       const unsigned int *section_leds,
+                                       unsigned int section_count, unsigned int stride,
+                                       unsigned int index, uint8_t *out);
+
+// Runs, from first_run on, that fit one extended datagram as whole-run
+// blocks; 0 when first_run alone does not.
+unsigned int loadgen_batch_runs(const unsigned int *led_counts, unsigned int run_count,
+                                unsigned int first_run);
+
+// Writes runs first_run .. first_run + count - 1 as one extended datagram
+// of whole-run blocks into `out`, which holds LOADGEN_UDP_MAX_PAYLOAD bytes.
+// rgb[run] holds run's LED-order RGB bytes. Returns the datagram length.
+size_t loadgen_encode_batch(uint32_t frame_id, const unsigned int *led_counts,
+                            const uint8_t *const *rgb, unsigned int first_run,
+                            unsigned int count, uint8_t *out);
@@ -0,0 +1,83 @@
+#include "loadgen_plan.h"
+
+#include <string.h>
+
+// xorshift32: cheap enough to call per datagram at line rate
+static uint32_t next_random(loadgen_plan_t *plan)
+{
+    uint32_t x = plan->rng;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    plan->rng = x;
+    return x;
+}
+
+static bool chance(loadgen_plan_t *plan, double probability)
+{
+    if (probability <= 0.0) {
+        return false;
+    }
+    return next_random(plan) < probability * 4294967296.0;
+}
+
+void loadgen_plan_init(loadgen_plan_t *plan, unsigned int run_count,
+                       const loadgen_impairments_t *impairments, uint32_t seed)
+{
+    memset(plan, 0, sizeof(*plan));
+    plan->impairments = *impairments;
+    plan->run_count = run_count;
+    plan->rng = seed != 0 ? seed : 1;
+}
+
+size_t loadgen_plan_frame(loadgen_plan_t *plan, uint32_t frame_id, loadgen_datagram_t *out)
+{
+    const loadgen_impairments_t *impairments = &plan->impairments;
+    unsigned int datagrams = plan->run_count + (impairments->parity ? 1 : 0);
+    loadgen_datagram_t held[LOADGEN_MAX_RUNS + 1];
+    size_t held_count = 0;
+    size_t count = 0;
+
+    for (unsigned int run = 0; run < datagrams; ++run) {
+        loadgen_datagram_t datagram = {
+            .run = (uint8_t)run,
+            .frame_id = frame_id,
+            .offset_us = impairments->skew_us ? next_random(plan) % (impairments->skew_us + 1) : 0,
+        };
+        plan->stats.planned++;
+        if (chance(plan, impairments->loss)) {
+            plan->stats.lost++;
+            continue;
+        }
+        if (chance(plan, impairments->reorder)) {
+            plan->stats.reordered++;
+            held[held_count++] = datagram;
+            continue;
+        }
+        size_t copies = chance(plan, impairments->duplicate) ? 2 : 1;
+        if (copies == 2) {
+            plan->stats.duplicated++;
+        }
+        // Insertion sort keeps the run order stable for equal offsets
+        for (size_t copy = 0; copy < copies; ++copy) {
+            size_t slot = count++;
+            while (slot > 0 && out[slot - 1].offset_us > datagram.offset_us) {
+                out[slot] = out[slot - 1];
+                --slot;
+            }
+            out[slot] = datagram;
+        }
+    }
+
+    // Last frame's stragglers trail this frame, so they arrive after a newer
+    // frame_id has started assembling
+    uint32_t last_offset_us = count > 0 ? out[count - 1].offset_us : 0;
+    for (size_t index = 0; index < plan->held_count; ++index) {
+        out[count] = plan->held[index];
+        out[count].offset_us = last_offset_us;
+        ++count;
+    }
+    memcpy(plan->held, held, held_count * sizeof(held[0]));
+    plan->held_count = held_count;
+    return count;
+}
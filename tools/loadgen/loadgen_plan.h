@@ -0,0 +1,53 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "loadgen_layout.h"
+
+// What the network should do to each datagram. Probabilities are per
+// datagram and independent; the parity datagram is impaired like a run.
+typedef struct {
+    double loss;        // never sent
+    double duplicate;   // sent twice back to back
+    double reorder;     // held back and sent after the next frame's datagrams
+    uint32_t skew_us;   // each datagram leaves up to this long after the frame starts
+    bool parity;        // also send the XOR parity datagram on PORT_BASE + run_count
+} loadgen_impairments_t;
+
+typedef struct {
+    uint32_t planned;
+    uint32_t lost;
+    uint32_t duplicated;
+    uint32_t reordered;
+} loadgen_plan_stats_t;
+
+typedef struct {
+    uint8_t run;         // run index, run_count for the parity datagram
+    uint32_t frame_id;
+    uint32_t offset_us;  // from the start of the frame period it is sent in
+} loadgen_datagram_t;
+
+// Worst case per frame: every datagram of this frame duplicated plus every
+// datagram held back from the previous one.
+#define LOADGEN_MAX_FRAME_DATAGRAMS (3 * (LOADGEN_MAX_RUNS + 1))
+
+// Decides, frame by frame, which datagrams go out when. Deterministic for a
+// given seed, so an impairment pattern can be replayed.
+typedef struct {
+    loadgen_impairments_t impairments;
+    unsigned int run_count;
+    uint32_t rng;
+    loadgen_datagram_t held[LOADGEN_MAX_RUNS + 1];
+    size_t held_count;
+    loadgen_plan_stats_t stats;
+} loadgen_plan_t;
+
+void loadgen_plan_init(loadgen_plan_t *plan, unsigned int run_count,
+                       const loadgen_impairments_t *impairments, uint32_t seed);
+
+// Fills `out` with the datagrams to send during frame_id's period, sorted by
+// offset. Datagrams held back from the previous frame come last. Returns the
+// count, at most LOADGEN_MAX_FRAME_DATAGRAMS.
+size_t loadgen_plan_frame(loadgen_plan_t *plan, uint32_t frame_id, loadgen_datagram_t *out);
@@ -0,0 +1,124 @@
+#!/usr/bin/env python3
+"""Break down the firmware's static RAM per subsystem for each layout.
+
+The frame arena comes from the same layout gen_config.py writes into
+config_autogen.h; task stacks and fixed rings are read from the firmware
+sources, so the report follows the code without a build.
+"""
+
+import argparse
+import json
+import re
+import sys
+from pathlib import Path
+from typing import Dict, List, Tuple
+
+sys.path.insert(0, str(Path(__file__).resolve().parent))
+
+import gen_config  # noqa: E402
+
+REPO_ROOT = Path(__file__).resolve().parents[1]
+MAIN_DIR = REPO_ROOT / "firmware" / "main"
+
+# Subsystem owning each task source
+SUBSYSTEMS = {
+    "rx_task.c": "rx",
+    "driver_task.c": "driver",
+    "status_task.c": "status",
+    "control_task.c": "control",
+    "net_task.c": "net",
+}
+TASK_PATTERN = re.compile(r'xTaskCreate(?:PinnedToCore)?\(\s*\w+,\s*"(\w+)",\s*(\d+)')
+# sizeof(event_t) and sizeof(rx_capture_entry_t) on the ESP32
+EVENT_BYTES = 12
+CAPTURE_ENTRY_BYTES = 16
+
+Row = Tuple[str, str, int]
+
+
+def read_define(path: Path, name: str) -> int:
+    match = re.search(rf"#define {name} (\d+)", path.read_text())
+    if match is None:
+        raise ValueError(f"{name} not found in {path.name}")
+    return int(match.group(1))
+
+
+def task_stacks(main_dir: Path) -> Dict[str, int]:
+    """Stack bytes per task name as created by the firmware."""
+    stacks = {}
+    for source in SUBSYSTEMS:
+        for name, size in TASK_PATTERN.findall((main_dir / source).read_text()):
+            stacks[name] = int(size)
+    return stacks
+
+
+def layout_rows(layout_data: dict, main_dir: Path = MAIN_DIR) -> List[Row]:
+    """(subsystem, item, bytes) rows for the default build of a layout."""
+    led_counts = [run.get("led_count", 0) for run in layout_data.get("runs", [])]
+    arena = gen_config.frame_arena_layout(led_counts)
+    rows: List[Row] = []
+    for index, run in enumerate(arena["runs"]):
+        rows.append(
+            (
+                "rx",
+                f"arena run {index} ({led_counts[index]} LEDs, "
+                f"{gen_config.RX_POOL_BUFFERS_PER_RUN} x {run['stride']} B)",
+                run["stride"] * gen_config.RX_POOL_BUFFERS_PER_RUN,
+            )
+        )
+    rows.append(("rx", "arena parity", arena["extended_rx_offset"] - arena["parity_offset"]))
+    rows.append(("rx", "arena extended receive", arena["total"] - arena["extended_rx_offset"]))
+
+    stacks = task_stacks(main_dir)
+    # One listener per run plus the parity and extended listeners unless
+    # RX_MULTIPLEXED_LISTENER
+    rows.append(("rx", f"rx_run stacks ({len(led_counts)} tasks)", stacks["rx_run"] * len(led_counts)))
+    rows.append(("rx", "rx_parity stack", stacks["rx_parity"]))
+    rows.append(("rx", "rx_ext stack", stacks["rx_ext"]))
+    capture_entries = read_define(main_dir / "rx_capture.h", "RX_CAPTURE_ENTRIES")
+    if capture_entries:
+        rows.append(("rx", "capture ring", capture_entries * CAPTURE_ENTRY_BYTES))
+    rows.append(("driver", "driver_task stack", stacks["driver_task"]))
+    rows.append(("status", "status_task stack", stacks["status_task"]))
+    rows.append(
+        (
+            "status",
+            "event log ring",
+            read_define(main_dir / "event_log.h", "EVENT_LOG_CAPACITY") * EVENT_BYTES,
+        )
+    )
+    rows.append(("control", "control_task stack", stacks["control_task"]))
+    rows.append(("net", "net_task stack", stacks["net_task"]))
+    return rows
+
+
+def format_report(name: str, rows: List[Row]) -> str:
+    lines = [f"{name}:"]
+    totals: Dict[str, int] = {}
+    for subsystem, item, size in rows:
+        totals[subsystem] = totals.get(subsystem, 0) + size
+        lines.append(f"  {subsystem:<8} {item:<44} {size:>8}")
+    for subsystem, size in totals.items():
+        lines.append(f"  {subsystem:<8} {'total':<44} {size:>8}")
+    lines.append(f"  {'all':<8} {'total':<44} {sum(totals.values()):>8}")
+    return "\n".join(lines)
+
+
+def main() -> None:
+    parser = argparse.ArgumentParser(description="Report static RAM per subsystem for each layout.")
+    parser.add_argument(
+        "layouts",
+        nargs="*",
+        help="Layout JSON files (default: every layout in config/)",
+    )
+    arguments = parser.parse_args()
+
+    paths = [Path(path) for path in arguments.layouts] or sorted((REPO_ROOT / "config").glob("*.json"))
+    reports = []
+    for path in paths:
+        reports.append(format_report(path.stem, layout_rows(json.loads(path.read_text()))))
+    print("\n\n".join(reports))
+
+
+if __name__ == "__main__":
+    main()
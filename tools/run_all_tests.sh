@@ -14,7 +14,25 @@ pytest
 cmake -S firmware/test -B firmware/test/build
 cmake --build firmware/test/build
 ./firmware/test/build/test_rx_task
+./firmware/test/build/test_rx_latency
+./firmware/test/build/test_rx_handoff
+./firmware/test/build/test_rx_multiplex
+./firmware/test/build/test_rx_parity
+./firmware/test/build/test_rx_fragments
+./firmware/test/build/test_rx_delta
+./firmware/test/build/test_rx_palette
+./firmware/test/build/test_rx_sections
+./firmware/test/build/test_latency_stats
+./firmware/test/build/test_metrics
+./firmware/test/build/test_event_log
 ./firmware/test/build/test_status_task
-./firmware/test/build/test_driver_task
+./firmware/test/build/test_telemetry
+./firmware/test/build/test_firmware_host
+./firmware/test/build/test_virtual_strip
+./firmware/test/build/test_loadgen
+./firmware/test/build/test_rx_capture
+./firmware/test/build/test_startup_sequence
+./firmware/test/build/test_ws2815_encoder
+./firmware/test/build/test_frame_timing
 
 popd >/dev/null
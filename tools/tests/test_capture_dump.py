@@ -0,0 +1,51 @@
+from pathlib import Path
+import struct
+import sys
+
+sys.path.insert(0, str(Path(__file__).resolve().parents[1]))
+
+import capture_dump  # noqa: E402
+
+
+def pack_capture(entries) -> bytes:
+    """Pack a capture stream field by field, following firmware/main/rx_capture.h."""
+    data = struct.pack("<4sBBBBII", b"BCAP", 1, 0, 3, 16, len(entries), 2)
+    data += struct.pack("<4HHHI", 362, 300, 379, 0, 49600, 0, 0)
+    for arrival_us, frame_id, length, run, outcome in entries:
+        data += struct.pack("<QIHBB", arrival_us, frame_id, length, run, outcome)
+    return data
+
+
+def chunk(stream: bytes, size: int = 1024):
+    count = (len(stream) + size - 1) // size
+    return [
+        struct.pack("<2sBBHH", b"BD", 1, 0, index, count) + stream[index * size:(index + 1) * size]
+        for index in range(count)
+    ]
+
+
+ENTRIES = [
+    (1000 + 10 * index, index // 4, 1090, index % 4, 3 if index % 7 == 0 else 0)
+    for index in range(200)
+]
+
+
+def test_chunks_reassemble_in_any_order() -> None:
+    stream = pack_capture(ENTRIES)
+    datagrams = chunk(stream)
+    assert len(datagrams) == 4
+    assert capture_dump.assemble_chunks(datagrams[:3]) is None
+    assert capture_dump.assemble_chunks(list(reversed(datagrams)) + [b"noise"]) == stream
+
+
+def test_decode_and_summarize() -> None:
+    header, entries = capture_dump.decode_capture(pack_capture(ENTRIES))
+    assert header["leds"] == [362, 300, 379]
+    assert header["overwritten"] == 2
+    assert entries[7] == {
+        "arrival_us": 1070, "frame_id": 1, "length": 1090, "run": 3, "outcome": "stale",
+    }
+    summary = capture_dump.summarize(header, entries)
+    assert "span 2.0 ms" in summary
+    assert "parity: accepted=" in summary
+    assert "run0: accepted=42 stale=8" in summary
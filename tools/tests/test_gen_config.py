@@ -56,10 +56,14 @@ def assert_header_matches_layout(layout_file: str, tmp_dir: Path) -> None:
 
     run_count = len(layout_data["runs"])
     assert f"#define RUN_COUNT {run_count}" in header_text
+    assert f"#define EXPECTED_MASK 0x{(1 << run_count) - 1:X}u" in header_text
 
     total_led_count = layout_data["total_leds"]
     assert f"#define TOTAL_LED_COUNT {total_led_count}" in header_text
 
+    max_run_led_count = max(run["led_count"] for run in layout_data["runs"])
+    assert f"#define MAX_RUN_LED_COUNT {max_run_led_count}" in header_text
+
     port_base = layout_data["port_base"]
     assert f"#define PORT_BASE {port_base}" in header_text
 
@@ -77,6 +81,36 @@ def assert_header_matches_layout(layout_file: str, tmp_dir: Path) -> None:
         assert f"#define STATIC_GW_ADDR{index} {value}" in header_text
 
 
+def test_frame_arena_places_every_buffer_aligned_without_overlap():
+    sys.path.insert(0, str(Path(__file__).resolve().parents[1]))
+    import gen_config
+
+    led_counts = [362, 300, 379]
+    arena = gen_config.frame_arena_layout(led_counts)
+    regions = []
+    for count, run in zip(led_counts, arena["runs"]):
+        assert run["stride"] % gen_config.FRAME_ARENA_ALIGN == 0
+        assert run["stride"] >= 4 + count * 3 + 1
+        regions.append((run["offset"], run["stride"] * gen_config.RX_POOL_BUFFERS_PER_RUN))
+    assert arena["parity_slot_bytes"] >= max(led_counts) * 3
+    regions.append((arena["parity_offset"], arena["parity_slot_bytes"] * gen_config.RX_SLOT_COUNT))
+    regions.append((arena["parity_rx_offset"], 4 + max(led_counts) * 3 + 1))
+    regions.append((arena["extended_rx_offset"], gen_config.UDP_MAX_PAYLOAD + 1))
+    end = 0
+    for offset, size in regions:
+        assert offset % gen_config.FRAME_ARENA_ALIGN == 0
+        assert offset >= end
+        end = offset + size
+    assert arena["total"] >= end
+
+
+def test_header_carries_frame_arena_layout(tmp_path):
+    header_text = run_and_read("config/left.json", tmp_path)
+    assert "#define FRAME_ARENA_BYTES 32332" in header_text
+    assert "RUN_POOL_OFFSET[RUN_COUNT] = {0, 8736, 16000};" in header_text
+    assert "RUN_BUFFER_STRIDE[RUN_COUNT] = {1092, 908, 1144};" in header_text
+
+
 def test_left_layout_generates_expected_header(tmp_path):
     assert_header_matches_layout("config/left.json", tmp_path)
 
@@ -123,3 +157,125 @@ def test_missing_gateway_port_results_in_error(tmp_path):
     process = run_gen_config(malformed_layout_path)
     assert process.returncode != 0
     assert "gateway_telemetry_port" in process.stderr.lower()
+
+
+def test_unreachable_target_fps_fails_generation(tmp_path):
+    repo_root = Path(__file__).resolve().parents[2]
+    layout_path = tmp_path / "too_fast.json"
+    layout_data = json.loads((repo_root / "config" / "four_run.json").read_text())
+    # 400-LED runs take 12280 us in parallel: 81 fps at most
+    layout_data["target_fps"] = 90
+    layout_path.write_text(json.dumps(layout_data))
+
+    process = run_gen_config(layout_path, tmp_path / "config_autogen.h")
+    assert process.returncode != 0
+    assert "target_fps 90" in process.stderr
+
+
+def test_tight_target_fps_warns_and_reports_budget(tmp_path):
+    repo_root = Path(__file__).resolve().parents[2]
+    layout_path = tmp_path / "tight.json"
+    layout_data = json.loads((repo_root / "config" / "four_run.json").read_text())
+    layout_data["target_fps"] = 75
+    layout_path.write_text(json.dumps(layout_data))
+
+    output_path = tmp_path / "config_autogen.h"
+    process = run_gen_config(layout_path, output_path)
+    assert process.returncode == 0
+    assert "warning: target_fps 75" in process.stderr
+    header_text = output_path.read_text()
+    assert "#define TARGET_FPS 75" in header_text
+    assert "#define FRAME_PERIOD_PARALLEL_US 12280" in header_text
+    assert "#define FRAME_PERIOD_SERIAL_US 49120" in header_text
+    assert "#define MAX_DATAGRAM_BYTES 1204" in header_text
+    assert "RUN_WIRE_US[RUN_COUNT] = {12280, 12280, 12280, 12280};" in header_text
+
+
+def test_sample_layouts_meet_their_target_without_warnings(tmp_path):
+    repo_root = Path(__file__).resolve().parents[2]
+    for layout in ("left", "right", "four_run", "four_short"):
+        process = run_gen_config(repo_root / "config" / f"{layout}.json", tmp_path / f"{layout}.h")
+        assert process.returncode == 0
+        assert process.stderr == ""
+
+
+def test_runs_over_one_datagram_are_budgeted_as_fragments(tmp_path):
+    repo_root = Path(__file__).resolve().parents[2]
+    layout_path = tmp_path / "long_runs.json"
+    layout_data = json.loads((repo_root / "config" / "right.json").read_text())
+    layout_data["runs"][0].pop("sections")
+    layout_data["runs"][0]["led_count"] = 1000
+    layout_data["total_leds"] = 1000
+    layout_data["target_fps"] = 30
+    layout_path.write_text(json.dumps(layout_data))
+
+    output_path = tmp_path / "config_autogen.h"
+    process = run_gen_config(layout_path, output_path)
+    assert process.returncode == 0
+    # 1000 LEDs need three fragments of at most 485 LEDs; parity cannot be
+    # split, so it is turned off rather than sent IP-fragmented
+    header = output_path.read_text()
+    assert "#define MAX_DATAGRAM_BYTES 1471" in header
+    assert "#define RX_PARITY_ENABLED 0" in header
+    assert "parity disabled" in process.stderr
+
+    layout_data["runs"][0]["led_count"] = 489
+    layout_path.write_text(json.dumps(layout_data))
+    process = run_gen_config(layout_path, output_path)
+    assert process.returncode == 0
+    assert "RX_PARITY_ENABLED" not in output_path.read_text()
+
+    layout_data["runs"][0]["led_count"] = 1025
+    layout_path.write_text(json.dumps(layout_data))
+    process = run_gen_config(layout_path, output_path)
+    assert process.returncode != 0
+    assert "led_count exceeds 1024" in process.stderr
+
+
+def test_short_runs_batch_into_fewer_datagrams():
+    sys.path.insert(0, str(Path(__file__).resolve().parents[1]))
+    import gen_config
+
+    assert gen_config.batched_datagrams([60, 60, 60, 60]) == 1
+    # Two 240-LED blocks fill 1464 bytes; the third run starts a new datagram
+    assert gen_config.batched_datagrams([240, 240, 240]) == 2
+    assert gen_config.batched_datagrams([400, 400, 400, 400]) == 4
+    # A fragmented run travels on its own between batches
+    assert gen_config.batched_datagrams([10, 1000, 10, 10]) == 5
+    assert "batched: 1 instead of 4" in gen_config.format_budget(
+        json.loads((Path(__file__).resolve().parents[2] / "config" / "four_short.json").read_text())
+    )
+
+
+def test_header_carries_section_tables(tmp_path):
+    header_text = run_and_read("config/left.json", tmp_path)
+    assert "#define SECTION_COUNT 8" in header_text
+    assert "RUN_FIRST_SECTION[RUN_COUNT] = {0, 3, 5};" in header_text
+    assert "RUN_SECTION_COUNT[RUN_COUNT] = {3, 2, 3};" in header_text
+    assert "SECTION_LED_COUNT[SECTION_COUNT] = {124, 128, 110, 161, 139, 173, 85, 121};" in header_text
+    assert "SECTION_FIRST_LED[SECTION_COUNT] = {0, 124, 252, 0, 161, 0, 173, 258};" in header_text
+
+
+def test_sections_must_cover_their_run(tmp_path):
+    sys.path.insert(0, str(Path(__file__).resolve().parents[1]))
+    import gen_config
+
+    repo_root = Path(__file__).resolve().parents[2]
+    layout_data = json.loads((repo_root / "config" / "right.json").read_text())
+    assert gen_config.run_sections(layout_data) == [[10, 10]]
+    # A run without sections is one section
+    layout_data["runs"][0].pop("sections")
+    assert gen_config.run_sections(layout_data) == [[20]]
+
+    layout_path = tmp_path / "short_sections.json"
+    layout_data["runs"][0]["sections"] = [{"id": "a", "led_count": 12}, {"id": "b", "led_count": 7}]
+    layout_path.write_text(json.dumps(layout_data))
+    process = run_gen_config(layout_path, tmp_path / "config_autogen.h")
+    assert process.returncode != 0
+    assert "sections of run 0 cover 19 LEDs, not 20" in process.stderr
+
+    layout_data["runs"][0]["sections"] = [{"id": "a", "led_count": 20}, {"id": "b", "led_count": 0}]
+    layout_path.write_text(json.dumps(layout_data))
+    process = run_gen_config(layout_path, tmp_path / "config_autogen.h")
+    assert process.returncode != 0
+    assert "positive led_count" in process.stderr
@@ -0,0 +1,64 @@
+from pathlib import Path
+import json
+import struct
+import sys
+
+sys.path.insert(0, str(Path(__file__).resolve().parents[1]))
+
+import heartbeat_monitor  # noqa: E402
+
+
+def pack_telemetry(version: int = 2, side: int = 1, run_count: int = 3) -> bytes:
+    """Pack a datagram field by field, following firmware/main/telemetry.h."""
+    data = struct.pack("<2sBBIIBBBB", b"BL", version, side, 7, 123456, run_count, 5, 24, 0x01)
+    # rx_frames, complete, applied, drops len/run/stale/window/pool/base,
+    # recovered, events_lost, frames_skipped, frame_gaps
+    data += struct.pack("<13I", 90, 30, 29, 1, 0, 2, 3, 0, 5, 4, 0, 6, 2)
+    for run in range(4):
+        data += struct.pack("<3I", 30 + run, run, 10 * run)
+    for stage in range(5):
+        buckets = [0] * 24
+        buckets[7] = 98  # [64, 127] us
+        buckets[12] = 2  # [2048, 4095] us
+        data += struct.pack("<I", 3000 + stage) + struct.pack("<24H", *buckets)
+    return data
+
+
+def test_datagram_size_matches_firmware() -> None:
+    assert heartbeat_monitor.TELEMETRY_BYTES == 376
+    assert len(pack_telemetry()) == heartbeat_monitor.TELEMETRY_BYTES
+
+
+def test_binary_telemetry_decodes_to_heartbeat_keys() -> None:
+    decoded = heartbeat_monitor.decode_binary_telemetry(pack_telemetry())
+    assert decoded is not None
+    assert decoded["id"] == "RIGHT"
+    assert decoded["sequence"] == 7
+    assert decoded["uptime_ms"] == 123456
+    assert decoded["link"] is True
+    assert decoded["rx_frames"] == 90
+    assert decoded["applied"] == 29
+    assert decoded["drops"] == {"len": 1, "run": 0, "stale": 2, "window": 3, "pool": 0, "base": 5}
+    assert decoded["dropped_frames"] == 11
+    assert decoded["recovered"] == 4
+    assert decoded["frames_skipped"] == 6
+    assert decoded["frame_gaps"] == 2
+    assert decoded["per_run"] == [
+        {"rx": 30, "drops": 0, "recovered": 0},
+        {"rx": 31, "drops": 1, "recovered": 10},
+        {"rx": 32, "drops": 2, "recovered": 20},
+    ]
+    assert decoded["latency_us"]["total"] == [127, 3004, 3004]
+    assert decoded["latency_buckets"]["assemble"][7] == 98
+
+
+def test_unknown_versions_and_short_datagrams_are_rejected() -> None:
+    assert heartbeat_monitor.decode_binary_telemetry(pack_telemetry(version=1)) is None
+    assert heartbeat_monitor.decode_binary_telemetry(pack_telemetry()[:-1]) is None
+
+
+def test_json_heartbeats_still_decode() -> None:
+    heartbeat = {"id": "LEFT", "rx_frames": 1}
+    payload = json.dumps(heartbeat).encode("utf-8")
+    assert heartbeat_monitor.decode_datagram(payload) == heartbeat
+    assert heartbeat_monitor.decode_datagram(b"\xff\xfe") is None
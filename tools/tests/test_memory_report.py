@@ -0,0 +1,28 @@
+from pathlib import Path
+import json
+import sys
+
+sys.path.insert(0, str(Path(__file__).resolve().parents[1]))
+
+import gen_config  # noqa: E402
+import memory_report  # noqa: E402
+
+REPO_ROOT = Path(__file__).resolve().parents[2]
+
+
+def test_rx_arena_rows_add_up_to_the_generated_arena():
+    layout_data = json.loads((REPO_ROOT / "config" / "four_run.json").read_text())
+    rows = memory_report.layout_rows(layout_data)
+    arena_bytes = sum(size for subsystem, item, size in rows if item.startswith("arena"))
+    led_counts = [run["led_count"] for run in layout_data["runs"]]
+    assert arena_bytes == gen_config.frame_arena_layout(led_counts)["total"]
+    assert ("rx", "rx_run stacks (4 tasks)", 4 * 4096) in rows
+    assert ("rx", "rx_ext stack", 4096) in rows
+    assert {subsystem for subsystem, _, _ in rows} == {"rx", "driver", "status", "control", "net"}
+
+
+def test_task_stacks_are_read_from_the_sources():
+    stacks = memory_report.task_stacks(memory_report.MAIN_DIR)
+    assert stacks["driver_task"] == 4096
+    assert stacks["control_task"] == 2048
+    assert set(stacks) >= {"rx_run", "rx_mux", "rx_parity", "rx_ext", "status_task", "net_task"}